@@ -0,0 +1,628 @@
+#pragma once
+/**
+ * @file broadcast_ring.hpp
+ *
+ * This would have a ring buffer that broadcast every item to few consumers (the same as the
+ * ring of the LMAX disruptor). Unlike the message_queue, in which each item is read by one
+ * of the readers, here each of the consumers is reading all the items, so a single stream can
+ * be handed to few independent outputs without having a queue (and a copy of the items) for
+ * each of them.
+ * There is a single producer, that claim the next slots in the ring, write the items into them
+ * and then publish them. Each consumer has its own cursor (the next item it would read), and
+ * the producer would not claim a slot before all the consumers moved past it, so an item is
+ * never overwritten before everyone read it. A consumer can be set to run after other consumers,
+ * in which case it would only see an item after they finished with it (so it can use what they
+ * did with it). Since the items are not copied out of the ring, the consumer would normally
+ * read all the items that are ready at once and then release them together.
+ * The threads that have to wait (the producer when the ring is full, and the consumers when
+ * there are no new items) are using the wait strategy of the ring -
+ *   busy_spin_wait - keep checking (lowest latency, but each waiting thread is using a CPU)
+ *   yielding_wait  - check few times and then give the CPU to other threads between the checks
+ *   blocking_wait  - sleep on a condition, the other side only signals it when someone is sleeping
+ *
+ * The use case for this is as follow -
+ *
+ *   typedef boost::broadcast_ring<trace_entry, boost::blocking_wait> trace_ring;
+ *   trace_ring ring(1024);
+ *   trace_ring::consumer& file = ring.add_consumer();
+ *   trace_ring::consumer& udp = ring.add_consumer();
+ *   trace_ring::consumer& stats = ring.add_consumer(udp);  // only count what was sent
+ *   // all the consumers must be added before the items are published
+ *
+ * in the producer -
+ *   trace_ring::sequence_type first = ring.claim(count);   // block while the ring is full
+ *   for (std::size_t i = 0; i < count; i++)
+ *     ring[first + i] = entries[i];
+ *   ring.publish(first, count);                            // from now the consumers can read them
+ *
+ * or for a single item -
+ *   ring.push(entry);
+ *
+ * in each of the consumers -
+ *   trace_ring::sequence_type first = 0;
+ *   std::size_t count = udp.wait_for(first);  // block until there are items, return all of them
+ *   for (std::size_t i = 0; i < count; i++)
+ *     send(ring[first + i]);
+ *   udp.release(count);                       // the producer (and stats) can have them now
+ *
+ * The sequences are always growing (and are allowed to wrap around), the slot of the item is its
+ * sequence modulo the size of the ring, which is rounded up to a power of 2.
+ */
+#include <boost/thread/mutex.hpp>                 // class mutex
+#include <boost/thread/condition_variable.hpp>    // for the blocking wait
+#include <boost/thread/thread.hpp>                // yield
+#include <boost/thread/thread_time.hpp>           // get_system_time
+#include <boost/detail/atomic_count.hpp>          // the sleeping threads of the blocking wait
+#include <boost/message_queue/detail/waiting.hpp> // count a sleeping thread
+#include <boost/bind.hpp>                         // bind parameters to function call
+#include <boost/date_time/posix_time/posix_time.hpp>  // for duration
+#include <vector>                                 // the slots and the consumers
+#include <memory>                                 // auto_ptr
+#include <algorithm>                              // min
+#include <cassert>
+#if defined(_MSC_VER)
+# include <intrin.h>    // barriers
+#endif  // _MSC_VER
+
+namespace boost
+{
+
+namespace details
+{
+namespace broadcast
+{
+// the sequences are written by a single thread and read by the others - on gcc we are using
+// the atomic builtins, for older compilers we are using the full barrier ones
+#if defined(__GNUC__) && defined(__ATOMIC_ACQUIRE)
+
+inline std::size_t load_acquire(const volatile std::size_t* at)
+{
+  return __atomic_load_n(at, __ATOMIC_ACQUIRE);
+}
+
+inline void store_release(volatile std::size_t* at, std::size_t value)
+{
+  __atomic_store_n(at, value, __ATOMIC_RELEASE);
+}
+
+inline void full_fence()
+{
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+#elif defined(__GNUC__)
+
+inline std::size_t load_acquire(const volatile std::size_t* at)
+{
+  const std::size_t value = *at;
+  __sync_synchronize();
+  return value;
+}
+
+inline void store_release(volatile std::size_t* at, std::size_t value)
+{
+  __sync_synchronize();
+  *at = value;
+}
+
+inline void full_fence()
+{
+  __sync_synchronize();
+}
+
+#elif defined(_MSC_VER)
+
+// on x86 the loads and the stores are already ordered, we only need to stop the compiler
+inline std::size_t load_acquire(const volatile std::size_t* at)
+{
+  const std::size_t value = *at;
+  _ReadWriteBarrier();
+  return value;
+}
+
+inline void store_release(volatile std::size_t* at, std::size_t value)
+{
+  _ReadWriteBarrier();
+  *at = value;
+}
+
+inline void full_fence()
+{
+  _mm_mfence();
+}
+
+#else
+# error "broadcast ring is not supported for this compiler"
+#endif  // __GNUC__ && __ATOMIC_ACQUIRE
+
+inline void relax()
+{
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+  __builtin_ia32_pause();
+#elif defined(_MSC_VER)
+  _mm_pause();
+#endif  // __GNUC__ && x86
+}
+
+// the cursors are written by different threads, so each is placed on its own cache line
+const std::size_t cache_line_size = 64;
+
+} // end of namespace broadcast
+} // end of namespace details
+
+/**
+ * @class busy_spin_wait
+ * @brief the waiting thread keep checking without giving up the CPU
+ */
+class busy_spin_wait
+{
+public:
+  template<typename F>
+  void wait(F ready)
+  {
+    while (!ready())
+    {
+      details::broadcast::relax();
+    }
+  }
+
+  // @return false if the timeout passed while the ring was not ready
+  template<typename F>
+  bool timed_wait(F ready, const boost::posix_time::time_duration& timeout)
+  {
+    const boost::system_time until = boost::get_system_time() + timeout;
+    for (unsigned int i = 0; !ready(); i++)
+    {
+      // don't read the clock on every check
+      if ((i % check_clock) == 0 && boost::get_system_time() >= until)
+      {
+        return ready();
+      }
+      details::broadcast::relax();
+    }
+    return true;
+  }
+
+  // called by the other side after it changed the ring
+  void signal()
+  {
+  }
+
+private:
+  static const unsigned int check_clock = 64;
+};
+
+/**
+ * @class yielding_wait
+ * @brief the waiting thread spin a little and then yield the CPU between the checks
+ */
+class yielding_wait
+{
+public:
+  template<typename F>
+  void wait(F ready)
+  {
+    for (unsigned int i = 0; !ready(); i++)
+    {
+      pause(i);
+    }
+  }
+
+  template<typename F>
+  bool timed_wait(F ready, const boost::posix_time::time_duration& timeout)
+  {
+    const boost::system_time until = boost::get_system_time() + timeout;
+    for (unsigned int i = 0; !ready(); i++)
+    {
+      if (i >= spin_count && boost::get_system_time() >= until)
+      {
+        return ready();
+      }
+      pause(i);
+    }
+    return true;
+  }
+
+  void signal()
+  {
+  }
+
+private:
+  static const unsigned int spin_count = 100;
+
+  static void pause(unsigned int tries)
+  {
+    if (tries < spin_count)
+    {
+      details::broadcast::relax();
+    }
+    else
+    {
+      boost::this_thread::yield();
+    }
+  }
+};
+
+/**
+ * @class blocking_wait
+ * @brief the waiting thread sleep on a condition
+ * the threads that are sleeping are counted, so that the other side would only take the lock
+ * and signal the condition when someone is actually sleeping
+ */
+class blocking_wait
+{
+public:
+  blocking_wait() : m_waiters(0)
+  {
+  }
+
+  template<typename F>
+  void wait(F ready)
+  {
+    if (ready())
+    {
+      return;
+    }
+    boost::unique_lock<boost::mutex> lock(m_mutex);
+    details::waiting count(m_waiters);
+    m_cond.wait(lock, ready);
+  }
+
+  template<typename F>
+  bool timed_wait(F ready, const boost::posix_time::time_duration& timeout)
+  {
+    if (ready())
+    {
+      return true;
+    }
+    boost::unique_lock<boost::mutex> lock(m_mutex);
+    details::waiting count(m_waiters);
+    return m_cond.timed_wait(lock, timeout, ready);
+  }
+
+  void signal()
+  {
+    // the cursor that was changed must be seen before we check for waiters, and a waiter
+    // is counted before it is checking the ring again - so either it would see the change or we
+    // would see it
+    details::broadcast::full_fence();
+    if (m_waiters == 0)
+    {
+      return;
+    }
+    {
+      // once we have the lock the waiter is either waiting on the condition or would see the change
+      boost::lock_guard<boost::mutex> lock(m_mutex);
+    }
+    m_cond.notify_all();  // the producer and all the consumers are waiting here
+  }
+
+private:
+  boost::mutex m_mutex;
+  boost::condition_variable m_cond;
+  boost::detail::atomic_count m_waiters;
+};
+
+/**
+ * @class broadcast_ring
+ * @brief a ring with a single producer in which each item is read by all the consumers (see above)
+ * T must be default constructible and assignable, the slots are created with the ring and are
+ * reused (the items are not destroyed when they are released)
+ */
+template<typename T, typename WaitStrategy = yielding_wait>
+class broadcast_ring
+{
+  typedef broadcast_ring<T, WaitStrategy> this_type;
+public:
+  typedef T value_type;
+  typedef std::size_t size_type;
+  typedef std::size_t sequence_type;
+  typedef WaitStrategy wait_strategy;
+
+  /**
+   * @class consumer
+   * @brief the cursor of one of the consumers of the ring - this is used only by a single thread
+   */
+  class consumer
+  {
+  public:
+    /**
+     * @function wait_for
+     * @brief block until there are items that this consumer can read
+     * @param first the sequence of the first item that can be read
+     * @return the number of items (from first) that can be read now
+     */
+    size_type wait_for(sequence_type& first)
+    {
+      m_ring.m_wait.wait(boost::bind(&consumer::has_items, this));
+      first = m_next;
+      return available();
+    }
+
+    /**
+     * @function try_wait_for
+     * @brief the same as wait_for, only that this would wait up to the timeout
+     * @return the number of items that can be read, 0 if the timeout passed
+     */
+    size_type try_wait_for(sequence_type& first, const boost::posix_time::time_duration& timeout)
+    {
+      first = m_next;
+      if (!m_ring.m_wait.timed_wait(boost::bind(&consumer::has_items, this), timeout))
+      {
+        return 0;
+      }
+      return available();
+    }
+
+    /**
+     * @function available
+     * @brief the number of items that this consumer can read now (without waiting)
+     */
+    size_type available() const
+    {
+      size_type count = details::broadcast::load_acquire(&m_ring.m_published) - m_next;
+      for (typename std::vector<const consumer*>::const_iterator i = m_after.begin(); i != m_after.end(); ++i)
+      {
+        // the sequences may wrap around, so we compare the distance from our cursor
+        count = std::min(count, details::broadcast::load_acquire(&(*i)->m_next) - m_next);
+      }
+      return count;
+    }
+
+    /**
+     * @function release
+     * @brief tell the producer (and the consumers that run after us) that we are done with items
+     * @param count the number of items (from the first that was not released yet)
+     */
+    void release(size_type count = 1)
+    {
+      assert(count <= available());
+      details::broadcast::store_release(&m_next, m_next + count);
+      m_ring.m_wait.signal();
+    }
+
+    /**
+     * @function pop
+     * @brief copy the next item, this would block until there is one
+     */
+    void pop(value_type& item)
+    {
+      sequence_type first = 0;
+      wait_for(first);
+      item = m_ring[first];
+      release(1);
+    }
+
+    /**
+     * @function try_pop
+     * @brief copy the next item if there is one
+     * @return true if the item was copied
+     */
+    bool try_pop(value_type& item)
+    {
+      if (available() == 0)
+      {
+        return false;
+      }
+      item = m_ring[m_next];
+      release(1);
+      return true;
+    }
+
+    // the next sequence that this consumer would read
+    sequence_type next() const
+    {
+      return m_next;
+    }
+
+  private:
+    friend class broadcast_ring<T, WaitStrategy>;
+
+    consumer(this_type& ring, sequence_type next) : m_ring(ring), m_next(next)
+    {
+    }
+
+    consumer(const consumer&);              // Disabled copy constructor
+    consumer& operator = (const consumer&); // Disabled assign operator
+
+    bool has_items() const
+    {
+      return available() > 0;
+    }
+
+    this_type& m_ring;
+    std::vector<const consumer*> m_after;   // the consumers that must finish with an item before us
+    char m_pad[details::broadcast::cache_line_size];
+    volatile sequence_type m_next;          // all the items before this were released
+    char m_padAfter[details::broadcast::cache_line_size];
+  };
+
+  /**
+   * constructor for the class accept the size
+   * @param capacity the number of items that can be in the ring - this is rounded up to a power of 2
+   */
+  explicit broadcast_ring(size_type capacity) : m_slots(round_up(capacity)), m_mask(m_slots.size() - 1),
+                                                m_claimed(0), m_gate(0), m_published(0)
+  {
+  }
+
+  ~broadcast_ring()
+  {
+    for (typename std::vector<consumer*>::iterator i = m_consumers.begin(); i != m_consumers.end(); ++i)
+    {
+      delete *i;
+    }
+  }
+
+  /**
+   * @function add_consumer
+   * @brief add a consumer that would read all the items that are published from now
+   * note that this must not be called while the producer is running
+   * @return the consumer, which is owned by the ring
+   */
+  consumer& add_consumer()
+  {
+    return add_consumer(0, 0);
+  }
+
+  /**
+   * @function add_consumer
+   * @brief add a consumer that would only see an item after another consumer released it
+   */
+  consumer& add_consumer(const consumer& after)
+  {
+    const consumer* afters[] = { &after };
+    return add_consumer(afters, 1);
+  }
+
+  /**
+   * @function add_consumer
+   * @brief add a consumer that would only see an item after all the given consumers released it
+   * @param after the consumers that must finish with an item first (they must belong to this ring)
+   * @param count the number of consumers in after
+   */
+  consumer& add_consumer(const consumer* const after[], size_type count)
+  {
+    std::auto_ptr<consumer> added(new consumer(*this, m_published));
+    added->m_after.assign(after, after + count);
+    m_consumers.push_back(added.get());
+    return *added.release();
+  }
+
+  /**
+   * @function claim
+   * @brief take the next slots to write items into, this would block until all the consumers
+   * released the items that were in these slots
+   * @param count the number of slots, must not be more than the capacity
+   * @return the sequence of the first slot
+   */
+  sequence_type claim(size_type count = 1)
+  {
+    assert(count <= capacity());
+    m_wait.wait(boost::bind(&this_type::has_room, this, count));
+    return take(count);
+  }
+
+  /**
+   * @function try_claim
+   * @brief the same as claim, only that this would wait up to the timeout for the slots
+   * @param first the sequence of the first slot
+   * @return true if the slots were claimed
+   */
+  bool try_claim(sequence_type& first, size_type count, const boost::posix_time::time_duration& timeout)
+  {
+    assert(count <= capacity());
+    if (!m_wait.timed_wait(boost::bind(&this_type::has_room, this, count), timeout))
+    {
+      return false;
+    }
+    first = take(count);
+    return true;
+  }
+
+  /**
+   * @function publish
+   * @brief allow the consumers to read items that were claimed
+   * @param first the sequence that claim returned
+   * @param count the number of items that were written (the same as for claim)
+   */
+  void publish(sequence_type first, size_type count = 1)
+  {
+    assert(first == m_published && count <= m_claimed - m_published);
+    details::broadcast::store_release(&m_published, first + count);
+    m_wait.signal();
+  }
+
+  /**
+   * @function push
+   * @brief place a single item in the ring, this would block while the ring is full
+   */
+  void push(const value_type& item)
+  {
+    const sequence_type at = claim(1);
+    (*this)[at] = item;
+    publish(at, 1);
+  }
+
+  // the slot of an item - the producer can write to a slot it claimed (until it is published)
+  // and a consumer can read the slots that wait_for returned (until it release them)
+  value_type& operator [] (sequence_type sequence)
+  {
+    return m_slots[sequence & m_mask];
+  }
+
+  const value_type& operator [] (sequence_type sequence) const
+  {
+    return m_slots[sequence & m_mask];
+  }
+
+  size_type capacity() const
+  {
+    return m_slots.size();
+  }
+
+  // the next sequence that would be published
+  sequence_type published() const
+  {
+    return details::broadcast::load_acquire(&m_published);
+  }
+
+private:
+  broadcast_ring(const broadcast_ring&);              // Disabled copy constructor
+  broadcast_ring& operator = (const broadcast_ring&); // Disabled assign operator
+
+  static size_type round_up(size_type capacity)
+  {
+    size_type size = 1;
+    while (size < capacity)
+    {
+      size <<= 1;
+    }
+    return size;
+  }
+
+  // the lowest cursor of all the consumers - with no consumers the items are not kept
+  sequence_type gate() const
+  {
+    sequence_type lowest = m_claimed;
+    for (typename std::vector<consumer*>::const_iterator i = m_consumers.begin(); i != m_consumers.end(); ++i)
+    {
+      const sequence_type next = details::broadcast::load_acquire(&(*i)->m_next);
+      if (m_claimed - next > m_claimed - lowest)
+      {
+        lowest = next;
+      }
+    }
+    return lowest;
+  }
+
+  bool has_room(size_type count)
+  {
+    // first use the last gate we found, so we don't read the cursors of all the consumers every time
+    if (m_claimed + count - m_gate <= capacity())
+    {
+      return true;
+    }
+    m_gate = gate();
+    return m_claimed + count - m_gate <= capacity();
+  }
+
+  sequence_type take(size_type count)
+  {
+    const sequence_type first = m_claimed;
+    m_claimed += count;
+    return first;
+  }
+
+  std::vector<value_type> m_slots;
+  size_type m_mask;
+  std::vector<consumer*> m_consumers;
+  wait_strategy m_wait;
+  sequence_type m_claimed;      // the producer own these two
+  sequence_type m_gate;
+  char m_pad[details::broadcast::cache_line_size];
+  volatile sequence_type m_published;  // all the items before this can be read
+  char m_padAfter[details::broadcast::cache_line_size];
+};
+
+} // end of namespace boost
@@ -0,0 +1,45 @@
+#pragma once
+/**
+ * @file waiting.hpp
+ * the counting of the threads that are waiting on a condition, so that the thread that changed
+ * the condition would only take the lock and notify when some thread is actually waiting.
+ * This is used by both the message_queue and the blocking wait of the broadcast_ring
+ * IMPORTANT - this is for internal use only!
+ */
+#include <boost/detail/atomic_count.hpp>  // the number of waiting threads
+
+namespace boost
+{
+
+namespace details
+{
+
+/**
+ * @class waiting
+ * @brief count the thread as waiting for as long as this is alive
+ * note that the waiter is counted while it is holding the lock, and before it is checking
+ * the condition again, so a thread that changed the condition would either see that it is
+ * waiting, or the waiter would see the change
+ */
+struct waiting
+{
+  explicit waiting(boost::detail::atomic_count& count) : m_count(count)
+  {
+    ++m_count;
+  }
+
+  ~waiting()
+  {
+    --m_count;
+  }
+
+private:
+  waiting(const waiting&);
+  waiting& operator = (const waiting&);
+
+  boost::detail::atomic_count& m_count;
+};
+
+} // end of namespace details
+
+} // end of namespace boost
@@ -9,15 +9,17 @@
  * its life time or more pronaounced
  */
 #include <boost/message_queue/mq_data.hpp> // message queue data for special cases
-#include <boost/circular_buffer.hpp>  // the internal buffer is circular buffer
 #include <boost/thread/mutex.hpp>     // class mutex
 #include <boost/thread/condition.hpp> // class condition
 #include <boost/thread/thread.hpp>    // multi threads
 #include <boost/call_traits.hpp>      // optimized function call arguments
+#include <boost/detail/atomic_count.hpp>  // the counters that both sides of the queue are using
+#include <boost/message_queue/detail/waiting.hpp>  // count the threads that are waiting on a side
 #include <boost/progress.hpp>         // timers
 #include <boost/bind.hpp>             // bind parameters to function call
 #include <boost/date_time/posix_time/posix_time.hpp>  // for duration
 #include <algorithm>                  // min
+#include <vector>                     // the state of the slots
 
 /**
  * @class MTBoundBuffer
@@ -41,7 +43,7 @@ public:
   
   std::size_t size() const
   {
-    return m_unread;
+    return static_cast<std::size_t>(static_cast<long>(m_unread));
   }
   
    bool is_not_empty() const 
@@ -55,131 +57,76 @@ protected:
    explicit message_queue_base();
    
    ///////////////////////////////////////////////
-   // helper calls for the guarding the data
-   struct push_op
+   // the queue has two sides each with its own lock, so that producers and consumers
+   // are not blocking each other (the same as the two locks queue by Michael and Scott).
+   // The producers are only using the tail side and they are waiting on it while the queue
+   // is full, and the consumers are only using the head side and they are waiting on it while
+   // the queue is empty. The only thing that is shared by the two sides is the counters of the
+   // queue, which are atomic. Each side counts the threads that are waiting on it, so the
+   // other side would only take the lock and notify when some thread is actually waiting
+   struct side
    {
+     side();
      
      template<typename F>
-     push_op(boost::timed_mutex& m, boost::condition& nf, boost::condition& ne, F condition) : 
-                                           m_mutex(m), m_not_full(nf), m_not_empty(ne)
+     void wait(boost::unique_lock<boost::mutex>& lock, F ready)
      {
-       m_not_full.wait(m_mutex, condition);
-     }
-     
-     ~push_op();
-     
-   private:
-     boost::unique_lock<boost::timed_mutex> m_mutex;
-     boost::condition& m_not_full;
-     boost::condition& m_not_empty;
-   };
-   
-   struct time_push
-   {
-     time_push(boost::timed_mutex& m, boost::condition& nf, boost::condition& ne);                       
-     
-     template<typename TO, typename F>
-     bool enter(const TO& timeout, F condition)
-     {
-       if (m_mutex.timed_lock(timeout))
+       if (!ready())
        {
-         m_release = true;
-         if (m_not_full.timed_wait(m_mutex, timeout, condition))
-         {
-           return true;
-         }
-       } 
-       return false;
-     }
-     
-     ~time_push();
-     
-     
-     void leave(bool notify);
-     
-   private:
-     boost::unique_lock<boost::timed_mutex> m_mutex;
-     boost::condition& m_not_full;
-     boost::condition& m_not_empty;
-     bool m_release;
-   };
-   
-   struct pop_op
-   {
-     
-     template<typename F>
-     pop_op(boost::timed_mutex& m, boost::condition& nf, boost::condition& ne, F condition) : 
-                                           m_mutex(m), m_not_full(nf), m_not_empty(ne)
-     {
-      m_not_empty.wait(m_mutex, condition);
+         details::waiting count(m_waiters);
+         m_cond.wait(lock, ready);
+       }
      }
      
-     ~pop_op();
-     
-   private:
-     boost::unique_lock<boost::timed_mutex> m_mutex;
-     boost::condition& m_not_full;
-     boost::condition& m_not_empty;
-   };
-   
-   struct time_pop
-   {
-     time_pop(boost::timed_mutex& m, boost::condition& nf, boost::condition& ne); 
-                                           
-    
+     // @return false if the timeout passed while the side was not ready
      template<typename TO, typename F>
-     bool enter(const TO& timeout, F condition)
+     bool timed_wait(boost::unique_lock<boost::mutex>& lock, const TO& timeout, F ready)
      {
-       
-       if (m_mutex.timed_lock(timeout))
+       if (ready())
        {
-       
-         m_release = true;
-         if (m_not_empty.timed_wait(m_mutex, timeout, condition))
-         { 
-         
-           return true;
-         }
+         return true;
        }
-       return false;
+       details::waiting count(m_waiters);
+       return m_cond.timed_wait(lock, timeout, ready);
      }
      
-     void leave(bool notify);
+     // this is called by the other side (without its lock) after it made this side ready
+     // for count threads - it would do nothing if no thread is waiting
+     void notify(std::size_t count);
+     
+     boost::mutex m_mutex;
      
-     ~time_pop();
-       
    private:
-     boost::unique_lock<boost::timed_mutex> m_mutex;
-     boost::condition& m_not_full;
-     boost::condition& m_not_empty;
-     bool m_release;
+     boost::condition_variable m_cond;
+     boost::detail::atomic_count m_waiters;
    };
    
      ///////////////////////////////////////
    
 protected:
-   std::size_t m_unread;
-   boost::timed_mutex m_mutex;
-   boost::condition m_not_empty;
-   boost::condition m_not_full;
+   boost::detail::atomic_count m_unread;
+   side m_head;    // the consumers are waiting here while the queue is empty
+   side m_tail;    // the producers are waiting here while the queue is full
 };
   
 template <class T>
 class message_queue : protected message_queue_base
 {
   typedef message_queue_base base_type;
+  typedef message_queue<T>   this_type;
 public:
-  typedef boost::circular_buffer<T> container_type;
+  typedef std::vector<T> container_type;
   typedef typename container_type::size_type size_type;
   typedef typename container_type::value_type value_type;
   typedef typename boost::call_traits<value_type>::param_type param_type;
 
+   using base_type::size;   // the number of items that can be poped now
 
    /**
     * constructor for the class accept the size
     * @param size the max elements that can be inserted into the buffer
     */
-   explicit message_queue(size_type capacity) : m_container(capacity)
+   explicit message_queue(size_type capacity) : m_container(capacity), m_read(0), m_write(0)
    {
    }
 
@@ -190,32 +137,32 @@ public:
     */
    void push_front(const value_type& item) 
    {
-      // param_type represents the "best" way to pass a parameter of type value_type to a method
-      //boost::mutex::scoped_lock lock(m_mutex, boost::try_to_lock_t());
-      base_type::push_op guard(base_type::m_mutex, base_type::m_not_full, base_type::m_not_empty, 
-                               boost::bind(&message_queue<value_type>::is_not_full, this)); 
-      m_container.push_front(item);
-      ++base_type::m_unread;
+     {
+       boost::unique_lock<boost::mutex> lock(base_type::m_tail.m_mutex);
+       base_type::m_tail.wait(lock, boost::bind(&this_type::is_not_full, this));
+       put(item);
+     }
+     base_type::m_head.notify(1);
    }
    
    /**
     * @function try_push
-    * @brief try to add new element to the queue - if not locked (otherwise same as push_front)
+    * @brief try to add new element to the queue - if not full (otherwise same as push_front)
     * @param item which is the new item to add to the queue
     * @return true if item added else return false
     */
    bool try_push(const value_type& item)
    {
-     // only if we can access the lock here we would try and push new item inside
-     if (this->is_not_full())  // this call is thread safe..
      {
-       this->push_front(item);
-       return true;
-     }
-     else
-     {
-       return false;
+       boost::unique_lock<boost::mutex> lock(base_type::m_tail.m_mutex);
+       if (!is_not_full())
+       {
+         return false;
+       }
+       put(item);
      }
+     base_type::m_head.notify(1);
+     return true;
    }
    
    /**
@@ -227,20 +174,7 @@ public:
     */
    bool try_push(const value_type& item, const boost::posix_time::time_duration & timeout)
    {
-     base_type::time_push guard(base_type::m_mutex, base_type::m_not_full, base_type::m_not_empty);
-     
-     if (guard.enter(timeout, boost::bind(&message_queue<value_type>::is_not_full, this)))
-     {
-         m_container.push_front(item);
-         ++m_unread;
-         guard.leave(true);
-         return true;
-     }
-     else
-     {
-       guard.leave(false);
-       return false;
-     }
+     return timed_push(item, timeout);
    }
 
    /**
@@ -252,20 +186,7 @@ public:
     */
    bool try_push(const value_type& item, const boost::system_time & timeout)
    {
-     base_type::time_push guard(base_type::m_mutex, base_type::m_not_full, base_type::m_not_empty);
-     
-     if (guard.enter(timeout, boost::bind(&message_queue<value_type>::is_not_full, this)))
-     {
-         m_container.push_front(item);
-         ++base_type::m_unread;
-         guard.leave(true);
-         return true;
-     }
-     else
-     {
-       guard.leave(false);
-       return false;
-     }
+     return timed_push(item, timeout);
    }
    /**
     * @function pop_back
@@ -274,10 +195,12 @@ public:
     */
    void pop_back(value_type* item) 
    {
-      //boost::mutex::scoped_lock lock(m_mutex, boost::try_to_lock_t());
-      base_type::pop_op guard(base_type::m_mutex, base_type::m_not_full, base_type::m_not_empty,
-                              boost::bind(&base_type::is_not_empty, this));
-      *item = m_container[--base_type::m_unread];
+     {
+       boost::unique_lock<boost::mutex> lock(base_type::m_head.m_mutex);
+       base_type::m_head.wait(lock, boost::bind(&base_type::is_not_empty, static_cast<const base_type*>(this)));
+       take(item);
+     }
+     base_type::m_tail.notify(1);
    }
 
    /**
@@ -288,15 +211,16 @@ public:
     */
    bool try_pop(value_type* item) 
    {
-     if (this->is_not_empty())
      {
-       this->pop_back(item);
-       return true;
-     }
-     else
-     {
-       return false;
+       boost::unique_lock<boost::mutex> lock(base_type::m_head.m_mutex);
+       if (!base_type::is_not_empty())
+       {
+         return false;
+       }
+       take(item);
      }
+     base_type::m_tail.notify(1);
+     return true;
    }
 
    /**
@@ -308,19 +232,7 @@ public:
     */
    bool try_pop(value_type* item, const boost::posix_time::time_duration& timeout) 
    {
-     base_type::time_pop guard(base_type::m_mutex, base_type::m_not_full, base_type::m_not_empty);
-     
-     if (guard.enter(timeout, timeout, boost::bind(&base_type::is_not_empty, this)))
-     {
-       *item = m_container[--base_type::m_unread];
-       guard.leave(true);
-       return true;
-     }
-     else
-     {
-       guard.leave(false);
-       return false;
-     }
+     return timed_pop(item, timeout);
    }
    
    /**
@@ -332,19 +244,7 @@ public:
     */
    bool try_pop(value_type* item, const boost::system_time& timeout) 
    {
-     base_type::time_pop guard(base_type::m_mutex, base_type::m_not_full, base_type::m_not_empty);
-     
-     if (guard.enter(timeout, boost::bind(&base_type::is_not_empty, this)))
-     {
-       *item = m_container[--base_type::m_unread];
-       guard.leave(true);
-       return true;
-     }
-     else
-     {
-       guard.leave(false);
-       return false;
-     }
+     return timed_pop(item, timeout);
    }
    
 private:
@@ -354,10 +254,61 @@ private:
    
    bool is_not_full() const 
    { 
-     return m_unread < m_container.capacity(); 
+     return base_type::size() < m_container.size(); 
+   }
+   
+   // the producer write the item and only then count it, so the consumers would not see it before
+   // that, and the consumer count it out only after it read it, so it would not be overwritten.
+   // The slot is cleared once the item was read, so it would not hold on the resources of
+   // the item until it is reused
+   void put(const value_type& item)
+   {
+     m_container[m_write++ % m_container.size()] = item;
+     ++base_type::m_unread;
+   }
+   
+   void take(value_type* item)
+   {
+     value_type& slot = m_container[m_read++ % m_container.size()];
+     *item = slot;
+     slot = value_type();
+     --base_type::m_unread;
+   }
+   
+   template<typename TO>
+   bool timed_push(const value_type& item, const TO& timeout)
+   {
+     {
+       boost::unique_lock<boost::mutex> lock(base_type::m_tail.m_mutex);
+       if (!base_type::m_tail.timed_wait(lock, timeout, boost::bind(&this_type::is_not_full, this)))
+       {
+         return false;
+       }
+       put(item);
+     }
+     base_type::m_head.notify(1);
+     return true;
+   }
+   
+   template<typename TO>
+   bool timed_pop(value_type* item, const TO& timeout)
+   {
+     {
+       boost::unique_lock<boost::mutex> lock(base_type::m_head.m_mutex);
+       if (!base_type::m_head.timed_wait(lock, timeout, 
+                                         boost::bind(&base_type::is_not_empty, static_cast<const base_type*>(this))))
+       {
+         return false;
+       }
+       take(item);
+     }
+     base_type::m_tail.notify(1);
+     return true;
    }
 
-   container_type m_container;
+   container_type m_container;   // the items are placed in a ring - m_write is only used by the producers
+   size_type m_read;             // and m_read only by the consumers
+   size_type m_write;
 };
 
 /**
@@ -366,46 +317,60 @@ private:
  * this is an optimized version that would make sure that we are not just using 
  * allocated memory on the fly - it would allow for better interation with C lagacy code
  * we would only be using char* as opaque data and the size to save to the message queue 
+ * This queue has two lanes - urgent items are always read before the normal ones, unless
+ * the normal lane was waiting for more than max_urgent_burst urgent reads, in which case one
+ * normal item is read (so that normal items would not starve). Both lanes share the capacity
+ * The items are stored in slots of fixed size (max message size) that are allocated once
+ * when the queue is created, so pushing an item is a single copy into its slot, and poping it
+ * is a single copy out of it. To save these copies as well, the producer can build the item
+ * directly inside the slot, and the consumer can use it from there -
+ *
+ *   char* slot = queue.reserve(size);   // block while the queue is full
+ *   // write up to max_message_size() bytes into slot
+ *   queue.commit(slot, size);           // from now readers can take it
+ *
+ *   details::mq_data::data_type item = queue.peek();  // block while the queue is empty
+ *   // use item.first bytes at item.second
+ *   queue.release(item.second);         // from now the slot can be reused
+ *
+ * The items are read in the order that their slots were reserved, so an item that was committed
+ * would not be read before the items that were reserved before it are committed. In the same way
+ * the room of an item that was released is only reused after the items before it were released.
  */
 template<>
 class message_queue<details::mq_data> : public message_queue_base
 {
   typedef message_queue_base base_type;
 public:
-    typedef boost::circular_buffer<details::mq_data> container_type;
-    typedef  container_type::size_type size_type;
-    typedef container_type::value_type value_type;
+    typedef std::size_t size_type;
+    typedef details::mq_data value_type;
     typedef  message_queue<details::mq_data>  this_type;
 
    /**
     * constructor for the class accept the size
     * @param size the max elements that can be inserted into the buffer
+    * @param maxMessageSize the max size of each element (this is the size of each slot)
     */
    explicit message_queue(size_type capacity, size_type maxMessageSize);
    
    ~message_queue();
-   /*{
-     while (!m_container.empty())
-     {
-       m_container.pop_front(); // just remove all the variable from here so that they would be destructed
-     }
-   }*/
    
    /**
     * @function push_front
     * @brief add new element to the buffer
     * @param item the new item to add. Note that if the queue is full this would blocked the calling thread
+    * @param urgent whether to place the item in the urgent lane
     */
-   void push_front(const char* item, std::size_t size);
+   void push_front(const char* item, std::size_t size, bool urgent = false);
   
    
    /**
     * @function try_push
-    * @brief try to add new element to the queue - if not locked (otherwise same as push_front)
+    * @brief try to add new element to the queue - if not full (otherwise same as push_front)
     * @param item which is the new item to add to the queue
     * @return true if item added else return false
     */
-   bool try_push(const char* item, std::size_t size);
+   bool try_push(const char* item, std::size_t size, bool urgent = false);
    
    /**
     * @function try_push
@@ -414,7 +379,8 @@ public:
     * @param timeout the timeout value (duration) that we would wait for, if passed we would return false
     * @return true if item added, else return false
     */
-   bool try_push(const char* item, std::size_t size, const boost::posix_time::time_duration & timeout);
+   bool try_push(const char* item, std::size_t size, const boost::posix_time::time_duration & timeout,
+                 bool urgent = false);
 
    /**
     * @function try_push
@@ -423,7 +389,7 @@ public:
     * @param timeout the timeout value (absolute) that we would wait for, if passed we would return false
     * @return true if item added, else return false
     */
-   bool try_push(const char* item, std::size_t size, const boost::system_time & timeout);
+   bool try_push(const char* item, std::size_t size, const boost::system_time & timeout, bool urgent = false);
    /**
     * @function pop_back
     * @brief get the upper most (oldest) element in the buffer
@@ -457,18 +423,190 @@ public:
     */
    bool try_pop(char* item, std::size_t& size, const boost::system_time& timeout);
    
+   /**
+    * @function push_batch
+    * @brief add few elements to the buffer with a single lock
+    * this would block the calling thread if the queue is full, and once there is room 
+    * it would add as many of the items as can fit into the queue
+    * @param items the new items to add
+    * @param sizes the size of each of the items
+    * @param count the number of items
+    * @return the number of items (from the start of items) that were added
+    */
+   std::size_t push_batch(const char* const items[], const unsigned int sizes[], std::size_t count);
+   
+   /**
+    * @function pop_batch
+    * @brief get the oldest elements in the buffer with a single lock
+    * @param items buffer to which the data would be stored, element i is stored at items + i * stride
+    * @param stride the max size of each element in items
+    * @param sizes if not NULL, the size of each element would be stored here
+    * @param max_count the max number of elements to get
+    * @param timeout reletive time out value to wait if the queue is empty
+    * @return the number of elements that were poped (0 if timedout)
+    */
+   std::size_t pop_batch(char* items, std::size_t stride, unsigned int sizes[], std::size_t max_count,
+                         const boost::posix_time::time_duration& timeout);
+   
+   /**
+    * @function reserve
+    * @brief take the next free slot so the item can be written directly into it (see above)
+    * This would block the calling thread if the queue is full. The item is not seen by the readers
+    * until commit is called with the slot
+    * @param size the size of the item that would be written (only used to verify that it fit into the slot)
+    * @param urgent whether the item would be placed in the urgent lane
+    * @return the slot to write max_message_size() bytes into, or NULL if size is larger than that
+    */
+   char* reserve(std::size_t size, bool urgent = false);
+   
+   /**
+    * @function try_reserve
+    * @brief the same as reserve, only that this would wait up to the timeout for a free slot
+    * @param timeout reletive time out value to wait if the queue is full
+    * @return the slot or NULL if the timeout passed
+    */
+   char* try_reserve(std::size_t size, const boost::posix_time::time_duration& timeout, bool urgent = false);
+   
+   /**
+    * @function commit
+    * @brief allow the readers to take an item that was written into a slot that was reserved
+    * @param slot the value that reserve returned
+    * @param size the size of the item that was written into the slot
+    */
+   void commit(char* slot, std::size_t size);
+   
+   /**
+    * @function peek
+    * @brief take the oldest element in the buffer without copying it (see above)
+    * This would block the calling thread if the queue is empty. The slot of the item would not
+    * be reused until release is called for it
+    * @return the size of the item and its data
+    */
+   details::mq_data::data_type peek();
+   
+   /**
+    * @function try_peek
+    * @brief the same as peek, only that this would wait up to the timeout for an item
+    * @param timeout reletive time out value to wait if the queue is empty
+    * @return the size of the item and its data, the data is NULL if the timeout passed
+    */
+   details::mq_data::data_type try_peek(const boost::posix_time::time_duration& timeout);
+   
+   /**
+    * @function release
+    * @brief return the slot of an item that was taken with peek so it can be reused
+    * @param slot the data that peek returned
+    */
+   void release(const char* slot);
+   
+   size_type max_message_size() const
+   {
+     return m_messageSize;
+   }
+   
+   /**
+    * @struct lanes_info
+    * @brief the state of the lanes - note that this is a snapshot that is not taken under the locks
+    */
+   struct lanes_info
+   {
+     std::size_t normal;     // items waiting in the normal lane
+     std::size_t urgent;     // items waiting in the urgent lane
+     std::size_t overtaken;  // times an urgent item was read while normal items were waiting
+     std::size_t forced;     // times a normal item was read before urgent ones so it would not starve
+   };
+   
+   lanes_info lanes() const;
+   
+   // the number of urgent items that can be read in a row while normal items are waiting
+   static const std::size_t max_urgent_burst = 32;
+   
 private:
    message_queue(const message_queue&);              // Disabled copy constructor
    message_queue& operator = (const message_queue&); // Disabled assign operator
 
+   enum lane_index
+   {
+     normal_lane = 0,
+     urgent_lane,
+     lanes_count
+   };
+   
+   enum slot_state
+   {
+     slot_free = 0,
+     slot_reserved,  // a writer is filling it
+     slot_ready,     // waiting to be read
+     slot_reading    // a reader took it with peek
+   };
+   
+   // the positions of each lane - these are always growing, the slot is the position modulo the capacity
+   // the slots in [free, read) are being read, the slots in [read, ready) are ready and the slots in
+   // [ready, write) are reserved (or were committed while slots before them are still reserved).
+   // free and read are only used by the consumers (under the head lock) and ready and write only 
+   // by the producers (under the tail lock) - the two sides only learn about each other from the counters
+   struct lane
+   {
+     size_type free;
+     size_type read;
+     size_type ready;
+     size_type write;
+   };
    
    bool is_not_full() const 
    { 
-     return m_unread < m_container.capacity(); 
+     return static_cast<size_type>(static_cast<long>(m_used)) < m_capacity; 
+   }
+   
+   // place the item in its lane, must be called under the tail lock when the queue is not full
+   // @return the number of items that became ready to be read
+   size_type push_item(const char* item, std::size_t size, bool urgent);
+   
+   // copy the next item into item, must be called under the head lock when the queue is not empty
+   // @return the size that was copied, freed is increased by the number of slots that can be reused now
+   std::size_t pop_item(char* item, std::size_t size, size_type& freed);
+   
+   // the slots themselves - reserve and commit must be called under the tail lock, take and free
+   // under the head lock
+   // @return the index of the slot (in the arena) that was reserved, the queue must not be full
+   size_type reserve_slot(bool urgent);
+   
+   // @return the number of items that became ready to be read
+   size_type commit_slot(size_type index, std::size_t size);
+   
+   // @return the index of the slot that hold the next item, the queue must not be empty
+   size_type take_slot();
+   
+   // @return the number of slots that can be reused now
+   size_type free_slot(size_type index);
+   
+   size_type index_of(const char* slot) const;
+   
+   char* slot_at(size_type index) const
+   {
+     return m_arena + index * m_stride;
+   }
+   
+   bool take_urgent();
+   
+   boost::detail::atomic_count& unread(std::size_t at)
+   {
+     return at == urgent_lane ? m_urgentUnread : m_normalUnread;
    }
    
-   container_type m_container;
+   char*          m_arena;        // all the slots of the normal lane and then all the slots of the urgent lane
+   std::vector<unsigned char> m_states;
+   std::vector<size_type>     m_sizes;
+   lane           m_lanes[lanes_count];
+   size_type      m_capacity;
    size_type      m_messageSize;
+   size_type      m_stride;
+   boost::detail::atomic_count m_used;           // slots that cannot be reserved (in both lanes)
+   boost::detail::atomic_count m_normalUnread;   // the items that are ready in each lane (m_unread is the sum)
+   boost::detail::atomic_count m_urgentUnread;
+   size_type      m_burst;        // urgent items that were read in a row while normal items were waiting
+   size_type      m_overtaken;
+   size_type      m_forced;
 };
 
 typedef message_queue<details::mq_data> opaque_message_queue; // just to make the use of the above queue easier
@@ -11,212 +11,402 @@ namespace boost
     
   }
   
-  message_queue_base::push_op::~push_op()
+  message_queue_base::side::side() : m_waiters(0)
   {
-    m_mutex.unlock();
-    m_not_empty.notify_one();
+    
   }
   
-  message_queue_base::time_push::time_push(boost::timed_mutex& m, boost::condition& nf, boost::condition& ne) :
-    m_mutex(m, boost::defer_lock_t()), m_not_full(nf), m_not_empty(ne), m_release(false)
-  {
-  }
-  message_queue_base::time_push::~time_push()
+  void message_queue_base::side::notify(std::size_t count)
   {
-    if (m_release)
+    if (count == 0 || m_waiters == 0)
     {
-      m_mutex.unlock();
+      return;   // this is the common case - no need to touch the lock of the other side
     }
-  }
-  
-  void message_queue_base::time_push::leave(bool notify)
-  {
-    if (m_release)
     {
-      m_mutex.unlock();
-      m_release = false;
+      // a waiter that already counted itself may not be waiting on the condition yet, once we
+      // have the lock it is either waiting or would see the change when it check the condition
+      boost::lock_guard<boost::mutex> lock(m_mutex);
     }
-    if (notify)
+    if (count > 1)
     {
-       m_not_empty.notify_one();
+      m_cond.notify_all();
     }
-  }
-  
-  message_queue_base::pop_op::~pop_op()
-  {
-    m_mutex.unlock();
-    m_not_full.notify_one();    
-  }
-  
-  message_queue_base::time_pop::time_pop(boost::timed_mutex& m, boost::condition& nf, boost::condition& ne) :
-                                               m_mutex(m, boost::defer_lock_t()), 
-                                               m_not_full(nf), m_not_empty(ne), m_release(false)
-  {
-  }
-  
-  message_queue_base::time_pop::~time_pop()
-  {
-    if (m_release)
+    else
     {
-      m_mutex.unlock();
-    }    
+      m_cond.notify_one();
+    }
   }
+///////////////////////////////////////////////////////////////////////////////
   
-  void message_queue_base::time_pop::leave(bool notify)
+  namespace
   {
-    if (m_release)
+    // each slot start on its own cache line, so writers that are filling slots next to each other
+    // would not disturb each other
+    const std::size_t slot_alignment = 64;
+    
+    std::size_t slot_stride(std::size_t maxMessageSize)
     {
-      m_mutex.unlock();
-      m_release = false;
+      const std::size_t size = maxMessageSize > 0 ? maxMessageSize : 1;
+      return ((size + slot_alignment - 1) / slot_alignment) * slot_alignment;
     }
-    if (notify)
-    {
-      m_not_full.notify_one();
-    }    
-  }
-///////////////////////////////////////////////////////////////////////////////
+  } // end of local namespace
   
   //template<>
   message_queue<details::mq_data>::message_queue(size_type capacity, size_type maxMessageSize) :  
-                    m_container(capacity), m_messageSize(maxMessageSize)
+                    m_arena(new char[lanes_count * capacity * slot_stride(maxMessageSize)]),
+                    m_states(lanes_count * capacity, slot_free), m_sizes(lanes_count * capacity, 0),
+                    m_capacity(capacity), m_messageSize(maxMessageSize), m_stride(slot_stride(maxMessageSize)),
+                    m_used(0), m_normalUnread(0), m_urgentUnread(0), m_burst(0), m_overtaken(0), m_forced(0)
   { 
+    for (std::size_t i = 0; i < lanes_count; i++)
+    {
+      lane empty = { 0, 0, 0, 0 };
+      m_lanes[i] = empty;
+    }
   }
   
   message_queue<details::mq_data>::~message_queue()
   {
-    m_mutex.lock();
-    for (container_type::iterator i = m_container.begin(); i != m_container.end(); i++)
-    {
-      i->release();
-    }
-    m_mutex.unlock();
-    //m_not_full.notify_all();
-    //m_not_empty.notify_all();
-    
+    delete [] m_arena;
   }
   
-   void message_queue<details::mq_data>::push_front(const char* item, std::size_t size) 
+   message_queue<details::mq_data>::size_type message_queue<details::mq_data>::reserve_slot(bool urgent)
    {
-      // param_type represents the "best" way to pass a parameter of type value_type to a method
-      //boost::mutex::scoped_lock lock(m_mutex, boost::try_to_lock_t());
-      base_type::push_op guard(base_type::m_mutex, base_type::m_not_full, base_type::m_not_empty, 
-                               boost::bind(&this_type::is_not_full, this)); 
-      
-      m_container.push_front(details::mq_data_proxy(m_messageSize, item, size));
-      ++base_type::m_unread;
+     const std::size_t at = urgent ? urgent_lane : normal_lane;
+     const size_type index = at * m_capacity + m_lanes[at].write++ % m_capacity;
+     m_states[index] = slot_reserved;
+     ++m_used;
+     return index;
    }
    
+   message_queue<details::mq_data>::size_type message_queue<details::mq_data>::commit_slot(size_type index, 
+                                                                                            std::size_t size)
+   {
+     m_states[index] = slot_ready;
+     m_sizes[index] = size;
+     // the items are read in the order they were reserved, so this may not be the next one
+     const std::size_t at = index / m_capacity;
+     lane& l = m_lanes[at];
+     size_type count = 0;
+     while (l.ready != l.write && m_states[at * m_capacity + l.ready % m_capacity] == slot_ready)
+     {
+       ++l.ready;
+       ++count;
+       // the lane is counted first, so a consumer that see the item in m_unread would find it in its lane
+       ++unread(at);
+       ++base_type::m_unread;
+     }
+     return count;
+   }
    
-   bool message_queue<details::mq_data>::try_push(const char* item, std::size_t size)
+   message_queue<details::mq_data>::size_type message_queue<details::mq_data>::take_slot()
    {
-     // only if we can access the lock here we would try and push new item inside
-     if (this->is_not_full())  // this call is thread safe..
+     const std::size_t at = take_urgent() ? urgent_lane : normal_lane;
+     const size_type index = at * m_capacity + m_lanes[at].read++ % m_capacity;
+     m_states[index] = slot_reading;
+     --unread(at);
+     --base_type::m_unread;
+     return index;
+   }
+   
+   message_queue<details::mq_data>::size_type message_queue<details::mq_data>::free_slot(size_type index)
+   {
+     m_states[index] = slot_free;
+     // the slots are reused in order, so this may not be the next one
+     const std::size_t at = index / m_capacity;
+     lane& l = m_lanes[at];
+     size_type count = 0;
+     while (l.free != l.read && m_states[at * m_capacity + l.free % m_capacity] == slot_free)
      {
-       this->push_front(item, size);
+       ++l.free;
+       ++count;
+       --m_used;    // from now a producer may reuse the slot
+     }
+     return count;
+   }
+   
+   message_queue<details::mq_data>::size_type message_queue<details::mq_data>::index_of(const char* slot) const
+   {
+     return static_cast<size_type>(slot - m_arena) / m_stride;
+   }
+   
+   message_queue<details::mq_data>::size_type message_queue<details::mq_data>::push_item(const char* item, 
+                                                                                          std::size_t size, 
+                                                                                          bool urgent)
+   {
+     const size_type index = reserve_slot(urgent);
+     size = std::min(size, m_messageSize); // make sure that we didn't overflow
+     std::copy(item, item + size, slot_at(index));
+     return commit_slot(index, size);
+   }
+   
+   bool message_queue<details::mq_data>::take_urgent()
+   {
+     if (m_urgentUnread == 0)
+     {
+       return false;
+     }
+     if (m_normalUnread == 0)
+     {
+       m_burst = 0;    // no one is waiting for us
        return true;
      }
-     else
+     if (m_burst < max_urgent_burst)
      {
-       return false; 
+       ++m_burst;
+       ++m_overtaken;
+       return true;
      }
+     m_burst = 0;
+     ++m_forced;
+     return false;
    }
    
-   bool message_queue<details::mq_data>::try_push(const char* item, std::size_t size, const boost::posix_time::time_duration & timeout)
+   // the data must be copied before the slot is freed, since the producers are not using our lock
+   std::size_t message_queue<details::mq_data>::pop_item(char* item, std::size_t size, size_type& freed)
    {
-     base_type::time_push guard(base_type::m_mutex, base_type::m_not_full, base_type::m_not_empty);
-     
-     if (guard.enter(timeout, boost::bind(&this_type::is_not_full, this)))
+     const size_type index = take_slot();
+     size = std::min(m_sizes[index], size); // make sure that we didn't overflow
+     const char* data = slot_at(index);
+     std::copy(data, data + size, item);
+     freed += free_slot(index);
+     return size;
+   }
+   
+   message_queue<details::mq_data>::lanes_info message_queue<details::mq_data>::lanes() const
+   {
+     lanes_info info = { static_cast<std::size_t>(static_cast<long>(m_normalUnread)), 
+                         static_cast<std::size_t>(static_cast<long>(m_urgentUnread)), m_overtaken, m_forced };
+     return info;
+   }
+   
+   void message_queue<details::mq_data>::push_front(const char* item, std::size_t size, bool urgent) 
+   {
+     size_type ready = 0;
      {
-         m_container.push_front(details::mq_data_proxy(m_messageSize, item, size));
-         ++m_unread;
-         guard.leave(true);
-         return true;
+       boost::unique_lock<boost::mutex> lock(base_type::m_tail.m_mutex);
+       base_type::m_tail.wait(lock, boost::bind(&this_type::is_not_full, this));
+       ready = push_item(item, size, urgent);
      }
-     else
+     base_type::m_head.notify(ready);
+   }
+   
+   
+   bool message_queue<details::mq_data>::try_push(const char* item, std::size_t size, bool urgent)
+   {
+     size_type ready = 0;
      {
-       guard.leave(false);
-       return false;
+       boost::unique_lock<boost::mutex> lock(base_type::m_tail.m_mutex);
+       if (!is_not_full())
+       {
+         return false;
+       }
+       ready = push_item(item, size, urgent);
      }
+     base_type::m_head.notify(ready);
+     return true;
    }
    
-   
-   bool message_queue<details::mq_data>::try_push(const char* item, std::size_t size, const boost::system_time & timeout)
+   bool message_queue<details::mq_data>::try_push(const char* item, std::size_t size, const boost::posix_time::time_duration & timeout,
+                                                  bool urgent)
    {
-     base_type::time_push guard(base_type::m_mutex, base_type::m_not_full, base_type::m_not_empty);
-     
-     if (guard.enter(timeout, boost::bind(&this_type::is_not_full, this)))
+     size_type ready = 0;
      {
-         m_container.push_front(details::mq_data_proxy(m_messageSize, item, size));
-         ++base_type::m_unread;
-         guard.leave(true);
-         return true;
+       boost::unique_lock<boost::mutex> lock(base_type::m_tail.m_mutex);
+       if (!base_type::m_tail.timed_wait(lock, timeout, boost::bind(&this_type::is_not_full, this)))
+       {
+         return false;
+       }
+       ready = push_item(item, size, urgent);
      }
-     else
+     base_type::m_head.notify(ready);
+     return true;
+   }
+   
+   
+   bool message_queue<details::mq_data>::try_push(const char* item, std::size_t size, const boost::system_time & timeout,
+                                                  bool urgent)
+   {
+     size_type ready = 0;
      {
-       guard.leave(false);
-       return false;
+       boost::unique_lock<boost::mutex> lock(base_type::m_tail.m_mutex);
+       if (!base_type::m_tail.timed_wait(lock, timeout, boost::bind(&this_type::is_not_full, this)))
+       {
+         return false;
+       }
+       ready = push_item(item, size, urgent);
      }
+     base_type::m_head.notify(ready);
+     return true;
    }
    
    void message_queue<details::mq_data>::pop_back(char* item, std::size_t& size) 
    {
-      //boost::mutex::scoped_lock lock(m_mutex, boost::try_to_lock_t());
-      base_type::pop_op guard(base_type::m_mutex, base_type::m_not_full, base_type::m_not_empty,
-                              boost::bind(&base_type::is_not_empty, static_cast<const base_type*>(this)));
-      details::mq_data::data_type i = m_container[--base_type::m_unread].data();
-      size = std::min(i.first, size); // make sure that we didn't overflow
-      std::copy(i.second, i.second+size, item);
+     size_type freed = 0;
+     {
+       boost::unique_lock<boost::mutex> lock(base_type::m_head.m_mutex);
+       base_type::m_head.wait(lock, boost::bind(&base_type::is_not_empty, static_cast<const base_type*>(this)));
+       size = pop_item(item, size, freed);
+     }
+     base_type::m_tail.notify(freed);
    }
    
    
    bool message_queue<details::mq_data>::try_pop(char* item, std::size_t& size) 
    {
-     if (this->is_not_empty())
+     size_type freed = 0;
      {
-       this->pop_back(item, size);
-       return true;
+       boost::unique_lock<boost::mutex> lock(base_type::m_head.m_mutex);
+       if (!base_type::is_not_empty())
+       {
+         return false;
+       }
+       size = pop_item(item, size, freed);
      }
-     else
+     base_type::m_tail.notify(freed);
+     return true;
+   }
+   
+   bool message_queue<details::mq_data>::try_pop(char* item, std::size_t& size, const boost::posix_time::time_duration& timeout) 
+   {
+     size_type freed = 0;
      {
-       return false;
+       boost::unique_lock<boost::mutex> lock(base_type::m_head.m_mutex);
+       if (!base_type::m_head.timed_wait(lock, timeout, 
+                                         boost::bind(&base_type::is_not_empty, static_cast<const base_type*>(this))))
+       {
+         return false;
+       }
+       size = pop_item(item, size, freed);
      }
+     base_type::m_tail.notify(freed);
+     return true;
    }
    
-   bool message_queue<details::mq_data>::try_pop(char* item, std::size_t& size, const boost::posix_time::time_duration& timeout) 
+   
+   bool message_queue<details::mq_data>::try_pop(char* item, std::size_t& size, const boost::system_time& timeout)
    {
-     base_type::time_pop guard(base_type::m_mutex, base_type::m_not_full, base_type::m_not_empty);
-     
-     if (guard.enter(timeout, boost::bind(&base_type::is_not_empty, this)))
+     size_type freed = 0;
      {
-       details::mq_data::data_type i = m_container[--base_type::m_unread].data();
-       size = std::min(i.first, size); // make sure that we didn't overflow
-       std::copy(i.second, i.second+size, item);       
-       return true;
+       boost::unique_lock<boost::mutex> lock(base_type::m_head.m_mutex);
+       if (!base_type::m_head.timed_wait(lock, timeout, 
+                                         boost::bind(&base_type::is_not_empty, static_cast<const base_type*>(this))))
+       {
+         return false;
+       }
+       size = pop_item(item, size, freed);
      }
-     else
+     base_type::m_tail.notify(freed);
+     return true;
+   }
+   
+   std::size_t message_queue<details::mq_data>::push_batch(const char* const items[], const unsigned int sizes[], 
+                                                           std::size_t count)
+   {
+     std::size_t pushed = 0;
+     size_type ready = 0;
+     if (count > 0)
      {
-       guard.leave(false);
-       return false;
+       boost::unique_lock<boost::mutex> lock(base_type::m_tail.m_mutex);
+       base_type::m_tail.wait(lock, boost::bind(&this_type::is_not_full, this));
+       for (; pushed < count && is_not_full(); ++pushed)
+       {
+         ready += push_item(items[pushed], sizes[pushed], false);
+       }
      }
+     base_type::m_head.notify(ready);
+     return pushed;
    }
    
+   std::size_t message_queue<details::mq_data>::pop_batch(char* items, std::size_t stride, unsigned int sizes[], 
+                                                          std::size_t max_count,
+                                                          const boost::posix_time::time_duration& timeout)
+   {
+     std::size_t poped = 0;
+     size_type freed = 0;
+     if (max_count > 0)
+     {
+       boost::unique_lock<boost::mutex> lock(base_type::m_head.m_mutex);
+       if (base_type::m_head.timed_wait(lock, timeout, 
+                                        boost::bind(&base_type::is_not_empty, static_cast<const base_type*>(this))))
+       {
+         for (; poped < max_count && base_type::is_not_empty(); ++poped)
+         {
+           const std::size_t size = pop_item(items + poped * stride, stride, freed);
+           if (sizes)
+           {
+             sizes[poped] = static_cast<unsigned int>(size);
+           }
+         }
+       }
+     }
+     base_type::m_tail.notify(freed);
+     return poped;
+   }
    
-   bool message_queue<details::mq_data>::try_pop(char* item, std::size_t& size, const boost::system_time& timeout)
+   char* message_queue<details::mq_data>::reserve(std::size_t size, bool urgent)
    {
-     base_type::time_pop guard(base_type::m_mutex, base_type::m_not_full, base_type::m_not_empty);
-     
-     if (guard.enter(timeout, boost::bind(&base_type::is_not_empty, this)))
+     if (size > m_messageSize)
      {
-       details::mq_data::data_type i = m_container[--base_type::m_unread].data();
-       size = std::min(i.first, size); // make sure that we didn't overflow
-       std::copy(i.second, i.second+size, item);
-       guard.leave(true);
-       return true;
+       return 0;
+     }
+     boost::unique_lock<boost::mutex> lock(base_type::m_tail.m_mutex);
+     base_type::m_tail.wait(lock, boost::bind(&this_type::is_not_full, this));
+     return slot_at(reserve_slot(urgent));
+   }
+   
+   char* message_queue<details::mq_data>::try_reserve(std::size_t size, 
+                                                      const boost::posix_time::time_duration& timeout, bool urgent)
+   {
+     if (size > m_messageSize)
+     {
+       return 0;
+     }
+     boost::unique_lock<boost::mutex> lock(base_type::m_tail.m_mutex);
+     if (base_type::m_tail.timed_wait(lock, timeout, boost::bind(&this_type::is_not_full, this)))
+     {
+       return slot_at(reserve_slot(urgent));
      }
-     else
+     return 0;
+   }
+   
+   void message_queue<details::mq_data>::commit(char* slot, std::size_t size)
+   {
+     size_type ready = 0;
+     {
+       boost::unique_lock<boost::mutex> lock(base_type::m_tail.m_mutex);
+       ready = commit_slot(index_of(slot), std::min(size, m_messageSize));
+     }
+     base_type::m_head.notify(ready);
+   }
+   
+   details::mq_data::data_type message_queue<details::mq_data>::peek()
+   {
+     boost::unique_lock<boost::mutex> lock(base_type::m_head.m_mutex);
+     base_type::m_head.wait(lock, boost::bind(&base_type::is_not_empty, static_cast<const base_type*>(this)));
+     const size_type index = take_slot();
+     return details::mq_data::data_type(m_sizes[index], slot_at(index));
+   }
+   
+   details::mq_data::data_type message_queue<details::mq_data>::try_peek(const boost::posix_time::time_duration& timeout)
+   {
+     boost::unique_lock<boost::mutex> lock(base_type::m_head.m_mutex);
+     if (base_type::m_head.timed_wait(lock, timeout, 
+                                      boost::bind(&base_type::is_not_empty, static_cast<const base_type*>(this))))
+     {
+       const size_type index = take_slot();
+       return details::mq_data::data_type(m_sizes[index], slot_at(index));
+     }
+     return details::mq_data::data_type(0, static_cast<const char*>(0));
+   }
+   
+   void message_queue<details::mq_data>::release(const char* slot)
+   {
+     size_type freed = 0;
      {
-       guard.leave(false);
-       return -1;
+       boost::unique_lock<boost::mutex> lock(base_type::m_head.m_mutex);
+       freed = free_slot(index_of(slot));
      }
+     base_type::m_tail.notify(freed);
    }
 } // end of namespace boost
@@ -13,6 +13,8 @@
 #include <asynccallbacks/details/WorkingQueue.h>        // the "jobs" would be placed and read from here
 #include <asynccallbacks/details/WorkingQueueEntry.h>           // the items that we would execute
 #include <asynccallbacks/details/AsyncCallbackUtils.h>  // CriticalSection and Runner classes
+#include <asynccallbacks/Future.h>                      // the result of the calls
+#include <boost/function_types/result_type.hpp>         // the type of the result of the calls
 #include <boost/noncopyable.hpp>                        // to make this object none copyable
 #include <boost/shared_ptr.hpp>                         // smart pointer from boost
 
@@ -53,6 +55,14 @@ namespace details
     osal::milliseconds_t mMaxTimeHandling;
     WorkingQueueEntry    mItem;
   };
+
+  // the future that Call return for a member function
+  template<typename MF>
+  struct CallResult
+  {
+    typedef typename boost::function_types::result_type<MF>::type value_type;
+    typedef Future<value_type> type;
+  };
 } // end of namespace details
   
 /**
@@ -70,7 +80,6 @@ namespace details
 template<typename T>
 class Executer : boost::noncopyable
 {
-  typedef std::auto_ptr<WorkingQueueEntry>  WorkingQueueEntryAutoPtr;
   // This is the default "function" if we only want to run requests
   // from the queue. this is the default, if the user of this class
   // wants to do some internal work in the context of the thread
@@ -131,37 +140,38 @@ public:
   /**
    * register member function to be executed here
    * @param mem_fn a pointer to member function from class object_type that accept no paramters
-   * @return false if the member function start was not called yet!
+   * @return the future for the result of the member function (see Future.h), this is false
+   *         (not valid) if the member function start was not called yet!
    */
   template<typename MF>
-  bool Call(MF mem_fn);
+  typename details::CallResult<MF>::type Call(MF mem_fn);
   /**
    * register member function to be executed here
    * @param mem_fn a pointer to member function from class object_type that accept singel parameter
    * @param a the function parameter
-   * @return false if the member function start was not called yet!
+   * @return the future for the result of the member function, false if the member function start was not called yet!
    */
   template<typename MF, typename A>
-  bool Call(MF mem_fn, A a);
+  typename details::CallResult<MF>::type Call(MF mem_fn, A a);
   /**
    * register member function to be executed here
    * @param mem_fn a pointer to member function from class object_type that accept two parameters
    * @param a the function parameter
    * @param a2 the function parameter
-   * @return false if the member function start was not called yet!
+   * @return the future for the result of the member function, false if the member function start was not called yet!
    */
   template<typename MF, typename A, typename A2>
-  bool Call(MF mem_fn, A a, A2 a2);
+  typename details::CallResult<MF>::type Call(MF mem_fn, A a, A2 a2);
   /**
    * register member function to be executed here
    * @param mem_fn a pointer to member function from class object_type that accept 3 parameters
    * @param a the function parameter
    * @param a2 the function parameter
    * @param a3 the function parameter
-   * @return false if the member function start was not called yet!
+   * @return the future for the result of the member function, false if the member function start was not called yet!
    */
   template<typename MF, typename A, typename A2, typename A3>
-  bool Call(MF mem_fn, A a, A2 a2, A3 a3);
+  typename details::CallResult<MF>::type Call(MF mem_fn, A a, A2 a2, A3 a3);
   /**
    * register member function to be executed here
    * @param mem_fn a pointer to member function from class object_type that accept 4 parameters
@@ -169,10 +179,10 @@ public:
    * @param a2 the function parameter
    * @param a3 the function parameter
    * @param a4 the function parameter
-   * @return false if the member function start was not called yet!
+   * @return the future for the result of the member function, false if the member function start was not called yet!
    */
   template<typename MF, typename A, typename A2, typename A3, typename A4>
-  bool Call(MF mem_fn, A a, A2 a2, A3 a3, A4 a4);  
+  typename details::CallResult<MF>::type Call(MF mem_fn, A a, A2 a2, A3 a3, A4 a4);  
   /**
    * register member function to be executed here
    * @param mem_fn a pointer to member function from class object_type that accept 5 parameters
@@ -181,10 +191,10 @@ public:
    * @param a3 the function parameter
    * @param a4 the function parameter
    * @param a5 the function parameter
-   * @return false if the member function start was not called yet!
+   * @return the future for the result of the member function, false if the member function start was not called yet!
    */
   template<typename MF, typename A, typename A2, typename A3, typename A4, typename A5>
-  bool Call(MF mem_fn, A a, A2 a2, A3 a3, A4 a4, A5 a5);
+  typename details::CallResult<MF>::type Call(MF mem_fn, A a, A2 a2, A3 a3, A4 a4, A5 a5);
   /**
    * register member function to be executed here
    * @param mem_fn a pointer to member function from class object_type that accept 6 parameters
@@ -194,11 +204,11 @@ public:
    * @param a4 the function parameter
    * @param a5 the function parameter
    * @param a6 the function parameter
-   * @return false if the member function start was not called yet!
+   * @return the future for the result of the member function, false if the member function start was not called yet!
    */
   template<typename MF, typename A, typename A2, typename A3, typename A4, 
            typename A5, typename A6>
-  bool Call(MF mem_fn, A a, A2 a2, A3 a3, A4 a4, A5 a5, A6 a6);
+  typename details::CallResult<MF>::type Call(MF mem_fn, A a, A2 a2, A3 a3, A4 a4, A5 a5, A6 a6);
   
   /**
    * this function would allow to reset the timeout value to handle requests - note
@@ -216,13 +226,20 @@ private:
   // for differenet types and we don't want dependencies
   struct Runner
   {
-    static WorkingQueueEntry* mAction;
+    static const WorkingQueueEntry* mAction;
     static void Start();    
   };
   // this function is used so that we would stop the internal thread only
-  void StopFunction() const {}
-  // insert new functor into queue
-  void InsertJobIntoQueue(WorkingQueueEntryAutoPtr p);
+  // after it run everything that was placed in the queue before it
+  void StopFunction()
+  {
+    mLoopRunning = false;
+  }
+  // insert new functor into queue - the entry is copied into the queue
+  void InsertJobIntoQueue(const WorkingQueueEntry& entry);
+  // place the bound member function in a state that would hold its result
+  template<typename R, typename F>
+  Future<R> InsertCall(const F& func);
   // this function is called by the thread as the entry point
   // this is the function that is starting from the new thread created by member function Start
   // Read functors from the queue
@@ -234,9 +251,11 @@ private:
   T*                           mInstance;
   WorkingQueue                 mQueue;
   osal::Mutex::Id*             mGuard;
+  osal::Mutex::Id*             mCallGuard;     // a call is either placed before the stop request or not at all
   osal::EventNotification::Id* mThreadStarted;
   osal::EventNotification::Id* mThreadEnded;
   bool                         mStopThread;
+  bool                         mLoopRunning;   // only used by the internal thread
   osal::Thread::Id*            mWorkingThread;
   boost::shared_ptr<details::InternalWork> mRequestHandler;
 }; 
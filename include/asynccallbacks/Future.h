@@ -0,0 +1,299 @@
+#pragma once
+/**
+ * @file Future.h
+ *
+ * @brief holds the class Future that is returned from Executer::Call
+ *
+ * The future would have the return value of the member function once the thread of the Executer
+ * run it. So a class that need a result from an active object don't have to build its own
+ * handshake (an event and a place for the result) for it. For example -
+ *
+ *   class Calculator
+ *   {
+ *   public:
+ *     asynccallbacks::Future<int> Sum(int a, int b)
+ *     {
+ *       return mExecuter.Call(&Calculator::SumInternal, a, b);
+ *     }
+ *   private:
+ *     int SumInternal(int a, int b);
+ *     asynccallbacks::Executer<Calculator> mExecuter;
+ *   };
+ *
+ *   asynccallbacks::Future<int> result = calculator.Sum(1, 2);
+ *   // do something else
+ *   int value = result.Get();  // wait for it
+ *
+ * or if we don't want to wait more than 10 milliseconds -
+ *   int value = 0;
+ *   if (!result.TimedGet(value, 10)) ... // it is not ready yet
+ *
+ * If the member function throw an exception, Get would throw it in the thread that is calling it.
+ * The exception is copied with boost::current_exception, so it keeps its own type only if it was
+ * thrown with boost::enable_current_exception (or BOOST_THROW_EXCEPTION) -
+ *
+ *   throw boost::enable_current_exception(CalculatorError(...));
+ *
+ * otherwise a class derived from one of the standard exceptions is thrown as that standard
+ * exception (with the same what()), and any other type is thrown as boost::unknown_exception.
+ * A future that is not valid (false) is returned when the Executer was not started, in which
+ * case the function would not be called. Note that since the future convert to bool, code
+ * that used the bool that Call returned before is working without a change.
+ *
+ * Instead of waiting, an active object can ask that one of its own member functions would be
+ * called (in its own thread) with the future once the value is ready -
+ *
+ *   void Client::Start()
+ *   {
+ *     calculator.Sum(1, 2).Then(mExecuter, &Client::OnSum);
+ *   }
+ *
+ *   void Client::OnSum(asynccallbacks::Future<int> result)  // this run in the thread of the client
+ *   {
+ *     int value = result.Get();  // this would not block
+ *   }
+ *
+ * The state of the future (the value and the way to wait for it) is placed together with the call
+ * itself in a block that is taken from a pool, so getting a result would not allocate any memory
+ * more than what calling a function that do not return a value does.
+ */
+
+#include <asynccallbacks/details/FutureState.h>   // the state that is shared with the call
+#include <osal/OsalGeneralDefines.h>               // milliseconds type
+#include <utility>                                 // std::pair
+#include <assert.h>                                // assert macro
+
+namespace asynccallbacks
+{
+
+template<typename T> class Executer;
+
+template<typename R> class Future;
+
+namespace details
+{
+  // run the member function of the executer with the future once it is ready
+  template<typename R, typename E, typename MF>
+  struct ThenCall : Continuation
+  {
+    explicit ThenCall(const std::pair<Executer<E>*, MF>& target) : mOn(target.first), mMemFn(target.second)
+    {
+    }
+
+    void Run(FutureStateBase* state)
+    {
+      state->AddRef();  // this is the reference of the future that we are passing
+      mOn->Call(mMemFn, Future<R>(static_cast<FutureState<R>*>(state)));
+    }
+
+    Executer<E>* mOn;
+    MF mMemFn;
+  };
+
+  /**
+   * @class FutureBase
+   * @brief what is common to all the futures (with or without a value)
+   */
+  template<typename R>
+  class FutureBase
+  {
+    typedef void (FutureBase::*bool_type)() const;
+    void valid_future() const {}
+
+  public:
+    /**
+     * @return true if the call was placed in the queue (the Executer was started)
+     */
+    bool Valid() const
+    {
+      return mState != 0;
+    }
+
+    operator bool_type() const
+    {
+      return Valid() ? &FutureBase::valid_future : 0;
+    }
+
+    /**
+     * @return true if the value is set (or the call failed with exception), so Get would not block
+     */
+    bool IsReady() const
+    {
+      assert(mState);
+      return mState->IsReady();
+    }
+
+    /**
+     * wait for the value to be set without taking it
+     */
+    void Wait() const
+    {
+      assert(mState);
+      mState->Wait();
+    }
+
+    /**
+     * @param timeout the max time to wait
+     * @return false if the value was not set within the timeout
+     */
+    bool TimedWait(osal::milliseconds_t timeout) const
+    {
+      assert(mState);
+      return mState->TimedWait(timeout);
+    }
+
+    /**
+     * call a member function of the object of another executer with this future, once it is ready.
+     * The function would run in the thread of that executer (see above). If the future is already
+     * ready, the function is placed in its queue from this call.
+     * This can only be called once for the future (and all its copies)
+     * @param on the executer that would run the function
+     * @param mem_fn a member function of the class of on that accept the future (by value or by reference)
+     */
+    template<typename E, typename MF>
+    void Then(Executer<E>& on, MF mem_fn) const
+    {
+      assert(mState);
+      mState->template Then<ThenCall<R, E, MF> >(std::make_pair(&on, mem_fn));
+    }
+
+  protected:
+    typedef FutureState<R> state_type;
+
+    FutureBase() : mState(0)
+    {
+    }
+
+    // take the reference that the state already have for us
+    explicit FutureBase(state_type* state) : mState(state)
+    {
+    }
+
+    FutureBase(const FutureBase& other) : mState(other.mState)
+    {
+      if (mState)
+      {
+        mState->AddRef();
+      }
+    }
+
+    FutureBase& operator = (const FutureBase& other)
+    {
+      if (other.mState)
+      {
+        other.mState->AddRef();
+      }
+      if (mState)
+      {
+        mState->Release();
+      }
+      mState = other.mState;
+      return *this;
+    }
+
+    ~FutureBase()
+    {
+      if (mState)
+      {
+        mState->Release();
+      }
+    }
+
+    // wait for the state and throw the exception of the call if it had one
+    const state_type& Result() const
+    {
+      Wait();
+      mState->RethrowError();
+      return *mState;
+    }
+
+    state_type* mState;
+  };
+} // end of namespace details
+
+/**
+ * @class Future
+ * @brief the result of a call that was placed in the queue of an Executer (see above)
+ */
+template<typename R>
+class Future : public details::FutureBase<R>
+{
+  typedef details::FutureBase<R> base_type;
+
+public:
+  typedef R value_type;
+
+  Future()
+  {
+  }
+
+  explicit Future(typename base_type::state_type* state) : base_type(state)
+  {
+  }
+
+  /**
+   * wait for the value - if the call throw an exception it would be thrown from here
+   * @return the value that the member function returned
+   */
+  const R& Get() const
+  {
+    return this->Result().Value();
+  }
+
+  /**
+   * the same as Get, only that this would not wait more than the timeout
+   * @param value set to the value that the member function returned
+   * @param timeout the max time to wait
+   * @return false if the value was not set within the timeout
+   */
+  bool TimedGet(R& value, osal::milliseconds_t timeout) const
+  {
+    if (!this->TimedWait(timeout))
+    {
+      return false;
+    }
+    value = Get();
+    return true;
+  }
+};
+
+template<>
+class Future<void> : public details::FutureBase<void>
+{
+  typedef details::FutureBase<void> base_type;
+
+public:
+  typedef void value_type;
+
+  Future()
+  {
+  }
+
+  explicit Future(base_type::state_type* state) : base_type(state)
+  {
+  }
+
+  /**
+   * wait for the member function to finish - if it throw an exception it would be thrown from here
+   */
+  void Get() const
+  {
+    Result();
+  }
+
+  /**
+   * @param timeout the max time to wait
+   * @return false if the member function did not finish within the timeout
+   */
+  bool TimedGet(osal::milliseconds_t timeout) const
+  {
+    if (!TimedWait(timeout))
+    {
+      return false;
+    }
+    Get();
+    return true;
+  }
+};
+
+} // end of namespace asynccallbacks
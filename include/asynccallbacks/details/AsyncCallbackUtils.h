@@ -30,6 +30,13 @@ struct CriticalSection
   
   osal::Mutex::Id* mGuard;
 };
+
+  /**
+   * the mutex that all the executers are holding while their thread is starting,
+   * since the entry function of the thread is passed to it in a static member
+   * @return the same mutex for all the calls
+   */
+osal::Mutex::Id* ThreadStartGuard();
   
 
 
@@ -113,11 +113,12 @@ private:
   
 template<typename T>
 Executer<T>::Executer(T* thisPtr, unsigned int qLen) : mInstance(thisPtr), mQueue(qLen), 
-                                                       mGuard(0), mThreadStarted(0), mThreadEnded(0),
-                                                       mStopThread(true), mWorkingThread(0)
+                                                       mGuard(0), mCallGuard(0), mThreadStarted(0), mThreadEnded(0),
+                                                       mStopThread(true), mLoopRunning(false), mWorkingThread(0)
 {
 #if !defined(USE_SYNC_CALL_FOR_EXECUTER_OBJECT)
   mGuard = osal::Mutex::Create();
+  mCallGuard = osal::Mutex::Create();
   mThreadStarted = osal::EventNotification::Create();
   mThreadEnded = osal::EventNotification::Create();
 #endif  // USE_SYNC_CALL_FOR_EXECUTER_OBJECT
@@ -130,6 +131,7 @@ Executer<T>::~Executer()
   
 #if !defined(USE_SYNC_CALL_FOR_EXECUTER_OBJECT)
   osal::Mutex::Delete(mGuard);
+  osal::Mutex::Delete(mCallGuard);
   osal::EventNotification::Delete(mThreadStarted);
   osal::EventNotification::Delete(mThreadEnded);
 #endif // USE_SYNC_CALL_FOR_EXECUTER_OBJECT
@@ -139,8 +141,11 @@ template<typename T>
 void Executer<T>::StartThread(const char* name, osal::Thread::PriorityType prio)
 {
 #if !defined(USE_SYNC_CALL_FOR_EXECUTER_OBJECT)
-  std::auto_ptr<WorkingQueueEntry> item = MakeWorkingQueueEntry(&Executer<T>::MainLoop, this);
-  Runner::mAction = item.release();
+  // Runner::mAction is shared with the other executers of this type
+  utils::CriticalSection cs(utils::ThreadStartGuard());
+  WorkingQueueEntry item(boost::bind(&Executer<T>::MainLoop, this));
+  Runner::mAction = &item;
+  mLoopRunning = true;
  
   static const unsigned int MIN_STACK_SIZE = 1024*1024;
   unsigned int stackSize = mQueue.MaxSize()*10;
@@ -192,88 +197,85 @@ void Executer<T>::Start(const char* name, osal::Thread::PriorityType prio)
 template<typename T>
 void Executer<T>::Stop()
 {
-  mStopThread = true;
 #if !defined(USE_SYNC_CALL_FOR_EXECUTER_OBJECT)
   utils::CriticalSection cs(mGuard); // protect this function we my have multi thread access here
+  {
+    // InsertCall check the flag under the same guard, so no call would be placed after
+    // the stop request (no one would run it). We don't hold it while waiting for the
+    // thread, since the calls that are still in the queue may call this object
+    utils::CriticalSection callCs(mCallGuard);
+    mStopThread = true;
+    if (mWorkingThread)
+    {
+      mQueue.Push(WorkingQueueEntry(boost::bind(&Executer<T>::StopFunction, this)));
+    }
+  }
   if (mWorkingThread)
   {
-    WorkingQueueEntryAutoPtr p = MakeWorkingQueueEntry(&Executer<T>::StopFunction, this);
-    mQueue.Push(p.release());
     osal::EventNotification::Wait(mThreadEnded);
     osal::Thread::Clean(mWorkingThread);
     mWorkingThread = 0;
   }
+#else
+  mStopThread = true;
 #endif  // USE_SYNC_CALL_FOR_EXECUTER_OBJECT
 }
 
 template<typename T> template<typename MF>
-bool Executer<T>::Call(MF mem_fn)
+typename details::CallResult<MF>::type Executer<T>::Call(MF mem_fn)
 {
-  if (!mStopThread)
-  {
-    InsertJobIntoQueue(MakeWorkingQueueEntry(mem_fn, mInstance));
-  }
-  return !mStopThread;
+  return InsertCall<typename details::CallResult<MF>::value_type>(boost::bind(mem_fn, mInstance));
 }
 
 template<typename T> template<typename MF, typename A>
-bool Executer<T>::Call(MF mem_fn, A a)
+typename details::CallResult<MF>::type Executer<T>::Call(MF mem_fn, A a)
 {
-  if (!mStopThread)
-  {
-    InsertJobIntoQueue( MakeWorkingQueueEntry(mem_fn, mInstance, a));
-  }
-  return !mStopThread;
+  return InsertCall<typename details::CallResult<MF>::value_type>(boost::bind(mem_fn, mInstance, a));
 }
 
 template<typename T> template<typename MF, typename A, typename A2>
-bool Executer<T>::Call(MF mem_fn, A a, A2 a2)
+typename details::CallResult<MF>::type Executer<T>::Call(MF mem_fn, A a, A2 a2)
 {
-  if (!mStopThread)
-  {
-    InsertJobIntoQueue( MakeWorkingQueueEntry(mem_fn, mInstance, a, a2));
-  }
-  return !mStopThread;
+  return InsertCall<typename details::CallResult<MF>::value_type>(boost::bind(mem_fn, mInstance, a, a2));
 }
 
 template<typename T> template<typename MF, typename A, typename A2, typename A3>
-bool Executer<T>::Call(MF mem_fn, A a, A2 a2, A3 a3)
+typename details::CallResult<MF>::type Executer<T>::Call(MF mem_fn, A a, A2 a2, A3 a3)
 {
-  if (!mStopThread)
-  {
-    InsertJobIntoQueue( MakeWorkingQueueEntry(mem_fn, mInstance, a, a2, a3));
-  }
-  return !mStopThread;
+  return InsertCall<typename details::CallResult<MF>::value_type>(boost::bind(mem_fn, mInstance, a, a2, a3));
 }
 
 template<typename T> template<typename MF, typename A, typename A2, typename A3, typename A4>
-bool Executer<T>::Call(MF mem_fn, A a, A2 a2, A3 a3, A4 a4)
+typename details::CallResult<MF>::type Executer<T>::Call(MF mem_fn, A a, A2 a2, A3 a3, A4 a4)
 {
-  if (!mStopThread)
-  {
-    InsertJobIntoQueue(MakeWorkingQueueEntry(mem_fn, mInstance, a, a2, a3, a4));
-  }
-  return !mStopThread;
+  return InsertCall<typename details::CallResult<MF>::value_type>(boost::bind(mem_fn, mInstance, a, a2, a3, a4));
 }
 
 template<typename T> template<typename MF, typename A, typename A2, typename A3, typename A4, typename A5>
-bool Executer<T>::Call(MF mem_fn, A a, A2 a2, A3 a3, A4 a4, A5 a5)
+typename details::CallResult<MF>::type Executer<T>::Call(MF mem_fn, A a, A2 a2, A3 a3, A4 a4, A5 a5)
 {
-  if (!mStopThread)
-  {
-    InsertJobIntoQueue(MakeWorkingQueueEntry(mem_fn, mInstance, a, a2, a3, a4, a5));
-  }
-  return !mStopThread;
+  return InsertCall<typename details::CallResult<MF>::value_type>(boost::bind(mem_fn, mInstance, a, a2, a3, a4, a5));
 }
 
 template<typename T> template<typename MF, typename A, typename A2, typename A3, typename A4, typename A5, typename A6>
-bool Executer<T>::Call(MF mem_fn, A a, A2 a2, A3 a3, A4 a4, A5 a5, A6 a6)
+typename details::CallResult<MF>::type Executer<T>::Call(MF mem_fn, A a, A2 a2, A3 a3, A4 a4, A5 a5, A6 a6)
+{
+  return InsertCall<typename details::CallResult<MF>::value_type>(boost::bind(mem_fn, mInstance, a, a2, a3, a4, a5, a6));
+}
+
+template<typename T> template<typename R, typename F>
+Future<R> Executer<T>::InsertCall(const F& func)
 {
-  if (!mStopThread)
+#if !defined(USE_SYNC_CALL_FOR_EXECUTER_OBJECT)
+  utils::CriticalSection cs(mCallGuard); // so it would not be placed after the stop request
+#endif  // USE_SYNC_CALL_FOR_EXECUTER_OBJECT
+  if (mStopThread)
   {
-    InsertJobIntoQueue(MakeWorkingQueueEntry(mem_fn, mInstance, a, a2, a3, a4, a5, a6));
+    return Future<R>();
   }
-  return !mStopThread;
+  details::CallState<R, F>* state = details::CallState<R, F>::Create(func);
+  InsertJobIntoQueue(state->Entry());
+  return Future<R>(state);
 }
 
 // this function is called by the thread as the entry point
@@ -285,7 +287,9 @@ void Executer<T>::MainLoop()
 #if !defined(USE_SYNC_CALL_FOR_EXECUTER_OBJECT)
   osal::EventNotification::Signal(mThreadStarted);  // tell the main thread that we started
   
-  while (!mStopThread)
+  // we are not checking mStopThread here, so that everything that was placed in the
+  // queue before the stop request would run (and no one would block on a full queue)
+  while (mLoopRunning)
   {
     // extract item from the queue and execute them
     (*mRequestHandler)();
@@ -295,13 +299,13 @@ void Executer<T>::MainLoop()
 }
 
 template<typename T>
-void Executer<T>::InsertJobIntoQueue(WorkingQueueEntryAutoPtr p)
+void Executer<T>::InsertJobIntoQueue(const WorkingQueueEntry& entry)
 {
 #ifdef USE_SYNC_CALL_FOR_EXECUTER_OBJECT
 //#warning "compile without support for async operation"
-  (*p)(); // execute it here..
+  entry(); // execute it here..
 #else
-  mQueue.Push(p.release());
+  mQueue.Push(entry);
 #endif  // USE_SYNC_CALL_FOR_EXECUTER_OBJECT
 }
 
@@ -314,7 +318,9 @@ void Executer<T>::Runner::Start()
   {
     return;
   }
-  (*mAction)();
+  // the entry that was passed is gone once the thread has started
+  WorkingQueueEntry action(*mAction);
+  action();
 }
 
 template<typename T>
@@ -327,6 +333,6 @@ void Executer<T>::ResetQueueTimeout(osal::milliseconds_t timeout)
 }
 // must initialized the static member of runner here
 template<typename T>
-WorkingQueueEntry* Executer<T>::Runner::mAction = 0;
+const WorkingQueueEntry* Executer<T>::Runner::mAction = 0;
 
 } // namespace asyccallbacks
@@ -0,0 +1,221 @@
+#pragma once
+/**
+ * @file asynccallbacks/details/FutureState.h
+ *
+ * @brief the state that is shared between a Future and the call that would set its value
+ *
+ * The state of each call is allocated in a single block from a pool (see FutureState.cpp) and
+ * it hold everything that the call needs - the bound function and its parameters and the place
+ * for the result (the queue entry that would run it only hold a pointer to the state). So a call
+ * that return a value would not allocate anything (once the pool has blocks in it).
+ * IMPORTANT - this is for internal use only! (use Future.h)
+ */
+
+#include <asynccallbacks/details/WorkingQueueEntry.h>   // the entry that would run the call
+#include <osal/OsalGeneralDefines.h>                     // milliseconds type
+#include <boost/detail/atomic_count.hpp>                 // references count
+#include <boost/exception_ptr.hpp>                       // to pass the exception to the caller
+#include <boost/optional.hpp>                            // the place for the value
+#include <boost/static_assert.hpp>                       // the continuation must fit in the state
+#include <cstddef>                                       // size_t
+#include <new>                                           // placement new
+
+namespace osal { namespace EventNotification { struct Id; }}
+
+namespace asynccallbacks
+{
+
+namespace details
+{
+
+/**
+ * the memory for the states - blocks of up to POOLED_FUTURE_SIZE bytes are reused, larger ones
+ * are allocated every time. Each block come with its own event notification that is only created
+ * once for it
+ * @param size the size of the state that would be placed in the block
+ * @param event set to the event of the block
+ * @return the memory for the state
+ */
+void* AllocateFutureBlock(std::size_t size, osal::EventNotification::Id*& event);
+
+// return a block that was allocated with AllocateFutureBlock (the state was already destroyed)
+void FreeFutureBlock(void* memory);
+
+class FutureStateBase;
+
+// what to run once the value is set (see Future::Then) - this is placed inside the state
+struct Continuation
+{
+  virtual ~Continuation()
+  {
+  }
+
+  virtual void Run(FutureStateBase* state) = 0;
+};
+
+class FutureStateBase
+{
+public:
+  void AddRef();
+
+  // the last one to release the state would return it to the pool
+  void Release();
+
+  bool IsReady() const;
+
+  void Wait() const;
+
+  // @return false if the timeout passed before the value was set
+  bool TimedWait(osal::milliseconds_t timeout) const;
+
+  // throw the exception that the call had (if it had one), must be called once the state is ready
+  // (see Future.h for which types of exceptions are kept)
+  void RethrowError() const;
+
+  // run the call, this is called from the queue entry
+  virtual void Run() = 0;
+
+  // @return the entry that would run the call - it only hold a pointer to this state
+  WorkingQueueEntry Entry()
+  {
+    return WorkingQueueEntry(Runner(this));
+  }
+
+  /**
+   * place the continuation inside the state - this can be called only once
+   * @param C a type derived from Continuation that can be built from P
+   */
+  template<typename C, typename P>
+  void Then(const P& param)
+  {
+    BOOST_STATIC_ASSERT(sizeof(C) <= sizeof(mThenStorage));
+    mThen = new (&mThenStorage) C(param);
+    Continue();
+  }
+
+protected:
+  explicit FutureStateBase(osal::EventNotification::Id* event);
+
+  virtual ~FutureStateBase();
+
+  // mark the state as ready with the value that was already set
+  void Done();
+
+  // mark the state as ready with the exception that is handled now (must be called from catch)
+  void Failed();
+
+private:
+  FutureStateBase(const FutureStateBase&);
+  FutureStateBase& operator = (const FutureStateBase&);
+
+  // this is placed inside the entry, so it would not allocate memory for it
+  struct Runner
+  {
+    explicit Runner(FutureStateBase* state) : mState(state)
+    {
+    }
+
+    void operator () () const
+    {
+      mState->Run();
+    }
+
+    FutureStateBase* mState;
+  };
+
+  // run the continuation if it was set and the state is ready
+  void Continue();
+
+  osal::EventNotification::Id* mEvent;
+  boost::detail::atomic_count  mReferences;
+  boost::detail::atomic_count  mReady;
+  boost::detail::atomic_count  mPendingThen;  // both the value and the continuation must be set to run it
+  boost::exception_ptr         mError;
+  Continuation*                mThen;
+  union
+  {
+    char  mBytes[6 * sizeof(void*)];  // member function pointers can be up to 4 pointers in some compilers
+    void* mAlignPointer;
+    void (Continuation::*mAlignMember)(FutureStateBase*);
+  }                            mThenStorage;
+};
+
+template<typename R>
+class FutureState : public FutureStateBase
+{
+public:
+  const R& Value() const
+  {
+    return *mValue;
+  }
+
+protected:
+  explicit FutureState(osal::EventNotification::Id* event) : FutureStateBase(event)
+  {
+  }
+
+  template<typename F>
+  void Invoke(F& func)
+  {
+    mValue = func();
+  }
+
+private:
+  boost::optional<R> mValue;
+};
+
+template<>
+class FutureState<void> : public FutureStateBase
+{
+protected:
+  explicit FutureState(osal::EventNotification::Id* event) : FutureStateBase(event)
+  {
+  }
+
+  template<typename F>
+  void Invoke(F& func)
+  {
+    func();
+  }
+};
+
+// the state together with the call that would set its value
+template<typename R, typename F>
+class CallState : public FutureState<R>
+{
+public:
+  // @return new state with two references - one for the Future and one for the queue entry
+  static CallState* Create(const F& func)
+  {
+    osal::EventNotification::Id* event = 0;
+    void* memory = AllocateFutureBlock(sizeof(CallState), event);
+    return new (memory) CallState(event, func);
+  }
+
+private:
+  CallState(osal::EventNotification::Id* event, const F& func) : FutureState<R>(event), mFunction(func)
+  {
+  }
+
+  void Run()
+  {
+    try
+    {
+      this->Invoke(mFunction);
+    }
+    catch (...)
+    {
+      this->Failed();
+      this->Release();  // the reference of the queue entry
+      return;
+    }
+    this->Done();
+    this->Release();
+  }
+
+  F mFunction;
+};
+
+} // end of namespace details
+
+} // end of namespace asynccallbacks
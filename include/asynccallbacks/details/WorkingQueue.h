@@ -5,16 +5,17 @@
  * @brief contain the class WorkingQueue that is used to register work
  * 
  * This class would hold a queue that would have items for to be executed
- * later in some other thread. This is based on the osal message queue
- * but unlike that osal message queue it would only allow to register
- * and extract data in blocking manner
+ * later in some other thread. The entries are copied into (and out of) slots
+ * that are allocated once when the queue is created, so passing an entry
+ * through the queue would not allocate memory. Unlike the osal message queue
+ * it would only allow to register and extract data in blocking manner
  */
 
 #include <osal/OsalGeneralDefines.h>  // milliseconds type
 #include <cstddef>  // size_t
 #include <boost/noncopyable.hpp>  // make it none copyable
 
-namespace osal { namespace MessageQueue { struct Id; }}
+namespace boost { template<class T> class message_queue; }
 
 namespace asynccallbacks
 {
@@ -38,9 +39,14 @@ public:
   
   /**
    * add new element to the queue. if queue is full wait forever
-   * @param val a new entry into the queue - we assum that this was allocated on the heap
+   * @param val a new entry into the queue - it is copied into the queue
    * @return return true if the message was pushed into the queue
    */
+  bool Push(const WorkingQueueEntry& val);
+  
+  /**
+   * the same as above - the entry is copied, so the caller still own it
+   */
   bool Push(WorkingQueueEntry* val);
   
   /**
@@ -64,7 +70,9 @@ public:
   std::size_t MaxSize() const;
   
 private:
-  osal::MessageQueue::Id* mId;
+  typedef boost::message_queue<WorkingQueueEntry> queue_type;
+  
+  queue_type* mQueue;
   std::size_t mSize;
 };
 
@@ -65,7 +65,6 @@
  *  
  */
 
-#include <boost/function.hpp>   // boost::function is the holder of the "excutable"
 #include <boost/bind.hpp>       // to bind functions and paramters
 #include <boost/type_traits/remove_pointer.hpp> // so that we can test for valid parameters
 #include <boost/type_traits/is_function.hpp>    //so that we can test for valid parameters 
@@ -74,9 +73,106 @@
 #include <boost/static_assert.hpp>              // so that we can test for valid parameters
 #include <boost/type_traits/is_same.hpp>        // so that we can test for valid parameters
 #include <boost/mpl/if.hpp>                     // so that we can test for valid parameters
+#include <boost/type_traits/alignment_of.hpp>   // to know if the callable can be placed in the entry
+#include <cstddef>                              // size_t
+#include <memory>                               // auto_ptr
+#include <new>                                  // placement new
 
 namespace asynccallbacks
 {
+namespace details
+{
+  /**
+   * the memory for the callables that are too big to be placed inside the entry - blocks of
+   * up to POOLED_ENTRY_SIZE bytes are reused (see WorkingQueueEntry.cpp)
+   * @param size the size of the callable
+   * @return memory for the callable
+   */
+  void* AllocateEntryBlock(std::size_t size);
+
+  // return the memory that AllocateEntryBlock returned for the same size
+  void FreeEntryBlock(void* memory, std::size_t size);
+
+  // what the entry can do with the callable that it holds - there is one table for each type
+  struct EntryOperations
+  {
+    void (*Invoke)(void* storage);
+    void (*Clone)(const void* from, void* to);
+    void (*Destroy)(void* storage);
+  };
+
+  // the callable is placed in the entry itself
+  template<typename F>
+  struct InlineEntry
+  {
+    static void Create(const F& func, void* storage)
+    {
+      new (storage) F(func);
+    }
+
+    static void Invoke(void* storage)
+    {
+      (*static_cast<F*>(storage))();
+    }
+
+    static void Clone(const void* from, void* to)
+    {
+      Create(*static_cast<const F*>(from), to);
+    }
+
+    static void Destroy(void* storage)
+    {
+      static_cast<F*>(storage)->~F();
+    }
+
+    static const EntryOperations Table;
+  };
+
+  template<typename F>
+  const EntryOperations InlineEntry<F>::Table = { &InlineEntry<F>::Invoke, &InlineEntry<F>::Clone, &InlineEntry<F>::Destroy };
+
+  // the entry only hold a pointer to the callable, that is placed in a block from the pool
+  template<typename F>
+  struct PooledEntry
+  {
+    static void Create(const F& func, void* storage)
+    {
+      void* memory = AllocateEntryBlock(sizeof(F));
+      try
+      {
+        *static_cast<F**>(storage) = new (memory) F(func);
+      }
+      catch (...)
+      {
+        FreeEntryBlock(memory, sizeof(F));
+        throw;
+      }
+    }
+
+    static void Invoke(void* storage)
+    {
+      (**static_cast<F**>(storage))();
+    }
+
+    static void Clone(const void* from, void* to)
+    {
+      Create(**static_cast<F* const*>(from), to);
+    }
+
+    static void Destroy(void* storage)
+    {
+      F* func = *static_cast<F**>(storage);
+      func->~F();
+      FreeEntryBlock(func, sizeof(F));
+    }
+
+    static const EntryOperations Table;
+  };
+
+  template<typename F>
+  const EntryOperations PooledEntry<F>::Table = { &PooledEntry<F>::Invoke, &PooledEntry<F>::Clone, &PooledEntry<F>::Destroy };
+} // end of namespace details
+
 /**
  * @class WorkingQueueEntry
  * @brief the "interface to any callback that is registered
@@ -85,26 +181,55 @@ namespace asynccallbacks
  * and their variables to be executed later. The execution of the registered
  * entity is done through the call to operator () as nullary function (no
  * parameters are needed). 
+ * The registered entity is placed inside the entry itself if it is small enough (a bound member
+ * function with few parameters is), so creating, copying and destroying the entry would not
+ * allocate memory. The entry is sized to a single cache line, and a larger entity is placed in a
+ * block that is taken from a pool (and so is an entry that is created with new).
  */
 class WorkingQueueEntry
 {
 public:
-  typedef boost::function<void()> function_type;
-  
   /**
    * Use this constructor to register entity to be executed later through member operator ()
-   * @param ft the function type that would be saved to this object
+   * @param func any nullary function object (boost::bind result, functor...) - it is copied into this object
    */
-  WorkingQueueEntry(function_type ft) : func(ft)
+  template<typename F>
+  WorkingQueueEntry(const F& func) : mOperations(0)
   {
+    typedef typename boost::mpl::if_c<sizeof(F) <= INLINE_SIZE && 
+                                      boost::alignment_of<F>::value <= boost::alignment_of<Storage>::value,
+                                      details::InlineEntry<F>,
+                                      details::PooledEntry<F> >::type holder_type;
+    holder_type::Create(func, &mStorage);
+    mOperations = &holder_type::Table;
   }
   
   /**
    * default constructor - note that if this is the only one that
    * called then nothing would happen
    */
-  WorkingQueueEntry()
+  WorkingQueueEntry() : mOperations(0)
+  {
+  }
+  
+  WorkingQueueEntry(const WorkingQueueEntry& other) : mOperations(0)
+  {
+    CopyFrom(other);
+  }
+  
+  WorkingQueueEntry& operator = (const WorkingQueueEntry& other)
   {
+    if (this != &other)
+    {
+      Clear();
+      CopyFrom(other);
+    }
+    return *this;
+  }
+  
+  ~WorkingQueueEntry()
+  {
+    Clear();
   }
   
   /**
@@ -113,11 +238,76 @@ public:
    */
   void operator () () const
   {
-    func();
+    if (mOperations)
+    {
+      mOperations->Invoke(&mStorage);
+    }
+  }
+  
+  /**
+   * the entries that are allocated on their own (see MakeWorkingQueueEntry) are taken from
+   * the same pool as the large entities, so creating them would not allocate memory either
+   */
+  static void* operator new(std::size_t size)
+  {
+    return details::AllocateEntryBlock(size);
+  }
+  
+  static void operator delete(void* memory, std::size_t size)
+  {
+    if (memory)
+    {
+      details::FreeEntryBlock(memory, size);
+    }
+  }
+  
+  // this would hide the global placement new otherwise
+  static void* operator new(std::size_t, void* where)
+  {
+    return where;
+  }
+  
+  static void operator delete(void*, void*)
+  {
+  }
+  
+  /**
+   * release the registered entity (and its parameters), after that calling this would do nothing
+   */
+  void Clear()
+  {
+    if (mOperations)
+    {
+      const details::EntryOperations* operations = mOperations;
+      mOperations = 0;
+      operations->Destroy(&mStorage);
+    }
   }
   
 private:
-  function_type func;
+  void CopyFrom(const WorkingQueueEntry& other)
+  {
+    if (other.mOperations)
+    {
+      other.mOperations->Clone(&other.mStorage, &mStorage);
+      mOperations = other.mOperations;
+    }
+  }
+  
+  // with the pointer to the operations this is a single cache line
+  static const std::size_t INLINE_SIZE = 64 - sizeof(const details::EntryOperations*);
+  
+  union Storage
+  {
+    char   mBytes[INLINE_SIZE];
+    void*  mAlignPointer;
+    double mAlignDouble;
+    long   mAlignLong;
+    void (Storage::*mAlignMember)();
+  };
+  
+  const details::EntryOperations* mOperations;
+  mutable Storage                 mStorage;  // calling the entity may change it
 };
 
 namespace Private
@@ -128,47 +318,47 @@ struct MemFuncBinder
   template<typename F, typename C> static inline
   std::auto_ptr<WorkingQueueEntry> make(F mem_f, C inst)
   {
-    return std::auto_ptr<WorkingQueueEntry>(new WorkingQueueEntry(WorkingQueueEntry::function_type(boost::bind(mem_f, inst))));
+    return std::auto_ptr<WorkingQueueEntry>(new WorkingQueueEntry(boost::bind(mem_f, inst)));
   }
   
   template<typename F, typename C, typename A> static inline
   std::auto_ptr<WorkingQueueEntry> make(F mem_f, C inst, A a)
   {
-    return std::auto_ptr<WorkingQueueEntry>(new WorkingQueueEntry(WorkingQueueEntry::function_type(boost::bind(mem_f, inst, a)))); 
+    return std::auto_ptr<WorkingQueueEntry>(new WorkingQueueEntry(boost::bind(mem_f, inst, a))); 
   }
   
   template<typename F, typename C, typename A, typename A2> static inline
   std::auto_ptr<WorkingQueueEntry> make(F mem_f, C inst, A a,  A2 a2)
   {   
-    return std::auto_ptr<WorkingQueueEntry>(new WorkingQueueEntry(WorkingQueueEntry::function_type(boost::bind(mem_f, inst, a, a2)))); 
+    return std::auto_ptr<WorkingQueueEntry>(new WorkingQueueEntry(boost::bind(mem_f, inst, a, a2))); 
   }
   
   
   template<typename F, typename C, typename A, typename A2, typename A3> static inline
   std::auto_ptr<WorkingQueueEntry> make(F mem_f, C inst, A a, A2 a2, A3 a3)
   {
-    return std::auto_ptr<WorkingQueueEntry>(new WorkingQueueEntry(WorkingQueueEntry::function_type(boost::bind(mem_f, inst, a, a2, a3)))); 
+    return std::auto_ptr<WorkingQueueEntry>(new WorkingQueueEntry(boost::bind(mem_f, inst, a, a2, a3))); 
   }
   
   
   template<typename F, typename C, typename A, typename A2, typename A3, typename A4> static inline
   std::auto_ptr<WorkingQueueEntry> make(F mem_f, C inst, A a, A2 a2, A3 a3, A4 a4)
   {
-    return std::auto_ptr<WorkingQueueEntry>(new WorkingQueueEntry(WorkingQueueEntry::function_type(boost::bind(mem_f, inst, a, a2, a3, a4))));
+    return std::auto_ptr<WorkingQueueEntry>(new WorkingQueueEntry(boost::bind(mem_f, inst, a, a2, a3, a4)));
   }
   
   template<typename F, typename C, typename A, typename A2, 
            typename A3, typename A4, typename A5> static inline
   std::auto_ptr<WorkingQueueEntry> make(F mem_f, C inst, A a, A2 a2, A3 a3, A4 a4, A5 a5)
   {
-    return std::auto_ptr<WorkingQueueEntry>(new WorkingQueueEntry(WorkingQueueEntry::function_type(boost::bind(mem_f, inst, a, a2, a3, a4, a5))));
+    return std::auto_ptr<WorkingQueueEntry>(new WorkingQueueEntry(boost::bind(mem_f, inst, a, a2, a3, a4, a5)));
   }
   
   template<typename F, typename C, typename A, typename A2, 
            typename A3, typename A4, typename A5, typename A6> static inline
   std::auto_ptr<WorkingQueueEntry> make(F mem_f, C inst, A a, A2 a2, A3 a3, A4 a4, A5 a5, A6 a6)
   {
-    return std::auto_ptr<WorkingQueueEntry>(new WorkingQueueEntry(WorkingQueueEntry::function_type(boost::bind(mem_f, inst, a, a2, a3, a4, a5, a6))));
+    return std::auto_ptr<WorkingQueueEntry>(new WorkingQueueEntry(boost::bind(mem_f, inst, a, a2, a3, a4, a5, a6)));
   }
 };
 
@@ -243,7 +433,7 @@ template<typename F> inline
 std::auto_ptr<WorkingQueueEntry> MakeWorkingQueueEntry(F f)
 {
   BOOST_STATIC_ASSERT(boost::is_function<typename boost::remove_pointer<F>::type>::value);
-  return std::auto_ptr<WorkingQueueEntry>(new WorkingQueueEntry(WorkingQueueEntry::function_type(boost::bind(f)))); 
+  return std::auto_ptr<WorkingQueueEntry>(new WorkingQueueEntry(boost::bind(f))); 
 }
 
 
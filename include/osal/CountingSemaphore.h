@@ -106,6 +106,14 @@ is not ready it would return with an error
 */
 bool TimedWait(Id* on, milliseconds_t milliDuration);
 
+/**
+@brief the same as above with timeout in finer resolution than milliseconds (see Duration in OsalGeneralDefines.h)
+@param on this is the semaphore on which to wait
+@param duration the max time to wait
+@return true on successful operation
+*/
+bool TimedWait(Id* on, const Duration& duration);
+
 /**
 @brief this function would wait on a semaphore - return without blocking if not available
 This function would wait on the semaphore until its count
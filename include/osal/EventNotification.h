@@ -101,6 +101,14 @@ then we would not
 */
 bool TimedWait(Id* on, milliseconds_t milliDuration);
 
+/**
+@brief the same as above with timeout in finer resolution than milliseconds (see Duration in OsalGeneralDefines.h)
+ @param on the notification object to wait on
+ @param duration the timeout value to wait before returning from this function with failure
+ @return true value if event was signal
+*/
+bool TimedWait(Id* on, const Duration& duration);
+
 /**
 @brief This would signal that the event happened
 This would make the notification object signalled. If there is a thread waiting
@@ -121,6 +129,16 @@ able to continue its work
 */
 void SignalAll(Id* on);
 
+/**
+@brief return a file descriptor that become readable when the object is signalled
+This allow to wait on the event together with other file descriptors (see osal/Poller.h).
+The handle is created on the first call and it is closed when the object is deleted.
+Note that the handle is only a hint, the event must still be taken with TryWait
+@param on the object
+@return the file descriptor, or -1 if this is not supported on this platform (only Linux support it)
+*/
+int ReadyHandle(Id* on);
+
 /**
 @brief delete the event notification object and free any resources
 Make sure that this function is called only when all threads that are 
@@ -0,0 +1,139 @@
+#pragma once
+/**
+@file LatencyHistogram.h
+
+This would be a histogram for recording latencies (in nanoseconds) with fixed
+relative precision, in the spirit of HDR histogram. The values are stored in buckets
+that are arranged in powers of 2, and each power of 2 is divided into SUB_BUCKETS
+linear buckets. This means that values below SUB_BUCKETS are recorded exactly and 
+larger values are recorded with error of at most 1/SUB_BUCKETS (about 3%).
+Values that are larger than 2^MAX_VALUE_BITS nanoseconds (about 18 minutes) are 
+recorded in the last bucket (but the Max would still be correct).
+
+Recording is just an increment of a counter, so it is cheap enough to be used in 
+the hot path, but it is not thread safe. The use case for this is to have 
+a histogram per thread and then merge them at the thread that is reporting - 
+
+osal::LatencyHistogram dispatchTime;  // one per thread
+
+then at the code that we would like to measure - 
+{
+  osal::ScopedLatency measure(dispatchTime);
+  DoSomething();
+}
+or if we already have the time - 
+dispatchTime.Record(sw.StopNano());
+
+and then at the reporting thread (after the other threads are done, or at the
+point in which they are not recording any more) - 
+osal::LatencyHistogram total;
+total.Merge(dispatchTime);
+std::cout<<"99% of the calls took less than "<<total.Percentile(99.0)<<" nanoseconds\n";
+*/
+#include "osal/OsalGeneralDefines.h"  // nanoseconds_t
+#include "osal/StopWatch.h"           // to measure the time for ScopedLatency
+
+namespace osal
+{
+
+class LatencyHistogram
+{
+public:
+  enum
+  {
+    SUB_BUCKET_BITS = 5,
+    SUB_BUCKETS = 1 << SUB_BUCKET_BITS,
+    MAX_VALUE_BITS = 40,
+    BUCKETS = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS
+  };
+
+  LatencyHistogram();
+
+  /**
+  @brief add a new sample to the histogram
+  @param value the latency in nanoseconds
+  */
+  void Record(nanoseconds_t value);
+
+  /**
+  @brief add a the same value number of times to the histogram
+  @param value the latency in nanoseconds
+  @param count the number of samples with this value
+  */
+  void Record(nanoseconds_t value, unsigned long long count);
+
+  /**
+  @brief add all the samples from another histogram into this one
+  @param other the histogram to add, it would not be changed
+  */
+  void Merge(const LatencyHistogram& other);
+
+  /**
+  @brief remove all samples
+  */
+  void Reset();
+
+  // the number of samples that were recorded
+  unsigned long long Count() const;
+
+  // the smallest value that was recorded (0 when empty)
+  nanoseconds_t Min() const;
+
+  // the largest value that was recorded (0 when empty)
+  nanoseconds_t Max() const;
+
+  // the average of all the values that were recorded (0 when empty)
+  nanoseconds_t Mean() const;
+
+  /**
+  @brief return the value that the given percent of the samples are less or equal to
+  @param percent the percentile (0 - 100)
+  @return the highest value that is in the same bucket as the percentile (so that the
+          error would be on the safe side), or 0 if the histogram is empty
+  */
+  nanoseconds_t Percentile(double percent) const;
+
+  // access to the buckets, for the users that would like to print the full histogram
+  unsigned long long CountAt(unsigned int bucket) const;
+
+  // the smallest value that would be recorded into a given bucket
+  static nanoseconds_t BucketLowValue(unsigned int bucket);
+
+  // the largest value that would be recorded into a given bucket
+  static nanoseconds_t BucketHighValue(unsigned int bucket);
+
+  // the bucket that a value would be recorded into
+  static unsigned int BucketOf(nanoseconds_t value);
+
+private:
+  unsigned long long mCounts[BUCKETS];
+  unsigned long long mTotalCount;
+  nanoseconds_t mTotalValue;
+  nanoseconds_t mMin;
+  nanoseconds_t mMax;
+};
+
+// record the time that passed from the construction of this object to its 
+// destruction into the histogram
+class ScopedLatency
+{
+public:
+  explicit ScopedLatency(LatencyHistogram& into) : mInto(into), mStart(StopWatchOper::Now())
+  {
+  }
+
+  ~ScopedLatency()
+  {
+    const nanoseconds_t now = StopWatchOper::Now();
+    mInto.Record(now > mStart ? now - mStart : 0);
+  }
+
+private:
+  ScopedLatency(const ScopedLatency&);
+  ScopedLatency& operator = (const ScopedLatency&);
+
+  LatencyHistogram& mInto;
+  nanoseconds_t mStart;
+};
+
+} // end of namespace osal
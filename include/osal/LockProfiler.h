@@ -0,0 +1,88 @@
+#pragma once
+/**
+@file LockProfiler.h
+
+This would allow to find which locks (osal::Mutex and osal::RWMutex) are hot.
+Once the profiler is enabled, every lock operation is recorded per lock and per call site
+(the code that called Mutex::Lock, RWMutex::ReadLock and so on), with the number of times the lock
+was taken, how many of them found the lock already taken (contended), how long the thread waited
+for the lock and how long it was held.
+Each thread is recording into its own buffer, so the profiler do not add any shared state to the locks,
+and the buffers are merged only when the results are requested.
+
+The use case for this module is as follow -
+
+LockProfiler::Enable(true);
+RunTheApplication();
+LockProfiler::Report(10);  // print the 10 most contended locks
+
+or to process the results -
+LockProfiler::Entry top[10];
+unsigned int count = LockProfiler::Top(top, 10);
+
+The call sites are reported as code addresses (in the report they are translated to symbols when
+possible, else use addr2line to find the source line).
+Note that a lock that was deleted and a new lock that was created at the same address would share
+the same entries.
+When the profiler is disabled, the lock operations have a single branch to check whether it is enabled,
+and defining OSAL_NO_LOCK_PROFILER when building OSAL would remove even this. The profiler is only
+supported on Linux, on other platforms Enable do nothing and there are no results.
+*/
+#include "osal/OsalGeneralDefines.h"  // nanoseconds_t
+
+namespace osal
+{
+
+namespace LockProfiler
+{
+
+/**
+the results for a single lock at a single call site
+*/
+struct Entry
+{
+  const void* Lock;                   // the lock id
+  const void* CallSite;               // the code that took the lock
+  unsigned long long Acquisitions;    // number of times the lock was taken
+  unsigned long long Contended;       // number of times the lock was already taken by someone else
+  unsigned long long Failed;          // number of times try or timed lock did not get the lock
+  nanoseconds_t WaitTime;             // total time waiting for the lock
+  nanoseconds_t MaxWait;              // the longest wait for the lock
+  nanoseconds_t HoldTime;             // total time the lock was held (from this call site)
+  nanoseconds_t MaxHold;              // the longest time the lock was held
+};
+
+/**
+@brief start or stop recording the lock operations
+@param on true to start recording
+*/
+void Enable(bool on);
+
+/**
+@return true if the lock operations are recorded
+*/
+bool Enabled();
+
+/**
+@brief remove all the results that were recorded so far
+*/
+void Reset();
+
+/**
+@brief merge the results from all the threads and return the most contended locks
+The entries are ordered by the number of contended acquisitions, and then by the wait time
+@param entries array to place the results
+@param maxEntries the size of the array
+@return the number of entries that were placed in the array
+*/
+unsigned int Top(Entry* entries, unsigned int maxEntries);
+
+/**
+@brief print the most contended locks to the standard output
+@param topN the number of entries to print
+*/
+void Report(unsigned int topN);
+
+} // end of namespace LockProfiler
+
+} // end of namespace osal
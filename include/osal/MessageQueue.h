@@ -45,7 +45,54 @@ once those threads finished you must delete the queue
 
 MessageQueue::Delete(qid);
 
+NOTE about the queue engine - on Linux you can choose how the queue is implemented
+when creating it. The default is a queue that is guarded by a lock. The other option
+is lock free ring (MessageQueue::CreateLockFree) in which readers and writers never
+block each other, and only go to sleep when the queue is empty (or full). Note that
+the lock free ring capacity is rounded up to power of 2. For the common case where
+only one thread is writing to the queue and only one thread is reading from it, you
+can use MessageQueue::SINGLE_READER_WRITER, this is the fastest option, since neither
+side needs any atomic read-modify-write to pass a message, and the other side is only
+woken up when it is actually sleeping. It is an error to use such a queue from more
+than one writer (or more than one reader) thread. On other platforms the engine is
+ignored and the queue is always the native one
 
+NOTE about queues between processes - on Linux a queue can be placed in named shared memory
+so that two processes can pass messages with it. One process create the queue (this
+would replace a queue with the same name that was left by a process that crashed, but it
+would fail if the process that created that queue is still running)
+
+MessageQueue::Id* qid = MessageQueue::CreateShared("/trace_events", MAX_QUEUE_SIZE, MAX_MQ_MSG_SIZE);
+
+and the other process open it by name (this would return NULL if it was not created yet)
+
+MessageQueue::Id* qid = 0;
+while (!(qid = MessageQueue::OpenShared("/trace_events")))
+{
+  Thread::Self::Sleep(100);
+}
+
+From there the queue is used with the same functions as any other queue. One of the processes
+is sending the messages and the other is reading them, and in each of them only one thread
+is using the queue at a time (like the SINGLE_READER_WRITER engine), so passing a message
+is a single copy into the shared memory, and the kernel is only called if the other side is
+sleeping. If you need to send messages in both directions, create two queues.
+If the other process crashed while we are blocked on the queue, the call would fail with
+errno set to EPIPE (a short time after it crashed), and PeerAlive would return false. The
+process that opened the queue can open it again after it crashed. Note that ReadyHandle
+and MultiWait would only notice the messages that were sent from the same process.
+On the other platforms this is not supported.
+
+
+NOTE about message priority - the highPriority flag that is passed when sending a message
+would place it in a second (urgent) lane. Messages from the urgent lane are always read before
+the messages in the normal lane, and in each lane the messages are read in the order they were
+sent. So that the normal messages would not starve when there is a constant flow of urgent
+messages, after a burst of urgent messages that were read while normal messages were waiting
+a single normal message is read. You can see the state of the lanes with CurrentLanesCount.
+On the lock free engines each lane has its own room of queueSize messages, on the locking engine
+the two lanes share the same room. On VxWorks the native queue is used - urgent messages are
+placed at the head of the queue (there is no starvation protection there)
 
 NOTE about interrupts safty - the implementation would be interrupt safe to
 the same level as VxWorks native calls (see http://www-kryo.desy.de/documents/vxWorks/V5.4/vxworks/ref/msgQLib.html)
@@ -67,6 +114,29 @@ namespace MessageQueue
 
 struct Id;
 
+/**
+@enum Engine
+@brief the way the queue is implemented internally (see the note above)
+*/
+enum Engine
+{
+  LOCKING,      // the default - the queue is guarded by lock
+  LOCK_FREE,    // bounded ring that is not using any lock (threads only wait if it is full or empty)
+  SINGLE_READER_WRITER  // like LOCK_FREE, but only for exactly one writer thread and one reader thread
+};
+
+/**
+@struct LanesCount
+@brief the state of the two lanes of the queue (see the note about priority above)
+*/
+struct LanesCount
+{
+  int Normal;               // the number of messages that are waiting in the normal lane
+  int Urgent;               // the number of messages that are waiting in the urgent lane
+  unsigned long Overtaken;  // the number of urgent messages that were read while normal messages were waiting
+  unsigned long Forced;     // the number of normal messages that were read before urgent ones so they would not starve
+};
+
 /**
 @brief this function would register a callback function to be called when critical error has happened
 @param func the function to be called at exit
@@ -84,6 +154,26 @@ it would assert on the failure
 */
 Id* Create(unsigned int queueSize, unsigned int maxMessageSize);
 
+/**
+@brief create a new message queue with the given engine
+This is the same as Create above, only that it allows to select the way the queue is implemented
+@param queueSize the max number of messages that can be placed in the queue before sending is blocked
+@param maxMessageSize the max size for a given message in the queue
+@param engine the implementation of the queue (this is ignored on platforms that don't support it)
+@return MessageQueueId pointer. Note that this function would never return NULL, if it would fail internally
+it would assert on the failure
+*/
+Id* Create(unsigned int queueSize, unsigned int maxMessageSize, Engine engine);
+
+/**
+@brief create a new message queue that is not using locks
+This is the same as calling Create(queueSize, maxMessageSize, LOCK_FREE)
+@param queueSize the max number of messages that can be placed in the queue before sending is blocked
+@param maxMessageSize the max size for a given message in the queue
+@return MessageQueueId pointer. Note that this function would never return NULL
+*/
+Id* CreateLockFree(unsigned int queueSize, unsigned int maxMessageSize);
+
 /**
 @brief this function would place a new message in the queue
 The function would block the caller if the queue is full
@@ -117,6 +207,13 @@ The function would block the caller if the queue is full up until the timeout va
 */
 bool TimedSend(Id* mqId, CONST_MESSAGE char* msgBuff, unsigned int msgSize, 
                milliseconds_t milliDuration, bool highPriority);
+
+/**
+@brief the same as above with timeout in finer resolution than milliseconds (see Duration in OsalGeneralDefines.h)
+@param duration the max time to wait if the queue is full
+*/
+bool TimedSend(Id* mqId, CONST_MESSAGE char* msgBuff, unsigned int msgSize,
+               const Duration& duration, bool highPriority);
 	
 /**
 @brief extract a message from the queue
@@ -149,6 +246,47 @@ This function would read a message from the queue. it would block if queue is em
 */	
 int TimedReceive(Id* mqId, char* msgBuff, unsigned int buffSize, milliseconds_t milliDuration);
 
+/**
+@brief the same as above with timeout in finer resolution than milliseconds (see Duration in OsalGeneralDefines.h)
+@param duration max time to be blocked if message queue is empty
+@return -1 if failed to read or timedout, else the message size that was read
+*/
+int TimedReceive(Id* mqId, char* msgBuff, unsigned int buffSize, const Duration& duration);
+
+/**
+@brief place few messages in the queue at once
+This is like calling Send for each message, only that all the messages that can fit into
+the queue are placed with a single access to the queue (and a single wakeup for the readers).
+The function would block the caller only if the queue is full, and it would return as soon
+as at least one message was placed, so to send all the messages, you can do something like
+for (unsigned int sent = 0; sent < count;)
+{
+  sent += MessageQueue::SendBatch(qid, msgs + sent, sizes + sent, count - sent);
+}
+@param mqId the id to which the messages are pushed
+@param msgs the messages to be placed in the queue
+@param sizes the size of each of the messages (each less than maxMessageSize!)
+@param count the number of messages in msgs (and in sizes)
+@return the number of messages (from the start of msgs) that were placed in the queue
+*/
+unsigned int SendBatch(Id* mqId, CONST_MESSAGE char* const msgs[], const unsigned int sizes[], unsigned int count);
+
+/**
+@brief extract few messages from the queue at once
+This would block the caller up until the timeout value if the queue is empty. Once there is a
+message in the queue it would read all the messages that are in the queue (up to maxCount)
+with a single access to the queue. Message number i is copied to msgBuff + i * stride.
+@param mqId the id from which the messages are read
+@param msgBuff buffer that is large enough for maxCount messages
+@param stride the space for each message in msgBuff. If this is less than the message, not all message is read
+@param sizes if not NULL, the size of each message that was read is stored here (must hold maxCount entries)
+@param maxCount the max number of messages to read
+@param milliDuration max time to be blocked if message queue is empty (0 would not block at all)
+@return the number of messages that were read, 0 if timedout
+*/
+unsigned int ReceiveBatch(Id* mqId, char* msgBuff, unsigned int stride, unsigned int sizes[],
+                          unsigned int maxCount, milliseconds_t milliDuration);
+
 /**
 @brief return the number of pending messages in the queue (note that this may not be correct!)
 @param mqId message queue from which to read number of waiting messages
@@ -156,6 +294,50 @@ int TimedReceive(Id* mqId, char* msgBuff, unsigned int buffSize, milliseconds_t
 */
 int CurrentCount(Id* mqId);
 
+/**
+@brief return the state of each of the queue lanes (note that like CurrentCount this is only a snapshot)
+@param mqId message queue for which we want the information
+@return the number of messages in each lane and how many times one lane was read before the other
+*/
+LanesCount CurrentLanesCount(Id* mqId);
+
+/**
+@brief return a file descriptor that become readable when a message is sent to the queue
+This allow to wait on the queue together with other file descriptors (see osal/Poller.h).
+The handle is created on the first call and it is closed when the queue is deleted.
+Note that the handle is only a hint, once it is readable the queue may already be empty again,
+so the messages should be read with TryReceive
+@param mqId the message queue
+@return the file descriptor, or -1 if this is not supported on this platform (only Linux support it)
+*/
+int ReadyHandle(Id* mqId);
+
+/**
+@brief create a queue in named shared memory, so it can be used by another process (see the note above)
+This is only supported on Linux. The name is removed when the queue is deleted by this process
+@param name the name of the shared memory object (should start with '/' for example "/my_queue")
+@param queueSize the max number of messages that can be placed in the queue before sending is blocked
+@param maxMessageSize the max size for a given message in the queue
+@return MessageQueueId pointer. Note that this function would never return NULL, if it would fail internally
+it would assert on the failure (EEXIST if a queue with this name was created by a process that is still running)
+*/
+Id* CreateShared(const char* name, unsigned int queueSize, unsigned int maxMessageSize);
+
+/**
+@brief open a queue that another process created with CreateShared
+@param name the name that the queue was created with
+@return the queue, or NULL if it was not created yet or another process (that is still running) opened it
+*/
+Id* OpenShared(const char* name);
+
+/**
+@brief check whether the process on the other side of a shared queue is still running
+@param mqId the message queue
+@return false if the other process crashed (or exit without deleting the queue). This is always true
+for a queue that is not shared, and when the other process did not open the queue yet
+*/
+bool PeerAlive(Id* mqId);
+
 /**
 @brief delete the message queue and release any resources allocated by it
 This function must not be called if the message queue is still in use. Call this function
@@ -0,0 +1,144 @@
+#pragma once
+/**
+@file MultiWait.h
+
+This would allow a thread to wait on more than one OSAL object at the same time -
+event notifications, counting semaphores and message queues. This is like
+WaitForMultipleObjects in Windows, and unlike Poller.h it do not need file descriptors, so it
+is supported on VxWorks as well as on Linux.
+The thread is only blocked once for each wait - each object hold a list of the threads that are
+waiting on it, and wake them up when it become ready, so there is no need to poll the objects
+in a loop.
+
+The use case for this module is as follow -
+
+osal::WaitObject inputs[] = { osal::WaitObject(stopEvent),
+                              osal::WaitObject(commandsQueue),
+                              osal::WaitObject(freeBuffers) };
+for (;;)
+{
+  switch (osal::WaitAny(inputs, 3, 100))
+  {
+    case 0:   // the stop event was signaled (and taken)
+      return;
+    case 1:   // there are messages in the queue - this do not read them
+      while (MessageQueue::TryReceive(commandsQueue, buffer, sizeof(buffer)) >= 0) ...
+      break;
+    case 2:   // we got a buffer from the semaphore
+      ...
+      break;
+    default:  // the timeout passed
+      ...
+  }
+}
+
+Event notifications and counting semaphores are taken by the wait (the same as if TryWait was
+called on them), message queues are only checked to be not empty - the message must be read with
+TryReceive (and since other threads may read it first, you must not block on the queue).
+Note that SignalAll on event notification do not release the threads that are waiting here, since
+it is not changing the event state.
+This is only supported on Linux and VxWorks, on other platforms calling the wait functions
+would report a critical error.
+*/
+#include "osal/OsalGeneralDefines.h"  // milliseconds_t
+
+namespace osal
+{
+
+namespace EventNotification
+{
+  struct Id;
+} // end of namespace EventNotification
+
+namespace CountingSemaphore
+{
+  struct Id;
+} // end of namespace CountingSemaphore
+
+namespace MessageQueue
+{
+  struct Id;
+} // end of namespace MessageQueue
+
+namespace MultiWait
+{
+
+/**
+a single object to wait on
+*/
+struct WaitObject
+{
+  enum Type
+  {
+    EVENT_NOTIFICATION,
+    COUNTING_SEMAPHORE,
+    MESSAGE_QUEUE
+  };
+
+  WaitObject() : ObjectType(EVENT_NOTIFICATION), Event(0)
+  {
+  }
+
+  explicit WaitObject(EventNotification::Id* event) : ObjectType(EVENT_NOTIFICATION), Event(event)
+  {
+  }
+
+  explicit WaitObject(CountingSemaphore::Id* semaphore) : ObjectType(COUNTING_SEMAPHORE), Semaphore(semaphore)
+  {
+  }
+
+  explicit WaitObject(MessageQueue::Id* queue) : ObjectType(MESSAGE_QUEUE), Queue(queue)
+  {
+  }
+
+  Type ObjectType;
+  union
+  {
+    EventNotification::Id* Event;
+    CountingSemaphore::Id* Semaphore;
+    MessageQueue::Id* Queue;
+  };
+};
+
+/**
+@brief this function would register a callback function to be called when critical error has happened
+@param func the function to be called at exit
+*/
+void RegisterAtExit(at_error_fun func);
+
+/**
+@brief block until one of the objects is ready
+@param objects the objects to wait on
+@param count the number of objects
+@return the index of the object that is ready (if more than one is ready, this is the first in the array)
+*/
+int WaitAny(const WaitObject objects[], unsigned int count);
+
+/**
+@brief the same as above only return after the timeout if none of the objects is ready
+@return the index of the object that is ready, or -1 if the timeout passed
+*/
+int WaitAny(const WaitObject objects[], unsigned int count, milliseconds_t milliDuration);
+
+/**
+@brief block until all the objects are ready at the same time. The events and the semaphores
+are only taken once all of them are available - if we failed to take one of them, the ones that
+were already taken are given back and we wait again
+@param objects the objects to wait on
+@param count the number of objects
+*/
+void WaitAll(const WaitObject objects[], unsigned int count);
+
+/**
+@brief the same as above only return after the timeout if not all the objects are ready
+@return true if all the objects are ready, false if the timeout passed (nothing is taken in this case)
+*/
+bool WaitAll(const WaitObject objects[], unsigned int count, milliseconds_t milliDuration);
+
+} // end of namespace MultiWait
+
+using MultiWait::WaitObject;
+using MultiWait::WaitAny;
+using MultiWait::WaitAll;
+
+} // end of namespace osal
@@ -62,6 +62,14 @@ enum Protection
 	PRIORITY_UNSAFE
 };
 
+/* what a thread is doing when the mutex it want is locked by another thread */
+enum Policy
+{
+	BLOCKING,       /* block in the kernel right away - this is what Create() is using */
+	ADAPTIVE_SPIN,  /* spin for a short time before blocking - for short critical sections */
+	SPIN            /* never block - only for real time threads that each have its own CPU */
+};
+
 /**
 @brief this function would register a callback function to be called when critical error has happened
 @param func the function to be called at exit
@@ -82,6 +90,26 @@ use does no need to test this!
 */
 Id* Create();
 
+/**
+@brief create a mutex like the one above, with control over what the thread that is waiting for
+the lock would do.
+For critical sections that are very short (few hundred nanoseconds), blocking in the kernel
+cost much more than the time we are waiting for the lock to be released. With ADAPTIVE_SPIN
+each mutex keep a running estimate of the time the lock is held, and a thread that find it
+locked would spin for a time that is based on this estimate, as long as the owner seems to be
+running (it is holding the lock for no longer than expected). If the lock was not released by
+then, the thread would block. Mutexes that are held for long time would not spin at all, and
+on a machine with a single CPU we never spin since the owner cannot run while we are spinning.
+With SPIN the thread would never block - it is burning the CPU until the lock is released, this
+should only be used when all the threads that use the lock have their own CPU (and real time
+priority), otherwise a thread may spin while the owner is not running.
+Note that the mutex do not support recursive locking or priority inheritance, the same as Create().
+On VxWorks and Windows the policy is ignored and this is the same as Create()
+@param policy what to do when the mutex is locked
+@return MutexId pointer which is allocated on the head. This function cannot fail
+*/
+Id* Create(Policy policy);
+
 /**
 @brief this would create a mutex with recursive call protection and possibly priority inversion protection
 This function would create a mutex that would support against deadlocks if the same thread
@@ -141,6 +169,14 @@ to access the same code path.
 */
 bool TimedLock(Id* id, milliseconds_t milliDuration);
 
+/**
+@brief the same as above with timeout in finer resolution than milliseconds (see Duration in OsalGeneralDefines.h)
+@param id is the mutex to lock
+@param duration max time to wait for the lock before return false
+@return true value if the function succeeded, false value if failed to lock the mutex
+*/
+bool TimedLock(Id* id, const Duration& duration);
+
 /**
 @brief this function must be call after each successful lock function, it would release the mutex for other threads
 This function must be call once the thread finish with the mutex. Failing to do so would lead to locking
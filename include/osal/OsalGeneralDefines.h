@@ -16,6 +16,54 @@ namespace osal
 # endif // CONST_MESSAGE
 #endif  // __VXWORKS__
 typedef unsigned long	milliseconds_t;	/* this would be used as timeout value */
+typedef unsigned long long	nanoseconds_t;	/* this would be used for fine grain time measurements */
+
+/* timeout with finer resolution than milliseconds_t - all the timed functions have an overload
+   that accept it. On Linux the wait is for absolute deadline on the monotonic clock, and for the
+   last part of the wait the thread is spinning instead of blocking, so the wait would end close
+   to the time that was requested (the kernel may wake a thread that is blocked tens of microseconds
+   late). On other platforms it is rounded up to milliseconds (or system ticks).
+   Create it with one of the functions below, for example EventNotification::TimedWait(ev, Microseconds(200)) */
+class Duration
+{
+public:
+  explicit Duration(nanoseconds_t nano) : mNano(nano)
+  {
+  }
+
+  nanoseconds_t Nano() const
+  {
+    return mNano;
+  }
+
+  unsigned long long Micro() const   // rounded up
+  {
+    return (mNano + 999ULL) / 1000ULL;
+  }
+
+  milliseconds_t Milli() const       // rounded up, so we would never wait less than requested
+  {
+    return (milliseconds_t)((mNano + 999999ULL) / 1000000ULL);
+  }
+
+private:
+  nanoseconds_t mNano;
+};
+
+inline Duration Nanoseconds(nanoseconds_t nano)
+{
+  return Duration(nano);
+}
+
+inline Duration Microseconds(unsigned long long micro)
+{
+  return Duration(micro * 1000ULL);
+}
+
+inline Duration Milliseconds(milliseconds_t milli)
+{
+  return Duration((nanoseconds_t)milli * 1000000ULL);
+}
 
 typedef void (*at_error_fun)(int);		/* function to be called when something critical happened. 
                                          The user would register a callback function here */
@@ -0,0 +1,165 @@
+#pragma once
+/**
+@file Poller.h
+
+This would allow a single thread to wait on many OSAL objects (event notifications and
+message queues) and file descriptors (sockets, pipes) at the same time. On Linux this is
+done with epoll - the OSAL objects expose an eventfd (see EventNotification::ReadyHandle and
+MessageQueue::ReadyHandle) that is readable once they are ready, so a single system call is made
+for each wakeup no matter how many sources are waited on.
+
+The use case for this module is as follow -
+
+Poller::Id* poller = Poller::Create();
+Poller::Add(poller, commandsQueue, &commandsHandler);
+Poller::Add(poller, stopEvent, 0);
+Poller::Add(poller, socketFd, Poller::READABLE, &socketHandler);
+
+Poller::Ready ready[16];
+for (;;)
+{
+  int count = Poller::TimedWait(poller, ready, 16, 100);
+  for (int i = 0; i < count; i++)
+  {
+    switch (ready[i].Type)
+    {
+      case Poller::MESSAGE_QUEUE:
+        while (MessageQueue::TryReceive(ready[i].Queue, buffer, sizeof(buffer)) >= 0)  ...
+      ...
+    }
+  }
+}
+Poller::Delete(poller);
+
+The poller is level triggered - as long as the OSAL object is ready (the event is signalled or there
+are messages in the queue) it would be reported again. Note that the OSAL object would not be taken
+by the poller - the user must call TryWait or TryReceive, and since other threads may take it first,
+the user must not block on it.
+The poller itself is not thread safe - it should be used by a single thread (the one that is
+waiting on it) and the sources must be removed before they are deleted.
+This is only supported on Linux, on other platforms Create would report a critical error.
+*/
+#include "osal/OsalGeneralDefines.h"  // milliseconds_t
+
+namespace osal
+{
+
+namespace EventNotification
+{
+  struct Id;
+} // end of namespace EventNotification
+
+namespace MessageQueue
+{
+  struct Id;
+} // end of namespace MessageQueue
+
+namespace Poller
+{
+
+struct Id;
+
+enum SourceType
+{
+  FILE_DESCRIPTOR,
+  EVENT_NOTIFICATION,
+  MESSAGE_QUEUE
+};
+
+// what to wait for with file descriptors (the OSAL objects are always waited for being ready)
+enum Events
+{
+  READABLE = 1,
+  WRITABLE = 2,
+  HANGUP = 4        // this is only reported, there is no need to ask for it
+};
+
+/**
+the information about a source that is ready
+*/
+struct Ready
+{
+  SourceType Type;
+  union
+  {
+    int Fd;
+    EventNotification::Id* Event;
+    MessageQueue::Id* Queue;
+  };
+  unsigned int Events;      // for file descriptors - which of the Events happened
+  void* UserData;           // the value that was given when the source was added
+};
+
+/**
+@brief this function would register a callback function to be called when critical error has happened
+@param func the function to be called at exit
+*/
+void RegisterAtExit(at_error_fun func);
+
+/**
+@brief create a new poller, this function would never return NULL
+*/
+Id* Create();
+
+/**
+@brief start waiting on a file descriptor
+@param id the poller
+@param fd the file descriptor
+@param events combination of READABLE and WRITABLE
+@param userData would be returned when the file descriptor is ready
+@return false if the file descriptor is already in the poller or is not valid
+*/
+bool Add(Id* id, int fd, unsigned int events, void* userData);
+
+/**
+@brief start waiting for an event notification to be signalled
+@return false if the event is already in the poller
+*/
+bool Add(Id* id, EventNotification::Id* event, void* userData);
+
+/**
+@brief start waiting for messages in a message queue
+@return false if the queue is already in the poller
+*/
+bool Add(Id* id, MessageQueue::Id* queue, void* userData);
+
+/**
+@brief stop waiting on a source
+@return false if the source is not in the poller
+*/
+bool Remove(Id* id, int fd);
+
+bool Remove(Id* id, EventNotification::Id* event);
+
+bool Remove(Id* id, MessageQueue::Id* queue);
+
+/**
+@brief block until at least one of the sources is ready
+@param id the poller
+@param ready array to place the sources that are ready
+@param maxReady the size of the array
+@return the number of sources that are ready
+*/
+int Wait(Id* id, Ready* ready, unsigned int maxReady);
+
+/**
+@brief the same as Wait without blocking
+@return the number of sources that are ready (0 if none)
+*/
+int TryWait(Id* id, Ready* ready, unsigned int maxReady);
+
+/**
+@brief the same as Wait only return after the timeout if no source is ready
+@return the number of sources that are ready (0 if the timeout passed)
+*/
+int TimedWait(Id* id, Ready* ready, unsigned int maxReady, milliseconds_t milliDuration);
+
+/**
+@brief delete the poller, the sources are not affected
+@param id the poller, would be set to NULL
+*/
+void Delete(Id*& id);
+
+} // end of namespace Poller
+
+} // end of namespace osal
@@ -140,6 +140,14 @@ bool TryReadLock(Id* id);
  */
 bool TimedReadLock(Id* id, milliseconds_t milliTimeout);
 
+/**
+ * @brief the same as above with timeout in finer resolution than milliseconds (see Duration in OsalGeneralDefines.h)
+ * @param id the mutex id
+ * @param timeout the timeout to wait for the lock to become available
+ * @return false if the mutex was not given from reading, true if the mutex was taken
+ */
+bool TimedReadLock(Id* id, const Duration& timeout);
+
 /**
  * @brief lock the mutex for writing
  * This function would lock the mutex exclusively in the sense that
@@ -174,6 +182,14 @@ bool TryWriteLock(Id* id);
  */
 bool TimedWriteLock(Id* id, milliseconds_t milliTimeout);
 
+/**
+ * @brief the same as above with timeout in finer resolution than milliseconds (see Duration in OsalGeneralDefines.h)
+ * @param id the mutex id
+ * @param timeout the max timeout to wait before return false
+ * @return false if the thread did not lock the mutex, true if it did
+ */
+bool TimedWriteLock(Id* id, const Duration& timeout);
+
 /**
  * @brief any thread that locked this mutex must call this function to release it to other threads
  * This function must be called when ever the mutex was successfully locked (by any of the
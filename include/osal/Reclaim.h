@@ -0,0 +1,186 @@
+#pragma once
+/**
+@file Reclaim.h
+
+This would allow lock free data structures (queues, lists, snapshots of configuration) to free
+the nodes that were removed from them, while other threads may still be reading these nodes.
+A node that was unlinked from the structure is not freed directly - it is "retired" into the
+reclaim domain, and the domain would free it only once no thread can hold a pointer to it.
+
+Two ways to protect the nodes are supported, and they can be mixed in the same domain -
+- epochs: the reader mark the code that access the structure with Enter and Leave (or a Guard).
+  This cost a single store and a memory barrier no matter how many nodes are accessed, and
+  is the right choice for short operations (push, pop, lookup). A thread that stay inside
+  for long time would keep all the retired nodes in the domain from being freed.
+- hazard pointers: the reader protect each node it is holding with Protect before accessing it.
+  This cost a barrier for each node, but only the protected nodes are kept from being freed, so
+  this is the right choice for readers that hold a node for long time (an iterator, a snapshot
+  that is used while processing).
+
+Each thread keep the nodes it retired in its own lists (for each epoch), so retiring a node is
+not taking any lock. Every few retired nodes the thread try to move the domain to the next epoch
+and free the nodes that are two epochs old and are not protected by any hazard pointer.
+The nodes are freed by calling the function that was given to Create, so they can be returned
+to a MemoryPool (or any other allocator).
+
+The use case for this module is as follow -
+
+struct NodesPool
+{
+  Mutex::Id* Lock;
+  MemoryPool Nodes;
+};
+
+void FreeNode(void* node, void* context)
+{
+  NodesPool* pool = static_cast<NodesPool*>(context);
+  Mutex::Lock(pool->Lock);          // MemoryPool is not thread safe, and nodes are freed from
+  pool->Nodes.Free(node);           // the threads that retired them
+  Mutex::Release(pool->Lock);
+}
+
+Reclaim::Id* domain = Reclaim::Create(FreeNode, &nodesPool);
+
+in the readers -
+{
+  Reclaim::Guard guard(domain);
+  for (Node* node = head; node; node = node->Next)
+  ...
+}
+
+or with hazard pointers for long time -
+Node* node = Reclaim::Protect(domain, 0, head);
+... (node is safe to use until the slot is cleared or used for other node)
+Reclaim::Clear(domain, 0);
+
+and in the thread that remove a node (it must be unlinked first) -
+if (CompareAndSwap(&head, node, node->Next))
+{
+  Reclaim::Retire(domain, node);
+}
+
+Note that Protect only protect a node if the source it is reading from still point to it
+after the hazard pointer was published, so the source must be the link that the node is
+removed from before it is retired. Each thread has HAZARDS slots in each domain.
+The free function may be called from any thread that is using the domain, and a few threads may
+call it at the same time. Nodes that are still retired when a thread exit are freed by the next
+thread that start to use the domain, and all the nodes that are left are freed by Delete.
+This is only supported on Linux, on other platforms Create would report a critical error.
+*/
+#include "osal/OsalGeneralDefines.h"  // at_error_fun
+
+namespace osal
+{
+
+namespace Reclaim
+{
+
+struct Id;
+
+/**
+define the type of the function that free the retired nodes
+*/
+typedef void (*free_func_t)(void* node, void* context);
+
+enum
+{
+  HAZARDS = 4   // the number of hazard pointers each thread has in each domain
+};
+
+/**
+@brief this function would register a callback function to be called when critical error has happened
+@param func the function to be called at exit
+*/
+void RegisterAtExit(at_error_fun func);
+
+/**
+@brief create a reclaim domain
+@param func this would be called to free each retired node (once it is safe)
+@param context would be passed to func
+*/
+Id* Create(free_func_t func, void* context);
+
+/**
+@brief start to access the nodes - until Leave is called none of the nodes that this thread can see
+would be freed. Calls to Enter can be nested (Leave must be called the same number of times)
+*/
+void Enter(Id* id);
+
+/**
+@brief done accessing the nodes - the pointers that were read since Enter must not be used after this
+*/
+void Leave(Id* id);
+
+/**
+@brief read a pointer from source and protect the node it point to with the hazard pointer in slot.
+The node would not be freed until the slot is cleared or used to protect other node
+@param slot the hazard pointer to use (smaller than HAZARDS)
+@param source the shared link that point to the node
+@return the node (may be NULL if the source is NULL)
+*/
+void* Protect(Id* id, unsigned int slot, void* const volatile* source);
+
+/**
+@brief the same as above for typed links, for example Node* node = Protect(domain, 0, head);
+*/
+template<typename T>
+T* Protect(Id* id, unsigned int slot, T* const volatile& source)
+{
+  return static_cast<T*>(Protect(id, slot, reinterpret_cast<void* const volatile*>(&source)));
+}
+
+/**
+@brief stop protecting the node in slot
+*/
+void Clear(Id* id, unsigned int slot);
+
+/**
+@brief free the node once no thread can access it. The node must not be reachable from the shared
+structure when this is called (and must not be retired more than once)
+*/
+void Retire(Id* id, void* node);
+
+/**
+@brief try to free the nodes that the calling thread retired (this would not block)
+@return the number of nodes that this thread retired and are still waiting to be freed
+*/
+unsigned int Flush(Id* id);
+
+/**
+@return the number of nodes that were retired (by all the threads) and were not freed yet
+*/
+unsigned int Pending(Id* id);
+
+/**
+@brief free all the retired nodes and delete the domain. No thread may be using the domain when
+this is called
+@param id the domain, would be set to NULL
+*/
+void Delete(Id*& id);
+
+/**
+@brief Enter the domain for the life time of this object
+*/
+class Guard
+{
+public:
+  explicit Guard(Id* id) : mId(id)
+  {
+    Enter(mId);
+  }
+
+  ~Guard()
+  {
+    Leave(mId);
+  }
+
+private:
+  Guard(const Guard&);
+  Guard& operator = (const Guard&);
+
+  Id* mId;
+};
+
+} // end of namespace Reclaim
+
+} // end of namespace osal
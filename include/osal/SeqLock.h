@@ -0,0 +1,315 @@
+#pragma once
+/**
+@file SeqLock.h
+
+This would be a sequence lock - a way to protect small data that is read very often
+and changed rarely (configuration, masks etc.) without any cost for the readers beyond
+reading the data itself.
+The lock has a sequence number that the writer is making odd before it change the data and
+even again after it finished. A reader read the sequence, copy the data and then read the
+sequence again - if it was odd or it was changed, a writer was changing the data while
+we were reading it, and we just read it again. So the readers are never writing to the
+shared memory (they don't move the cache line between the CPUs as a mutex or RW mutex
+would do), and they are never blocking the writers. Writers are serialized between them by
+the sequence number itself (a writer that find it odd would spin until the other writer finished).
+
+The use case for this module is as follow -
+
+struct TraceConfig
+{
+  unsigned int ColourMask;
+  unsigned int Level;
+};
+
+osal::SeqLock<TraceConfig> traceConfig;
+
+in the threads that read it (on every operation) -
+const TraceConfig config = traceConfig.Read();
+if (config.ColourMask & colour) ...
+
+and in the thread that change it -
+TraceConfig config = { newMask, level };
+traceConfig.Write(config);
+
+or to change only part of it -
+traceConfig.BeginWrite().Level = newLevel;
+traceConfig.EndWrite();
+
+Read and Write are copying the data as raw memory, so T must be trivially copyable (no pointers
+to its own members, no virtual functions, no members with constructors that allocate memory).
+For other types you can read only what you need inside a loop -
+unsigned int ticket = 0;
+do
+{
+  ticket = lock.BeginRead();
+  size = lock.Data().Size;
+} while (!lock.EndRead(ticket));
+
+Note that the values that are read inside the loop may be inconsistent (a writer may be in the middle
+of changing them) until EndRead returned true, so they must not be used for anything (such as
+following a pointer) before that.
+Writers are spinning while other writer is active, so writes should be short and not too
+frequent, otherwise the readers would keep retrying.
+*/
+#include <string.h>     // memcpy
+#if defined(_MSC_VER)
+# include <intrin.h>    // interlocked functions and barriers
+#endif  // _MSC_VER
+
+namespace osal
+{
+
+namespace SeqLockDetails
+{
+
+// the sequence number operations - on gcc (Linux and VxWorks) we are using the atomic builtins,
+// if the compiler is too old for them we are using the older (full barrier) ones
+#if defined(__GNUC__) && defined(__ATOMIC_ACQUIRE)
+
+inline unsigned int LoadAcquire(const volatile unsigned int* at)
+{
+  return __atomic_load_n(at, __ATOMIC_ACQUIRE);
+}
+
+inline unsigned int LoadRelaxed(const volatile unsigned int* at)
+{
+  return __atomic_load_n(at, __ATOMIC_RELAXED);
+}
+
+inline void StoreRelease(volatile unsigned int* at, unsigned int value)
+{
+  __atomic_store_n(at, value, __ATOMIC_RELEASE);
+}
+
+inline bool CompareExchange(volatile unsigned int* at, unsigned int expected, unsigned int desired)
+{
+  return __atomic_compare_exchange_n(at, &expected, desired, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+inline void FenceAcquire()
+{
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+}
+
+inline void FenceRelease()
+{
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+#elif defined(__GNUC__)
+
+inline unsigned int LoadAcquire(const volatile unsigned int* at)
+{
+  const unsigned int value = *at;
+  __sync_synchronize();
+  return value;
+}
+
+inline unsigned int LoadRelaxed(const volatile unsigned int* at)
+{
+  return *at;
+}
+
+inline void StoreRelease(volatile unsigned int* at, unsigned int value)
+{
+  __sync_synchronize();
+  *at = value;
+}
+
+inline bool CompareExchange(volatile unsigned int* at, unsigned int expected, unsigned int desired)
+{
+  return __sync_bool_compare_and_swap(at, expected, desired);
+}
+
+inline void FenceAcquire()
+{
+  __sync_synchronize();
+}
+
+inline void FenceRelease()
+{
+  __sync_synchronize();
+}
+
+#elif defined(_MSC_VER)
+
+// on x86 the loads and the stores are already ordered, we only need to stop the compiler
+inline unsigned int LoadAcquire(const volatile unsigned int* at)
+{
+  const unsigned int value = *at;
+  _ReadWriteBarrier();
+  return value;
+}
+
+inline unsigned int LoadRelaxed(const volatile unsigned int* at)
+{
+  return *at;
+}
+
+inline void StoreRelease(volatile unsigned int* at, unsigned int value)
+{
+  _ReadWriteBarrier();
+  *at = value;
+}
+
+inline bool CompareExchange(volatile unsigned int* at, unsigned int expected, unsigned int desired)
+{
+  return _InterlockedCompareExchange(reinterpret_cast<volatile long*>(at), (long)desired, (long)expected) ==
+         (long)expected;
+}
+
+inline void FenceAcquire()
+{
+  _ReadWriteBarrier();
+}
+
+inline void FenceRelease()
+{
+  _ReadWriteBarrier();
+}
+
+#else
+# error "sequence lock is not supported for this compiler"
+#endif  // __GNUC__ && __ATOMIC_ACQUIRE
+
+// used while waiting for the writer to finish
+inline void Relax()
+{
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+  __builtin_ia32_pause();
+#elif defined(_MSC_VER)
+  _mm_pause();
+#endif  // __GNUC__ && x86
+}
+
+} // end of namespace SeqLockDetails
+
+template<typename T>
+class SeqLock
+{
+public:
+  SeqLock() : mSequence(0), mData()
+  {
+  }
+
+  explicit SeqLock(const T& value) : mSequence(0), mData(value)
+  {
+  }
+
+  /**
+  @brief read the data - this would retry as long as a writer is changing it
+  @return a consistent copy of the data
+  */
+  T Read() const
+  {
+    T value;
+    while (!TryRead(value))
+    {
+      SeqLockDetails::Relax();
+    }
+    return value;
+  }
+
+  /**
+  @brief make a single attempt to read the data
+  @param value would be set to the data (only if this return true)
+  @return false if a writer was changing the data while we were reading it
+  */
+  bool TryRead(T& value) const
+  {
+    const unsigned int ticket = SeqLockDetails::LoadAcquire(&mSequence);
+    if (ticket & WRITING)
+    {
+      return false;
+    }
+    T copy;
+    memcpy(&copy, &mData, sizeof(T));
+    if (!EndRead(ticket))
+    {
+      return false;
+    }
+    value = copy;
+    return true;
+  }
+
+  /**
+  @brief start a read of the data in place (see the file comments), this would spin while a writer is active
+  @return the ticket to pass to EndRead
+  */
+  unsigned int BeginRead() const
+  {
+    unsigned int ticket = SeqLockDetails::LoadAcquire(&mSequence);
+    while (ticket & WRITING)
+    {
+      SeqLockDetails::Relax();
+      ticket = SeqLockDetails::LoadAcquire(&mSequence);
+    }
+    return ticket;
+  }
+
+  /**
+  @return true if the values that were read since BeginRead are consistent, false if we need to read again
+  */
+  bool EndRead(unsigned int ticket) const
+  {
+    SeqLockDetails::FenceAcquire();  // the reads of the data must be done before we check the sequence again
+    return SeqLockDetails::LoadRelaxed(&mSequence) == ticket;
+  }
+
+  /**
+  @brief the data to read from between BeginRead and EndRead, or to change between BeginWrite and EndWrite
+  */
+  const T& Data() const
+  {
+    return mData;
+  }
+
+  /**
+  @brief replace the data, the readers would see either the old or the new data (but never a mix of them)
+  */
+  void Write(const T& value)
+  {
+    BeginWrite();
+    memcpy(&mData, &value, sizeof(T));
+    EndWrite();
+  }
+
+  /**
+  @brief start to change the data in place, this would spin while other writer is active.
+  EndWrite must be called once the change is done
+  @return the data to change
+  */
+  T& BeginWrite()
+  {
+    for (;;)
+    {
+      const unsigned int current = SeqLockDetails::LoadRelaxed(&mSequence);
+      if (!(current & WRITING) && SeqLockDetails::CompareExchange(&mSequence, current, current + 1))
+      {
+        break;
+      }
+      SeqLockDetails::Relax();
+    }
+    SeqLockDetails::FenceRelease();  // the sequence must be odd before any change to the data is seen
+    return mData;
+  }
+
+  void EndWrite()
+  {
+    SeqLockDetails::StoreRelease(&mSequence, SeqLockDetails::LoadRelaxed(&mSequence) + 1);
+  }
+
+private:
+  SeqLock(const SeqLock&);
+  SeqLock& operator = (const SeqLock&);
+
+  enum
+  {
+    WRITING = 1   // the sequence is odd while a writer is changing the data
+  };
+
+  volatile unsigned int mSequence;
+  T mData;
+};
+
+} // end of namespace osal
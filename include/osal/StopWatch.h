@@ -1,14 +1,14 @@
 #ifndef STOPWATCH_DEF_H
 #define STOPWATCH_DEF_H
 
-#include "osal/OsalGeneralDefines.h"  // milliseconds_t
-#ifndef __VXWORKS__
-# include <boost/date_time/posix_time/posix_time_types.hpp>
-#endif  // __VXWORKS__
+#include "osal/OsalGeneralDefines.h"  // milliseconds_t, nanoseconds_t
 
 namespace osal
 {
   // use this class to measure that time pass between 2 points in the execusion of the code
+  // the time is taken from a monotonic clock so it would not be affected by changes to the system time.
+  // On Linux this is the invariant TSC (calibrated once against CLOCK_MONOTONIC_RAW) when the CPU
+  // support it, and CLOCK_MONOTONIC_RAW otherwise. On VxWorks the resolution is the system tick
 class StopWatchOper
 {
 public:
@@ -17,14 +17,17 @@ public:
   osal::milliseconds_t Pause() const; // return the current time that was measured, not realy stop the clock
   
   osal::milliseconds_t Stop();  // this would ensure that the clock would reset! return current value
+
+  osal::nanoseconds_t PauseNano() const; // same as Pause, only in nanoseconds
+
+  osal::nanoseconds_t StopNano();  // same as Stop, only in nanoseconds
+
+  // the current time from the clock that is used by the stop watch - this has no meaning by itself,
+  // but the difference between two calls is the time that passed in nanoseconds
+  static osal::nanoseconds_t Now();
   
 private:
-#ifdef __VXWORKS__
-  osal::milliseconds_t 
-#else
-  boost::posix_time::ptime
-#endif  // __VXWORKS__
-                        mInitialValue;
+  osal::nanoseconds_t mInitialValue;
 };
 
 } // end of namespace osal
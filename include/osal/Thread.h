@@ -275,6 +275,82 @@ enum PriorityType
 
 struct Id;
 
+/**
+@struct CpuSet
+@brief set of CPUs on which a thread is allowed to run
+
+This is the same as cpu_set_t under Linux and cpuset_t under VxWorks SMP.
+An empty set (the default) mean that the thread can run on any CPU, and 
+the OS would choose where to run it. Note that binding threads to CPUs
+is not portable, and on some platforms it is not supported at all
+(in that case setting this would have no effect)
+*/
+struct CpuSet
+{
+  enum
+  {
+    MAX_CPUS = 256
+  };
+
+  CpuSet()
+  {
+    Reset();
+  }
+
+  /// allow the thread to run on this CPU
+  void Set(unsigned int cpu)
+  {
+    if (cpu < MAX_CPUS)
+    {
+      Mask[cpu / BITS_IN_WORD] |= (1UL << (cpu % BITS_IN_WORD));
+    }
+  }
+
+  /// remove this CPU from the set of CPUs the thread can run on
+  void Clear(unsigned int cpu)
+  {
+    if (cpu < MAX_CPUS)
+    {
+      Mask[cpu / BITS_IN_WORD] &= ~(1UL << (cpu % BITS_IN_WORD));
+    }
+  }
+
+  bool IsSet(unsigned int cpu) const
+  {
+    return cpu < MAX_CPUS && (Mask[cpu / BITS_IN_WORD] & (1UL << (cpu % BITS_IN_WORD))) != 0;
+  }
+
+  /// @return true if no CPU was set - that is no restrictions on where to run
+  bool Empty() const
+  {
+    for (unsigned int i = 0; i < WORDS; i++)
+    {
+      if (Mask[i])
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void Reset()
+  {
+    for (unsigned int i = 0; i < WORDS; i++)
+    {
+      Mask[i] = 0;
+    }
+  }
+
+private:
+  enum
+  {
+    BITS_IN_WORD = sizeof(unsigned long) * 8,
+    WORDS = MAX_CPUS / BITS_IN_WORD
+  };
+
+  unsigned long Mask[WORDS];
+};
+
 /**
 @struct ThreadAttributes
 @brief arguments passed when creating a thread
@@ -291,6 +367,7 @@ struct Attributes
 	const char* Name;
 	unsigned int StackSize;
 	PriorityType Priority;
+	CpuSet Affinity;    // by default this is empty - the thread can run on any CPU
 
 	/// default ctor
 	Attributes();
@@ -304,10 +381,22 @@ struct Attributes
 	*/
 	Attributes(const char* name, unsigned int stackSize,
 				PriorityType prio);
+
+	/**
+		@brief constract this object with parameters
+		@param name the thread name
+		@param stackSize the size of the stakc in bytes
+		@param prio the priotity of the thread - if this is set to INVALID_PRIORITY, then use the creating task priority
+		@param affinity the set of CPUs the thread is allowed to run on
+	*/
+	Attributes(const char* name, unsigned int stackSize,
+				PriorityType prio, const CpuSet& affinity);
 };
 
 Attributes CreateAttribute(const char* name, unsigned int sSize, PriorityType);
 
+Attributes CreateAttribute(const char* name, unsigned int sSize, PriorityType, const CpuSet& affinity);
+
 /**
 @brief this function would register a callback function to be called when critical error has happened
 @param func the function to be called at exit
@@ -346,6 +435,9 @@ Id* Create(const Attributes& attr, entry_func_t entryFunc);
 @brief This function would return the priority of the given thread
 @param to the thread that we would like to set the priority to
 @return the old priority
+Note that under Linux the priority is mapped to real time scheduling (SCHED_FIFO) if the
+process is allowed to use it, else to nice level, in both cases this would return the 
+priority as it was given to the thread
 */
 PriorityType Priority(Id* to);
 
@@ -356,6 +448,22 @@ PriorityType Priority(Id* to);
  */
 void NewPriority(Id* to, PriorityType newPrio);
 
+/**
+ * @brief limit the thread with the given id to run only on the given set of CPUs
+ * @param to the thread to which the affinity is set
+ * @param cpus the CPUs on which the thread can run, empty set would allow all CPUs
+ * @return false if this is not supported on this platform or the set is not valid for this machine
+ */
+bool NewAffinity(Id* to, const CpuSet& cpus);
+
+/**
+ * @brief get the set of CPUs the thread with the given id is allowed to run on
+ * @param of the thread to read the affinity from
+ * @param cpus would be set to the CPUs, an empty set mean that the thread is not bound (on VxWorks)
+ * @return false if this is not supported on this platform (cpus would be empty)
+ */
+bool Affinity(Id* of, CpuSet& cpus);
+
 /**
 @brief this function would return the thread name
 @param id the id of the thread that we would like to get its name
@@ -384,13 +492,25 @@ resources allocated for the thread that we are deleting
 For VxWorks this would call the taskDelete function. Since the taskDelete
 may not actually stop the other thread the return value must be checked. Note that
 if the time was pass we would force the deletion of the task! so this would
-always succeed under VxWorks
+always succeed under VxWorks. Under Linux if the time pass we would cancel the 
+thread (it would exit at the next cancellation point) and detach from it, in this
+case the return value is false. The waits of the OSAL objects are cancellation points,
+including the mutex locks (a thread that is blocked on a PRIORITY_SAFE mutex may need
+up to 100 milliseconds to see that it was cancelled)
 @param id the id of the thread that need to be de-allocated
 @param milliDuration time to wait for the thread to exit by itself
 @return true value if successfully de-allocated resources of this thread
 */
 bool TimeClean(Id*& id, milliseconds_t milliDuration);
 
+/**
+@brief the same as above with timeout in finer resolution than milliseconds (see Duration in OsalGeneralDefines.h)
+@param id the id of the thread that need to be de-allocated
+@param duration time to wait for the thread to exit by itself
+@return true value if successfully de-allocated resources of this thread
+*/
+bool TimeClean(Id*& id, const Duration& duration);
+
 /**
  * @brief collection of functions that would be used to operate on the current thread
  * This is a collection of functions that do not need to have the thread id as parameter
@@ -429,6 +549,13 @@ Thread::PriorityType Priority();
  */
 void NewPriority(Thread::PriorityType newPrio);
 
+/**
+ * @brief limit the current thread to run only on the given set of CPUs
+ * @param cpus the CPUs on which the thread can run, empty set would allow all CPUs
+ * @return false if this is not supported on this platform or the set is not valid for this machine
+ */
+bool NewAffinity(const CpuSet& cpus);
+
 /**
 @brief this function would return the current thread name
 @return the thread name
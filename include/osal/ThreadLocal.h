@@ -0,0 +1,276 @@
+#pragma once
+/**
+@file ThreadLocal.h
+
+This would give each thread its own copy of a value - per thread caches, counters that are
+changed on every operation, trace buffers etc. Since each thread only change its own copy,
+there is no need for a lock or an atomic operation, and the cache lines are not moved between
+the CPUs.
+The value is created (with its default constructor) the first time a thread access it, and it
+is deleted when the thread exit. Before it is deleted, the function that was given to the
+constructor (if any) is called with it - for example to add the thread's counter to a total.
+The values of all the threads that are alive can be visited with ForEach, so that a total
+can be calculated.
+
+Each thread keep a pointer to its value in a thread local variable - on Linux this is a __thread
+variable (so reading it is a single load relative to the %fs register), and on VxWorks this is a
+task variable (taskVarAdd), that is switched with the task, so reading it is a single load as well.
+On the other platforms the value is found with thread specific storage of the OS.
+
+The use case for this module is as follow -
+
+struct Counter
+{
+  Counter() : Packets(0)
+  {
+  }
+
+  volatile unsigned long long Packets;
+};
+
+void AddToTotal(Counter& counter, void* context)
+{
+  *static_cast<unsigned long long*>(context) += counter.Packets;
+}
+
+unsigned long long exited = 0;
+ThreadLocal<Counter> packets(AddToTotal, &exited);
+
+in the threads that are counting -
+++packets.Get().Packets;
+
+and to read the total -
+unsigned long long total = exited;
+packets.ForEach(AddToTotal, &total);
+
+Note that the thread local variable is shared by all the objects of the same type, so only one
+object of each ThreadLocal<T, Tag> can use it at any time. Another object of the same type that is
+created while the first one is alive would still work (each object has its own values), but it would
+find the value with the thread specific storage of the OS, which is slower. If you need more than one
+object for the same type, give each a different tag -
+struct RxTag;
+struct TxTag;
+ThreadLocal<Counter, RxTag> rxPackets;
+ThreadLocal<Counter, TxTag> txPackets;
+
+The values of the other threads are read by ForEach while these threads may be changing them, so the
+fields that are read should be volatile (or atomic), and the threads must not keep a reference to their
+value after the object was deleted. The exit function and ForEach are never called at the same time
+(they are called under the same lock), so a value is never visited after the exit function was called
+with it.
+Note that the values of the threads that are still alive when the object is deleted are deleted
+without calling the exit function.
+*/
+#include <assert.h>   // assert macro
+
+#if defined(__linux__)
+# define OSAL_THREAD_LOCAL_SLOT __thread      // the pointer to the value is kept in a __thread variable
+#elif defined(__VXWORKS__)
+# define OSAL_THREAD_LOCAL_SLOT               // the pointer is a global variable that is made a task variable
+#endif  // __linux__
+
+namespace osal
+{
+
+// the part that is not depending on the type of the value - this is implemented by each platform
+namespace ThreadLocalDetails
+{
+
+struct Id;
+
+typedef void* (*create_func_t)();
+typedef void (*exit_func_t)(void* value, void* owner);
+typedef void (*delete_func_t)(void* value);
+typedef void (*visit_func_t)(void* value, void* context);
+
+/**
+@brief create the thread local storage
+@param create would be called to create the value in each thread
+@param atExit would be called when the thread exit (with the iteration blocked)
+@param remove would be called to delete the value once it is no longer used
+@param owner would be passed to atExit
+*/
+Id* Create(create_func_t create, exit_func_t atExit, delete_func_t remove, void* owner);
+
+/**
+@brief create the value for the calling thread (this is called when the thread access it for the first time)
+@param slot the thread local variable that the value would be stored at (may be NULL if there is none)
+@return the new value
+*/
+void* Attach(Id* id, void** slot);
+
+/**
+@return the value of the calling thread, create it if it is not there yet
+*/
+void* Get(Id* id);
+
+#ifdef OSAL_THREAD_LOCAL_SLOT
+/**
+@brief take the thread local variable of the type for the given object
+@param user the object that is using the variable now (NULL if no one)
+@return false if another object is using it
+*/
+bool TakeSlot(void* volatile* user, void* self);
+
+/**
+@brief give back the thread local variable that was taken with TakeSlot
+*/
+void GiveSlot(void* volatile* user, void* self);
+#endif  // OSAL_THREAD_LOCAL_SLOT
+
+/**
+@brief call func for the values of all the threads that are alive
+*/
+void ForEach(Id* id, visit_func_t func, void* context);
+
+/**
+@return the number of threads that have a value
+*/
+unsigned int Count(Id* id);
+
+/**
+@brief delete all the values and the storage. The threads must not use the values after this
+@param id would be set to NULL
+*/
+void Delete(Id*& id);
+
+} // end of namespace ThreadLocalDetails
+
+template<typename T, typename Tag = T>
+class ThreadLocal
+{
+public:
+  /**
+  define the type of the function that is called with the thread's value when the thread exit
+  */
+  typedef void (*exit_func_t)(T& value, void* context);
+
+  /**
+  define the type of the function that is called with each thread's value by ForEach
+  */
+  typedef void (*visit_func_t)(T& value, void* context);
+
+  /**
+  @param atExit if not NULL, this would be called with the value of each thread that exit
+  @param context would be passed to atExit
+  */
+  explicit ThreadLocal(exit_func_t atExit = 0, void* context = 0) : mAtExit(atExit), mContext(context),
+                      mId(ThreadLocalDetails::Create(Create, Exit, Remove, this)), mSlot(false)
+  {
+#ifdef OSAL_THREAD_LOCAL_SLOT
+    // only one object at a time can use the thread local variable (see the comments above)
+    mSlot = ThreadLocalDetails::TakeSlot(&sSlotUser, this);
+#endif  // OSAL_THREAD_LOCAL_SLOT
+  }
+
+  ~ThreadLocal()
+  {
+    ThreadLocalDetails::Delete(mId);  // this clear the variable in the threads that are still alive
+#ifdef OSAL_THREAD_LOCAL_SLOT
+    if (mSlot)
+    {
+      ThreadLocalDetails::GiveSlot(&sSlotUser, this);
+    }
+#endif  // OSAL_THREAD_LOCAL_SLOT
+  }
+
+  /**
+  @return the value of the calling thread (it is created if this is the first time this thread access it)
+  */
+  T& Get()
+  {
+#ifdef OSAL_THREAD_LOCAL_SLOT
+    if (mSlot)
+    {
+      T* const value = sValue;
+      if (value)
+      {
+        return *value;
+      }
+      return *static_cast<T*>(ThreadLocalDetails::Attach(mId, reinterpret_cast<void**>(&sValue)));
+    }
+#endif  // OSAL_THREAD_LOCAL_SLOT
+    return *static_cast<T*>(ThreadLocalDetails::Get(mId));
+  }
+
+  T* operator -> ()
+  {
+    return &Get();
+  }
+
+  T& operator * ()
+  {
+    return Get();
+  }
+
+  /**
+  @brief call func with the value of each thread that is alive (and accessed its value)
+  */
+  void ForEach(visit_func_t func, void* context)
+  {
+    Visitor visitor = { func, context };
+    ThreadLocalDetails::ForEach(mId, Visit, &visitor);
+  }
+
+  /**
+  @return the number of threads that have a value
+  */
+  unsigned int Count()
+  {
+    return ThreadLocalDetails::Count(mId);
+  }
+
+private:
+  ThreadLocal(const ThreadLocal&);
+  ThreadLocal& operator = (const ThreadLocal&);
+
+  struct Visitor
+  {
+    visit_func_t Func;
+    void* Context;
+  };
+
+  static void* Create()
+  {
+    return new T();
+  }
+
+  static void Exit(void* value, void* owner)
+  {
+    ThreadLocal* self = static_cast<ThreadLocal*>(owner);
+    if (self->mAtExit)
+    {
+      self->mAtExit(*static_cast<T*>(value), self->mContext);
+    }
+  }
+
+  static void Remove(void* value)
+  {
+    delete static_cast<T*>(value);
+  }
+
+  static void Visit(void* value, void* context)
+  {
+    Visitor* visitor = static_cast<Visitor*>(context);
+    visitor->Func(*static_cast<T*>(value), visitor->Context);
+  }
+
+  exit_func_t mAtExit;
+  void* mContext;
+  ThreadLocalDetails::Id* mId;
+  bool mSlot;   // this object is using the thread local variable
+#ifdef OSAL_THREAD_LOCAL_SLOT
+  static void* volatile sSlotUser;
+  static OSAL_THREAD_LOCAL_SLOT T* sValue;
+#endif  // OSAL_THREAD_LOCAL_SLOT
+};
+
+#ifdef OSAL_THREAD_LOCAL_SLOT
+template<typename T, typename Tag>
+void* volatile ThreadLocal<T, Tag>::sSlotUser = 0;
+
+template<typename T, typename Tag>
+OSAL_THREAD_LOCAL_SLOT T* ThreadLocal<T, Tag>::sValue = 0;
+#endif  // OSAL_THREAD_LOCAL_SLOT
+
+} // end of namespace osal
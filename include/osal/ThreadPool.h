@@ -0,0 +1,165 @@
+#pragma once
+/**
+@file ThreadPool.h
+
+This would be the interface for the thread pool. The pool has a fixed number of worker threads
+(created with osal::Thread, so the priority and CPU affinity from the attributes are used), and
+short tasks can be submitted to it instead of creating a thread for each component.
+
+The pool is built for fine grained tasks - each worker has its own deque of tasks (Chase-Lev
+work stealing deque). Tasks that are submitted from a worker (that is, from inside another task)
+are placed in the worker's own deque without any lock, and the worker run them in LIFO order. A
+worker that has nothing to do steals from the other end of the deque of a random worker, so
+the work is balanced between the workers without a shared queue that all the workers are contending
+on. Tasks that are submitted from other threads are placed in a shared queue that the workers
+are reading when they have nothing in their own deque.
+Idle workers spin for a short time looking for work and then go to sleep, and submitting a
+task would only wake a worker if some are sleeping.
+
+Tasks can be tracked with a group - Wait would return once all the tasks in the group finished.
+While waiting, the calling thread would run tasks from the pool (helping wait) so it is safe
+to wait from inside a task (for example recursive divide and conquer).
+
+The use case for this module is as follow -
+
+ThreadPool::Id* pool = ThreadPool::Create(8, Thread::CreateAttribute("workers", 64 * 1024, Thread::PRIORITY_10));
+
+void Process(void* context)
+{
+  Packet* packet = static_cast<Packet*>(context);
+  ...
+}
+
+ThreadPool::Group group;
+for (unsigned int i = 0; i < count; i++)
+{
+  ThreadPool::Submit(pool, Process, &packets[i], &group);
+}
+ThreadPool::Wait(pool, group);
+
+or for loops over index range -
+
+void Scale(unsigned int begin, unsigned int end, void* context)
+{
+  float* values = static_cast<float*>(context);
+  for (unsigned int i = begin; i < end; i++)
+  {
+    values[i] *= 2;
+  }
+}
+
+ThreadPool::ParallelFor(pool, 0, size, 1024, Scale, values);
+...
+ThreadPool::Delete(pool);
+
+Note that tasks must not block for long time (on I/O for example) since this would take
+a worker from the pool. Tasks that are submitted without a group can not be waited on,
+but Delete would wait for all the tasks that were submitted before it was called.
+The work stealing pool is only implemented for Linux, on other platforms the tasks are
+executed directly from the thread that submitted them.
+*/
+#include "osal/OsalGeneralDefines.h"  // general types
+#include "osal/Thread.h"              // Attributes
+
+namespace osal
+{
+
+namespace ThreadPool
+{
+
+struct Id;
+
+/**
+define the type of the function that is executed by the pool
+*/
+typedef void (*task_func_t)(void* context);
+
+/**
+define the type of the function that is executed by ParallelFor for each part of the range
+*/
+typedef void (*range_func_t)(unsigned int begin, unsigned int end, void* context);
+
+/**
+a task to submit to the pool with SubmitBatch
+*/
+struct Task
+{
+  task_func_t Func;
+  void* Context;
+};
+
+/**
+track a number of tasks so that we can wait for them to finish. A group must not be
+destroyed while there are tasks in it that did not finished
+*/
+struct Group
+{
+  Group() : State(0)
+  {
+  }
+
+  volatile int State;   // this is used by the pool - don't change it
+};
+
+/**
+@brief this function would register a callback function to be called when critical error has happened
+@param func the function to be called at exit
+*/
+void RegisterAtExit(at_error_fun func);
+
+/**
+@brief create the pool and start the workers, this function would never return NULL
+@param workers the number of worker threads, 0 to have a worker for each CPU
+@param attr the attributes for the worker threads (the name is used as prefix for the workers names)
+*/
+Id* Create(unsigned int workers, const Thread::Attributes& attr);
+
+/**
+@brief the number of workers in the pool
+*/
+unsigned int Workers(Id* id);
+
+/**
+@brief add a task to the pool
+@param id the pool
+@param func the function to run
+@param context would be passed to the function
+@param group if not NULL, the group that the task is added to
+*/
+void Submit(Id* id, task_func_t func, void* context, Group* group = 0);
+
+/**
+@brief add number of tasks to the pool - this is cheaper than submitting each of them, since the
+shared queue is locked once and the sleeping workers are woken up with a single call
+*/
+void SubmitBatch(Id* id, const Task tasks[], unsigned int count, Group* group = 0);
+
+/**
+@brief block until all the tasks in the group finished, while waiting this would run other tasks from the pool
+*/
+void Wait(Id* id, Group& group);
+
+/**
+@return the number of tasks in the group that did not finish yet
+*/
+unsigned int Pending(const Group& group);
+
+/**
+@brief run func over the range [begin, end) in parallel and wait for it to finish.
+The range is divided into parts of grain size (the last may be smaller) and each call to func
+is given a single part. The range is split recursively so the workers are stealing large
+parts from each other, and the calling thread is taking part in the work.
+@param grain the size of each part, 0 to let the pool choose it based on the number of workers
+*/
+void ParallelFor(Id* id, unsigned int begin, unsigned int end, unsigned int grain, range_func_t func, void* context);
+
+/**
+@brief stop the workers and delete the pool, all the tasks that were submitted are executed before
+this return. This must not be called from a task that is running in the pool
+@param id the pool, would be set to NULL
+*/
+void Delete(Id*& id);
+
+} // end of namespace ThreadPool
+
+} // end of namespace osal
@@ -0,0 +1,193 @@
+#pragma once
+/**
+@file TimerService.h
+
+This would be the interface for the timer service. The timer service allow to schedule
+a function to be called after some time without creating a thread per timer or polling
+on some stop watch. It is built on a hierarchical timing wheel (4 levels of 256 slots each,
+in the same way that the Linux kernel timers are working) so that scheduling and cancelling
+a timer are O(1) operations, no matter how many timers are pending.
+All the timers are allocated when the service is created (the maximum number of timers is
+given at creation time) so there are no memory allocations when scheduling timers.
+
+The timers are fired in one of two ways -
+1. the service has its own thread (call TimerService::Start) and that thread would fire the timers.
+2. the user is calling TimerService::Poll from its own loop. In this case the user can use
+   TimerService::NextTimeout to know how long it can wait before calling Poll again.
+
+When a timer is fired, its callback is either called directly from the thread that fired it, or,
+if the timer was scheduled with a target message queue, a message is sent to this queue,
+and the thread that is reading from the queue is calling TimerService::Dispatch with this message.
+This allow to run the callbacks in the context of the thread that own the data (for example
+a state machine that has its own queue of events). Note that the queue must be created with
+message size of at least TimerService::MESSAGE_SIZE and that if the queue is full, the thread
+that fire the timers would be blocked until there is a room in the queue.
+
+The use case for this module is as follow -
+
+TimerService::Id* timers = TimerService::Create(MAX_TIMERS, 1);  // 1 millisecond resolution
+TimerService::Start(timers, "timers", osal::Thread::Self::Priority());
+
+void Retransmit(void* context)
+{
+  ...
+}
+
+TimerService::Handle h = TimerService::Schedule(timers, 50, Retransmit, &connection);
+...
+if we got the reply in time -
+TimerService::Cancel(timers, h);
+...
+TimerService::Stop(timers);
+TimerService::Delete(timers);
+
+Or with a target queue -
+TimerService::Schedule(timers, 50, Retransmit, &connection, fsmQueue);
+and in the thread that is reading from fsmQueue -
+int size = MessageQueue::Receive(fsmQueue, buffer, sizeof(buffer));
+if (!TimerService::Dispatch(buffer, size))
+{
+  // this is not a timer message, handle it here
+}
+
+Note that the timer would never fire before the time that was given passed, but it may fire up to
+one resolution unit later (and more if the thread that fire the timers is not running in time).
+Timers that should fire on the same tick are fired at the order of their scheduling.
+The callbacks are called without holding any lock, so they can schedule and cancel timers.
+*/
+#include "osal/OsalGeneralDefines.h"  // milliseconds_t
+#include "osal/Thread.h"              // PriorityType
+
+namespace osal
+{
+
+namespace MessageQueue
+{
+  struct Id;
+} // end of namespace MessageQueue
+
+namespace TimerService
+{
+
+struct Id;
+
+/**
+define the type of the function that would be called when the timer expired
+*/
+typedef void (*timer_func_t)(void* context);
+
+/**
+this would identify a timer that was scheduled, so that it can be cancelled.
+A handle is never reused so it is safe to cancel a timer that has already fired
+*/
+typedef unsigned long long Handle;
+
+const Handle INVALID_HANDLE = 0;
+
+/**
+this is the message that is sent to the target queue when the timer expired.
+The tag is set by the service, so that Dispatch would only call the function of a message
+that was sent by it (and not of some other message of the same size in the queue)
+*/
+struct Expired
+{
+  const void* Tag;
+  timer_func_t Func;
+  void* Context;
+};
+
+enum
+{
+  MESSAGE_SIZE = sizeof(Expired)
+};
+
+/**
+@brief this function would register a callback function to be called when critical error has happened
+@param func the function to be called at exit
+*/
+void RegisterAtExit(at_error_fun func);
+
+/**
+@brief create a new timer service
+The service would not fire any timers until either Start or Poll are called
+@param maxTimers the maximum number of timers that can be pending at the same time
+@param resolution the resolution of the timers in milliseconds (must be larger than 0)
+@return pointer to the new service, this function would never return NULL
+*/
+Id* Create(unsigned int maxTimers, milliseconds_t resolution);
+
+/**
+@brief start a thread that would fire the timers
+@param id the service
+@param name the name of the thread
+@param prio the priority of the thread
+*/
+void Start(Id* id, const char* name, Thread::PriorityType prio);
+
+/**
+@brief stop the thread that was started with Start, this would block
+until the thread exit. Pending timers are not cancelled
+@param id the service
+*/
+void Stop(Id* id);
+
+/**
+@brief schedule a new timer
+@param id the service
+@param milliDelay the time from now in which the timer would fire
+@param func the function to call when the timer fire
+@param context this would be passed to func
+@param target if not NULL the function would be called by the thread that is reading from this queue
+@return a handle to the timer or INVALID_HANDLE if there are already maxTimers pending timers
+*/
+Handle Schedule(Id* id, milliseconds_t milliDelay, timer_func_t func, void* context,
+                MessageQueue::Id* target = 0);
+
+/**
+@brief cancel a pending timer
+@param id the service
+@param timer the handle that was returned from Schedule
+@return true if the timer was cancelled, false if it already fired (or is now firing)
+*/
+bool Cancel(Id* id, Handle timer);
+
+/**
+@brief fire all the timers that expired, this is the integrable tick,
+for when the service is not running its own thread
+@param id the service
+@return the number of timers that were fired
+*/
+unsigned int Poll(Id* id);
+
+/**
+@brief the max time the caller can wait before calling Poll again
+(there may be no timer to fire at that time)
+@param id the service
+@return time in milliseconds, 0 if Poll should be called now
+*/
+milliseconds_t NextTimeout(Id* id);
+
+/**
+@brief the number of timers that are pending
+@param id the service
+*/
+unsigned int Pending(Id* id);
+
+/**
+@brief call the function of the timer that was sent to a queue
+@param msg the message that was read from the queue
+@param size the size of the message
+@return false if this is not a timer message (nothing is called in this case)
+*/
+bool Dispatch(const char* msg, int size);
+
+/**
+@brief delete the service and all the timers that are pending.
+If the service thread is running, it would be stopped first
+@param id the service, would be set to NULL
+*/
+void Delete(Id*& id);
+
+} // end of namespace TimerService
+
+} // end of namespace osal
@@ -0,0 +1,132 @@
+#pragma once
+/**
+@file Topology.h
+
+This would describe the machine we are running on - which CPUs are SMT siblings on the same core,
+which cores share the L2 and L3 caches, and which CPUs belong to each NUMA node - and help to choose
+where to run the threads, so that threads that are passing data between them (a producer and its
+consumer, an Executer and the threads that are calling it) would share a cache, and threads that are
+working on their own data would not compete on the same core.
+
+The placement functions return a CpuSet that can be used directly in the thread attributes
+(or with Thread::NewAffinity). When the topology is not known (on platforms other than Linux, or if
+/sys can't be read) they return an empty set, which mean that the thread can run on any CPU, so the
+code that use them would still work.
+
+The use case for this module is as follow -
+
+spread the workers so that each has its own core (and its own caches if possible) -
+for (unsigned int i = 0; i < workers; i++)
+{
+  threads[i] = Thread::Create(Thread::CreateAttribute("worker", stack, prio, Topology::Spread(i)), Work);
+}
+
+place the consumer close to the producer that is already running -
+Thread::CpuSet cpus = Topology::Near(producer, Topology::L3_CACHE);
+Thread::Id* consumer = Thread::Create(Thread::CreateAttribute("consumer", stack, prio, cpus), Consume);
+
+The topology is read from /sys/devices/system on the first call, and is not changed after that
+(CPUs that are brought online later are not known).
+*/
+#include "osal/Thread.h"  // CpuSet
+
+namespace osal
+{
+
+namespace Topology
+{
+
+/**
+the levels of sharing between the CPUs, from the closest to the farthest
+*/
+enum Level
+{
+  CORE,       // SMT siblings (hyper threads) on the same core
+  L2_CACHE,
+  L3_CACHE,
+  NUMA_NODE,
+  PACKAGE     // the same physical socket
+};
+
+/**
+@struct Cpu
+@brief the location of a single CPU. Each of the domains is identified by the lowest
+numbered CPU in it, so two CPUs share a domain if they have the same value
+*/
+struct Cpu
+{
+  unsigned int Id;        // the OS number of this CPU (what CpuSet is using)
+  unsigned int Core;
+  unsigned int L2;        // if the cache is not reported, this is the same as the core
+  unsigned int L3;        // if the cache is not reported, this is the same as the package
+  unsigned int Node;      // the NUMA node number (0 if NUMA is not supported)
+  unsigned int Package;
+};
+
+/**
+@return the number of CPUs that are known, 0 if the topology is not supported on this platform
+*/
+unsigned int Count();
+
+/**
+@brief get the location of a CPU
+@param index from 0 to Count() - note that this is not the CPU number, since some CPUs may be offline
+@param info would be set to the CPU location
+@return false if the index is not valid
+*/
+bool At(unsigned int index, Cpu& info);
+
+/**
+@brief get the location of a CPU by its OS number
+@return false if this CPU is not known (offline or not exists)
+*/
+bool Find(unsigned int cpu, Cpu& info);
+
+/**
+@return the CPU that the calling thread is running on now, or Count() if this is not supported
+*/
+unsigned int Current();
+
+/**
+@return all the CPUs that share the level with the given CPU (including it), empty if it is not known
+*/
+Thread::CpuSet Domain(unsigned int cpu, Level level);
+
+/**
+@brief placement for the index'th thread in a group of threads that should be as far as possible
+from each other - each NUMA node, L3 and L2 domain get a thread before a second one is placed in it,
+and SMT siblings are only used once all the cores have a thread. Only the CPUs that the process is
+allowed to run on (when the topology was loaded) are used. If there are more threads than these CPUs
+this would start again from the first one
+@return a set with a single CPU
+*/
+Thread::CpuSet Spread(unsigned int index);
+
+/**
+@brief placement for the index'th thread in a group of threads that should be as close as possible
+to each other - the SMT siblings of a core are used first, then the other cores that share the caches
+and only then the next L3 domain and NUMA node. Only the CPUs that the process is allowed to run on
+(when the topology was loaded) are used
+@return a set with a single CPU
+*/
+Thread::CpuSet Compact(unsigned int index);
+
+/**
+@brief the CPUs that share the level with the CPUs the thread is bound to
+@param thread the thread to be close to, NULL for the calling thread (if it is not bound to specific
+CPUs, the CPU it is running on now is used)
+@return the CPUs, empty if the thread is not bound to specific CPUs (so we don't know where it runs)
+*/
+Thread::CpuSet Near(Thread::Id* thread, Level level);
+
+/**
+@brief read the topology again from a different root instead of /sys (for example when the host /sys
+is mounted elsewhere, or in the unit tests). This must not be called while other threads are using
+this module
+@return false if the topology could not be read (in this case the topology would be empty)
+*/
+bool Load(const char* root);
+
+} // end of namespace Topology
+
+} // end of namespace osal
@@ -17,6 +17,18 @@ namespace utils
     osal::Mutex::Release(mGuard);
   }
 
+  osal::Mutex::Id* ThreadStartGuard()
+  {
+    static osal::Mutex::Id* guard = osal::Mutex::Create();
+    return guard;
+  }
+
+namespace
+{
+  // make sure that it is created before main, when there is only one thread
+  osal::Mutex::Id* const START_GUARD = ThreadStartGuard();
+}
+
 
 
 } // end of namespace utils
@@ -0,0 +1,210 @@
+#include "asynccallbacks/details/FutureState.h"  // header file for this cpp file
+#include "osal/EventNotification.h"  // to wait for the value
+#include "osal/Mutex.h"              // to guard the pool
+#include "osal/StopWatch.h"          // to wait for the rest of the timeout
+#include "asynccallbacks/details/AsyncCallbackUtils.h"  // CriticalSection
+#include <assert.h>                  // assert macro
+
+namespace asynccallbacks
+{
+namespace details
+{
+
+namespace
+{
+  // most of the states (the call with few parameters and a small result) are smaller than this
+  const std::size_t POOLED_FUTURE_SIZE = 256;
+  const std::size_t MAX_POOLED_BLOCKS = 1024;
+
+  // the header of each block - the state is placed right after it
+  union BlockHeader
+  {
+    struct
+    {
+      BlockHeader* Next;
+      osal::EventNotification::Id* Event;
+      std::size_t Size;
+    } Info;
+    double mAlign;  // the state must be aligned as anything that it may hold
+    long double mAlignLong;
+  };
+
+  // this is never deleted - futures may still be released while the static objects are destroyed
+  class BlockPool
+  {
+  public:
+    BlockPool() : mGuard(osal::Mutex::Create()), mFree(0), mCount(0)
+    {
+    }
+
+    BlockHeader* Get(std::size_t size)
+    {
+      if (size <= POOLED_FUTURE_SIZE)
+      {
+        utils::CriticalSection cs(mGuard);
+        if (mFree)
+        {
+          BlockHeader* block = mFree;
+          mFree = block->Info.Next;
+          --mCount;
+          return block;
+        }
+        size = POOLED_FUTURE_SIZE;  // so it can be placed in the pool later
+      }
+      BlockHeader* block = static_cast<BlockHeader*>(::operator new(sizeof(BlockHeader) + size));
+      block->Info.Next = 0;
+      block->Info.Event = osal::EventNotification::Create();
+      block->Info.Size = size;
+      return block;
+    }
+
+    void Put(BlockHeader* block)
+    {
+      // the waiters may have left the event signaled
+      while (osal::EventNotification::TryWait(block->Info.Event))
+      {
+      }
+      if (block->Info.Size == POOLED_FUTURE_SIZE)
+      {
+        utils::CriticalSection cs(mGuard);
+        if (mCount < MAX_POOLED_BLOCKS)
+        {
+          block->Info.Next = mFree;
+          mFree = block;
+          ++mCount;
+          return;
+        }
+      }
+      Delete(block);
+    }
+
+  private:
+    static void Delete(BlockHeader* block)
+    {
+      osal::EventNotification::Delete(block->Info.Event);
+      ::operator delete(block);
+    }
+
+    osal::Mutex::Id* mGuard;
+    BlockHeader* mFree;
+    std::size_t mCount;
+  };
+
+  BlockPool& ThePool()
+  {
+    static BlockPool* pool = new BlockPool;
+    return *pool;
+  }
+
+  // make sure that it is created before main, when there is only one thread
+  BlockPool* const THE_POOL = &ThePool();
+} // end of local namespace
+
+void* AllocateFutureBlock(std::size_t size, osal::EventNotification::Id*& event)
+{
+  BlockHeader* block = ThePool().Get(size);
+  event = block->Info.Event;
+  return block + 1;
+}
+
+void FreeFutureBlock(void* memory)
+{
+  ThePool().Put(static_cast<BlockHeader*>(memory) - 1);
+}
+
+// the queue entry and the future are both holding the state
+FutureStateBase::FutureStateBase(osal::EventNotification::Id* event) : mEvent(event), mReferences(2), mReady(0),
+                                                                       mPendingThen(2), mThen(0)
+{
+}
+
+FutureStateBase::~FutureStateBase()
+{
+  if (mThen)
+  {
+    mThen->~Continuation();
+  }
+}
+
+void FutureStateBase::AddRef()
+{
+  ++mReferences;
+}
+
+void FutureStateBase::Release()
+{
+  if (--mReferences == 0)
+  {
+    void* memory = dynamic_cast<void*>(this);  // the block start at the derived class
+    this->~FutureStateBase();
+    FreeFutureBlock(memory);
+  }
+}
+
+bool FutureStateBase::IsReady() const
+{
+  return mReady != 0;
+}
+
+void FutureStateBase::Wait() const
+{
+  while (!IsReady())
+  {
+    osal::EventNotification::Wait(mEvent);
+  }
+  osal::EventNotification::Signal(mEvent);  // so other copies of the future would be released as well
+}
+
+bool FutureStateBase::TimedWait(osal::milliseconds_t timeout) const
+{
+  // the event may be left signaled by an earlier waiter, in which case we would wait
+  // again for what is left of the timeout
+  osal::StopWatchOper sw;
+  osal::milliseconds_t passed = 0;
+  while (!IsReady())
+  {
+    if (passed >= timeout || !osal::EventNotification::TimedWait(mEvent, timeout - passed))
+    {
+      return IsReady();
+    }
+    passed = sw.Pause();
+  }
+  osal::EventNotification::Signal(mEvent);
+  return true;
+}
+
+void FutureStateBase::RethrowError() const
+{
+  assert(IsReady());
+  if (mError)
+  {
+    boost::rethrow_exception(mError);
+  }
+}
+
+void FutureStateBase::Done()
+{
+  ++mReady;   // this is a full barrier, so the value is seen before
+  osal::EventNotification::Signal(mEvent);
+  Continue();
+}
+
+void FutureStateBase::Failed()
+{
+  mError = boost::current_exception();
+  Done();
+}
+
+void FutureStateBase::Continue()
+{
+  // this is called once when the state is ready and once when the continuation is set, the
+  // second one would run it
+  if (--mPendingThen == 0)
+  {
+    assert(mThen);
+    mThen->Run(this);
+  }
+}
+
+} // end of namespace details
+} // end of namespace asynccallbacks
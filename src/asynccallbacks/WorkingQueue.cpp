@@ -1,44 +1,43 @@
 #include "asynccallbacks/details/WorkingQueue.h"
 #include "asynccallbacks/details/WorkingQueueEntry.h"  // the data that would be placed in this queue
-#include "osal/MessageQueue.h"  // we would use a message queue from osal to sync between threads
+#include <boost/message_queue/message_queue.hpp>       // the entries are copied into the slots of this queue
 
 namespace asynccallbacks
 {
-  
-namespace
-{    
-   const unsigned int SIZEOF_OBJECT_TYPE = sizeof(WorkingQueueEntry);
-}
 
-WorkingQueue::WorkingQueue(size_t s) : mId(0), mSize(s)
+WorkingQueue::WorkingQueue(size_t s) : mQueue(new queue_type(s)), mSize(s)
 {
-  mId = osal::MessageQueue::Create(s, SIZEOF_OBJECT_TYPE);
 }
 
 WorkingQueue::~WorkingQueue()
 {
-  osal::MessageQueue::Delete(mId);  // delete the queue
+  delete mQueue;  // delete the queue
 }
 
-bool WorkingQueue::Push(WorkingQueueEntry* val)
+bool WorkingQueue::Push(const WorkingQueueEntry& val)
 {
-  osal::MessageQueue::Send(mId, (char*)val, SIZEOF_OBJECT_TYPE, false);
+  mQueue->push_front(val);
   return true;
 }
-  
+
+bool WorkingQueue::Push(WorkingQueueEntry* val)
+{
+  return Push(*val);
+}
+
 bool WorkingQueue::Pop(WorkingQueueEntry& val)
 {
-  return osal::MessageQueue::Receive(mId, (char*)&val, SIZEOF_OBJECT_TYPE) == (int)SIZEOF_OBJECT_TYPE;
+  mQueue->pop_back(&val);
+  return true;
 }
 
 bool WorkingQueue::Pop(WorkingQueueEntry& val, osal::milliseconds_t maxTimeout)
 {
-  return osal::MessageQueue::TimedReceive(mId, (char*)&val, SIZEOF_OBJECT_TYPE, maxTimeout);
+  return mQueue->try_pop(&val, boost::posix_time::milliseconds(maxTimeout));
 }
-  
+
 std::size_t WorkingQueue::MaxSize() const
 {
-  return mSize*SIZEOF_OBJECT_TYPE;
+  return mSize*sizeof(WorkingQueueEntry);
 }
 } // end of namespace asynccallbacks
-
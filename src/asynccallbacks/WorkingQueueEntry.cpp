@@ -0,0 +1,100 @@
+#include "asynccallbacks/details/WorkingQueueEntry.h"  // header file for this cpp file
+#include "osal/Mutex.h"                                 // to guard the pool
+#include "asynccallbacks/details/AsyncCallbackUtils.h"  // CriticalSection
+
+namespace asynccallbacks
+{
+namespace details
+{
+
+namespace
+{
+  // a bound function with a few strings as parameters is smaller than this
+  const std::size_t POOLED_ENTRY_SIZE = 256;
+  const std::size_t MAX_POOLED_BLOCKS = 1024;
+
+  union Block
+  {
+    Block* mNext;   // only while it is in the pool
+    char   mBytes[POOLED_ENTRY_SIZE];
+    double mAlign;
+    long double mAlignLong;
+  };
+
+  // this is never deleted - entries may still be destroyed while the static objects are destroyed
+  class BlockPool
+  {
+  public:
+    BlockPool() : mGuard(osal::Mutex::Create()), mFree(0), mCount(0)
+    {
+    }
+
+    Block* Get()
+    {
+      {
+        utils::CriticalSection cs(mGuard);
+        if (mFree)
+        {
+          Block* block = mFree;
+          mFree = block->mNext;
+          --mCount;
+          return block;
+        }
+      }
+      return new Block;
+    }
+
+    void Put(Block* block)
+    {
+      {
+        utils::CriticalSection cs(mGuard);
+        if (mCount < MAX_POOLED_BLOCKS)
+        {
+          block->mNext = mFree;
+          mFree = block;
+          ++mCount;
+          return;
+        }
+      }
+      delete block;
+    }
+
+  private:
+    osal::Mutex::Id* mGuard;
+    Block* mFree;
+    std::size_t mCount;
+  };
+
+  BlockPool& ThePool()
+  {
+    static BlockPool* pool = new BlockPool;
+    return *pool;
+  }
+
+  // make sure that it is created before main, when there is only one thread
+  BlockPool* const THE_POOL = &ThePool();
+} // end of local namespace
+
+void* AllocateEntryBlock(std::size_t size)
+{
+  if (size <= sizeof(Block))
+  {
+    return ThePool().Get();
+  }
+  return ::operator new(size);
+}
+
+void FreeEntryBlock(void* memory, std::size_t size)
+{
+  if (size <= sizeof(Block))
+  {
+    ThePool().Put(static_cast<Block*>(memory));
+  }
+  else
+  {
+    ::operator delete(memory);
+  }
+}
+
+} // end of namespace details
+} // end of namespace asynccallbacks
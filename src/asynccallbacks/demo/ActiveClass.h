@@ -24,7 +24,7 @@ class InternalWorker; // gmock object for testing internal expected calls (see E
  *  - Create and initialized internal Executer object
  *  
  *  Executer can support any kind of input parameter.
- *  Limitation: Executer doesn't support return values from any kind.
+ *  The member functions can return values, Executer::Call return a Future for them (see asynccallbacks/Future.h).
  */
 class ActiveClass
 {
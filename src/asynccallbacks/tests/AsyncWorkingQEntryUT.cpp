@@ -163,4 +163,48 @@ TEST_F(TestAsyncWorkingQ, SimpleAsyncTest)
   osal::Thread::Clean(workerT);
 }
 
+struct Counted
+{
+  Counted()
+  {
+    ++alive;
+  }
+  
+  Counted(const Counted&)
+  {
+    ++alive;
+  }
+  
+  ~Counted()
+  {
+    --alive;
+  }
+  
+  void operator () () const
+  {
+  }
+  
+  static int alive;
+};
+
+int Counted::alive = 0;
+
+TEST_F(TestAsyncWorkingQ, QueueReleaseEntries)
+{
+  // the queue must not hold on the entries that were taken from it
+  WorkingQueue queue(2);
+  for (int i = 0; i < 5; ++i)
+  {
+    EXPECT_TRUE(queue.Push(WorkingQueueEntry(Counted())));
+    EXPECT_EQ(1, Counted::alive);
+    WorkingQueueEntry entry;
+    EXPECT_TRUE(queue.Pop(entry, 10));
+    EXPECT_EQ(1, Counted::alive);
+    entry.Clear();
+    EXPECT_EQ(0, Counted::alive);
+  }
+  WorkingQueueEntry entry;
+  EXPECT_FALSE(queue.Pop(entry, 10));
+}
+
 }
@@ -0,0 +1,360 @@
+
+#include "asynccallbacks/Executer.h"
+#include "gtest/gtest.h"
+#include "osal/Thread.h"
+#include "osal/EventNotification.h"
+#include <boost/exception/all.hpp>
+#include <stdexcept>
+#include <string>
+
+using namespace asynccallbacks;
+
+namespace
+{ // all test code is local to this file
+
+  const int EXPECTED_A = 11;
+  const int EXPECTED_B = 41;
+  const std::string EXPECTED_S = "this is the expected string";
+
+  struct ServerError : std::runtime_error
+  {
+    explicit ServerError(int code) : std::runtime_error("server error"), mCode(code)
+    {
+    }
+
+    int mCode;
+  };
+
+  struct NotStandardError
+  {
+  };
+
+  // an active object that return values from its member functions
+  class Server
+  {
+  public:
+    Server() : mExecuter(this, 10), mCalled(0), mBlock(osal::EventNotification::Create())
+    {
+      mExecuter.Start("serverThread");
+    }
+
+    ~Server()
+    {
+      osal::EventNotification::Signal(mBlock);  // so it would not get stuck
+      mExecuter.Stop();
+      osal::EventNotification::Delete(mBlock);
+    }
+
+    Future<int> Sum(int a, int b)
+    {
+      return mExecuter.Call(&Server::sum, a, b);
+    }
+
+    Future<std::string> Echo(const std::string& s)
+    {
+      return mExecuter.Call(&Server::echo, s);
+    }
+
+    Future<void> Touch()
+    {
+      return mExecuter.Call(&Server::touch);
+    }
+
+    Future<int> Throw()
+    {
+      return mExecuter.Call(&Server::throwing);
+    }
+
+    // @param enable throw it with boost::enable_current_exception
+    Future<void> ThrowServerError(bool enable)
+    {
+      return mExecuter.Call(&Server::throwingServerError, enable);
+    }
+
+    Future<void> ThrowNotStandard()
+    {
+      return mExecuter.Call(&Server::throwingNotStandard);
+    }
+
+    // the next calls would not run until Release is called
+    Future<void> Block()
+    {
+      return mExecuter.Call(&Server::block);
+    }
+
+    void Release()
+    {
+      osal::EventNotification::Signal(mBlock);
+    }
+
+    void Stop()
+    {
+      mExecuter.Stop();
+    }
+
+    int Called() const
+    {
+      return mCalled;
+    }
+
+  private:
+    int sum(int a, int b)
+    {
+      ++mCalled;
+      return a + b;
+    }
+
+    std::string echo(const std::string& s) const
+    {
+      return s;
+    }
+
+    void touch()
+    {
+      ++mCalled;
+    }
+
+    int throwing()
+    {
+      throw std::runtime_error("failed");
+    }
+
+    void throwingServerError(bool enable)
+    {
+      if (enable)
+      {
+        throw boost::enable_current_exception(ServerError(EXPECTED_A));
+      }
+      throw ServerError(EXPECTED_A);
+    }
+
+    void throwingNotStandard()
+    {
+      throw NotStandardError();
+    }
+
+    void block()
+    {
+      osal::EventNotification::Wait(mBlock);
+    }
+
+    Executer<Server> mExecuter;
+    int mCalled;
+    osal::EventNotification::Id* mBlock;
+  };
+
+  // an active object that get the results of the server in its own thread
+  class Client
+  {
+  public:
+    Client() : mExecuter(this, 10), mResult(0), mThread(0), mDone(osal::EventNotification::Create())
+    {
+      mExecuter.Start("clientThread");
+    }
+
+    ~Client()
+    {
+      mExecuter.Stop();
+      osal::EventNotification::Delete(mDone);
+    }
+
+    void Ask(Server& server, int a, int b)
+    {
+      server.Sum(a, b).Then(mExecuter, &Client::onSum);
+    }
+
+    bool WaitForResult()
+    {
+      return osal::EventNotification::TimedWait(mDone, 1000);
+    }
+
+    Executer<Client> mExecuter;
+    int mResult;
+    osal::Thread::Id* mThread;
+
+    void onSum(Future<int> result)
+    {
+      EXPECT_TRUE(result.IsReady());
+      mResult = result.Get();
+      mThread = osal::Thread::Self::Id();
+      osal::EventNotification::Signal(mDone);
+    }
+
+  private:
+    osal::EventNotification::Id* mDone;
+  };
+
+  Server* stoppedServer = 0;
+  bool callHung = false;
+
+  // keep calling until the server is stopped - every call that was accepted must run
+  void CallUntilStopped()
+  {
+    for (;;)
+    {
+      Future<int> result = stoppedServer->Sum(EXPECTED_A, EXPECTED_B);
+      if (!result)
+      {
+        return;
+      }
+      int value = 0;
+      if (!result.TimedGet(value, 1000))
+      {
+        callHung = true;
+        return;
+      }
+    }
+  }
+
+TEST(FutureUT, Value)
+{
+  Server server;
+  Future<int> result = server.Sum(EXPECTED_A, EXPECTED_B);
+  ASSERT_TRUE(result);
+  EXPECT_EQ(result.Get(), EXPECTED_A + EXPECTED_B);
+  EXPECT_TRUE(result.IsReady());
+  EXPECT_EQ(server.Echo(EXPECTED_S).Get(), EXPECTED_S);
+}
+
+TEST(FutureUT, Void)
+{
+  Server server;
+  Future<void> result = server.Touch();
+  ASSERT_TRUE(result);
+  result.Get();
+  EXPECT_EQ(server.Called(), 1);
+}
+
+TEST(FutureUT, NotStarted)
+{
+  Server server;
+  server.Stop();
+  Future<int> result = server.Sum(EXPECTED_A, EXPECTED_B);
+  EXPECT_FALSE(result);
+  EXPECT_FALSE(result.Valid());
+  EXPECT_EQ(server.Called(), 0);
+}
+
+TEST(FutureUT, Exception)
+{
+  Server server;
+  Future<int> result = server.Throw();
+  EXPECT_THROW(result.Get(), std::runtime_error);
+  // we can still use the executer after that
+  EXPECT_EQ(server.Sum(EXPECTED_A, EXPECTED_B).Get(), EXPECTED_A + EXPECTED_B);
+}
+
+TEST(FutureUT, CustomException)
+{
+  Server server;
+  Future<void> result = server.ThrowServerError(true);
+  try
+  {
+    result.Get();
+    ADD_FAILURE() << "no exception";
+  }
+  catch (const ServerError& e)
+  {
+    EXPECT_EQ(e.mCode, EXPECTED_A);
+  }
+  // without enable_current_exception we only get the standard base
+  result = server.ThrowServerError(false);
+  try
+  {
+    result.Get();
+    ADD_FAILURE() << "no exception";
+  }
+  catch (const ServerError&)
+  {
+    ADD_FAILURE() << "the type is not expected to be kept";
+  }
+  catch (const std::runtime_error& e)
+  {
+    EXPECT_EQ(std::string(e.what()), "server error");
+  }
+  EXPECT_THROW(server.ThrowNotStandard().Get(), boost::unknown_exception);
+}
+
+TEST(FutureUT, TimedGet)
+{
+  Server server;
+  Future<void> blocked = server.Block();
+  Future<int> result = server.Sum(EXPECTED_A, EXPECTED_B);
+  int value = 0;
+  EXPECT_FALSE(result.IsReady());
+  EXPECT_FALSE(result.TimedGet(value, 10));
+  EXPECT_FALSE(blocked.TimedGet(10));
+  server.Release();
+  EXPECT_TRUE(blocked.TimedGet(1000));
+  EXPECT_TRUE(result.TimedGet(value, 1000));
+  EXPECT_EQ(value, EXPECTED_A + EXPECTED_B);
+}
+
+TEST(FutureUT, CallWhileStopping)
+{
+  for (int i = 0; i < 20 && !callHung; ++i)
+  {
+    Server server;
+    stoppedServer = &server;
+    osal::Thread::Id* caller = osal::Thread::Create(osal::Thread::CreateAttribute("callerT", 64 * 1024,
+                                                                                  osal::Thread::Self::Priority()),
+                                                    CallUntilStopped);
+    osal::Thread::Self::Sleep(1);
+    server.Stop();
+    osal::Thread::Clean(caller);
+  }
+  EXPECT_FALSE(callHung);
+}
+
+TEST(FutureUT, Copies)
+{
+  Server server;
+  Future<int> copy;
+  EXPECT_FALSE(copy);
+  {
+    Future<int> result = server.Sum(EXPECTED_A, EXPECTED_B);
+    copy = result;
+    Future<int> another(result);
+    EXPECT_EQ(another.Get(), EXPECTED_A + EXPECTED_B);
+  }
+  EXPECT_EQ(copy.Get(), EXPECTED_A + EXPECTED_B);
+  // the states are reused, make sure that we still have the right values
+  for (int i = 0; i < 100; ++i)
+  {
+    EXPECT_EQ(server.Sum(i, EXPECTED_B).Get(), i + EXPECTED_B);
+  }
+}
+
+TEST(FutureUT, DroppedFuture)
+{
+  Server server;
+  for (int i = 0; i < 5; ++i)
+  {
+    server.Touch();  // no one is waiting for these
+  }
+  server.Touch().Get();
+  EXPECT_EQ(server.Called(), 6);
+}
+
+TEST(FutureUT, ThenRunOnOtherExecuter)
+{
+  Server server;
+  Client client;
+  client.Ask(server, EXPECTED_A, EXPECTED_B);
+  ASSERT_TRUE(client.WaitForResult());
+  EXPECT_EQ(client.mResult, EXPECTED_A + EXPECTED_B);
+  EXPECT_NE(client.mThread, (osal::Thread::Id*)0);
+}
+
+TEST(FutureUT, ThenAfterReady)
+{
+  Server server;
+  Client client;
+  Future<int> result = server.Sum(EXPECTED_A, EXPECTED_B);
+  result.Wait();
+  result.Then(client.mExecuter, &Client::onSum);
+  ASSERT_TRUE(client.WaitForResult());
+  EXPECT_EQ(client.mResult, EXPECTED_A + EXPECTED_B);
+}
+
+}
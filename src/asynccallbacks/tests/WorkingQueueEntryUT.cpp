@@ -308,4 +308,75 @@ namespace
        EXPECT_EQ(1, Bar::three_args_call);
        EXPECT_EQ(1, Bar::four_args_call);
     }
+    
+    // count the copies of the callable that are alive, the padding set its size
+    template<unsigned int PADDING>
+    struct CountedCall
+    {
+      CountedCall(int* calls) : mCalls(calls)
+      {
+        ++alive;
+      }
+      
+      CountedCall(const CountedCall& other) : mCalls(other.mCalls)
+      {
+        ++alive;
+      }
+      
+      ~CountedCall()
+      {
+        --alive;
+      }
+      
+      void operator () ()
+      {
+        ++*mCalls;
+      }
+      
+      int* mCalls;
+      char mPadding[PADDING];
+      static int alive;
+    };
+    
+    template<unsigned int PADDING>
+    int CountedCall<PADDING>::alive = 0;
+    
+    template<typename C>
+    void TestEntryCopies()
+    {
+      int calls = 0;
+      {
+        WorkingQueueEntry entry = C(&calls);
+        EXPECT_EQ(1, C::alive);
+        WorkingQueueEntry copy(entry);
+        EXPECT_EQ(2, C::alive);
+        WorkingQueueEntry assigned;
+        assigned();   // nothing is registered in it
+        assigned = copy;
+        EXPECT_EQ(3, C::alive);
+        entry();
+        copy();
+        assigned();
+        EXPECT_EQ(3, calls);
+        copy.Clear();
+        copy();
+        EXPECT_EQ(3, calls);
+        EXPECT_EQ(2, C::alive);
+        assigned = WorkingQueueEntry();
+        EXPECT_EQ(1, C::alive);
+      }
+      EXPECT_EQ(0, C::alive);
+    }
+    
+    TEST_F(TestWorkingQ, InlineEntryCopies)
+    {
+      EXPECT_EQ(64u, sizeof(WorkingQueueEntry));
+      TestEntryCopies<CountedCall<8> >();
+    }
+    
+    TEST_F(TestWorkingQ, PooledEntryCopies)
+    {
+      TestEntryCopies<CountedCall<100> >();   // this is too big to be placed in the entry
+      TestEntryCopies<CountedCall<1000> >();  // and this is too big for the pool
+    }
 }
@@ -1,3 +1,5 @@
+#ifndef CRITICAL_SECTION__H
+#define CRITICAL_SECTION__H
 // this would allow for the use of auto mutex, we have 
 // the ctor takes the mutex and the dtor releasing it
 // this assumes that we have a function called take
@@ -29,3 +31,5 @@ private:
 } // end of namespace private
 
 } // end of namespace osal
+
+#endif  // CRITICAL_SECTION__H
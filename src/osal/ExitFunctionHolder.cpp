@@ -40,7 +40,19 @@ namespace
     return true;
   }
 #else
-# define ENTER_CRITICAL_SECTION(lock) // need to define for POSIX as well
+# ifdef __linux__
+#   define ENTER_CRITICAL_SECTION(lock) CriticalSection<FutexLock> __lock_(lock)
+# else
+#   define ENTER_CRITICAL_SECTION(lock) // need to define for POSIX as well
+# endif // __linux__
+  bool WasTimedOut(int err)
+  {
+    return err == ETIMEDOUT;
+  }
+  bool ResourceNotAvial(int err)
+  {
+    return err == EAGAIN || err == EBUSY;
+  }
 #endif  // __VXWORKS__
   
   void DefaultExitFunction(int)
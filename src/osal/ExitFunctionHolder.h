@@ -1,6 +1,8 @@
 #include "osal/OsalGeneralDefines.h"  // general definitions for this package (osal)
 #ifdef __VXWORKS__
 # include "vxworks/SemHandle.h"  // vxworks lock
+#elif defined(__linux__)
+# include "posix/Futex.h"        // linux lock
 #endif  // __VXWROKS__
 // all namespace are under namespace osal
 namespace osal
@@ -57,7 +59,9 @@ private:
                                        // registered by the user
 #ifdef __VXWORKS__
 	semvx::SemHandle 
-#else // for posix put lock here as well
+#elif defined(__linux__)
+	FutexLock
+#else // for other posix put lock here as well
 	int
 #endif  // __VXWORKS__
                   mLock;
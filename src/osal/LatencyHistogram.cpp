@@ -0,0 +1,172 @@
+#include "osal/LatencyHistogram.h" // header for this file
+#include <string.h>                // memset
+
+namespace osal
+{
+
+namespace
+{
+
+const nanoseconds_t MAX_MIN_VALUE = ~0ULL;
+
+unsigned int MostSignificantBit(nanoseconds_t value)
+{
+#ifdef __GNUC__
+  return 63 - __builtin_clzll(value);
+#else
+  unsigned int bit = 0;
+  while (value >>= 1)
+  {
+    ++bit;
+  }
+  return bit;
+#endif  // __GNUC__
+}
+
+} // end of local namespace
+
+LatencyHistogram::LatencyHistogram()
+{
+  Reset();
+}
+
+void LatencyHistogram::Record(nanoseconds_t value)
+{
+  Record(value, 1);
+}
+
+void LatencyHistogram::Record(nanoseconds_t value, unsigned long long count)
+{
+  mCounts[BucketOf(value)] += count;
+  mTotalCount += count;
+  mTotalValue += value * count;
+  if (value < mMin)
+  {
+    mMin = value;
+  }
+  if (value > mMax)
+  {
+    mMax = value;
+  }
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other)
+{
+  for (unsigned int i = 0; i < BUCKETS; i++)
+  {
+    mCounts[i] += other.mCounts[i];
+  }
+  mTotalCount += other.mTotalCount;
+  mTotalValue += other.mTotalValue;
+  if (other.mMin < mMin)
+  {
+    mMin = other.mMin;
+  }
+  if (other.mMax > mMax)
+  {
+    mMax = other.mMax;
+  }
+}
+
+void LatencyHistogram::Reset()
+{
+  memset(mCounts, 0, sizeof(mCounts));
+  mTotalCount = 0;
+  mTotalValue = 0;
+  mMin = MAX_MIN_VALUE;
+  mMax = 0;
+}
+
+unsigned long long LatencyHistogram::Count() const
+{
+  return mTotalCount;
+}
+
+nanoseconds_t LatencyHistogram::Min() const
+{
+  return mTotalCount ? mMin : 0;
+}
+
+nanoseconds_t LatencyHistogram::Max() const
+{
+  return mMax;
+}
+
+nanoseconds_t LatencyHistogram::Mean() const
+{
+  return mTotalCount ? mTotalValue / mTotalCount : 0;
+}
+
+nanoseconds_t LatencyHistogram::Percentile(double percent) const
+{
+  if (mTotalCount == 0)
+  {
+    return 0;
+  }
+  if (percent <= 0.0)
+  {
+    return mMin;
+  }
+  unsigned long long target = static_cast<unsigned long long>(percent * mTotalCount / 100.0 + 0.5);
+  if (target == 0)
+  {
+    target = 1;
+  }
+  unsigned long long seen = 0;
+  for (unsigned int i = 0; i < BUCKETS; i++)
+  {
+    seen += mCounts[i];
+    if (seen >= target)
+    {
+      const nanoseconds_t high = BucketHighValue(i);
+      return high < mMax ? high : mMax;
+    }
+  }
+  return mMax;
+}
+
+unsigned long long LatencyHistogram::CountAt(unsigned int bucket) const
+{
+  return bucket < BUCKETS ? mCounts[bucket] : 0;
+}
+
+// the first SUB_BUCKETS buckets hold the exact values, after that each power of 2
+// is split into SUB_BUCKETS buckets using the bits that are bellow the most significant bit
+unsigned int LatencyHistogram::BucketOf(nanoseconds_t value)
+{
+  if (value < SUB_BUCKETS)
+  {
+    return static_cast<unsigned int>(value);
+  }
+  const unsigned int msb = MostSignificantBit(value);
+  if (msb >= MAX_VALUE_BITS)
+  {
+    return BUCKETS - 1;
+  }
+  const unsigned int shift = msb - SUB_BUCKET_BITS;
+  const unsigned int sub = static_cast<unsigned int>(value >> shift) & (SUB_BUCKETS - 1);
+  return (shift + 1) * SUB_BUCKETS + sub;
+}
+
+nanoseconds_t LatencyHistogram::BucketLowValue(unsigned int bucket)
+{
+  if (bucket < SUB_BUCKETS)
+  {
+    return bucket;
+  }
+  const unsigned int shift = bucket / SUB_BUCKETS - 1;
+  const nanoseconds_t sub = bucket % SUB_BUCKETS;
+  return (SUB_BUCKETS + sub) << shift;
+}
+
+nanoseconds_t LatencyHistogram::BucketHighValue(unsigned int bucket)
+{
+  if (bucket < SUB_BUCKETS)
+  {
+    return bucket;
+  }
+  const unsigned int shift = bucket / SUB_BUCKETS - 1;
+  return BucketLowValue(bucket) + (1ULL << shift) - 1;
+}
+
+} // end of namespace osal
@@ -0,0 +1,37 @@
+#include "osal/LockProfiler.h" // header for for this file
+#ifdef __linux__
+# include "posix/LockProfilerPosix.hpp"
+#else
+// the profiler is only hooked into the Linux locks, on other platforms there is nothing to report
+namespace osal
+{
+
+namespace LockProfiler
+{
+
+void Enable(bool)
+{
+}
+
+bool Enabled()
+{
+  return false;
+}
+
+void Reset()
+{
+}
+
+unsigned int Top(Entry*, unsigned int)
+{
+  return 0;
+}
+
+void Report(unsigned int)
+{
+}
+
+} // end of namespace LockProfiler
+
+} // end of namespace osal
+#endif  // __linux__
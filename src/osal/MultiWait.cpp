@@ -0,0 +1,240 @@
+#include "osal/MultiWait.h" // header for for this file
+#include "ExitFunctionHolder.h"     // hold the exit functions
+#include <errno.h>                  // ETIMEDOUT, ENOSYS
+#if defined(__VXWORKS__) || defined(__linux__)
+#include "osal/EventNotification.h" // the objects to wait on
+#include "osal/CountingSemaphore.h" // the objects to wait on
+#include "osal/MessageQueue.h"      // the objects to wait on
+#include "WaitList.h"               // the waiters on the objects
+#include <vector>                   // the links when there are many objects
+#endif  // __VXWORKS__ || __linux__
+
+namespace osal
+{
+
+namespace MultiWait
+{
+
+namespace
+{
+
+Private::ExitFunctionHolder& ErrorHandler()
+{
+  static Private::ExitFunctionHolder theList;
+  return theList;
+}
+
+#if defined(__VXWORKS__) || defined(__linux__)
+
+enum
+{
+  LOCAL_LINKS = 8   // for more objects than this we allocate the links
+};
+
+// @return the index of the ready object or -1 if none of them is ready
+typedef int (*attempt_func_t)(const WaitObject objects[], unsigned int count);
+
+Private::WaitList& WaitListOf(const WaitObject& object)
+{
+  switch (object.ObjectType)
+  {
+    case WaitObject::EVENT_NOTIFICATION:
+      return EventNotification::WaitListOf(object.Event);
+    case WaitObject::COUNTING_SEMAPHORE:
+      return CountingSemaphore::WaitListOf(object.Semaphore);
+    default:
+      return MessageQueue::WaitListOf(object.Queue);
+  }
+}
+
+// take the object if it is ready, the queues are only checked
+bool Take(const WaitObject& object)
+{
+  switch (object.ObjectType)
+  {
+    case WaitObject::EVENT_NOTIFICATION:
+      return EventNotification::TryWait(object.Event);
+    case WaitObject::COUNTING_SEMAPHORE:
+      return CountingSemaphore::TryWait(object.Semaphore);
+    default:
+      return MessageQueue::CurrentCount(object.Queue) > 0;
+  }
+}
+
+void GiveBack(const WaitObject& object)
+{
+  switch (object.ObjectType)
+  {
+    case WaitObject::EVENT_NOTIFICATION:
+      EventNotification::Signal(object.Event);
+      break;
+    case WaitObject::COUNTING_SEMAPHORE:
+      CountingSemaphore::Post(object.Semaphore);
+      break;
+    default:
+      break;
+  }
+}
+
+int AttemptAny(const WaitObject objects[], unsigned int count)
+{
+  for (unsigned int i = 0; i < count; i++)
+  {
+    if (Take(objects[i]))
+    {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+int AttemptAll(const WaitObject objects[], unsigned int count)
+{
+  for (unsigned int i = 0; i < count; i++)
+  {
+    if (!Take(objects[i]))
+    {
+      while (i > 0)
+      {
+        GiveBack(objects[--i]);
+      }
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// the waiter is registered on all the objects as long as this is in scope
+class Registration
+{
+public:
+  Registration(const WaitObject objects[], unsigned int count, Private::Waiter& waiter) :
+      mObjects(objects), mCount(count), mLinks(mLocal)
+  {
+    if (count > LOCAL_LINKS)
+    {
+      mMore.resize(count);
+      mLinks = &mMore[0];
+    }
+    for (unsigned int i = 0; i < count; i++)
+    {
+      mLinks[i].Owner = &waiter;
+      WaitListOf(objects[i]).Add(&mLinks[i]);
+    }
+  }
+
+  ~Registration()
+  {
+    for (unsigned int i = 0; i < mCount; i++)
+    {
+      WaitListOf(mObjects[i]).Remove(&mLinks[i]);
+    }
+  }
+
+private:
+  Registration(const Registration&);
+  Registration& operator = (const Registration&);
+
+  const WaitObject* mObjects;
+  const unsigned int mCount;
+  Private::WaitLink* mLinks;
+  Private::WaitLink mLocal[LOCAL_LINKS];
+  std::vector<Private::WaitLink> mMore;
+};
+
+// @param timeout NULL to wait forever
+// @return the result of the attempt function, -1 if the timeout passed
+int Waiting(const WaitObject objects[], unsigned int count, const milliseconds_t* timeout, attempt_func_t attempt,
+            const char* func, int line)
+{
+  OSAL_ASSERT_CONDITION(objects && count > 0, ErrorHandler(), "there are no objects to wait on");
+  int ready = attempt(objects, count);   // no need to register if it is already ready
+  if (ready >= 0 || (timeout && *timeout == 0))
+  {
+    return ready;
+  }
+  Private::Waiter waiter(timeout);
+  Registration registration(objects, count, waiter);
+  for (;;)
+  {
+    waiter.Prepare();
+    ready = attempt(objects, count);
+    if (ready >= 0)
+    {
+      return ready;
+    }
+    const int err = waiter.Park();
+    if (err == ETIMEDOUT)
+    {
+      return attempt(objects, count);   // we may have been woken up just now
+    }
+    else if (err)
+    {
+      ErrorHandler().CriticalError(err, func, line);
+      return -1;
+    }
+  }
+}
+
+#endif  // __VXWORKS__ || __linux__
+
+} // end of local namespace
+
+void RegisterAtExit(at_error_fun func)
+{
+  ErrorHandler().Push(func);
+}
+
+#if defined(__VXWORKS__) || defined(__linux__)
+
+int WaitAny(const WaitObject objects[], unsigned int count)
+{
+  return Waiting(objects, count, 0, AttemptAny, __FUNCTION__, __LINE__);
+}
+
+int WaitAny(const WaitObject objects[], unsigned int count, milliseconds_t milliDuration)
+{
+  return Waiting(objects, count, &milliDuration, AttemptAny, __FUNCTION__, __LINE__);
+}
+
+void WaitAll(const WaitObject objects[], unsigned int count)
+{
+  Waiting(objects, count, 0, AttemptAll, __FUNCTION__, __LINE__);
+}
+
+bool WaitAll(const WaitObject objects[], unsigned int count, milliseconds_t milliDuration)
+{
+  return Waiting(objects, count, &milliDuration, AttemptAll, __FUNCTION__, __LINE__) == 0;
+}
+
+#else
+// there are no wait lists on the objects for this platform
+
+int WaitAny(const WaitObject[], unsigned int)
+{
+  ErrorHandler().CriticalError(ENOSYS, __FUNCTION__, __LINE__);
+  return -1;
+}
+
+int WaitAny(const WaitObject[], unsigned int, milliseconds_t)
+{
+  ErrorHandler().CriticalError(ENOSYS, __FUNCTION__, __LINE__);
+  return -1;
+}
+
+void WaitAll(const WaitObject[], unsigned int)
+{
+  ErrorHandler().CriticalError(ENOSYS, __FUNCTION__, __LINE__);
+}
+
+bool WaitAll(const WaitObject[], unsigned int, milliseconds_t)
+{
+  ErrorHandler().CriticalError(ENOSYS, __FUNCTION__, __LINE__);
+  return false;
+}
+
+#endif  // __VXWORKS__ || __linux__
+
+} // end of namespace MultiWait
+
+} // end of namespace osal
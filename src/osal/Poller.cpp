@@ -0,0 +1,94 @@
+#include "osal/Poller.h" // header for for this file
+#ifdef __linux__
+# include "posix/PollerPosix.hpp"
+#else
+// there are no file descriptors for the OS objects on the other platforms, so there is nothing to poll on
+#include "ExitFunctionHolder.h"     // hold the exit functions
+#include <errno.h>                  // ENOSYS
+
+namespace osal
+{
+
+namespace Poller
+{
+
+namespace
+{
+
+Private::ExitFunctionHolder& ErrorHandler()
+{
+  static Private::ExitFunctionHolder theList;
+  return theList;
+}
+
+} // end of local namespace
+
+struct Id
+{
+};
+
+void RegisterAtExit(at_error_fun func)
+{
+  ErrorHandler().Push(func);
+}
+
+Id* Create()
+{
+  ErrorHandler().CriticalError(ENOSYS, __FUNCTION__, __LINE__);
+  return 0;
+}
+
+bool Add(Id*, int, unsigned int, void*)
+{
+  return false;
+}
+
+bool Add(Id*, EventNotification::Id*, void*)
+{
+  return false;
+}
+
+bool Add(Id*, MessageQueue::Id*, void*)
+{
+  return false;
+}
+
+bool Remove(Id*, int)
+{
+  return false;
+}
+
+bool Remove(Id*, EventNotification::Id*)
+{
+  return false;
+}
+
+bool Remove(Id*, MessageQueue::Id*)
+{
+  return false;
+}
+
+int Wait(Id*, Ready*, unsigned int)
+{
+  return 0;
+}
+
+int TryWait(Id*, Ready*, unsigned int)
+{
+  return 0;
+}
+
+int TimedWait(Id*, Ready*, unsigned int, milliseconds_t)
+{
+  return 0;
+}
+
+void Delete(Id*& id)
+{
+  id = 0;
+}
+
+} // end of namespace Poller
+
+} // end of namespace osal
+#endif  // __linux__
@@ -0,0 +1,80 @@
+#include "osal/Reclaim.h" // header for for this file
+#ifdef __linux__
+# include "posix/ReclaimPosix.hpp"
+#else
+// the lock free reclamation is only implemented for Linux (it need thread local records and atomic operations)
+#include "ExitFunctionHolder.h"     // hold the exit functions
+#include <errno.h>                  // ENOSYS
+
+namespace osal
+{
+
+namespace Reclaim
+{
+
+namespace
+{
+
+Private::ExitFunctionHolder& ErrorHandler()
+{
+  static Private::ExitFunctionHolder theList;
+  return theList;
+}
+
+} // end of local namespace
+
+struct Id
+{
+};
+
+void RegisterAtExit(at_error_fun func)
+{
+  ErrorHandler().Push(func);
+}
+
+Id* Create(free_func_t, void*)
+{
+  ErrorHandler().CriticalError(ENOSYS, __FUNCTION__, __LINE__);
+  return 0;
+}
+
+void Enter(Id*)
+{
+}
+
+void Leave(Id*)
+{
+}
+
+void* Protect(Id*, unsigned int, void* const volatile* source)
+{
+  return *source;
+}
+
+void Clear(Id*, unsigned int)
+{
+}
+
+void Retire(Id*, void*)
+{
+}
+
+unsigned int Flush(Id*)
+{
+  return 0;
+}
+
+unsigned int Pending(Id*)
+{
+  return 0;
+}
+
+void Delete(Id*& id)
+{
+  id = 0;
+}
+
+} // end of namespace Reclaim
+
+} // end of namespace osal
+#endif  // __linux__
@@ -3,8 +3,15 @@
 # include "OsalTimeUtils.h"  // function to translate from ticks 2 milli and back
 # include <vxWorks.h>  // vxworks types
 # include <tickLib.h>  // tickGet
+#elif defined(WIN32)
+# include <boost/date_time/posix_time/posix_time_types.hpp>
 #else
-#include <boost/date_time/posix_time/posix_time_types.hpp>
+# include <time.h>     // clock_gettime
+# if defined(__x86_64__)
+#   include <cpuid.h>  // __get_cpuid
+#   include <stdio.h>  // to read the clock source of the kernel
+#   include <string.h> // strncmp
+# endif // __x86_64__
 #endif  // __VXWORKS__
 
 namespace osal
@@ -12,32 +19,142 @@ namespace osal
   
 namespace
 {
-#ifdef __VXWORKS__
-  typedef osal::milliseconds_t  current_time_t;
-#else
-  typedef boost::posix_time::ptime  current_time_t;
-#endif  // __VXWORKS__
-  
-  
-  current_time_t GetCurrentTime()
+  const osal::nanoseconds_t NANO_IN_MILLI = 1000000ULL;
+
+#if !defined(__VXWORKS__) && !defined(WIN32)
+  osal::nanoseconds_t RawClock()
+  {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+    return (osal::nanoseconds_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+  }
+
+# if defined(__x86_64__)
+  // reading the TSC is much cheaper than clock_gettime, but we can only use it if 
+  // the CPU report that it is running at constant rate (invariant TSC) and the kernel
+  // is using it as well (it stop using it if it see that it is not stable). The conversion
+  // to nanoseconds is done with a fixed point multiplier that is calibrated once
+  class TscClock
+  {
+  public:
+    enum
+    {
+      CALIBRATION_TIME = 10000000,  // nanoseconds to spend on calibration
+      SAMPLE_TRIES = 16,            // clock reads for each calibration point
+      INVARIANT_TSC = 1 << 8        // CPUID 0x80000007 EDX
+    };
+
+    TscClock() : mUsable(false), mBaseTsc(0), mBaseNano(0), mMultiplier(0)
+    {
+      unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+      if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) || !(edx & INVARIANT_TSC) || !KernelUsesTsc())
+      {
+        return;
+      }
+      Sample first = Sample();
+      Sample last = Sample();
+      Take(first);
+      do
+      {
+        Take(last);
+      } while (last.Nano - first.Nano < CALIBRATION_TIME);
+      const unsigned long long ticks = last.Tsc - first.Tsc;
+      if (ticks > 0)
+      {
+        mBaseTsc = last.Tsc;
+        mBaseNano = last.Nano;
+        mMultiplier = ((last.Nano - first.Nano) << 32) / ticks;
+        mUsable = mMultiplier > 0;
+      }
+    }
+
+    bool Usable() const
+    {
+      return mUsable;
+    }
+
+    osal::nanoseconds_t Now() const
+    {
+      const unsigned __int128 ticks = __builtin_ia32_rdtsc() - mBaseTsc;
+      return mBaseNano + (osal::nanoseconds_t)((ticks * mMultiplier) >> 32);
+    }
+
+  private:
+    // a clock read and the TSC value at the time it was taken
+    struct Sample
+    {
+      unsigned long long Tsc;
+      osal::nanoseconds_t Nano;
+    };
+
+    // the clock is read between two TSC reads, and we keep the read with the shortest gap
+    // between them, so a preemption in the middle of a read would not skew the calibration
+    static void Take(Sample& sample)
+    {
+      unsigned long long best = ~0ULL;
+      for (int i = 0; i < SAMPLE_TRIES; ++i)
+      {
+        const unsigned long long before = __builtin_ia32_rdtsc();
+        const osal::nanoseconds_t nano = RawClock();
+        const unsigned long long after = __builtin_ia32_rdtsc();
+        if (after - before < best)
+        {
+          best = after - before;
+          sample.Tsc = before + best / 2;
+          sample.Nano = nano;
+        }
+      }
+    }
+
+    // @return false if the kernel is using another clock source (it would not if the TSC is not stable)
+    static bool KernelUsesTsc()
+    {
+      FILE* file = fopen("/sys/devices/system/clocksource/clocksource0/current_clocksource", "r");
+      if (!file)
+      {
+        return true;  // we don't know, the CPU said it is invariant
+      }
+      char name[32] = "";
+      const bool tsc = fgets(name, sizeof(name), file) && strncmp(name, "tsc", 3) == 0;
+      fclose(file);
+      return tsc;
+    }
+
+    bool mUsable;
+    unsigned long long mBaseTsc;
+    osal::nanoseconds_t mBaseNano;
+    unsigned long long mMultiplier; // nanoseconds per tick in 32.32 fixed point
+  };
+
+  const TscClock& Tsc()
+  {
+    static const TscClock clock;
+    return clock;
+  }
+# endif // __x86_64__
+#endif  // !__VXWORKS__ && !WIN32
+
+  osal::nanoseconds_t GetCurrentTime()
   {
 #ifdef __VXWORKS__
-    return osal::TimeUtils::Ticks2Milli(tickGet());
+    return osal::TimeUtils::Ticks2Milli(tickGet()) * NANO_IN_MILLI;
+#elif defined(WIN32)
+    static const boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    return (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds() * 1000ULL;
+#elif defined(__x86_64__)
+    const TscClock& tsc = Tsc();
+    return tsc.Usable() ? tsc.Now() : RawClock();
 #else
-    return boost::posix_time::microsec_clock::local_time();
+    return RawClock();
 #endif  // __VXWORKS__    
   }
   
-  osal::milliseconds_t GetTimeDiff(current_time_t oldTime)
+  osal::nanoseconds_t GetTimeDiff(osal::nanoseconds_t oldTime)
   {
-#ifdef __VXWORKS__
-    return GetCurrentTime() - oldTime;
-#else
-    return boost::posix_time::time_duration(GetCurrentTime() - oldTime).total_milliseconds();
-#endif  // __VXWORKS__
+    const osal::nanoseconds_t now = GetCurrentTime();
+    return now > oldTime ? now - oldTime : 0;  // in case the TSC is not synced between the CPUs
   }
   
-  
 } // end of local namespace
  
 StopWatchOper::StopWatchOper() : mInitialValue(GetCurrentTime())
@@ -46,14 +163,30 @@ StopWatchOper::StopWatchOper() : mInitialValue(GetCurrentTime())
 
 osal::milliseconds_t StopWatchOper::Pause() const
 {
-  return GetTimeDiff(mInitialValue);
+  return static_cast<osal::milliseconds_t>(PauseNano() / NANO_IN_MILLI);
 }
 
 osal::milliseconds_t StopWatchOper::Stop()
 {
-  osal::milliseconds_t ret = GetTimeDiff(mInitialValue);
-  mInitialValue = GetCurrentTime();
+  return static_cast<osal::milliseconds_t>(StopNano() / NANO_IN_MILLI);
+}
+
+osal::nanoseconds_t StopWatchOper::PauseNano() const
+{
+  return GetTimeDiff(mInitialValue);
+}
+
+osal::nanoseconds_t StopWatchOper::StopNano()
+{
+  const osal::nanoseconds_t now = GetCurrentTime();
+  const osal::nanoseconds_t ret = now > mInitialValue ? now - mInitialValue : 0;
+  mInitialValue = now;
   return ret;
 }
+
+osal::nanoseconds_t StopWatchOper::Now()
+{
+  return GetCurrentTime();
+}
   
 } // end of namespace osal
@@ -0,0 +1,8 @@
+#include "osal/ThreadLocal.h" // header for for this file
+#if defined(__VXWORKS__)
+# include "vxworks/ThreadLocalVxWorks.hpp"
+#elif defined(WIN32)
+# include "win32/ThreadLocal.hpp"
+#else
+# include "posix/ThreadLocalPosix.hpp"
+#endif  // __VXWORKS__
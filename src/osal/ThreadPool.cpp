@@ -0,0 +1,93 @@
+#include "osal/ThreadPool.h" // header for for this file
+#ifdef __linux__
+# include "posix/ThreadPoolPosix.hpp"
+#else
+// the work stealing pool is only implemented for Linux, here the tasks are executed directly
+// from the thread that submit them, so the code that is using the pool would still work
+#include "ExitFunctionHolder.h"     // hold the exit functions
+
+namespace osal
+{
+
+namespace ThreadPool
+{
+
+namespace
+{
+
+Private::ExitFunctionHolder& ErrorHandler()
+{
+  static Private::ExitFunctionHolder theList;
+  return theList;
+}
+
+} // end of local namespace
+
+struct Id
+{
+  explicit Id(unsigned int workers) : Workers(workers ? workers : 1)
+  {
+  }
+
+  const unsigned int Workers;
+};
+
+void RegisterAtExit(at_error_fun func)
+{
+  ErrorHandler().Push(func);
+}
+
+Id* Create(unsigned int workers, const Thread::Attributes&)
+{
+  return new Id(workers);
+}
+
+unsigned int Workers(Id* id)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid thread pool id");
+  return id->Workers;
+}
+
+void Submit(Id* id, task_func_t func, void* context, Group*)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid thread pool id");
+  func(context);
+}
+
+void SubmitBatch(Id* id, const Task tasks[], unsigned int count, Group*)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid thread pool id");
+  for (unsigned int i = 0; i < count; i++)
+  {
+    tasks[i].Func(tasks[i].Context);
+  }
+}
+
+void Wait(Id*, Group&)
+{
+}
+
+unsigned int Pending(const Group&)
+{
+  return 0;
+}
+
+void ParallelFor(Id* id, unsigned int begin, unsigned int end, unsigned int, range_func_t func, void* context)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid thread pool id");
+  if (begin < end)
+  {
+    func(begin, end, context);
+  }
+}
+
+void Delete(Id*& id)
+{
+  delete id;
+  id = 0;
+}
+
+} // end of namespace ThreadPool
+
+} // end of namespace osal
+#endif  // __linux__
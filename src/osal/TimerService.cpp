@@ -0,0 +1,551 @@
+#include "osal/TimerService.h"       // header for this file
+#include "osal/Mutex.h"              // to protect the wheel
+#include "osal/EventNotification.h"  // to wake up the service thread
+#include "osal/MessageQueue.h"       // to send expired timers to their target
+#include "osal/StopWatch.h"          // monotonic clock
+#include "ExitFunctionHolder.h"      // to define the list of error handling functions
+#include <vector>                    // to hold all the timers
+#include <string.h>                  // memcpy
+#include <memory>                    // auto_ptr
+
+namespace osal
+{
+
+namespace TimerService
+{
+
+namespace
+{
+
+Private::ExitFunctionHolder& ErrorHandler()
+{
+  static Private::ExitFunctionHolder theList;
+  return theList;
+}
+
+typedef unsigned long long tick_t;
+
+const nanoseconds_t NANO_IN_MILLI = 1000000ULL;
+
+enum
+{
+  LEVELS = 4,
+  SLOT_BITS = 8,
+  SLOTS = 1 << SLOT_BITS,
+  SLOT_MASK = SLOTS - 1,
+  FIRE_BATCH = 32,         // number of timers to collect while holding the lock
+  MAX_IDLE_WAIT = 1000,    // milliseconds to wait when there are no timers
+  STACK_SIZE = 64 * 1024
+};
+
+const tick_t MAX_TICKS = (1ULL << (LEVELS * SLOT_BITS)) - 1;
+
+// the timers are kept in double linked lists, each slot in the wheel is
+// the head of the list so that removing a timer do not require to know where it is
+struct Node
+{
+  enum State
+  {
+    FREE,
+    PENDING
+  };
+
+  Node() : Next(this), Prev(this), Expires(0), Func(0), Context(0), Target(0), Generation(1), Status(FREE)
+  {
+  }
+
+  bool Empty() const
+  {
+    return Next == this;
+  }
+
+  void Unlink()
+  {
+    Prev->Next = Next;
+    Next->Prev = Prev;
+    Next = Prev = this;
+  }
+
+  void PushBack(Node* node)
+  {
+    node->Prev = Prev;
+    node->Next = this;
+    Prev->Next = node;
+    Prev = node;
+  }
+
+  // move all the nodes from this list to the end of the other list
+  void SpliceInto(Node& to)
+  {
+    if (!Empty())
+    {
+      Next->Prev = to.Prev;
+      Prev->Next = &to;
+      to.Prev->Next = Next;
+      to.Prev = Prev;
+      Next = Prev = this;
+    }
+  }
+
+  Node* Next;
+  Node* Prev;
+  tick_t Expires;
+  timer_func_t Func;
+  void* Context;
+  MessageQueue::Id* Target;
+  unsigned int Generation;
+  State Status;
+};
+
+// the address of this is the tag of the messages that we are sending
+const char MESSAGE_TAG = 0;
+
+void Fire(const Expired& what, MessageQueue::Id* target)
+{
+  if (target)
+  {
+    Expired message = what;
+    message.Tag = &MESSAGE_TAG;
+    MessageQueue::Send(target, reinterpret_cast<CONST_MESSAGE char*>(&message), sizeof(message), false);
+  }
+  else
+  {
+    what.Func(what.Context);
+  }
+}
+
+Mutex::Id* StartGuard()
+{
+  static Mutex::Id* guard = Mutex::Create();
+  return guard;
+}
+
+Id* startingService = 0;  // pass the service to the new thread, protected by StartGuard
+
+void ServiceThread();
+
+} // end of local namespace
+
+struct Id
+{
+  Id(unsigned int maxTimers, milliseconds_t resolution) :
+          mGuard(Mutex::Create()), mNodes(maxTimers), mFree(0), mNow(0), mPending(0),
+          mStart(StopWatchOper::Now()), mTickNano(resolution * NANO_IN_MILLI),
+          mThread(0), mWakeup(EventNotification::Create()), mStarted(EventNotification::Create()),
+          mStop(false), mWakeTick(0)
+  {
+    for (unsigned int i = mNodes.size(); i > 0; i--)
+    {
+      Release(&mNodes[i - 1]);
+    }
+  }
+
+  ~Id()
+  {
+    Mutex::Delete(mGuard);
+    EventNotification::Delete(mWakeup);
+    EventNotification::Delete(mStarted);
+  }
+
+  Handle Schedule(milliseconds_t milliDelay, timer_func_t func, void* context, MessageQueue::Id* target)
+  {
+    // round up so that the timer would never fire too early
+    const tick_t expires = (Elapsed() + milliDelay * NANO_IN_MILLI + mTickNano - 1) / mTickNano;
+    bool wakeup = false;
+    Handle handle = INVALID_HANDLE;
+    Mutex::Lock(mGuard);
+    Node* node = mFree;
+    if (node)
+    {
+      mFree = node->Next;
+      node->Next = node->Prev = node;
+      node->Expires = expires;
+      node->Func = func;
+      node->Context = context;
+      node->Target = target;
+      node->Status = Node::PENDING;
+      Insert(node);
+      ++mPending;
+      handle = MakeHandle(node);
+      wakeup = expires < mWakeTick; // the service thread would sleep past this timer
+      if (wakeup)
+      {
+        mWakeTick = expires;
+      }
+    }
+    Mutex::Release(mGuard);
+    if (wakeup)
+    {
+      EventNotification::Signal(mWakeup);
+    }
+    return handle;
+  }
+
+  bool Cancel(Handle timer)
+  {
+    const unsigned int index = static_cast<unsigned int>(timer & 0xffffffffULL);
+    const unsigned int generation = static_cast<unsigned int>(timer >> 32);
+    if (index == 0 || index > mNodes.size())
+    {
+      return false;
+    }
+    bool cancelled = false;
+    Mutex::Lock(mGuard);
+    Node* node = &mNodes[index - 1];
+    if (node->Status == Node::PENDING && node->Generation == generation)
+    {
+      node->Unlink();
+      --mPending;
+      Release(node);
+      cancelled = true;
+    }
+    Mutex::Release(mGuard);
+    return cancelled;
+  }
+
+  unsigned int Poll()
+  {
+    unsigned int fired = 0;
+    Expired batch[FIRE_BATCH];
+    MessageQueue::Id* targets[FIRE_BATCH];
+    unsigned int count = FIRE_BATCH;
+    while (count == FIRE_BATCH)
+    {
+      Mutex::Lock(mGuard);
+      count = Collect(batch, targets, CurrentTick());
+      Mutex::Release(mGuard);
+      // we are calling the user functions without holding the lock so they can schedule new timers
+      for (unsigned int i = 0; i < count; i++)
+      {
+        Fire(batch[i], targets[i]);
+      }
+      fired += count;
+    }
+    return fired;
+  }
+
+  milliseconds_t NextTimeout()
+  {
+    Mutex::Lock(mGuard);
+    const tick_t next = NextTick();
+    mWakeTick = next;
+    Mutex::Release(mGuard);
+    if (next == MAX_TICKS)
+    {
+      return MAX_IDLE_WAIT;
+    }
+    const nanoseconds_t at = next * mTickNano;
+    const nanoseconds_t now = Elapsed();
+    if (at <= now)
+    {
+      return 0;
+    }
+    const nanoseconds_t wait = (at - now + NANO_IN_MILLI - 1) / NANO_IN_MILLI;
+    return wait < MAX_IDLE_WAIT ? static_cast<milliseconds_t>(wait) : static_cast<milliseconds_t>(MAX_IDLE_WAIT);
+  }
+
+  unsigned int Pending()
+  {
+    Mutex::Lock(mGuard);
+    const unsigned int pending = mPending;
+    Mutex::Release(mGuard);
+    return pending;
+  }
+
+  void Start(const char* name, Thread::PriorityType prio)
+  {
+    Mutex::Lock(StartGuard());
+    if (!mThread)
+    {
+      mStop = false;
+      mWakeTick = 0;
+      startingService = this;
+      mThread = Thread::Create(Thread::CreateAttribute(name, STACK_SIZE, prio), ServiceThread);
+      EventNotification::Wait(mStarted); // the thread would signal us when it is no longer need startingService
+      startingService = 0;
+    }
+    Mutex::Release(StartGuard());
+  }
+
+  void Stop()
+  {
+    Mutex::Lock(StartGuard());
+    if (mThread)
+    {
+      mStop = true;
+      EventNotification::Signal(mWakeup);
+      Thread::Clean(mThread);
+      mThread = 0;
+    }
+    Mutex::Release(StartGuard());
+  }
+
+  void Run()
+  {
+    EventNotification::Signal(mStarted); // we are running
+    while (!mStop)
+    {
+      Poll();
+      EventNotification::TimedWait(mWakeup, NextTimeout());
+    }
+  }
+
+private:
+  Handle MakeHandle(Node* node) const
+  {
+    return (static_cast<Handle>(node->Generation) << 32) | static_cast<Handle>(node - &mNodes[0] + 1);
+  }
+
+  void Release(Node* node)
+  {
+    node->Status = Node::FREE;
+    if (++node->Generation == 0)
+    {
+      node->Generation = 1;   // so that a handle would never be 0
+    }
+    node->Next = mFree;
+    mFree = node;
+  }
+
+  nanoseconds_t Elapsed() const
+  {
+    const nanoseconds_t now = StopWatchOper::Now();
+    return now > mStart ? now - mStart : 0;
+  }
+
+  tick_t CurrentTick() const
+  {
+    return Elapsed() / mTickNano;
+  }
+
+  // place the timer at the wheel level that match its distance from mNow,
+  // timers at the higher levels would be moved down (cascaded) when mNow reach their slot
+  void Insert(Node* node)
+  {
+    const tick_t expires = node->Expires;
+    Node* slot = 0;
+    if (expires < mNow)
+    {
+      slot = &mWheel[0][mNow & SLOT_MASK];  // already expired, fire at the next tick
+    }
+    else
+    {
+      tick_t diff = expires - mNow;
+      if (diff > MAX_TICKS)
+      {
+        diff = MAX_TICKS;
+        node->Expires = mNow + diff;
+      }
+      unsigned int level = 0;
+      while (level < LEVELS - 1 && diff >= (1ULL << ((level + 1) * SLOT_BITS)))
+      {
+        ++level;
+      }
+      slot = &mWheel[level][(node->Expires >> (level * SLOT_BITS)) & SLOT_MASK];
+    }
+    slot->PushBack(node);
+  }
+
+  void Cascade(unsigned int level, unsigned int index)
+  {
+    Node list;
+    mWheel[level][index].SpliceInto(list);
+    while (!list.Empty())
+    {
+      Node* node = list.Next;
+      node->Unlink();
+      Insert(node);
+    }
+  }
+
+  // process one tick - all the timers that expire at mNow are moved to the expired list
+  void Advance()
+  {
+    const unsigned int index = static_cast<unsigned int>(mNow & SLOT_MASK);
+    if (index == 0)
+    {
+      for (unsigned int level = 1; level < LEVELS; level++)
+      {
+        const unsigned int slot = static_cast<unsigned int>((mNow >> (level * SLOT_BITS)) & SLOT_MASK);
+        Cascade(level, slot);
+        if (slot != 0)
+        {
+          break;
+        }
+      }
+    }
+    mWheel[0][index].SpliceInto(mExpired);
+    ++mNow;
+  }
+
+  // must be called with the lock held
+  // @return the number of timers that were placed in the batch
+  unsigned int Collect(Expired* batch, MessageQueue::Id** targets, tick_t until)
+  {
+    unsigned int count = 0;
+    while (count < FIRE_BATCH)
+    {
+      if (!mExpired.Empty())
+      {
+        Node* node = mExpired.Next;
+        node->Unlink();
+        batch[count].Tag = 0;
+        batch[count].Func = node->Func;
+        batch[count].Context = node->Context;
+        targets[count] = node->Target;
+        ++count;
+        --mPending;
+        Release(node);
+      }
+      else if (mNow > until)
+      {
+        break;
+      }
+      else if (mPending == 0)
+      {
+        mNow = until + 1; // nothing to do, no need to go over all the ticks
+      }
+      else
+      {
+        Advance();
+      }
+    }
+    return count;
+  }
+
+  // the next tick in which something may happen - either there is a timer at the lowest level
+  // or we need to cascade the next level. MAX_TICKS if there are no timers at all
+  tick_t NextTick() const
+  {
+    if (mPending == 0)
+    {
+      return MAX_TICKS;
+    }
+    if (!mExpired.Empty())
+    {
+      return mNow;
+    }
+    tick_t tick = mNow;
+    do
+    {
+      if (!mWheel[0][tick & SLOT_MASK].Empty())
+      {
+        return tick;
+      }
+      ++tick;
+    }
+    while (tick & SLOT_MASK);
+    return tick;  // cascade
+  }
+
+  Mutex::Id* mGuard;
+  std::vector<Node> mNodes;
+  Node* mFree;
+  Node mWheel[LEVELS][SLOTS];
+  Node mExpired;
+  tick_t mNow;              // the next tick to process
+  unsigned int mPending;
+  const nanoseconds_t mStart;
+  const nanoseconds_t mTickNano;
+  Thread::Id* mThread;
+  EventNotification::Id* mWakeup;
+  EventNotification::Id* mStarted;
+  volatile bool mStop;
+  tick_t mWakeTick;         // the tick in which the service thread would wake up
+};
+
+namespace
+{
+
+void ServiceThread()
+{
+  Id* service = startingService;
+  service->Run();
+}
+
+} // end of local namespace
+
+void RegisterAtExit(at_error_fun func)
+{
+  ErrorHandler().Push(func);
+}
+
+Id* Create(unsigned int maxTimers, milliseconds_t resolution)
+{
+  OSAL_ASSERT_CONDITION(resolution > 0, ErrorHandler(), "timer service resolution must be larger than 0");
+  std::auto_ptr<Id> id(new Id(maxTimers, resolution));
+  return id.release();
+}
+
+void Start(Id* id, const char* name, Thread::PriorityType prio)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid timer service id");
+  id->Start(name, prio);
+}
+
+void Stop(Id* id)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid timer service id");
+  id->Stop();
+}
+
+Handle Schedule(Id* id, milliseconds_t milliDelay, timer_func_t func, void* context, MessageQueue::Id* target)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid timer service id");
+  OSAL_ASSERT_CONDITION(func, ErrorHandler(), "invalid timer function");
+  return id->Schedule(milliDelay, func, context, target);
+}
+
+bool Cancel(Id* id, Handle timer)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid timer service id");
+  return id->Cancel(timer);
+}
+
+unsigned int Poll(Id* id)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid timer service id");
+  return id->Poll();
+}
+
+milliseconds_t NextTimeout(Id* id)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid timer service id");
+  return id->NextTimeout();
+}
+
+unsigned int Pending(Id* id)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid timer service id");
+  return id->Pending();
+}
+
+bool Dispatch(const char* msg, int size)
+{
+  if (!msg || size != MESSAGE_SIZE)
+  {
+    return false;
+  }
+  Expired what;
+  memcpy(&what, msg, sizeof(what));
+  if (what.Tag != &MESSAGE_TAG || !what.Func)
+  {
+    return false;   // some other message with the same size
+  }
+  what.Func(what.Context);
+  return true;
+}
+
+void Delete(Id*& id)
+{
+  if (id)
+  {
+    id->Stop();
+    delete id;
+    id = 0;
+  }
+}
+
+} // end of namespace TimerService
+
+} // end of namespace osal
@@ -0,0 +1,62 @@
+#include "osal/Topology.h" // header for for this file
+#ifdef __linux__
+# include "posix/TopologyPosix.hpp"
+#else
+// the topology is only read on Linux, here nothing is known so all the placement functions
+// return an empty set (the threads can run on any CPU)
+
+namespace osal
+{
+
+namespace Topology
+{
+
+unsigned int Count()
+{
+  return 0;
+}
+
+bool At(unsigned int, Cpu&)
+{
+  return false;
+}
+
+bool Find(unsigned int, Cpu&)
+{
+  return false;
+}
+
+unsigned int Current()
+{
+  return 0;
+}
+
+Thread::CpuSet Domain(unsigned int, Level)
+{
+  return Thread::CpuSet();
+}
+
+Thread::CpuSet Spread(unsigned int)
+{
+  return Thread::CpuSet();
+}
+
+Thread::CpuSet Compact(unsigned int)
+{
+  return Thread::CpuSet();
+}
+
+Thread::CpuSet Near(Thread::Id*, Level)
+{
+  return Thread::CpuSet();
+}
+
+bool Load(const char*)
+{
+  return false;
+}
+
+} // end of namespace Topology
+
+} // end of namespace osal
+#endif  // __linux__
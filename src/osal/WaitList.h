@@ -0,0 +1,286 @@
+#ifndef WAIT_LIST__H
+#define WAIT_LIST__H
+// This allow a thread to wait on more than one OSAL object at the same time
+// (see osal/MultiWait.h). Each object that can be waited on this way hold a list of
+// links - one for each thread that is waiting on it. The thread is parked once (on
+// its own Waiter) and the object would unpark all the threads in its list when it
+// become ready (event signaled, semaphore posted, message sent).
+// When no one is waiting, Notify cost a single load, so this is not slowing down
+// the normal use of the objects. On Linux Notify don't have a fence of its own - it use
+// the one that the object already has between the change of its state and its own waiters
+// check (the atomic read-modify-write of the events and semaphores, and the fence of the
+// EventCount in the lock free queues). On VxWorks the objects are kernel objects, so Notify
+// has a fence since we can't count on theirs.
+
+#include "osal/OsalGeneralDefines.h"  // milliseconds_t
+#include "CriticalSection.h"          // to guard the list
+#ifdef __VXWORKS__
+# include "vxworks/SemHandle.h"       // the lock for the list
+# include "OsalTimeUtils.h"           // Milli2Ticks
+# include <vxWorks.h>                 // vxworks types
+# include <eventLib.h>                // task events to park on
+# include <taskLib.h>                 // taskIdSelf
+# include <tickLib.h>                 // tickGet
+# include <errnoLib.h>                // errnoGet
+# include <errno.h>                   // ETIMEDOUT
+# include <vxAtomicLib.h>             // memory barrier
+#elif defined(__linux__)
+# include "posix/Futex.h"             // the lock for the list and to park on
+#endif  // __VXWORKS__
+
+namespace osal
+{
+
+namespace Private
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// the thread that is waiting - this is where it is parked. Note that this should
+// be used only by the thread that created it (other threads only call Unpark)
+class Waiter
+{
+public:
+  // @param timeout how long to wait in all calls to Park, NULL to wait forever
+  explicit Waiter(const milliseconds_t* timeout);
+
+  // must be called before checking the objects again, so that we would not miss Unpark
+  void Prepare();
+
+  // @return 0 if we were unparked (or may have been), ETIMEDOUT or other error
+  int Park();
+
+  void Unpark();
+
+  // @return true if the calling thread is the one that is waiting
+  bool IsCaller() const;
+
+private:
+  Waiter(const Waiter&);
+  Waiter& operator = (const Waiter&);
+
+#ifdef __VXWORKS__
+  enum
+  {
+    WAKEUP_EVENT = VXEV24   // the task event that is used to unpark
+  };
+
+  int mTask;
+  bool mForever;
+  ULONG mEnd;
+#elif defined(__linux__)
+  volatile int mWord;
+  pid_t mThread;
+  bool mForever;
+  Deadline mDeadline;
+#endif  // __VXWORKS__
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// the registration of a waiter on a single object
+struct WaitLink
+{
+  WaitLink() : Next(0), Prev(0), Owner(0)
+  {
+  }
+
+  WaitLink* Next;
+  WaitLink* Prev;
+  Waiter* Owner;
+};
+
+class WaitList
+{
+public:
+  WaitList() : mLock(true), mHead(0)
+  {
+  }
+
+  void Add(WaitLink* link)
+  {
+    {
+      CriticalSection<lock_t> guard(mLock);
+      link->Prev = 0;
+      link->Next = mHead;
+      if (mHead)
+      {
+        mHead->Prev = link;
+      }
+      mHead = link;
+    }
+    Fence();  // the list must be updated before the waiter check the object again
+  }
+
+  void Remove(WaitLink* link)
+  {
+    CriticalSection<lock_t> guard(mLock);
+    if (link->Prev)
+    {
+      link->Prev->Next = link->Next;
+    }
+    else
+    {
+      mHead = link->Next;
+    }
+    if (link->Next)
+    {
+      link->Next->Prev = link->Prev;
+    }
+    link->Next = link->Prev = 0;
+  }
+
+  // this must be called after the object state was changed to ready, and on Linux there must be
+  // a full fence between that change and this call (an atomic read-modify-write is one).
+  // all the waiters are woken up since they may not all be waiting for the same thing.
+  // a waiter that is giving back what it took (in WaitAll) is not woken up by itself
+  void Notify()
+  {
+#ifdef __VXWORKS__
+    Fence();  // the object state change must be visible before we read the list
+#endif  // __VXWORKS__
+    if (LoadHead())
+    {
+      CriticalSection<lock_t> guard(mLock);
+      for (WaitLink* link = mHead; link; link = link->Next)
+      {
+        if (!link->Owner->IsCaller())
+        {
+          link->Owner->Unpark();
+        }
+      }
+    }
+  }
+
+private:
+  WaitList(const WaitList&);
+  WaitList& operator = (const WaitList&);
+
+  static void Fence()
+  {
+#ifdef __VXWORKS__
+    VX_MEM_BARRIER_RW();
+#elif defined(__linux__)
+    AtomicFence();
+#endif  // __VXWORKS__
+  }
+
+  WaitLink* LoadHead() const
+  {
+#ifdef __VXWORKS__
+    return mHead;
+#elif defined(__linux__)
+    return AtomicLoad(&mHead);  // ordered after the atomic operation that changed the state
+#endif  // __VXWORKS__
+  }
+
+#ifdef __VXWORKS__
+  typedef semvx::SemHandle lock_t;
+#elif defined(__linux__)
+  typedef FutexLock lock_t;
+#endif  // __VXWORKS__
+
+  lock_t mLock;
+  WaitLink* volatile mHead;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+#ifdef __VXWORKS__
+
+inline Waiter::Waiter(const milliseconds_t* timeout) : mTask(taskIdSelf()), mForever(!timeout),
+                                                       mEnd(timeout ? tickGet() + TimeUtils::Milli2Ticks(*timeout) : 0)
+{
+}
+
+inline void Waiter::Prepare()
+{
+  // drop wakeups that are left from former calls
+  UINT32 events = 0;
+  eventReceive(WAKEUP_EVENT, EVENTS_WAIT_ANY, NO_WAIT, &events);
+}
+
+inline int Waiter::Park()
+{
+  int ticks = WAIT_FOREVER;
+  if (!mForever)
+  {
+    const ULONG now = tickGet();
+    if ((long)(mEnd - now) <= 0)
+    {
+      return ETIMEDOUT;
+    }
+    ticks = (int)(mEnd - now);
+  }
+  UINT32 events = 0;
+  if (eventReceive(WAKEUP_EVENT, EVENTS_WAIT_ANY, ticks, &events) != OK)
+  {
+    return errnoGet() == S_eventLib_TIMEOUT ? ETIMEDOUT : errnoGet();
+  }
+  return 0;
+}
+
+inline void Waiter::Unpark()
+{
+  eventSend(mTask, WAKEUP_EVENT);
+}
+
+inline bool Waiter::IsCaller() const
+{
+  return mTask == taskIdSelf();
+}
+
+#elif defined(__linux__)
+
+inline Waiter::Waiter(const milliseconds_t* timeout) : mWord(0), mThread(CurrentThreadId()), mForever(!timeout),
+                                                       mDeadline(timeout ? *timeout : 0)
+{
+}
+
+inline void Waiter::Prepare()
+{
+  AtomicStore(&mWord, 0);
+}
+
+inline int Waiter::Park()
+{
+  return mForever ? Futex::Wait(&mWord, 0) : Futex::WaitUntil(&mWord, 0, mDeadline);
+}
+
+inline void Waiter::Unpark()
+{
+  AtomicStore(&mWord, 1);
+  Futex::Wake(&mWord, 1);
+}
+
+inline bool Waiter::IsCaller() const
+{
+  return mThread == CurrentThreadId();
+}
+
+#endif  // __VXWORKS__
+
+} // end of namespace Private
+
+// the objects that can be waited on together
+namespace EventNotification
+{
+  struct Id;
+
+  Private::WaitList& WaitListOf(Id* id);
+} // end of namespace EventNotification
+
+namespace CountingSemaphore
+{
+  struct Id;
+
+  Private::WaitList& WaitListOf(Id* id);
+} // end of namespace CountingSemaphore
+
+namespace MessageQueue
+{
+  struct Id;
+
+  Private::WaitList& WaitListOf(Id* id);
+} // end of namespace MessageQueue
+
+} // end of namespace osal
+
+#endif  // WAIT_LIST__H
@@ -4,7 +4,7 @@
 // C++ standard implementation) for message queue
 // since this is portable by itself we can use this for both win32 and posix plaftfroms
 
-#include "osal/OsalGeneralDefines.h"  // milliseconds_t
+#include "osal/OsalGeneralDefines.h"  // milliseconds_t, Duration
 #include <boost/message_queue/message_queue.hpp>  // the actual impl is here
 
 namespace osal
@@ -25,19 +25,24 @@ public:
   {    
   }
   
-  void Push(const char* item, value_type::size_type len)
+  void Push(const char* item, value_type::size_type len, bool urgent)
   {
-    mData.push_front(item, len);
+    mData.push_front(item, len, urgent);
   }
   
-  bool TryPush(const char* item, value_type::size_type len)
+  bool TryPush(const char* item, value_type::size_type len, bool urgent)
   {
-    return mData.try_push(item, len);
+    return mData.try_push(item, len, urgent);
   }
   
-  bool TimePush(const char* item, value_type::size_type len, milliseconds_t timeout)
+  bool TimePush(const char* item, value_type::size_type len, milliseconds_t timeout, bool urgent)
   {
-    return mData.try_push(item, len, boost::posix_time::milliseconds(timeout));
+    return mData.try_push(item, len, boost::posix_time::milliseconds(timeout), urgent);
+  }
+
+  bool TimePush(const char* item, value_type::size_type len, const Duration& timeout, bool urgent)
+  {
+    return mData.try_push(item, len, boost::posix_time::microseconds(timeout.Micro()), urgent);
   }
   
   int  Pop(char* buff, value_type::size_type maxLen)
@@ -70,12 +75,42 @@ public:
     }
     
   }
+
+  int TimePop(char* buff, value_type::size_type maxLen, const Duration& timeout)
+  {
+    if (mData.try_pop(buff, maxLen, boost::posix_time::microseconds(timeout.Micro())))
+    {
+       return (int)maxLen;
+    }
+    else
+    {
+      return -1;
+    }
+  }
+  
+  unsigned int PushBatch(const char* const items[], const unsigned int sizes[], unsigned int count)
+  {
+    return (unsigned int)mData.push_batch(items, sizes, count);
+  }
+  
+  unsigned int PopBatch(char* buff, unsigned int stride, unsigned int sizes[], unsigned int maxCount, 
+                        milliseconds_t timeout)
+  {
+    return (unsigned int)mData.pop_batch(buff, stride, sizes, maxCount, boost::posix_time::milliseconds(timeout));
+  }
   
   int Size() const
   {
     return mData.size();
   }
   
+  LanesCount Lanes() const
+  {
+    value_type::lanes_info info = mData.lanes();
+    LanesCount lanes = { (int)info.normal, (int)info.urgent, (unsigned long)info.overtaken, (unsigned long)info.forced };
+    return lanes;
+  }
+  
 private:
   value_type mData;
 }; 
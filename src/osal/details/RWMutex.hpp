@@ -55,27 +55,25 @@ bool ExclusiveTimedLock(boost::shared_mutex& lock, boost::posix_time::time_durat
 class ReadWriteMutex
 {
 public:
-  ReadWriteMutex()
+  ReadWriteMutex() : mWriteLocked(false)
   {
   }
   
   void ReadLock()
   {
     mLock.lock_shared();
-    release_func = ReadWriteMutex::SharedRelease;
   }
   
   void WriteLock()
   {
     mLock.lock();
-    release_func = ReadWriteMutex::UniqueRelease;
+    mWriteLocked = true;
   }
   
   bool TryReadLock()
   {
     if (mLock.try_lock_shared())
     {
-      release_func = ReadWriteMutex::SharedRelease;
       return true;
     }
     else
@@ -88,7 +86,7 @@ public:
   {
     if (mLock.try_lock())
     {
-      release_func = ReadWriteMutex::UniqueRelease;
+      mWriteLocked = true;
       return true;
     }
     else
@@ -102,7 +100,6 @@ public:
     boost::posix_time::time_duration d = boost::posix_time::milliseconds(timeout);
     if (mLock.timed_lock_shared(boost::get_system_time() + d))
     {
-      release_func = ReadWriteMutex::SharedRelease;
       return true;
     }
     else
@@ -117,7 +114,7 @@ public:
     //if (ExclusiveTimedLock(mLock, d))
     if (mLock.timed_lock(d))
     {
-      release_func = ReadWriteMutex::UniqueRelease;
+      mWriteLocked = true;
       return true;
     }
     else
@@ -128,27 +125,22 @@ public:
   
   void Unlock()
   {
-    release_func(mLock);  // note that the write function would be called based on the lock we got
-  }
-  
-private:
-  
-  static void UniqueRelease(boost::shared_mutex& what)
-  {
-    what.unlock();//_upgrade();
-  }
-  
-  static void SharedRelease(boost::shared_mutex& what)
-  {
-    what.unlock_shared();
+    // only the writer can set this flag and no reader can hold the lock at the same
+    // time, so readers see it false (and never write it)
+    if (mWriteLocked)
+    {
+      mWriteLocked = false;
+      mLock.unlock();
+    }
+    else
+    {
+      mLock.unlock_shared();
+    }
   }
   
 private:
   boost::shared_mutex mLock;
-  // we need to know what is the action to do when releasing the lock so we would have a pointer that would 
-  // point to the function to be called based on the lock we took
-  typedef void(*unlock_fun)(boost::shared_mutex& lock);
-  unlock_fun  release_func;
+  bool mWriteLocked;
 };
   
 } // end of namespace details
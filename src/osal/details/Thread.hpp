@@ -71,11 +71,21 @@ Attributes::Attributes() : Name(DefaultName()), StackSize(DefaultStackSize()), P
 {
 }
 
+Attributes::Attributes(const char* name, unsigned int stackSize, PriorityType prio, const CpuSet& affinity) : 
+    Name(name), StackSize(stackSize), Priority(prio), Affinity(affinity)
+{ 
+}
+
 Attributes CreateAttribute(const char* name, unsigned int sSize, PriorityType pt)
 {
   return Attributes(name, sSize, pt); 
 }
 
+Attributes CreateAttribute(const char* name, unsigned int sSize, PriorityType pt, const CpuSet& affinity)
+{
+  return Attributes(name, sSize, pt, affinity); 
+}
+
   
 } // namespace Thread
 } // namespace osal
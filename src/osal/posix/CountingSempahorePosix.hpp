@@ -1,2 +1,185 @@
+#ifndef COUNTINGSEMPAHOREPOSIX_HPP
+#define COUNTINGSEMPAHOREPOSIX_HPP
+// Linux implementation for the counting semaphore - the count itself is the
+// futex word, so as long as the count is positive Wait would not enter
+// the kernel, and Post would only enter the kernel if someone is waiting
 
-#error "posix counting semaphore is not supported yet"
+#include "osal/CountingSemaphore.h" // the interface for this implementation
+#include "Futex.h"                  // futex system calls and atomic operations
+#include "CriticalSection.h"        // to guard the error handling functions
+#include "ExitFunctionHolder.h"     // to define the list of error handling functions
+#include "WaitList.h"               // to allow waiting on more than one object
+#include <errno.h>                  // errno values
+#include <assert.h>                 // assert macro
+#include <memory>                   // auto_ptr
+
+namespace osal
+{
+
+namespace CountingSemaphore
+{
+
+namespace
+{
+// local functions
+Private::ExitFunctionHolder& ErrorFunctionsHandler();
+
+
+Private::ExitFunctionHolder& ErrorFunctionsHandler()
+{
+	static Private::ExitFunctionHolder functions;
+	return functions;
+}
+
+}	// end of local namespace
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct Id
+{
+  explicit Id(int count) : mCount(count), mWaiters(0)
+  {
+  }
+
+  bool TryTake()
+  {
+    int current = Private::AtomicLoad(&mCount);
+    while (current > 0)
+    {
+      if (Private::AtomicCompareExchange(&mCount, current, current - 1))
+      {
+        return true;
+      }
+    }
+    errno = EAGAIN;
+    return false;
+  }
+
+  // @return false with errno set to the reason
+  bool Take(const Private::Deadline* deadline)
+  {
+    while (!TryTake())
+    {
+      Private::Futex::CancellationPoint();
+      Private::AtomicFetchAdd(&mWaiters, 1);
+      // we would only block if the count is still 0
+      int err = deadline ? Private::Futex::WaitUntil(&mCount, 0, *deadline) :
+                           Private::Futex::Wait(&mCount, 0);
+      Private::AtomicFetchAdd(&mWaiters, -1);
+      Private::Futex::CancellationPoint();
+      if (err)
+      {
+        errno = err;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void Give()
+  {
+    Private::AtomicFetchAdd(&mCount, 1);
+    if (Private::AtomicLoad(&mWaiters) > 0)
+    {
+      Private::Futex::Wake(&mCount, 1);
+    }
+    mWaitList.Notify();
+  }
+
+  Private::WaitList& Waiters()
+  {
+    return mWaitList;
+  }
+
+private:
+  volatile int mCount;
+  volatile int mWaiters;
+  Private::WaitList mWaitList;
+};
+
+void RegisterAtExit(at_error_fun func)
+{
+  ErrorFunctionsHandler().Push(func);
+}
+
+Id* Create(int count)
+{
+	std::auto_ptr<Id> id(new Id(count));
+	return id.release();
+}
+
+void Wait(Id* on)
+{
+	assert(on);
+	if (!on->Take(0))
+	{
+	  ErrorFunctionsHandler().CriticalError(errno, __FUNCTION__, __LINE__);
+	}
+}
+
+bool TryWait(Id* on)
+{
+	assert(on);
+	if (!on->TryTake())
+	{
+	  return ErrorFunctionsHandler().TryFail(errno, __FUNCTION__, __LINE__);
+	}
+	else
+	{
+		return true;	// all ok
+	}
+}
+
+bool TimedWait(Id* on, milliseconds_t milliDuration)
+{
+	assert(on);
+	Private::Deadline deadline(milliDuration);
+	if (!on->Take(&deadline))
+	{
+	  return ErrorFunctionsHandler().TimedOut(errno, __FUNCTION__, __LINE__);
+	}
+	else
+	{
+		return true;	// all is OK
+	}
+}
+
+bool TimedWait(Id* on, const Duration& duration)
+{
+	assert(on);
+	Private::Deadline deadline(duration);
+	if (!on->Take(&deadline))
+	{
+	  return ErrorFunctionsHandler().TimedOut(errno, __FUNCTION__, __LINE__);
+	}
+	else
+	{
+		return true;	// all is OK
+	}
+}
+
+void Post(Id* on)
+{
+	assert(on);
+	on->Give();
+}
+
+Private::WaitList& WaitListOf(Id* id)
+{
+	return id->Waiters();
+}
+
+void Delete(Id*& what)
+{
+	if (what)
+	{
+	  delete what;
+	  what = 0;
+	}
+}
+
+}	// end of namespace CountingSemaphore
+}	// end of namespace osal
+#else
+#	error "you are including a file that should never be included in header file"
+#endif	// COUNTINGSEMPAHOREPOSIX_HPP
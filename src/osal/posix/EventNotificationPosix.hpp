@@ -1,2 +1,248 @@
+#ifndef EVENT_NOTIFICATION_POSIX__HPP
+#define EVENT_NOTIFICATION_POSIX__HPP
+// Linux implementation for event notification - this is the same as the
+// vxworks binary semaphore that is created empty. It is based on futex so
+// Signal would only enter the kernel if there is someone waiting, and waiting on
+// event that was already signaled would not enter the kernel
 
-#error "posix event notification is not supported yet"
+#include "osal/EventNotification.h" // the interface for this implementation
+#include "Futex.h"                  // futex system calls and atomic operations
+#include "CriticalSection.h"        // to gaurd error function registrations
+#include "ExitFunctionHolder.h"     // hold the exit functions
+#include "Readiness.h"              // to allow polling on the event
+#include <errno.h>                  // errno values
+#include <assert.h>                 // assert function
+#include <memory>                   // for auto_ptr
+
+namespace osal
+{
+
+namespace EventNotification
+{
+
+namespace
+{
+  Private::ExitFunctionHolder& ErrorFunctionsHandler()
+  {
+    static Private::ExitFunctionHolder value;
+    return value;
+  }
+} // end of local namespace
+
+// the futex word hold in the lowest bit whether the event is signaled, the rest
+// is a generation count that is changed on SignalAll so that all the threads
+// that are waiting at that time would be released even if the event is not signaled
+struct Id
+{
+  enum
+  {
+    SIGNALED = 1,
+    GENERATION = 2
+  };
+
+  Id() : mWord(0), mWaiters(0), mReady(IsSignaled, this)
+  {
+  }
+
+  bool TryTake()
+  {
+    int current = Private::AtomicLoad(&mWord);
+    while (current & SIGNALED)
+    {
+      if (Private::AtomicCompareExchange(&mWord, current, current & ~SIGNALED))
+      {
+        return true;
+      }
+    }
+    errno = EAGAIN;
+    return false;
+  }
+
+  // @return false with errno set to the reason
+  bool Take(const Private::Deadline* deadline)
+  {
+    int current = Private::AtomicLoad(&mWord);
+    const int generation = current & ~SIGNALED;
+    for (;;)
+    {
+      if (current & SIGNALED)
+      {
+        if (Private::AtomicCompareExchange(&mWord, current, current & ~SIGNALED))
+        {
+          return true;
+        }
+        continue; // current was updated with the new value
+      }
+      if (current != generation)
+      {
+        return true;  // SignalAll was called while we were waiting
+      }
+      Private::Futex::CancellationPoint();
+      Private::AtomicFetchAdd(&mWaiters, 1);
+      int err = deadline ? Private::Futex::WaitUntil(&mWord, current, *deadline) :
+                           Private::Futex::Wait(&mWord, current);
+      Private::AtomicFetchAdd(&mWaiters, -1);
+      Private::Futex::CancellationPoint();
+      if (err)
+      {
+        errno = err;
+        return false;
+      }
+      current = Private::AtomicLoad(&mWord);
+    }
+  }
+
+  void Give()
+  {
+    int current = Private::AtomicLoad(&mWord);
+    while (!(current & SIGNALED))
+    {
+      if (Private::AtomicCompareExchange(&mWord, current, current | SIGNALED))
+      {
+        if (Private::AtomicLoad(&mWaiters) > 0)
+        {
+          Private::Futex::Wake(&mWord, 1);
+        }
+        mReady.Notify();
+        return;
+      }
+    }
+  }
+
+  // this is like semFlush in vxworks - all waiting threads are released, but
+  // the state of the event is not changed
+  void ReleaseAll()
+  {
+    Private::AtomicFetchAdd(&mWord, GENERATION);
+    if (Private::AtomicLoad(&mWaiters) > 0)
+    {
+      Private::Futex::WakeAll(&mWord);
+    }
+  }
+
+  Private::Readiness& Ready()
+  {
+    return mReady;
+  }
+
+private:
+  static bool IsSignaled(const void* owner)
+  {
+    return Private::AtomicLoad(&static_cast<const Id*>(owner)->mWord) & SIGNALED;
+  }
+
+  volatile int mWord;
+  volatile int mWaiters;
+  Private::Readiness mReady;
+};
+
+void RegisterAtExit(at_error_fun func)
+{
+  ErrorFunctionsHandler().Push(func);
+}
+
+Id* Create()
+{
+  std::auto_ptr<Id> id(new Id);
+  return id.release();  // give the pointer back to the user
+}
+
+void Wait(Id* on)
+{
+  assert(on);
+  if (!on->Take(0))
+  {
+    ErrorFunctionsHandler().CriticalError(errno, __FUNCTION__, __LINE__);
+  }
+}
+
+bool TryWait(Id* on)
+{
+  assert(on);
+  if (!on->TryTake())
+  {
+    return ErrorFunctionsHandler().TryFail(errno, __FUNCTION__, __LINE__);
+  }
+  else
+  {
+    return true;
+  }
+}
+
+bool TimedWait(Id* on, milliseconds_t milliDuration)
+{
+  assert(on);
+  Private::Deadline deadline(milliDuration);
+  if (!on->Take(&deadline))
+  {
+    return ErrorFunctionsHandler().TimedOut(errno, __FUNCTION__, __LINE__);
+  }
+  else
+  {
+    return true;
+  }
+}
+
+bool TimedWait(Id* on, const Duration& duration)
+{
+  assert(on);
+  Private::Deadline deadline(duration);
+  if (!on->Take(&deadline))
+  {
+    return ErrorFunctionsHandler().TimedOut(errno, __FUNCTION__, __LINE__);
+  }
+  else
+  {
+    return true;
+  }
+}
+
+void Signal(Id* on)
+{
+  assert(on);
+  on->Give();
+}
+
+void SignalAll(Id* on)
+{
+  assert(on);
+  on->ReleaseAll();
+}
+
+int ReadyHandle(Id* on)
+{
+  assert(on);
+  int fd = on->Ready().Handle();
+  if (fd < 0)
+  {
+    ErrorFunctionsHandler().CriticalError(errno, __FUNCTION__, __LINE__);
+  }
+  return fd;
+}
+
+Private::Readiness& ReadinessOf(Id* id)
+{
+  return id->Ready();
+}
+
+Private::WaitList& WaitListOf(Id* id)
+{
+  return id->Ready().Waiters();
+}
+
+void Delete(Id*& id)
+{
+  if (id)
+  {
+    delete id;
+    id = 0;
+  }
+}
+
+}       // end of namespace EventNotification
+
+}       // end of namespace osal
+
+#else
+#	error "you must not include this file inside header file"
+#endif  // EVENT_NOTIFICATION_POSIX__HPP
@@ -0,0 +1,581 @@
+#ifndef FUTEX_POSIX__H
+#define FUTEX_POSIX__H
+// This file would hold the building blocks for the native Linux implementation
+// of the OSAL synchronization objects. Everything here is based on a single
+// 32 bits word that is changed with atomic operations from user space, and only
+// when a thread must block (or must wake someone that is blocked) we are going
+// into the kernel with the futex system call.
+// For more details see "Futexes Are Tricky" by Ulrich Drepper and man futex(2)
+
+#if !defined(__linux__)
+#	error "futex based synchronization is only supported under Linux"
+#endif	// __linux__
+
+#include "osal/OsalGeneralDefines.h"  // milliseconds_t, Duration
+#include <linux/futex.h>              // FUTEX_WAIT, FUTEX_WAKE..
+#include <sys/syscall.h>              // SYS_futex, SYS_gettid
+#include <sys/types.h>                // pid_t
+#include <unistd.h>                   // syscall
+#include <time.h>                     // clock_gettime
+#include <errno.h>                    // errno values
+#include <limits.h>                   // INT_MAX
+#include <pthread.h>                  // pthread_testcancel, pthread_setcanceltype
+
+namespace osal
+{
+
+namespace Private
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// atomic operations on the futex word (and other shared variables) - we are using the
+// compiler builtins so that we would not depend on any external library for this.
+// unless the name say otherwise, the operations are sequentially consistent
+template<typename T>
+inline T AtomicLoad(const volatile T* at)
+{
+  return __atomic_load_n(at, __ATOMIC_SEQ_CST);
+}
+
+template<typename T>
+inline T AtomicLoadAcquire(const volatile T* at)
+{
+  return __atomic_load_n(at, __ATOMIC_ACQUIRE);
+}
+
+template<typename T>
+inline T AtomicLoadRelaxed(const volatile T* at)
+{
+  return __atomic_load_n(at, __ATOMIC_RELAXED);
+}
+
+template<typename T, typename V>
+inline void AtomicStore(volatile T* at, V value)
+{
+  __atomic_store_n(at, static_cast<T>(value), __ATOMIC_SEQ_CST);
+}
+
+template<typename T, typename V>
+inline void AtomicStoreRelease(volatile T* at, V value)
+{
+  __atomic_store_n(at, static_cast<T>(value), __ATOMIC_RELEASE);
+}
+
+template<typename T, typename V>
+inline void AtomicStoreRelaxed(volatile T* at, V value)
+{
+  __atomic_store_n(at, static_cast<T>(value), __ATOMIC_RELAXED);
+}
+
+template<typename T, typename V>
+inline T AtomicExchange(volatile T* at, V value)
+{
+  return __atomic_exchange_n(at, static_cast<T>(value), __ATOMIC_SEQ_CST);
+}
+
+// note that on failure expected would hold the current value
+template<typename T, typename V>
+inline bool AtomicCompareExchange(volatile T* at, T& expected, V desired)
+{
+  return __atomic_compare_exchange_n(at, &expected, static_cast<T>(desired), false,
+                                     __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+// @return the value before the addition
+template<typename T, typename V>
+inline T AtomicFetchAdd(volatile T* at, V value)
+{
+  return __atomic_fetch_add(at, static_cast<T>(value), __ATOMIC_SEQ_CST);
+}
+
+// full memory barrier - stores before this are visible before loads after it
+inline void AtomicFence()
+{
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+// put this between variables that are changed by different threads so they would not share the same cache line
+enum
+{
+  CACHE_LINE_SIZE = 64
+};
+
+// use this inside a busy loop so that the other hardware thread on the same core would run
+inline void CpuRelax()
+{
+#if defined(__i386__) || defined(__x86_64__)
+  __builtin_ia32_pause();
+#else
+  __asm__ __volatile__("" ::: "memory");
+#endif
+}
+
+// the cached id of the calling thread, 0 until it is read from the kernel
+inline pid_t& CachedThreadId()
+{
+  static __thread pid_t tid = 0;  // we don't want to have a system call each time
+  return tid;
+}
+
+// the thread that called fork is the only one in the child, and it has a new id there
+inline void ForgetThreadId()
+{
+  CachedThreadId() = 0;
+}
+
+inline void ForgetThreadIdAtFork()
+{
+  pthread_atfork(0, 0, ForgetThreadId);
+}
+
+// @return the kernel id of the calling thread (this is what PI futexes are using as owner)
+inline pid_t CurrentThreadId()
+{
+  pid_t& tid = CachedThreadId();
+  if (tid == 0)
+  {
+    static pthread_once_t atFork = PTHREAD_ONCE_INIT;
+    pthread_once(&atFork, ForgetThreadIdAtFork);  // before any id is cached
+    tid = (pid_t)syscall(SYS_gettid);
+  }
+  return tid;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// absolute point in time to wait up to - the OSAL interface is using
+// relative time, but if we are waking up before the time pass (and we need to
+// wait again), we don't want to start the count from the beginning
+struct Deadline
+{
+  enum
+  {
+    // the kernel may wake up a thread that is blocked with timeout up to the timer slack (50 microseconds
+    // by default) after the time that was requested, so precise deadlines only block until this
+    // much time before the deadline, and then spin (see Futex::WaitUntil)
+    SPIN_WINDOW_NANO = 50000
+  };
+
+  Deadline(milliseconds_t milliDuration, clockid_t clock = CLOCK_MONOTONIC) : mClock(clock), mPrecise(false)
+  {
+    clock_gettime(mClock, &mWhen);
+    Add(mWhen, (long long)milliDuration * NANO_IN_MILLI);
+  }
+
+  Deadline(const Duration& duration, clockid_t clock = CLOCK_MONOTONIC) : mClock(clock), mPrecise(true)
+  {
+    clock_gettime(mClock, &mWhen);
+    Add(mWhen, (long long)duration.Nano());
+  }
+
+  bool Passed() const
+  {
+    return Reached(mWhen, mClock);
+  }
+
+  // @return the time that is left until the deadline (rounded up), 0 if it passed
+  milliseconds_t Left() const
+  {
+    const nanoseconds_t nano = NanoLeft();
+    return (milliseconds_t)((nano + NANO_IN_MILLI - 1) / NANO_IN_MILLI);
+  }
+
+  // @return the time that is left until the deadline, 0 if it passed
+  nanoseconds_t NanoLeft() const
+  {
+    timespec now;
+    clock_gettime(mClock, &now);
+    const long long nano = (long long)(mWhen.tv_sec - now.tv_sec) * NANO_IN_SECOND + (mWhen.tv_nsec - now.tv_nsec);
+    return nano > 0 ? (nanoseconds_t)nano : 0;
+  }
+
+  const timespec* Get() const
+  {
+    return &mWhen;
+  }
+
+  clockid_t Clock() const
+  {
+    return mClock;
+  }
+
+  // true if this was created from Duration - the waits for it would spin at the end
+  bool Precise() const
+  {
+    return mPrecise;
+  }
+
+  // @param park would be set to the time to stop blocking and start spinning
+  // @return false if this time has already passed
+  bool ParkUntil(timespec& park) const
+  {
+    park = mWhen;
+    Add(park, -(long long)SPIN_WINDOW_NANO);
+    return !Reached(park, mClock);
+  }
+
+private:
+  static const long long NANO_IN_SECOND = 1000000000LL;
+  static const long long NANO_IN_MILLI = 1000000LL;
+
+  static void Add(timespec& to, long long nano)
+  {
+    to.tv_sec += (time_t)(nano / NANO_IN_SECOND);
+    to.tv_nsec += (long)(nano % NANO_IN_SECOND);
+    if (to.tv_nsec >= NANO_IN_SECOND)
+    {
+      to.tv_nsec -= NANO_IN_SECOND;
+      ++to.tv_sec;
+    }
+    else if (to.tv_nsec < 0)
+    {
+      to.tv_nsec += NANO_IN_SECOND;
+      --to.tv_sec;
+    }
+  }
+
+  static bool Reached(const timespec& when, clockid_t clock)
+  {
+    timespec now;
+    clock_gettime(clock, &now);
+    return now.tv_sec > when.tv_sec ||
+           (now.tv_sec == when.tv_sec && now.tv_nsec >= when.tv_nsec);
+  }
+
+  clockid_t mClock;
+  timespec  mWhen;
+  bool      mPrecise;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// the system calls themselves. all the wait functions would return 0 if we were woken up
+// (or if the value was not the expected one to begin with), else the errno value.
+// the futex word is private to the process (which is faster for the kernel) unless shared
+// is set - this is needed when the word is in memory that is mapped by more than one process
+namespace Futex
+{
+
+inline int Scope(bool shared)
+{
+  return shared ? 0 : FUTEX_PRIVATE_FLAG;
+}
+
+inline int Call(volatile int* at, int op, int value, const timespec* timeout, int value3)
+{
+  return (int)syscall(SYS_futex, at, op, value, timeout, (int*)0, value3);
+}
+
+// the waits of the OSAL objects are cancellation points (the same as sem_wait and pthread_cond_wait),
+// but the cancellation is kept deferred - it is only acted on here, where the calling thread is not
+// registered as a waiter and is not holding anything. So this is called before a thread start to
+// wait and after it is done (the objects that count their waiters can't be left in the middle)
+inline void CancellationPoint()
+{
+  pthread_testcancel();
+}
+
+// the waits of the locks are cancellation points while the thread is blocked in the kernel (so that
+// a thread that is stuck on a lock can still be stopped with pthread_cancel). This is only used where
+// the thread would not own anything when it is unwound - the lock itself is only taken after the call
+// returns, and a waiter that is gone would only cost the owner one extra wake up
+inline int CancellableCall(volatile int* at, int op, int value, const timespec* timeout, int value3)
+{
+  int oldType = PTHREAD_CANCEL_DEFERRED;
+  pthread_setcanceltype(PTHREAD_CANCEL_ASYNCHRONOUS, &oldType);
+  int ret = Call(at, op, value, timeout, value3);
+  int err = errno;
+  pthread_setcanceltype(oldType, &oldType);
+  errno = err;
+  return ret;
+}
+
+inline int WaitCall(volatile int* at, int op, int value, const timespec* timeout, int value3, bool cancellable)
+{
+  return cancellable ? CancellableCall(at, op, value, timeout, value3) : Call(at, op, value, timeout, value3);
+}
+
+inline int ErrorCode(int ret)
+{
+  if (ret == 0)
+  {
+    return 0;
+  }
+  else
+  {
+    int err = errno;
+    // the value was changed or we got a signal - the caller would check the value again anyway
+    return (err == EAGAIN || err == EINTR) ? 0 : err;
+  }
+}
+
+// block as long as the value at address is equal to expected (set cancellable only for locks, see above)
+inline int Wait(volatile int* at, int expected, bool shared = false, bool cancellable = false)
+{
+  return ErrorCode(WaitCall(at, FUTEX_WAIT | Scope(shared), expected, 0, 0, cancellable));
+}
+
+// block as long as the value at address is equal to expected, or until the deadline passed (ETIMEDOUT)
+// note that the bitset version of wait is using absolute time so we don't need to recalculate it.
+// for precise deadlines we are blocking until a short time before the deadline, and then spin on the
+// value, so that the wait would not end late because of the kernel timer slack
+inline int WaitUntil(volatile int* at, int expected, const Deadline& deadline, bool shared = false,
+                     bool cancellable = false)
+{
+  int op = FUTEX_WAIT_BITSET | Scope(shared);
+  if (deadline.Clock() == CLOCK_REALTIME)
+  {
+    op |= FUTEX_CLOCK_REALTIME;
+  }
+  if (!deadline.Precise())
+  {
+    return ErrorCode(WaitCall(at, op, expected, deadline.Get(), FUTEX_BITSET_MATCH_ANY, cancellable));
+  }
+  timespec park;
+  if (deadline.ParkUntil(park))
+  {
+    int err = ErrorCode(WaitCall(at, op, expected, &park, FUTEX_BITSET_MATCH_ANY, cancellable));
+    if (err != ETIMEDOUT)
+    {
+      return err;
+    }
+  }
+  while (AtomicLoadRelaxed(at) == expected)
+  {
+    if (deadline.Passed())
+    {
+      return ETIMEDOUT;
+    }
+    CpuRelax();
+  }
+  return 0;
+}
+
+// @return the number of threads that were woken up
+inline int Wake(volatile int* at, int count, bool shared = false)
+{
+  return Call(at, FUTEX_WAKE | Scope(shared), count, 0, 0);
+}
+
+inline int WakeAll(volatile int* at)
+{
+  return Wake(at, INT_MAX);
+}
+
+// priority inheritance support - the value at address is the kernel thread id of the owner.
+// note that the kernel expect the timeout here as absolute CLOCK_REALTIME
+inline int LockPICall(volatile int* at, const Deadline* deadline)
+{
+  int ret = Call(at, FUTEX_LOCK_PI | FUTEX_PRIVATE_FLAG, 0, deadline ? deadline->Get() : 0, 0);
+  return ret == 0 ? 0 : errno;
+}
+
+enum
+{
+  PI_CANCEL_CHECK_MILLI = 100   // how long a cancellable PI lock is blocking between the cancellation checks
+};
+
+// here the kernel is the one that give us the lock, so we can't be cancelled while we are blocked
+// (we may be unwound right after we got it, and the lock would never be released). A cancellable
+// wait is blocking for up to PI_CANCEL_CHECK_MILLI at a time instead, and is checking for
+// cancellation between the tries, when it does not own the lock
+inline int LockPI(volatile int* at, const Deadline* deadline, bool cancellable = false)
+{
+  if (!cancellable)
+  {
+    return LockPICall(at, deadline);
+  }
+  const nanoseconds_t SLICE_NANO = (nanoseconds_t)PI_CANCEL_CHECK_MILLI * 1000000;
+  for (;;)
+  {
+    CancellationPoint();
+    if (deadline && deadline->NanoLeft() <= SLICE_NANO)
+    {
+      return LockPICall(at, deadline);  // the last try
+    }
+    const Deadline slice(PI_CANCEL_CHECK_MILLI, CLOCK_REALTIME);
+    int err = LockPICall(at, &slice);
+    if (err != ETIMEDOUT)
+    {
+      return err;
+    }
+  }
+}
+
+inline int UnlockPI(volatile int* at)
+{
+  int ret = Call(at, FUTEX_UNLOCK_PI | FUTEX_PRIVATE_FLAG, 0, 0, 0);
+  return ret == 0 ? 0 : errno;
+}
+
+} // end of namespace Futex
+
+///////////////////////////////////////////////////////////////////////////////
+// event count - allow to wait for a condition that is changed without any lock.
+// the waiter take a ticket, then check the condition again, and only if it is still
+// false it would wait on the ticket. the one that make the condition true would call
+// Notify, which would only enter the kernel if someone is waiting. set shared if the
+// object is placed in memory that is shared between processes
+class EventCount
+{
+public:
+  explicit EventCount(bool shared = false) : mCount(0), mWaiters(0), mShared(shared)
+  {
+  }
+
+  // @return the ticket to wait on - you must call either Wait or CancelWait after this
+  int PrepareWait()
+  {
+    Futex::CancellationPoint();
+    AtomicFetchAdd(&mWaiters, 1);
+    return AtomicLoad(&mCount);
+  }
+
+  // call this if after PrepareWait the condition became true
+  void CancelWait()
+  {
+    AtomicFetchAdd(&mWaiters, -1);
+  }
+
+  // @return 0 if we were notified (or the ticket is old), else the error (ETIMEDOUT)
+  int Wait(int ticket, const Deadline* deadline)
+  {
+    int err = deadline ? Futex::WaitUntil(&mCount, ticket, *deadline, mShared) : Futex::Wait(&mCount, ticket, mShared);
+    AtomicFetchAdd(&mWaiters, -1);
+    Futex::CancellationPoint();
+    return err;
+  }
+
+  // @return true if some thread is between PrepareWait and the end of Wait (or CancelWait)
+  bool HasWaiters() const
+  {
+    return AtomicLoad(&mWaiters) > 0;
+  }
+
+  // call this after the condition was changed
+  void Notify(bool all)
+  {
+    AtomicFence();  // the change to the condition must be visible before we read the waiters count
+    if (AtomicLoadRelaxed(&mWaiters) > 0)
+    {
+      AtomicFetchAdd(&mCount, 1);
+      Futex::Wake(&mCount, all ? INT_MAX : 1, mShared);
+    }
+  }
+
+private:
+  volatile int mCount;
+  volatile int mWaiters;
+  bool mShared;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// the basic lock - this is the third mutex from "Futexes Are Tricky"
+// the word can be 0 - unlocked, 1 - locked with no waiters 2 - locked and
+// there may be waiters, so the one that release the lock must go to the kernel
+// note that the interface (Take/Give as const functions) is the same as in
+// semvx::SemHandle so that we can use it with Private::CriticalSection
+struct FutexLock
+{
+  enum State
+  {
+    UNLOCKED = 0,
+    LOCKED,
+    CONTENDED
+  };
+
+  enum Cancel
+  {
+    CANCELLABLE
+  };
+
+  // the parameter is only here so that this can replace SemHandle
+  explicit FutexLock(bool = false) : mState(UNLOCKED), mCancellable(false)
+  {
+  }
+
+  // the waits for this lock are cancellation points (this is for the locks of the Mutex objects)
+  explicit FutexLock(Cancel) : mState(UNLOCKED), mCancellable(true)
+  {
+  }
+
+  bool TryTake() const
+  {
+    int expected = UNLOCKED;
+    return AtomicCompareExchange(&mState, expected, LOCKED);
+  }
+
+  bool Take() const
+  {
+    int current = UNLOCKED;
+    if (!AtomicCompareExchange(&mState, current, LOCKED))
+    {
+      if (current != CONTENDED)
+      {
+        current = AtomicExchange(&mState, CONTENDED);
+      }
+      while (current != UNLOCKED)
+      {
+        int err = Futex::Wait(&mState, CONTENDED, false, mCancellable);
+        if (err)
+        {
+          errno = err;
+          return false;
+        }
+        current = AtomicExchange(&mState, CONTENDED);
+      }
+    }
+    return true;
+  }
+
+  // @return false with errno set to ETIMEDOUT if we failed to lock before the deadline
+  bool Take(const Deadline& deadline) const
+  {
+    int current = UNLOCKED;
+    if (!AtomicCompareExchange(&mState, current, LOCKED))
+    {
+      if (current != CONTENDED)
+      {
+        current = AtomicExchange(&mState, CONTENDED);
+      }
+      while (current != UNLOCKED)
+      {
+        int err = Futex::WaitUntil(&mState, CONTENDED, deadline, false, mCancellable);
+        if (err)
+        {
+          errno = err;
+          return false;
+        }
+        current = AtomicExchange(&mState, CONTENDED);
+      }
+    }
+    return true;
+  }
+
+  bool Give() const
+  {
+    if (AtomicExchange(&mState, UNLOCKED) == CONTENDED)
+    {
+      Futex::Wake(&mState, 1);  // only in this case we need to go to the kernel
+    }
+    return true;
+  }
+
+  // to spin on the lock without writing to it (that would move the cache line between the CPUs)
+  bool IsLocked() const
+  {
+    return AtomicLoadRelaxed(&mState) != UNLOCKED;
+  }
+
+private:
+  // don't allow copy and assign for this object!
+  FutexLock(const FutexLock&);
+  FutexLock& operator = (const FutexLock&);
+
+  mutable volatile int mState;
+  const bool mCancellable;
+};
+
+} // end of namespace Private
+
+} // end of namespace osal
+
+#endif  // FUTEX_POSIX__H
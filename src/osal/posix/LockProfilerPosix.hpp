@@ -0,0 +1,315 @@
+#ifndef LOCK_PROFILER_POSIX__HPP
+#define LOCK_PROFILER_POSIX__HPP
+// Linux implementation for the lock profiler. Each thread has its own table of
+// entries (a hash table that is keyed by the lock and the call site) and a stack of
+// the locks it is holding (to measure the hold time). Only the owner thread is writing
+// to its table, and the tables are never freed (so the results of threads that exited
+// are kept) so the reporting thread can read them at any time without locking.
+// Reset is done with a generation counter - each thread clear its own table when it see
+// that the generation was changed.
+
+#include "osal/LockProfiler.h"      // the interface for this implementation
+#include "LockProfiling.h"          // the hooks that are used by the locks
+#include "Futex.h"                  // atomic operations
+#include <execinfo.h>               // backtrace_symbols
+#include <stdio.h>                  // printf
+#include <stdlib.h>                 // free
+#include <string.h>                 // memset
+#include <algorithm>                // sort
+#include <map>                      // to merge the results
+#include <vector>                   // to sort the results
+#include <utility>                  // pair
+
+namespace osal
+{
+
+namespace Private
+{
+
+namespace LockProfiling
+{
+
+volatile bool enabled = false;
+__thread unsigned int heldLocks = 0;
+
+namespace
+{
+
+enum
+{
+  TABLE_SIZE = 256,     // must be power of 2
+  MAX_HELD = 16         // deeper lock nesting would not be recorded for hold time
+};
+
+struct Slot
+{
+  const void* volatile Lock;
+  const void* Site;
+  volatile unsigned long long Acquisitions;
+  volatile unsigned long long Contended;
+  volatile unsigned long long Failed;
+  volatile nanoseconds_t WaitTime;
+  volatile nanoseconds_t MaxWait;
+  volatile nanoseconds_t HoldTime;
+  volatile nanoseconds_t MaxHold;
+};
+
+struct Held
+{
+  const void* Lock;
+  Slot* Where;
+  nanoseconds_t Since;
+};
+
+struct ThreadTable
+{
+  ThreadTable* Next;
+  volatile unsigned int Generation;
+  Slot Slots[TABLE_SIZE];
+  Held Holding[MAX_HELD];
+};
+
+ThreadTable* volatile allTables = 0;
+volatile unsigned int generation = 0;
+__thread ThreadTable* threadTable = 0;
+
+// only the owner thread is changing the values, so this do not need to be atomic
+// operation, but it must be atomic store so that the reporting thread would see full values
+template<typename T>
+void Add(volatile T* at, T value)
+{
+  AtomicStoreRelaxed(at, AtomicLoadRelaxed(at) + value);
+}
+
+template<typename T>
+void Maximum(volatile T* at, T value)
+{
+  if (value > AtomicLoadRelaxed(at))
+  {
+    AtomicStoreRelaxed(at, value);
+  }
+}
+
+ThreadTable* CurrentTable()
+{
+  ThreadTable* table = threadTable;
+  if (!table)
+  {
+    table = new ThreadTable;
+    memset(table, 0, sizeof(*table));
+    table->Generation = AtomicLoad(&generation);
+    ThreadTable* head = AtomicLoad(&allTables);
+    do
+    {
+      table->Next = head;
+    }
+    while (!AtomicCompareExchange(&allTables, head, table));
+    threadTable = table;
+  }
+  else if (table->Generation != AtomicLoadRelaxed(&generation))
+  {
+    // we were reset, the locks we are holding now would not be counted
+    for (unsigned int i = 0; i < TABLE_SIZE; i++)
+    {
+      AtomicStoreRelaxed(&table->Slots[i].Lock, (const void*)0);
+    }
+    heldLocks = 0;
+    AtomicStoreRelease(&table->Generation, AtomicLoadRelaxed(&generation));
+  }
+  return table;
+}
+
+Slot* Find(ThreadTable* table, const void* lock, const void* site)
+{
+  unsigned long hash = ((unsigned long)lock >> 4) ^ ((unsigned long)site * 0x9E3779B1UL);
+  hash ^= hash >> 16;
+  for (unsigned int i = 0; i < TABLE_SIZE; i++)
+  {
+    Slot* slot = &table->Slots[(hash + i) & (TABLE_SIZE - 1)];
+    const void* current = AtomicLoadRelaxed(&slot->Lock);
+    if (current == lock && slot->Site == site)
+    {
+      return slot;
+    }
+    if (!current)
+    {
+      // new entry - make sure that the reporting thread would only see it once it is ready
+      slot->Site = site;
+      AtomicStoreRelaxed(&slot->Acquisitions, 0ULL);
+      AtomicStoreRelaxed(&slot->Contended, 0ULL);
+      AtomicStoreRelaxed(&slot->Failed, 0ULL);
+      AtomicStoreRelaxed(&slot->WaitTime, 0ULL);
+      AtomicStoreRelaxed(&slot->MaxWait, 0ULL);
+      AtomicStoreRelaxed(&slot->HoldTime, 0ULL);
+      AtomicStoreRelaxed(&slot->MaxHold, 0ULL);
+      AtomicStoreRelease(&slot->Lock, lock);
+      return slot;
+    }
+  }
+  return 0;   // the table is full
+}
+
+bool MoreContended(const osal::LockProfiler::Entry& left, const osal::LockProfiler::Entry& right)
+{
+  if (left.Contended != right.Contended)
+  {
+    return left.Contended > right.Contended;
+  }
+  return left.WaitTime > right.WaitTime;
+}
+
+} // end of local namespace
+
+void Acquired(const void* lock, const void* site, bool contended, nanoseconds_t waited)
+{
+  ThreadTable* table = CurrentTable();
+  Slot* slot = Find(table, lock, site);
+  if (!slot)
+  {
+    return;
+  }
+  Add(&slot->Acquisitions, 1ULL);
+  if (contended)
+  {
+    Add(&slot->Contended, 1ULL);
+    Add(&slot->WaitTime, waited);
+    Maximum(&slot->MaxWait, waited);
+  }
+  if (heldLocks < MAX_HELD)
+  {
+    Held& held = table->Holding[heldLocks++];
+    held.Lock = lock;
+    held.Where = slot;
+    held.Since = StopWatchOper::Now();
+  }
+}
+
+void Failed(const void* lock, const void* site, nanoseconds_t waited)
+{
+  Slot* slot = Find(CurrentTable(), lock, site);
+  if (slot)
+  {
+    Add(&slot->Failed, 1ULL);
+    Add(&slot->WaitTime, waited);
+    Maximum(&slot->MaxWait, waited);
+  }
+}
+
+void Released(const void* lock)
+{
+  ThreadTable* table = threadTable;
+  // locks are normally released in the reverse order, so start from the top
+  for (unsigned int i = heldLocks; i > 0; i--)
+  {
+    Held& held = table->Holding[i - 1];
+    if (held.Lock == lock)
+    {
+      const nanoseconds_t now = StopWatchOper::Now();
+      const nanoseconds_t hold = now > held.Since ? now - held.Since : 0;
+      if (table->Generation == AtomicLoadRelaxed(&generation))
+      {
+        Add(&held.Where->HoldTime, hold);
+        Maximum(&held.Where->MaxHold, hold);
+      }
+      table->Holding[i - 1] = table->Holding[--heldLocks];
+      return;
+    }
+  }
+}
+
+} // end of namespace LockProfiling
+
+} // end of namespace Private
+
+namespace LockProfiler
+{
+
+void Enable(bool on)
+{
+  Private::AtomicStore(&Private::LockProfiling::enabled, on);
+}
+
+bool Enabled()
+{
+  return Private::AtomicLoad(&Private::LockProfiling::enabled);
+}
+
+void Reset()
+{
+  Private::AtomicFetchAdd(&Private::LockProfiling::generation, 1u);
+}
+
+unsigned int Top(Entry* entries, unsigned int maxEntries)
+{
+  using namespace Private::LockProfiling;
+  typedef std::map<std::pair<const void*, const void*>, Entry> merged_t;
+  merged_t merged;
+  const unsigned int current = Private::AtomicLoad(&generation);
+  for (ThreadTable* table = Private::AtomicLoad(&allTables); table; table = table->Next)
+  {
+    if (Private::AtomicLoadAcquire(&table->Generation) != current)
+    {
+      continue;   // this thread did not record anything since the last reset
+    }
+    for (unsigned int i = 0; i < TABLE_SIZE; i++)
+    {
+      const Slot& slot = table->Slots[i];
+      const void* lock = Private::AtomicLoadAcquire(&slot.Lock);
+      if (!lock)
+      {
+        continue;
+      }
+      std::pair<merged_t::iterator, bool> at = merged.insert(std::make_pair(std::make_pair(lock, slot.Site), Entry()));
+      Entry& entry = at.first->second;
+      if (at.second)
+      {
+        memset(&entry, 0, sizeof(entry));
+        entry.Lock = lock;
+        entry.CallSite = slot.Site;
+      }
+      entry.Acquisitions += Private::AtomicLoadRelaxed(&slot.Acquisitions);
+      entry.Contended += Private::AtomicLoadRelaxed(&slot.Contended);
+      entry.Failed += Private::AtomicLoadRelaxed(&slot.Failed);
+      entry.WaitTime += Private::AtomicLoadRelaxed(&slot.WaitTime);
+      entry.HoldTime += Private::AtomicLoadRelaxed(&slot.HoldTime);
+      entry.MaxWait = std::max(entry.MaxWait, Private::AtomicLoadRelaxed(&slot.MaxWait));
+      entry.MaxHold = std::max(entry.MaxHold, Private::AtomicLoadRelaxed(&slot.MaxHold));
+    }
+  }
+  std::vector<Entry> all;
+  all.reserve(merged.size());
+  for (merged_t::const_iterator i = merged.begin(); i != merged.end(); ++i)
+  {
+    all.push_back(i->second);
+  }
+  std::sort(all.begin(), all.end(), MoreContended);
+  const unsigned int count = std::min(maxEntries, static_cast<unsigned int>(all.size()));
+  std::copy(all.begin(), all.begin() + count, entries);
+  return count;
+}
+
+void Report(unsigned int topN)
+{
+  std::vector<Entry> entries(topN);
+  const unsigned int count = topN ? Top(&entries[0], topN) : 0;
+  printf("%-18s %-40s %12s %12s %8s %14s %12s %14s %12s\n", "lock", "call site", "acquired", "contended", "failed",
+         "wait(ns)", "max wait", "hold(ns)", "max hold");
+  for (unsigned int i = 0; i < count; i++)
+  {
+    const Entry& entry = entries[i];
+    void* site = const_cast<void*>(entry.CallSite);
+    char** symbol = backtrace_symbols(&site, 1);
+    printf("%-18p %-40s %12llu %12llu %8llu %14llu %12llu %14llu %12llu\n", entry.Lock, symbol ? symbol[0] : "?",
+           entry.Acquisitions, entry.Contended, entry.Failed, entry.WaitTime, entry.MaxWait,
+           entry.HoldTime, entry.MaxHold);
+    free(symbol);
+  }
+}
+
+} // end of namespace LockProfiler
+
+} // end of namespace osal
+
+#else
+# error "you must not include this file inside header file"
+#endif  // LOCK_PROFILER_POSIX__HPP
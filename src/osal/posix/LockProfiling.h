@@ -0,0 +1,84 @@
+#ifndef LOCK_PROFILING__H
+#define LOCK_PROFILING__H
+// The hooks for the lock profiler (see osal/LockProfiler.h) that are used by the lock
+// implementations. When the profiler is disabled, taking a lock costs a single check
+// of a global flag and releasing a lock a single check of a thread local counter.
+// Defining OSAL_NO_LOCK_PROFILER remove the hooks completely
+
+#include "osal/OsalGeneralDefines.h"  // nanoseconds_t
+#include "osal/StopWatch.h"           // to measure the wait time
+#include <errno.h>                    // errno
+
+namespace osal
+{
+
+namespace Private
+{
+
+namespace LockProfiling
+{
+
+extern volatile bool enabled;             // whether we are recording
+extern __thread unsigned int heldLocks;   // number of recorded locks that the current thread is holding
+
+void Acquired(const void* lock, const void* site, bool contended, nanoseconds_t waited);
+
+void Failed(const void* lock, const void* site, nanoseconds_t waited);
+
+void Released(const void* lock);
+
+// take a lock while recording it. We are first trying to take the lock so we would know whether it
+// is contended. Op must have -
+// bool Try() - try to take the lock without blocking
+// bool Wait() - block until the lock is taken (or the timeout passed)
+// const void* Lock() const - the lock id
+// @return the same as the lock operation with the same errno
+template<typename Op>
+bool ProfiledTake(Op op, const void* site, bool tryOnly)
+{
+  if (op.Try())
+  {
+    Acquired(op.Lock(), site, false, 0);
+    return true;
+  }
+  int err = errno;
+  if (tryOnly)
+  {
+    Failed(op.Lock(), site, 0);
+    errno = err;
+    return false;
+  }
+  const nanoseconds_t start = StopWatchOper::Now();
+  const bool taken = op.Wait();
+  err = errno;
+  const nanoseconds_t waited = StopWatchOper::Now() - start;
+  if (taken)
+  {
+    Acquired(op.Lock(), site, true, waited);
+  }
+  else
+  {
+    Failed(op.Lock(), site, waited);
+  }
+  errno = err;
+  return taken;
+}
+
+} // end of namespace LockProfiling
+
+} // end of namespace Private
+
+} // end of namespace osal
+
+#ifdef OSAL_NO_LOCK_PROFILER
+# define OSAL_LOCK_PROFILING() false
+# define OSAL_LOCK_HOLDING() false
+#else
+# define OSAL_LOCK_PROFILING() __builtin_expect(osal::Private::LockProfiling::enabled, 0)
+# define OSAL_LOCK_HOLDING() __builtin_expect(osal::Private::LockProfiling::heldLocks != 0, 0)
+#endif  // OSAL_NO_LOCK_PROFILER
+
+// the code that called the lock function, this must be used in the public lock functions
+#define OSAL_LOCK_CALL_SITE() __builtin_return_address(0)
+
+#endif  // LOCK_PROFILING__H
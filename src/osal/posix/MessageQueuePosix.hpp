@@ -1,2 +1,711 @@
+#ifndef MESSAGE_QUEUE_POSIX__HPP
+#define MESSAGE_QUEUE_POSIX__HPP
+// Linux implementation for the message queue - there are two engines here
+// the locking engine is the portable one that is based on boost message queue
+// and the lock free engine is based on ring buffer with futex to sleep when the
+// queue is full or empty (see MessageRing.h). The same ring has a simpler version
+// for queues with only one writer and one reader, and a version of it that is placed
+// in shared memory so that it can be used by two processes (see SharedMessageRing.h)
 
-#error "posix message queue is not supported yet"
+#include "osal/MessageQueue.h"        // the interface for this implementation
+#include "../details/MessageQueue.hpp" // the locking engine
+#include "MessageRing.h"              // the lock free engine
+#include "SharedMessageRing.h"        // the engine for queues between processes
+#include "CriticalSection.h"          // critical section pattern
+#include "ExitFunctionHolder.h"       // to handle functions called on exit
+#include "Readiness.h"                // to allow polling on the queue
+#include <boost/interprocess/shared_memory_object.hpp>  // the named shared memory
+#include <boost/interprocess/mapped_region.hpp>         // to map it
+#include <assert.h>                   // assert
+#include <errno.h>                    // errno values
+#include <new>                        // placement new
+#include <string>                     // class string
+
+namespace osal
+{
+
+namespace MessageQueue
+{
+
+namespace
+{
+
+  Private::ExitFunctionHolder& ExitFunctionsList();
+
+  Private::ExitFunctionHolder& ExitFunctionsList()
+  {
+    static Private::ExitFunctionHolder theList;
+    return theList;
+  }
+
+} // end of local namespace
+
+///////////////////////////////////////////////////////////////////////////////
+// all the function that may fail, return false (or -1) with errno set to the reason
+struct Id
+{
+  explicit Id(unsigned int msgSize) : MaxMessageSize(msgSize), mReady(NotEmpty, this)
+  {
+  }
+
+  virtual ~Id()
+  {
+  }
+
+  virtual bool Push(const char* msg, unsigned int size, bool urgent) = 0;
+
+  virtual bool TryPush(const char* msg, unsigned int size, bool urgent) = 0;
+
+  virtual bool TimePush(const char* msg, unsigned int size, const Private::Deadline& deadline, bool urgent) = 0;
+
+  virtual int Pop(char* buff, unsigned int buffSize) = 0;
+
+  virtual int TryPop(char* buff, unsigned int buffSize) = 0;
+
+  virtual int TimePop(char* buff, unsigned int buffSize, const Private::Deadline& deadline) = 0;
+
+  // @return the number of messages that were added (0 with errno set on failure)
+  virtual unsigned int PushBatch(const char* const msgs[], const unsigned int sizes[], unsigned int count) = 0;
+
+  // @return the number of messages that were read (0 with errno set on failure)
+  virtual unsigned int PopBatch(char* buff, unsigned int stride, unsigned int sizes[], unsigned int maxCount,
+                                milliseconds_t timeout) = 0;
+
+  virtual int Size() const = 0;
+
+  virtual LanesCount Lanes() const = 0;
+
+  // the queues inside the process have no other side that can crash
+  virtual bool PeerAlive() const
+  {
+    return true;
+  }
+
+  Private::Readiness& Ready()
+  {
+    return mReady;
+  }
+
+  const unsigned int MaxMessageSize;  // the same as in VxWorks, we are not allowing larger messages
+
+private:
+  static bool NotEmpty(const void* owner)
+  {
+    return static_cast<const Id*>(owner)->Size() > 0;
+  }
+
+  Private::Readiness mReady;
+};
+
+struct LockingId : public Id
+{
+  LockingId(unsigned int qSize, unsigned int msgSize) : Id(msgSize), mQueue(qSize, msgSize)
+  {
+  }
+
+  // unlike the rings, the lock is not a full fence - and we need one before Readiness::Notify
+  bool Push(const char* msg, unsigned int size, bool urgent)
+  {
+    mQueue.Push(msg, size, urgent);
+    Private::AtomicFence();
+    return true;
+  }
+
+  bool TryPush(const char* msg, unsigned int size, bool urgent)
+  {
+    if (mQueue.TryPush(msg, size, urgent))
+    {
+      Private::AtomicFence();
+      return true;
+    }
+    errno = EAGAIN;
+    return false;
+  }
+
+  // boost is using relative timeout - this is the time that is left until the deadline
+  bool TimePush(const char* msg, unsigned int size, const Private::Deadline& deadline, bool urgent)
+  {
+    if (mQueue.TimePush(msg, size, Duration(deadline.NanoLeft()), urgent))
+    {
+      Private::AtomicFence();
+      return true;
+    }
+    errno = ETIMEDOUT;
+    return false;
+  }
+
+  int Pop(char* buff, unsigned int buffSize)
+  {
+    return mQueue.Pop(buff, buffSize);
+  }
+
+  int TryPop(char* buff, unsigned int buffSize)
+  {
+    int ret = mQueue.TryPop(buff, buffSize);
+    if (ret < 0)
+    {
+      errno = EAGAIN;
+    }
+    return ret;
+  }
+
+  int TimePop(char* buff, unsigned int buffSize, const Private::Deadline& deadline)
+  {
+    int ret = mQueue.TimePop(buff, buffSize, Duration(deadline.NanoLeft()));
+    if (ret < 0)
+    {
+      errno = ETIMEDOUT;
+    }
+    return ret;
+  }
+
+  unsigned int PushBatch(const char* const msgs[], const unsigned int sizes[], unsigned int count)
+  {
+    const unsigned int ret = mQueue.PushBatch(msgs, sizes, count);
+    Private::AtomicFence();
+    return ret;
+  }
+
+  unsigned int PopBatch(char* buff, unsigned int stride, unsigned int sizes[], unsigned int maxCount,
+                        milliseconds_t timeout)
+  {
+    unsigned int ret = mQueue.PopBatch(buff, stride, sizes, maxCount, timeout);
+    if (ret == 0)
+    {
+      errno = timeout ? ETIMEDOUT : EAGAIN;
+    }
+    return ret;
+  }
+
+  int Size() const
+  {
+    return mQueue.Size();
+  }
+
+  LanesCount Lanes() const
+  {
+    return mQueue.Lanes();
+  }
+
+private:
+  details::MessageQueue mQueue;
+};
+
+template<typename Ring>
+struct RingId : public Id
+{
+  RingId(unsigned int qSize, unsigned int msgSize) : Id(msgSize), mRing(qSize, msgSize)
+  {
+  }
+
+  bool Push(const char* msg, unsigned int size, bool urgent)
+  {
+    return mRing.Push(msg, size, urgent, 0);
+  }
+
+  bool TryPush(const char* msg, unsigned int size, bool urgent)
+  {
+    if (mRing.TryPush(msg, size, urgent))
+    {
+      return true;
+    }
+    errno = EAGAIN;
+    return false;
+  }
+
+  bool TimePush(const char* msg, unsigned int size, const Private::Deadline& deadline, bool urgent)
+  {
+    return mRing.Push(msg, size, urgent, &deadline);
+  }
+
+  int Pop(char* buff, unsigned int buffSize)
+  {
+    return mRing.Pop(buff, buffSize, 0);
+  }
+
+  int TryPop(char* buff, unsigned int buffSize)
+  {
+    int ret = mRing.TryPop(buff, buffSize);
+    if (ret < 0)
+    {
+      errno = EAGAIN;
+    }
+    return ret;
+  }
+
+  int TimePop(char* buff, unsigned int buffSize, const Private::Deadline& deadline)
+  {
+    return mRing.Pop(buff, buffSize, &deadline);
+  }
+
+  unsigned int PushBatch(const char* const msgs[], const unsigned int sizes[], unsigned int count)
+  {
+    return mRing.PushBatch(msgs, sizes, count, 0);
+  }
+
+  unsigned int PopBatch(char* buff, unsigned int stride, unsigned int sizes[], unsigned int maxCount,
+                        milliseconds_t timeout)
+  {
+    if (timeout == 0)
+    {
+      unsigned int ret = mRing.TryPopBatch(buff, stride, sizes, maxCount);
+      if (ret == 0)
+      {
+        errno = EAGAIN;
+      }
+      return ret;
+    }
+    Private::Deadline deadline(timeout);
+    return mRing.PopBatch(buff, stride, sizes, maxCount, &deadline);
+  }
+
+  int Size() const
+  {
+    return mRing.Size();
+  }
+
+  LanesCount Lanes() const
+  {
+    LanesCount lanes = { mRing.NormalSize(), mRing.UrgentSize(), mRing.Overtaken(), mRing.Forced() };
+    return lanes;
+  }
+
+private:
+  Private::MessageLanes<Ring> mRing;
+};
+
+// the queue between processes - the ring is in the shared memory, and we keep the mapping
+// of the memory for as long as the queue is used
+struct SharedId : public Id
+{
+  typedef Private::SharedMessageRing Ring;
+
+  // @param region the mapping of the shared memory - this would take it from the caller
+  SharedId(boost::interprocess::mapped_region& region, const char* name, Ring::Side side) :
+      Id(static_cast<Ring*>(region.get_address())->MaxMessageSize()),
+      mRing(static_cast<Ring*>(region.get_address())), mName(name), mSide(side)
+  {
+    mRegion.swap(region);
+  }
+
+  ~SharedId()
+  {
+    mRing->Detach(mSide);
+    if (mSide == Ring::CREATOR)
+    {
+      // the other process can still use the memory that it mapped, but no one else can open it
+      boost::interprocess::shared_memory_object::remove(mName.c_str());
+    }
+  }
+
+  bool Push(const char* msg, unsigned int size, bool urgent)
+  {
+    return mRing->Push(msg, size, urgent, 0, mSide);
+  }
+
+  bool TryPush(const char* msg, unsigned int size, bool urgent)
+  {
+    if (mRing->TryPush(msg, size, urgent))
+    {
+      return true;
+    }
+    errno = EAGAIN;
+    return false;
+  }
+
+  bool TimePush(const char* msg, unsigned int size, const Private::Deadline& deadline, bool urgent)
+  {
+    return mRing->Push(msg, size, urgent, &deadline, mSide);
+  }
+
+  int Pop(char* buff, unsigned int buffSize)
+  {
+    return mRing->Pop(buff, buffSize, 0, mSide);
+  }
+
+  int TryPop(char* buff, unsigned int buffSize)
+  {
+    int ret = mRing->TryPop(buff, buffSize);
+    if (ret < 0)
+    {
+      errno = EAGAIN;
+    }
+    return ret;
+  }
+
+  int TimePop(char* buff, unsigned int buffSize, const Private::Deadline& deadline)
+  {
+    return mRing->Pop(buff, buffSize, &deadline, mSide);
+  }
+
+  unsigned int PushBatch(const char* const msgs[], const unsigned int sizes[], unsigned int count)
+  {
+    return mRing->PushBatch(msgs, sizes, count, 0, mSide);
+  }
+
+  unsigned int PopBatch(char* buff, unsigned int stride, unsigned int sizes[], unsigned int maxCount,
+                        milliseconds_t timeout)
+  {
+    if (timeout == 0)
+    {
+      unsigned int ret = mRing->TryPopBatch(buff, stride, sizes, maxCount);
+      if (ret == 0)
+      {
+        errno = EAGAIN;
+      }
+      return ret;
+    }
+    Private::Deadline deadline(timeout);
+    return mRing->PopBatch(buff, stride, sizes, maxCount, &deadline, mSide);
+  }
+
+  int Size() const
+  {
+    return mRing->Size();
+  }
+
+  LanesCount Lanes() const
+  {
+    LanesCount lanes = { mRing->NormalSize(), mRing->UrgentSize(), mRing->Overtaken(), mRing->Forced() };
+    return lanes;
+  }
+
+  bool PeerAlive() const
+  {
+    return mRing->PeerAlive(mSide);
+  }
+
+private:
+  boost::interprocess::mapped_region mRegion;
+  Ring* mRing;
+  std::string mName;
+  Ring::Side mSide;
+};
+
+namespace
+{
+  void VerifySize(const Id* mqId, unsigned int msgSize, const char* func, int line)
+  {
+    if (msgSize > mqId->MaxMessageSize)
+    {
+      ExitFunctionsList().CriticalError(EMSGSIZE, func, line);
+    }
+  }
+} // end of local namespace
+
+void RegisterAtExit(at_error_fun func)
+{
+  ExitFunctionsList().Push(func);
+}
+
+Id* Create(unsigned int queueSize, unsigned int maxMessageSize)
+{
+  return Create(queueSize, maxMessageSize, LOCKING);
+}
+
+Id* Create(unsigned int queueSize, unsigned int maxMessageSize, Engine engine)
+{
+  switch (engine)
+  {
+  case LOCK_FREE:
+    return new RingId<Private::MessageRing>(queueSize, maxMessageSize);
+  case SINGLE_READER_WRITER:
+    return new RingId<Private::SingleMessageRing>(queueSize, maxMessageSize);
+  case LOCKING:
+  default:
+    return new LockingId(queueSize, maxMessageSize);
+  }
+}
+
+Id* CreateLockFree(unsigned int queueSize, unsigned int maxMessageSize)
+{
+  return Create(queueSize, maxMessageSize, LOCK_FREE);
+}
+
+namespace
+{
+
+// @return true if there is a queue with this name whose creator is still running
+bool CreatorAlive(const char* name)
+{
+  using namespace boost::interprocess;
+  try
+  {
+    shared_memory_object memory(open_only, name, read_only);
+    offset_t size = 0;
+    if (!memory.get_size(size) || size < static_cast<offset_t>(sizeof(Private::SharedMessageRing)))
+    {
+      return false;   // the creator crashed before it set the size
+    }
+    mapped_region region(memory, read_only);
+    const Private::SharedMessageRing* ring = static_cast<const Private::SharedMessageRing*>(region.get_address());
+    return ring->Attached(Private::SharedMessageRing::CREATOR);
+  }
+  catch (const interprocess_exception&)
+  {
+    return false;   // there is no such queue
+  }
+}
+
+} // end of local namespace
+
+Id* CreateShared(const char* name, unsigned int queueSize, unsigned int maxMessageSize)
+{
+  using namespace boost::interprocess;
+  assert(name);
+  try
+  {
+    if (CreatorAlive(name))
+    {
+      ExitFunctionsList().CriticalError(EEXIST, __FUNCTION__, __LINE__);  // we must not take it from its creator
+      return 0;
+    }
+    shared_memory_object::remove(name);   // left by a process that crashed before it deleted its queue
+    shared_memory_object memory(create_only, name, read_write);
+    memory.truncate(Private::SharedMessageRing::Footprint(queueSize, maxMessageSize));
+    mapped_region region(memory, read_write);
+    Private::SharedMessageRing* ring = new (region.get_address()) Private::SharedMessageRing(queueSize, maxMessageSize);
+    ring->Attach(Private::SharedMessageRing::CREATOR);  // this is a new ring, no one else can be there
+    ring->Publish();
+    return new SharedId(region, name, Private::SharedMessageRing::CREATOR);
+  }
+  catch (const interprocess_exception& e)
+  {
+    ExitFunctionsList().CriticalError(e.get_native_error(), __FUNCTION__, __LINE__);
+  }
+  return 0;
+}
+
+Id* OpenShared(const char* name)
+{
+  using namespace boost::interprocess;
+  assert(name);
+  try
+  {
+    shared_memory_object memory(open_only, name, read_write);
+    offset_t size = 0;
+    if (!memory.get_size(size) || size < static_cast<offset_t>(sizeof(Private::SharedMessageRing)))
+    {
+      ExitFunctionsList().TryFail(EAGAIN, __FUNCTION__, __LINE__);  // the creator did not set its size yet
+      return 0;
+    }
+    mapped_region region(memory, read_write);
+    Private::SharedMessageRing* ring = static_cast<Private::SharedMessageRing*>(region.get_address());
+    if (!Private::SharedMessageRing::Ready(ring))
+    {
+      ExitFunctionsList().TryFail(EAGAIN, __FUNCTION__, __LINE__);
+      return 0;
+    }
+    if (region.get_size() < Private::SharedMessageRing::Footprint(ring->Capacity(), ring->MaxMessageSize()))
+    {
+      ExitFunctionsList().CriticalError(EINVAL, __FUNCTION__, __LINE__);   // this is not our queue
+      return 0;
+    }
+    if (!ring->Attach(Private::SharedMessageRing::OPENER))
+    {
+      ExitFunctionsList().TryFail(errno, __FUNCTION__, __LINE__);   // another process that is alive opened it
+      return 0;
+    }
+    return new SharedId(region, name, Private::SharedMessageRing::OPENER);
+  }
+  catch (const interprocess_exception& e)
+  {
+    // if it was not created yet, the caller can try again later
+    const int err = e.get_native_error() == ENOENT ? EAGAIN : e.get_native_error();
+    ExitFunctionsList().TryFail(err, __FUNCTION__, __LINE__);
+  }
+  return 0;
+}
+
+void Send(Id* mqId, CONST_MESSAGE char* msgBuff, unsigned int msgSize, bool highPriority)
+{
+  assert(mqId);   // this function cannot be called with invalid id
+  VerifySize(mqId, msgSize, __FUNCTION__, __LINE__);
+  if (!mqId->Push(msgBuff, msgSize, highPriority))
+  {
+    ExitFunctionsList().CriticalError(errno, __FUNCTION__, __LINE__);
+  }
+  mqId->Ready().Notify();
+}
+
+bool TrySend(Id* mqId, CONST_MESSAGE char* msgBuff, unsigned int msgSize, bool highPriority)
+{
+  assert(mqId);   // this function cannot be called with invalid id
+  VerifySize(mqId, msgSize, __FUNCTION__, __LINE__);
+  if (!mqId->TryPush(msgBuff, msgSize, highPriority))
+  {
+    return ExitFunctionsList().TryFail(errno, __FUNCTION__, __LINE__);
+  }
+  else
+  {
+    mqId->Ready().Notify();
+    return true;
+  }
+}
+
+bool TimedSend(Id* mqId, CONST_MESSAGE char* msgBuff, unsigned int msgSize,
+               milliseconds_t milliDuration, bool highPriority)
+{
+  assert(mqId);   // this function cannot be called with invalid id
+  VerifySize(mqId, msgSize, __FUNCTION__, __LINE__);
+  if (!mqId->TimePush(msgBuff, msgSize, Private::Deadline(milliDuration), highPriority))
+  {
+    return ExitFunctionsList().TimedOut(errno, __FUNCTION__, __LINE__);
+  }
+  else
+  {
+    mqId->Ready().Notify();
+    return true;
+  }
+}
+
+bool TimedSend(Id* mqId, CONST_MESSAGE char* msgBuff, unsigned int msgSize,
+               const Duration& duration, bool highPriority)
+{
+  assert(mqId);   // this function cannot be called with invalid id
+  VerifySize(mqId, msgSize, __FUNCTION__, __LINE__);
+  if (!mqId->TimePush(msgBuff, msgSize, Private::Deadline(duration), highPriority))
+  {
+    return ExitFunctionsList().TimedOut(errno, __FUNCTION__, __LINE__);
+  }
+  else
+  {
+    mqId->Ready().Notify();
+    return true;
+  }
+}
+
+int Receive(Id* mqId, char* msgBuff, unsigned int buffSize)
+{
+  assert(mqId);   // this function cannot be called with invalid id
+  int ret = mqId->Pop(msgBuff, buffSize);
+  if (ret < 0)
+  {
+    ExitFunctionsList().CriticalError(errno, __FUNCTION__, __LINE__);
+  }
+  return ret;
+}
+
+int TryReceive(Id* mqId, char* msgBuff, unsigned int buffSize)
+{
+  assert(mqId);   // this function cannot be called with invalid id
+  int ret = mqId->TryPop(msgBuff, buffSize);
+  if (ret < 0)
+  {
+    ExitFunctionsList().TryFail(errno, __FUNCTION__, __LINE__);
+  }
+  return ret;
+}
+
+int TimedReceive(Id* mqId, char* msgBuff, unsigned int buffSize, milliseconds_t milliDuration)
+{
+  assert(mqId);   // this function cannot be called with invalid id
+  int ret = mqId->TimePop(msgBuff, buffSize, Private::Deadline(milliDuration));
+  if (ret < 0)
+  {
+    ExitFunctionsList().TimedOut(errno, __FUNCTION__, __LINE__);
+  }
+  return ret;
+}
+
+int TimedReceive(Id* mqId, char* msgBuff, unsigned int buffSize, const Duration& duration)
+{
+  assert(mqId);   // this function cannot be called with invalid id
+  int ret = mqId->TimePop(msgBuff, buffSize, Private::Deadline(duration));
+  if (ret < 0)
+  {
+    ExitFunctionsList().TimedOut(errno, __FUNCTION__, __LINE__);
+  }
+  return ret;
+}
+
+unsigned int SendBatch(Id* mqId, CONST_MESSAGE char* const msgs[], const unsigned int sizes[], unsigned int count)
+{
+  assert(mqId);   // this function cannot be called with invalid id
+  for (unsigned int i = 0; i < count; i++)
+  {
+    VerifySize(mqId, sizes[i], __FUNCTION__, __LINE__);
+  }
+  unsigned int ret = mqId->PushBatch(msgs, sizes, count);
+  if (ret == 0 && count > 0)
+  {
+    ExitFunctionsList().CriticalError(errno, __FUNCTION__, __LINE__);
+  }
+  mqId->Ready().Notify();
+  return ret;
+}
+
+unsigned int ReceiveBatch(Id* mqId, char* msgBuff, unsigned int stride, unsigned int sizes[],
+                          unsigned int maxCount, milliseconds_t milliDuration)
+{
+  assert(mqId);   // this function cannot be called with invalid id
+  unsigned int ret = mqId->PopBatch(msgBuff, stride, sizes, maxCount, milliDuration);
+  if (ret == 0 && maxCount > 0)
+  {
+    if (milliDuration)
+    {
+      ExitFunctionsList().TimedOut(errno, __FUNCTION__, __LINE__);
+    }
+    else
+    {
+      ExitFunctionsList().TryFail(errno, __FUNCTION__, __LINE__);
+    }
+  }
+  return ret;
+}
+
+int CurrentCount(Id* mqId)
+{
+  assert(mqId);   // this function cannot be called with invalid id
+  return mqId->Size();
+}
+
+LanesCount CurrentLanesCount(Id* mqId)
+{
+  assert(mqId);   // this function cannot be called with invalid id
+  return mqId->Lanes();
+}
+
+bool PeerAlive(Id* mqId)
+{
+  assert(mqId);   // this function cannot be called with invalid id
+  return mqId->PeerAlive();
+}
+
+int ReadyHandle(Id* mqId)
+{
+  assert(mqId);   // this function cannot be called with invalid id
+  int fd = mqId->Ready().Handle();
+  if (fd < 0)
+  {
+    ExitFunctionsList().CriticalError(errno, __FUNCTION__, __LINE__);
+  }
+  return fd;
+}
+
+Private::Readiness& ReadinessOf(Id* mqId)
+{
+  return mqId->Ready();
+}
+
+Private::WaitList& WaitListOf(Id* mqId)
+{
+  return mqId->Ready().Waiters();
+}
+
+void Delete(Id*& mqId)
+{
+  if (mqId)
+  {
+    delete mqId;
+    mqId = 0;
+  }
+}
+
+}  // end of namespace MessageQueue
+
+} // end of namespace osal
+
+#else
+# error "you are trying to include a file that must no include in header file"
+#endif  // MESSAGE_QUEUE_POSIX__HPP
@@ -0,0 +1,678 @@
+#ifndef MESSAGE_RING_POSIX__H
+#define MESSAGE_RING_POSIX__H
+// Bounded queue of messages for many writers and many readers that is not using any lock.
+// This is based on the bounded MPMC queue by Dmitry Vyukov
+// (see http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue)
+// Each slot in the ring has a sequence number - when it is equal to the writer position the
+// slot is free, when it is equal to the writer position + 1 it hold a message that is ready to
+// be read. Writers and readers are claiming positions with CAS so they never wait for each other,
+// only when the queue is full (or empty) the thread would go to sleep in the kernel.
+// After it there is a version of the ring for a single writer and a single reader, and at
+// the end of this file there is the queue that is using two rings as normal and urgent lanes
+
+#include "Futex.h"          // atomic operations, EventCount, Deadline
+#include <string.h>         // memcpy
+#include <stdlib.h>         // posix_memalign, free
+#include <errno.h>          // errno values
+#include <new>              // bad_alloc
+
+namespace osal
+{
+
+namespace Private
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// helpers that are shared by the rings
+inline unsigned int RingCapacity(unsigned int capacity)
+{
+  unsigned int rounded = 2;
+  while (rounded < capacity)
+  {
+    rounded <<= 1;
+  }
+  return rounded;
+}
+
+inline char* AllocateRing(unsigned int stride, unsigned int count)
+{
+  void* arena = 0;
+  if (posix_memalign(&arena, CACHE_LINE_SIZE, static_cast<size_t>(stride) * count) != 0)
+  {
+    throw std::bad_alloc();
+  }
+  return static_cast<char*>(arena);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+class MessageRing
+{
+public:
+  // note that the capacity is rounded up to power of 2 (and it is at least 2)
+  MessageRing(unsigned int capacity, unsigned int maxMessageSize) : mHead(0), mTail(0), mArena(0),
+                                                                   mMask(RingCapacity(capacity) - 1),
+                                                                   mStride(SlotSize(maxMessageSize)),
+                                                                   mMaxMessageSize(maxMessageSize)
+  {
+    mArena = AllocateRing(mStride, mMask + 1);
+    for (unsigned int i = 0; i <= mMask; i++)
+    {
+      At(i)->Sequence = i;
+    }
+  }
+
+  ~MessageRing()
+  {
+    free(mArena);
+  }
+
+  // @return false if the queue is full
+  bool TryPush(const char* msg, unsigned int size)
+  {
+    unsigned int pos = AtomicLoadRelaxed(&mTail);
+    Slot* slot = 0;
+    for (;;)
+    {
+      slot = At(pos);
+      int diff = static_cast<int>(AtomicLoadAcquire(&slot->Sequence) - pos);
+      if (diff == 0)
+      {
+        if (AtomicCompareExchange(&mTail, pos, pos + 1))
+        {
+          break;
+        }
+      }
+      else if (diff < 0)
+      {
+        return false;   // the reader did not free this slot yet
+      }
+      else
+      {
+        pos = AtomicLoadRelaxed(&mTail);  // someone else took it
+      }
+    }
+    memcpy(Data(slot), msg, size);
+    slot->Size = size;
+    AtomicStoreRelease(&slot->Sequence, pos + 1);
+    return true;
+  }
+
+  // @return -1 if the queue is empty, else the number of bytes that were copied to buff
+  int TryPop(char* buff, unsigned int buffSize)
+  {
+    unsigned int pos = AtomicLoadRelaxed(&mHead);
+    Slot* slot = 0;
+    for (;;)
+    {
+      slot = At(pos);
+      int diff = static_cast<int>(AtomicLoadAcquire(&slot->Sequence) - (pos + 1));
+      if (diff == 0)
+      {
+        if (AtomicCompareExchange(&mHead, pos, pos + 1))
+        {
+          break;
+        }
+      }
+      else if (diff < 0)
+      {
+        return -1;      // the writer did not fill this slot yet
+      }
+      else
+      {
+        pos = AtomicLoadRelaxed(&mHead);
+      }
+    }
+    int size = static_cast<int>(CopyOut(slot, buff, buffSize));
+    AtomicStoreRelease(&slot->Sequence, pos + mMask + 1);  // free it for the next round
+    return size;
+  }
+
+  // claim with a single CAS as many free slots as we can (up to count)
+  // @return the number of messages that were added - 0 if the queue is full
+  unsigned int TryPushBatch(const char* const msgs[], const unsigned int sizes[], unsigned int count)
+  {
+    if (count == 0)
+    {
+      return 0;
+    }
+    unsigned int pos = AtomicLoadRelaxed(&mTail);
+    unsigned int claimed = 0;
+    for (;;)
+    {
+      int diff = static_cast<int>(AtomicLoadAcquire(&At(pos)->Sequence) - pos);
+      if (diff == 0)
+      {
+        claimed = CountSlots(pos, 0, count);
+        if (AtomicCompareExchange(&mTail, pos, pos + claimed))
+        {
+          break;
+        }
+      }
+      else if (diff < 0)
+      {
+        return 0;
+      }
+      else
+      {
+        pos = AtomicLoadRelaxed(&mTail);
+      }
+    }
+    for (unsigned int i = 0; i < claimed; i++)
+    {
+      Slot* slot = At(pos + i);
+      memcpy(Data(slot), msgs[i], sizes[i]);
+      slot->Size = sizes[i];
+      AtomicStoreRelease(&slot->Sequence, pos + i + 1);
+    }
+    return claimed;
+  }
+
+  // claim with a single CAS as many ready messages as we can (up to maxCount)
+  // @return the number of messages that were read - 0 if the queue is empty
+  unsigned int TryPopBatch(char* buff, unsigned int stride, unsigned int sizes[], unsigned int maxCount)
+  {
+    if (maxCount == 0)
+    {
+      return 0;
+    }
+    unsigned int pos = AtomicLoadRelaxed(&mHead);
+    unsigned int claimed = 0;
+    for (;;)
+    {
+      int diff = static_cast<int>(AtomicLoadAcquire(&At(pos)->Sequence) - (pos + 1));
+      if (diff == 0)
+      {
+        claimed = CountSlots(pos, 1, maxCount);
+        if (AtomicCompareExchange(&mHead, pos, pos + claimed))
+        {
+          break;
+        }
+      }
+      else if (diff < 0)
+      {
+        return 0;
+      }
+      else
+      {
+        pos = AtomicLoadRelaxed(&mHead);
+      }
+    }
+    for (unsigned int i = 0; i < claimed; i++)
+    {
+      Slot* slot = At(pos + i);
+      unsigned int size = CopyOut(slot, buff + static_cast<size_t>(i) * stride, stride);
+      if (sizes)
+      {
+        sizes[i] = size;
+      }
+      AtomicStoreRelease(&slot->Sequence, pos + i + mMask + 1);
+    }
+    return claimed;
+  }
+
+  // note that this is only a snapshot, it may be changed by the time you are using it
+  int Size() const
+  {
+    int size = static_cast<int>(AtomicLoadRelaxed(&mTail) - AtomicLoadRelaxed(&mHead));
+    return size < 0 ? 0 : (size > static_cast<int>(mMask + 1) ? static_cast<int>(mMask + 1) : size);
+  }
+
+  bool Empty() const
+  {
+    return AtomicLoadRelaxed(&mTail) == AtomicLoadRelaxed(&mHead);
+  }
+
+  unsigned int MaxMessageSize() const
+  {
+    return mMaxMessageSize;
+  }
+
+private:
+  // don't allow copy and assign for this object!
+  MessageRing(const MessageRing&);
+  MessageRing& operator = (const MessageRing&);
+
+  struct Slot
+  {
+    volatile unsigned int Sequence;
+    unsigned int Size;
+  };
+
+  // each slot start on its own cache line so writers on different slots would not disturb each other
+  static unsigned int SlotSize(unsigned int maxMessageSize)
+  {
+    unsigned int size = sizeof(Slot) + maxMessageSize;
+    return ((size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE) * CACHE_LINE_SIZE;
+  }
+
+  Slot* At(unsigned int pos) const
+  {
+    return reinterpret_cast<Slot*>(mArena + static_cast<size_t>(pos & mMask) * mStride);
+  }
+
+  static char* Data(Slot* slot)
+  {
+    return reinterpret_cast<char*>(slot + 1);
+  }
+
+  static unsigned int CopyOut(Slot* slot, char* buff, unsigned int buffSize)
+  {
+    unsigned int size = slot->Size < buffSize ? slot->Size : buffSize;
+    memcpy(buff, Data(slot), size);
+    return size;
+  }
+
+  // @return how many slots starting at pos (that we know is ready) are in the same state - that is
+  // their sequence is ahead of their position by offset (0 for free slots, 1 for full ones), up to max
+  unsigned int CountSlots(unsigned int pos, unsigned int offset, unsigned int max) const
+  {
+    unsigned int count = 1;
+    while (count < max && count <= mMask &&
+           AtomicLoadAcquire(&At(pos + count)->Sequence) == pos + count + offset)
+    {
+      ++count;
+    }
+    return count;
+  }
+
+  // the readers and the writers position are each on its own cache line
+  volatile unsigned int mHead;
+  char mPad1[CACHE_LINE_SIZE - sizeof(unsigned int)];
+  volatile unsigned int mTail;
+  char mPad2[CACHE_LINE_SIZE - sizeof(unsigned int)];
+  char* mArena;
+  const unsigned int mMask;
+  const unsigned int mStride;
+  const unsigned int mMaxMessageSize;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Bounded queue for exactly one writer and one reader. Since each position is only
+// changed by a single thread there is no need for CAS - the writer publish a message
+// by storing the new tail with release semantic and the reader free it by storing the
+// new head. Each side keeps a private copy of the other side position, and it would
+// only read the shared one when the copy say that the ring is full (or empty), so in
+// the normal case the two threads are not touching each other cache lines.
+// The only cost on top of the copy is a fence when we check whether the other side
+// is sleeping (see MessageLanes below) - we are only going into the kernel if it is.
+class SingleMessageRing
+{
+public:
+  // note that the capacity is rounded up to power of 2 (and it is at least 2)
+  SingleMessageRing(unsigned int capacity, unsigned int maxMessageSize) :
+                                                mHead(0), mCachedTail(0), mTail(0), mCachedHead(0),
+                                                mArena(0), mMask(RingCapacity(capacity) - 1),
+                                                mStride(SlotSize(maxMessageSize)),
+                                                mMaxMessageSize(maxMessageSize)
+  {
+    mArena = AllocateRing(mStride, mMask + 1);
+  }
+
+  ~SingleMessageRing()
+  {
+    free(mArena);
+  }
+
+  // must only be called from the writer thread
+  // @return false if the queue is full
+  bool TryPush(const char* msg, unsigned int size)
+  {
+    return TryPushBatch(&msg, &size, 1) == 1;
+  }
+
+  // must only be called from the reader thread
+  // @return -1 if the queue is empty, else the number of bytes that were copied to buff
+  int TryPop(char* buff, unsigned int buffSize)
+  {
+    unsigned int size = 0;
+    return TryPopBatch(buff, buffSize, &size, 1) == 1 ? static_cast<int>(size) : -1;
+  }
+
+  // must only be called from the writer thread
+  // @return the number of messages that were added - 0 if the queue is full
+  unsigned int TryPushBatch(const char* const msgs[], const unsigned int sizes[], unsigned int count)
+  {
+    const unsigned int pos = mTail;   // only this thread is changing it
+    unsigned int room = mMask + 1 - (pos - mCachedHead);
+    if (room < count)
+    {
+      mCachedHead = AtomicLoadAcquire(&mHead);
+      room = mMask + 1 - (pos - mCachedHead);
+      if (room < count)
+      {
+        count = room;
+      }
+    }
+    for (unsigned int i = 0; i < count; i++)
+    {
+      unsigned int* slot = At(pos + i);
+      *slot = sizes[i];
+      memcpy(slot + 1, msgs[i], sizes[i]);
+    }
+    if (count > 0)
+    {
+      AtomicStoreRelease(&mTail, pos + count);
+    }
+    return count;
+  }
+
+  // must only be called from the reader thread
+  // @return the number of messages that were read - 0 if the queue is empty
+  unsigned int TryPopBatch(char* buff, unsigned int stride, unsigned int sizes[], unsigned int maxCount)
+  {
+    const unsigned int pos = mHead;   // only this thread is changing it
+    unsigned int ready = mCachedTail - pos;
+    if (ready < maxCount)
+    {
+      mCachedTail = AtomicLoadAcquire(&mTail);
+      ready = mCachedTail - pos;
+      if (ready < maxCount)
+      {
+        maxCount = ready;
+      }
+    }
+    for (unsigned int i = 0; i < maxCount; i++)
+    {
+      unsigned int* slot = At(pos + i);
+      unsigned int size = *slot < stride ? *slot : stride;
+      memcpy(buff + static_cast<size_t>(i) * stride, slot + 1, size);
+      if (sizes)
+      {
+        sizes[i] = size;
+      }
+    }
+    if (maxCount > 0)
+    {
+      AtomicStoreRelease(&mHead, pos + maxCount);
+    }
+    return maxCount;
+  }
+
+  // note that this is only a snapshot, it may be changed by the time you are using it
+  int Size() const
+  {
+    int size = static_cast<int>(AtomicLoadRelaxed(&mTail) - AtomicLoadRelaxed(&mHead));
+    return size < 0 ? 0 : (size > static_cast<int>(mMask + 1) ? static_cast<int>(mMask + 1) : size);
+  }
+
+  bool Empty() const
+  {
+    return AtomicLoadRelaxed(&mTail) == AtomicLoadRelaxed(&mHead);
+  }
+
+  unsigned int MaxMessageSize() const
+  {
+    return mMaxMessageSize;
+  }
+
+private:
+  // don't allow copy and assign for this object!
+  SingleMessageRing(const SingleMessageRing&);
+  SingleMessageRing& operator = (const SingleMessageRing&);
+
+  // unlike the many writers ring, here the slots can be packed since only one
+  // thread is writing to them at any time (each slot start with the message size)
+  static unsigned int SlotSize(unsigned int maxMessageSize)
+  {
+    unsigned int size = sizeof(unsigned int) + maxMessageSize;
+    return ((size + sizeof(unsigned int) - 1) / sizeof(unsigned int)) * sizeof(unsigned int);
+  }
+
+  unsigned int* At(unsigned int pos) const
+  {
+    return reinterpret_cast<unsigned int*>(mArena + static_cast<size_t>(pos & mMask) * mStride);
+  }
+
+  // the reader cache line - the reader position and its copy of the writer position
+  volatile unsigned int mHead;
+  unsigned int mCachedTail;
+  char mPad1[CACHE_LINE_SIZE - 2 * sizeof(unsigned int)];
+  // the writer cache line
+  volatile unsigned int mTail;
+  unsigned int mCachedHead;
+  char mPad2[CACHE_LINE_SIZE - 2 * sizeof(unsigned int)];
+  char* mArena;
+  const unsigned int mMask;
+  const unsigned int mStride;
+  const unsigned int mMaxMessageSize;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// The queue itself - it has two lanes (rings) one for normal messages and one for urgent
+// messages, and it is the one that knows how to go to sleep when the rings are full or
+// empty and how to wake the threads that are sleeping. Urgent messages are read first,
+// but after MAX_URGENT_BURST urgent messages were read while normal messages were
+// waiting, we would read one normal message so that they would not starve.
+// Ring is either MessageRing or SingleMessageRing
+template<typename Ring>
+class MessageLanes
+{
+public:
+  enum
+  {
+    MAX_URGENT_BURST = 32
+  };
+
+  MessageLanes(unsigned int capacity, unsigned int maxMessageSize) : mNormal(capacity, maxMessageSize),
+                                                                     mUrgent(capacity, maxMessageSize),
+                                                                     mBurst(0), mOvertaken(0), mForced(0)
+  {
+  }
+
+  // @return false if the lane is full
+  bool TryPush(const char* msg, unsigned int size, bool urgent)
+  {
+    if ((urgent ? mUrgent : mNormal).TryPush(msg, size))
+    {
+      mNotEmpty.Notify(false);
+      return true;
+    }
+    return false;
+  }
+
+  // @return -1 if the queue is empty, else the number of bytes that were copied to buff
+  int TryPop(char* buff, unsigned int buffSize)
+  {
+    const bool urgent = TakeUrgent();
+    int ret = (urgent ? mUrgent : mNormal).TryPop(buff, buffSize);
+    if (ret < 0)
+    {
+      ret = (urgent ? mNormal : mUrgent).TryPop(buff, buffSize);  // someone else took it before us
+    }
+    if (ret >= 0)
+    {
+      mNotFull.Notify(false);
+    }
+    return ret;
+  }
+
+  // batches are always placed in the normal lane
+  // @return the number of messages that were added - 0 if the queue is full
+  unsigned int TryPushBatch(const char* const msgs[], const unsigned int sizes[], unsigned int count)
+  {
+    unsigned int ret = mNormal.TryPushBatch(msgs, sizes, count);
+    if (ret > 0)
+    {
+      mNotEmpty.Notify(ret > 1);
+    }
+    return ret;
+  }
+
+  // read as many as we can from the urgent lane and then from the normal lane
+  // @return the number of messages that were read - 0 if the queue is empty
+  unsigned int TryPopBatch(char* buff, unsigned int stride, unsigned int sizes[], unsigned int maxCount)
+  {
+    unsigned int ret = 0;
+    if (!TakeUrgent())
+    {
+      // either there are no urgent messages, or one normal message must be read first
+      ret = mNormal.TryPopBatch(buff, stride, sizes, mUrgent.Empty() ? maxCount : 1);
+    }
+    ret += mUrgent.TryPopBatch(buff + static_cast<size_t>(ret) * stride, stride, sizes ? sizes + ret : 0,
+                               maxCount - ret);
+    ret += mNormal.TryPopBatch(buff + static_cast<size_t>(ret) * stride, stride, sizes ? sizes + ret : 0,
+                               maxCount - ret);
+    if (ret > 0)
+    {
+      mNotFull.Notify(ret > 1);
+    }
+    return ret;
+  }
+
+  // block while the lane is full
+  // @return false with errno set if we failed to add before the deadline (if deadline is 0 wait forever)
+  bool Push(const char* msg, unsigned int size, bool urgent, const Deadline* deadline)
+  {
+    while (!TryPush(msg, size, urgent))
+    {
+      int ticket = mNotFull.PrepareWait();
+      if (TryPush(msg, size, urgent))
+      {
+        mNotFull.CancelWait();
+        return true;
+      }
+      int err = mNotFull.Wait(ticket, deadline);
+      if (err)
+      {
+        errno = err;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // block while the queue is empty
+  // @return -1 with errno set if we failed to read before the deadline (if deadline is 0 wait forever)
+  int Pop(char* buff, unsigned int buffSize, const Deadline* deadline)
+  {
+    int ret = TryPop(buff, buffSize);
+    if (ret < 0)
+    {
+      unsigned int size = 0;
+      ret = PopBatch(buff, buffSize, &size, 1, deadline) == 1 ? static_cast<int>(size) : -1;
+    }
+    return ret;
+  }
+
+  // block while the queue is full, then add as many messages as we can
+  // @return the number of messages that were added, 0 with errno set if we failed to add before the deadline
+  unsigned int PushBatch(const char* const msgs[], const unsigned int sizes[], unsigned int count,
+                         const Deadline* deadline)
+  {
+    unsigned int ret = 0;
+    while (count > 0 && (ret = TryPushBatch(msgs, sizes, count)) == 0)
+    {
+      int ticket = mNotFull.PrepareWait();
+      if ((ret = TryPushBatch(msgs, sizes, count)) > 0)
+      {
+        mNotFull.CancelWait();
+        return ret;
+      }
+      int err = mNotFull.Wait(ticket, deadline);
+      if (err)
+      {
+        errno = err;
+        return 0;
+      }
+    }
+    return ret;
+  }
+
+  // block while the queue is empty, then read as many messages as we can
+  // @return the number of messages that were read, 0 with errno set if we failed to read before the deadline
+  unsigned int PopBatch(char* buff, unsigned int stride, unsigned int sizes[], unsigned int maxCount,
+                        const Deadline* deadline)
+  {
+    unsigned int ret = 0;
+    while (maxCount > 0 && (ret = TryPopBatch(buff, stride, sizes, maxCount)) == 0)
+    {
+      int ticket = mNotEmpty.PrepareWait();
+      if ((ret = TryPopBatch(buff, stride, sizes, maxCount)) > 0)
+      {
+        mNotEmpty.CancelWait();
+        return ret;
+      }
+      int err = mNotEmpty.Wait(ticket, deadline);
+      if (err)
+      {
+        errno = err;
+        return 0;
+      }
+    }
+    return ret;
+  }
+
+  // note that this is only a snapshot, it may be changed by the time you are using it
+  int Size() const
+  {
+    return mNormal.Size() + mUrgent.Size();
+  }
+
+  int NormalSize() const
+  {
+    return mNormal.Size();
+  }
+
+  int UrgentSize() const
+  {
+    return mUrgent.Size();
+  }
+
+  unsigned long Overtaken() const
+  {
+    return AtomicLoadRelaxed(&mOvertaken);
+  }
+
+  unsigned long Forced() const
+  {
+    return AtomicLoadRelaxed(&mForced);
+  }
+
+private:
+  // don't allow copy and assign for this object!
+  MessageLanes(const MessageLanes&);
+  MessageLanes& operator = (const MessageLanes&);
+
+  // @return true if the next message should be read from the urgent lane. Note that
+  // the counters are only changed when both lanes has messages, so when there are no
+  // urgent messages, this is only two loads of positions that are not changing
+  bool TakeUrgent()
+  {
+    if (mUrgent.Empty())
+    {
+      return false;
+    }
+    if (mNormal.Empty())
+    {
+      if (AtomicLoadRelaxed(&mBurst) != 0)
+      {
+        AtomicStoreRelaxed(&mBurst, 0);   // no one is waiting for the urgent messages
+      }
+      return true;
+    }
+    if (AtomicFetchAdd(&mBurst, 1) < static_cast<unsigned int>(MAX_URGENT_BURST))
+    {
+      AtomicFetchAdd(&mOvertaken, 1);
+      return true;
+    }
+    AtomicStoreRelaxed(&mBurst, 0);
+    AtomicFetchAdd(&mForced, 1);
+    return false;
+  }
+
+  EventCount mNotEmpty;
+  EventCount mNotFull;
+  // the ring positions that follow are changed all the time, don't let them share the cache line
+  char mPad[CACHE_LINE_SIZE - 2 * sizeof(EventCount)];
+  Ring mNormal;
+  Ring mUrgent;
+  volatile unsigned int mBurst;       // urgent messages that were read in a row while normal messages were waiting
+  volatile unsigned long mOvertaken;
+  volatile unsigned long mForced;
+};
+
+} // end of namespace Private
+
+} // end of namespace osal
+
+#endif  // MESSAGE_RING_POSIX__H
@@ -1,2 +1,599 @@
+#ifndef MUTEXPOSIX__HPP
+#define MUTEXPOSIX__HPP
+// Linux implementation for the mutex - this is based on futex so that
+// as long as there is no contention we would never enter the kernel
+// (see Futex.h for the details)
 
-#error "posix mutex is not supported yet"
+#include "osal/Mutex.h"              // this file header file (we are doing the implementation here)
+#include "Futex.h"                   // the futex lock and atomic operations
+#include "CriticalSection.h"         // to guard the error handling functions
+#include "ExitFunctionHolder.h"      // to define the list of error handling functions
+#include "LockProfiling.h"           // hooks for the lock profiler
+#include "osal/StopWatch.h"          // to measure the time the lock is held
+#include <linux/futex.h>             // FUTEX_TID_MASK
+#include <errno.h>                   // errno values
+#include <time.h>                    // CLOCK_REALTIME
+#include <unistd.h>                  // sysconf
+#include <memory>                    // auto_ptr
+
+namespace osal
+{
+
+namespace Mutex
+{
+
+namespace
+{
+
+Private::ExitFunctionHolder& ExitFunctionsList();
+
+
+Private::ExitFunctionHolder& ExitFunctionsList()
+{
+  static Private::ExitFunctionHolder holder;
+  return holder;
+}
+
+// when there is a single CPU the owner of the lock cannot run while we are spinning
+bool CanSpin()
+{
+  static const bool multiCpu = sysconf(_SC_NPROCESSORS_ONLN) > 1;
+  return multiCpu;
+}
+
+}	// end of local namespace
+
+// all the functions return false on failure with errno set to the reason
+struct Id
+{
+  virtual ~Id()
+  {
+  }
+
+  virtual bool Take() = 0;
+
+  virtual bool TryTake() = 0;
+
+  virtual bool TimedTake(const Private::Deadline& deadline) = 0;
+
+  virtual bool Give() = 0;
+
+  // the clock that the deadline for TimedTake must use
+  virtual clockid_t Clock() const
+  {
+    return CLOCK_MONOTONIC;
+  }
+};
+
+// the simple mutex - no recursion and no priority inversion protection
+struct IdNoRecuse : public Id
+{
+  IdNoRecuse() : mLock(Private::FutexLock::CANCELLABLE), mCurrentOwner(0)
+  {
+  }
+
+  bool Take()
+  {
+    if (mLock.Take())
+    {
+      mCurrentOwner = Private::CurrentThreadId();
+      return true;
+    }
+    return false;
+  }
+
+  bool TryTake()
+  {
+    if (mLock.TryTake())
+    {
+      mCurrentOwner = Private::CurrentThreadId();
+      return true;
+    }
+    errno = EBUSY;
+    return false;
+  }
+
+  bool TimedTake(const Private::Deadline& deadline)
+  {
+    if (mLock.Take(deadline))
+    {
+      mCurrentOwner = Private::CurrentThreadId();
+      return true;
+    }
+    return false;
+  }
+
+  bool Give()
+  {
+    // we want to make sure that only the thread that took the mutex would release it
+    OSAL_ASSERT_CONDITION(mCurrentOwner == Private::CurrentThreadId(), ExitFunctionsList(), "release called with invalid owner");
+    mCurrentOwner = 0;
+    return mLock.Give();
+  }
+
+  Private::FutexLock mLock;
+  pid_t mCurrentOwner;
+};
+
+// the simple mutex, only that a thread that find it locked would spin before it is blocking (ADAPTIVE_SPIN)
+// or would only spin (SPIN). For adaptive spinning the owner is measuring how long it held the lock, and
+// keep a running average of this time. The waiters are spinning for up to few times the average, as long
+// as the current owner did not hold the lock for longer than that - if it did, it was most likely preempted
+// or blocked, and would not release the lock soon, so we are going to block as well. For locks that
+// are held for long time we never spin, since blocking in the kernel would be cheaper
+struct IdSpinning : public Id
+{
+  enum
+  {
+    MIN_SPIN_NANO = 1000,   // spin at least that long (mostly until we have an estimate)
+    MAX_SPIN_NANO = 20000,  // this is about the cost of blocking and being woken up, never spin longer
+    SPIN_FACTOR = 2,        // how long to spin compared to the average time the lock is held
+    AVERAGE_SHIFT = 3,      // each new sample has weight of 1/8 in the average
+    DEADLINE_CHECK = 64     // for pure spin, how many times to spin between checking the deadline
+  };
+
+  explicit IdSpinning(Policy policy) : mPolicy(policy), mLock(Private::FutexLock::CANCELLABLE), mCurrentOwner(0),
+                                       mSince(0), mHoldTime(0)
+  {
+  }
+
+  bool Take()
+  {
+    if (!mLock.TryTake() && !Spin(0) && !mLock.Take())
+    {
+      return false;
+    }
+    Acquired();
+    return true;
+  }
+
+  bool TryTake()
+  {
+    if (mLock.TryTake())
+    {
+      Acquired();
+      return true;
+    }
+    errno = EBUSY;
+    return false;
+  }
+
+  bool TimedTake(const Private::Deadline& deadline)
+  {
+    if (!mLock.TryTake() && !Spin(&deadline))
+    {
+      if (mPolicy == SPIN)
+      {
+        errno = ETIMEDOUT;
+        return false;
+      }
+      if (!mLock.Take(deadline))
+      {
+        return false;
+      }
+    }
+    Acquired();
+    return true;
+  }
+
+  bool Give()
+  {
+    OSAL_ASSERT_CONDITION(mCurrentOwner == Private::CurrentThreadId(), ExitFunctionsList(), "release called with invalid owner");
+    mCurrentOwner = 0;
+    if (mPolicy == ADAPTIVE_SPIN)
+    {
+      Learn(StopWatchOper::Now() - Private::AtomicLoadRelaxed(&mSince));
+      Private::AtomicStoreRelaxed(&mSince, 0);
+    }
+    return mLock.Give();
+  }
+
+private:
+  void Acquired()
+  {
+    mCurrentOwner = Private::CurrentThreadId();
+    if (mPolicy == ADAPTIVE_SPIN)
+    {
+      Private::AtomicStoreRelaxed(&mSince, StopWatchOper::Now());
+    }
+  }
+
+  // only the owner is updating the average, so this is safe without atomic read-modify-write.
+  // a single long sample (the owner was preempted) is limited so it would not stop the spinning for long
+  void Learn(nanoseconds_t held)
+  {
+    const long long sample = held < (nanoseconds_t)MAX_SPIN_NANO * 2 ? (long long)held : MAX_SPIN_NANO * 2;
+    const long long average = (long long)Private::AtomicLoadRelaxed(&mHoldTime);
+    Private::AtomicStoreRelaxed(&mHoldTime, average + ((sample - average) >> AVERAGE_SHIFT));
+  }
+
+  // @return 0 if we should not spin at all, else how long to spin
+  nanoseconds_t Budget() const
+  {
+    const nanoseconds_t budget = Private::AtomicLoadRelaxed(&mHoldTime) * SPIN_FACTOR;
+    if (budget > (nanoseconds_t)MAX_SPIN_NANO || !CanSpin())
+    {
+      return 0;
+    }
+    return budget < (nanoseconds_t)MIN_SPIN_NANO ? (nanoseconds_t)MIN_SPIN_NANO : budget;
+  }
+
+  // @return true if we took the lock while spinning
+  bool Spin(const Private::Deadline* deadline)
+  {
+    if (mPolicy == SPIN)
+    {
+      for (unsigned int i = 1; ; i++)
+      {
+        if (!mLock.IsLocked() && mLock.TryTake())
+        {
+          return true;
+        }
+        if (deadline && i % DEADLINE_CHECK == 0 && deadline->Passed())
+        {
+          return false;
+        }
+        Private::CpuRelax();
+      }
+    }
+    const nanoseconds_t budget = Budget();
+    if (budget == 0)
+    {
+      return false;
+    }
+    const nanoseconds_t start = StopWatchOper::Now();
+    for (;;)
+    {
+      Private::CpuRelax();
+      if (!mLock.IsLocked() && mLock.TryTake())
+      {
+        return true;
+      }
+      const nanoseconds_t now = StopWatchOper::Now();
+      const nanoseconds_t since = Private::AtomicLoadRelaxed(&mSince);
+      if (now - start > budget || (since && now > since && now - since > budget) ||
+          (deadline && deadline->Passed()))
+      {
+        return false;   // the owner is not releasing the lock soon - we better block
+      }
+    }
+  }
+
+  const Policy mPolicy;
+  Private::FutexLock mLock;
+  pid_t mCurrentOwner;
+  volatile nanoseconds_t mSince;      // when the current owner took the lock (0 if not locked)
+  volatile nanoseconds_t mHoldTime;   // the running average of the time the lock is held
+};
+
+// recursive mutex - the same thread can lock it many times as long as it release it the same number of times
+struct IdRecursive : public Id
+{
+  IdRecursive() : mLock(Private::FutexLock::CANCELLABLE), mCurrentOwner(0), mCount(0)
+  {
+  }
+
+  bool Take()
+  {
+    if (Recurse())
+    {
+      return true;
+    }
+    if (mLock.Take())
+    {
+      SetOwner();
+      return true;
+    }
+    return false;
+  }
+
+  bool TryTake()
+  {
+    if (Recurse())
+    {
+      return true;
+    }
+    if (mLock.TryTake())
+    {
+      SetOwner();
+      return true;
+    }
+    errno = EBUSY;
+    return false;
+  }
+
+  bool TimedTake(const Private::Deadline& deadline)
+  {
+    if (Recurse())
+    {
+      return true;
+    }
+    if (mLock.Take(deadline))
+    {
+      SetOwner();
+      return true;
+    }
+    return false;
+  }
+
+  bool Give()
+  {
+    OSAL_ASSERT_CONDITION(Private::AtomicLoad(&mCurrentOwner) == Private::CurrentThreadId(), ExitFunctionsList(), "release called with invalid owner");
+    if (--mCount == 0)
+    {
+      Private::AtomicStore(&mCurrentOwner, 0);
+      return mLock.Give();
+    }
+    return true;
+  }
+
+private:
+  // only the owner can see its own id here, so this is safe to do without the lock
+  bool Recurse()
+  {
+    if (Private::AtomicLoad(&mCurrentOwner) == Private::CurrentThreadId())
+    {
+      ++mCount;
+      return true;
+    }
+    return false;
+  }
+
+  void SetOwner()
+  {
+    Private::AtomicStore(&mCurrentOwner, Private::CurrentThreadId());
+    mCount = 1;
+  }
+
+  Private::FutexLock mLock;
+  volatile int mCurrentOwner;
+  unsigned int mCount;
+};
+
+// recursive mutex with priority inheritance - the lock word hold the owner thread id,
+// this is what the kernel is expecting for PI futex. as long as the lock is not taken
+// we are not entering the kernel, otherwise the kernel would boost the owner priority
+struct IdPrioritySafe : public Id
+{
+  IdPrioritySafe() : mWord(0), mCount(0)
+  {
+  }
+
+  bool Take()
+  {
+    return Lock(0);
+  }
+
+  bool TryTake()
+  {
+    if (Owned())
+    {
+      ++mCount;
+      return true;
+    }
+    int expected = 0;
+    if (Private::AtomicCompareExchange(&mWord, expected, Private::CurrentThreadId()))
+    {
+      mCount = 1;
+      return true;
+    }
+    errno = EBUSY;
+    return false;
+  }
+
+  bool TimedTake(const Private::Deadline& deadline)
+  {
+    return Lock(&deadline);
+  }
+
+  // the kernel is using absolute real time clock for PI futex timeout
+  clockid_t Clock() const
+  {
+    return CLOCK_REALTIME;
+  }
+
+  bool Give()
+  {
+    OSAL_ASSERT_CONDITION(Owned(), ExitFunctionsList(), "release called with invalid owner");
+    if (--mCount == 0)
+    {
+      int expected = Private::CurrentThreadId();
+      if (!Private::AtomicCompareExchange(&mWord, expected, 0))
+      {
+        // there are waiters (the kernel set the waiters bit) so let the kernel pass the ownership
+        int err = Private::Futex::UnlockPI(&mWord);
+        if (err)
+        {
+          errno = err;
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+private:
+  bool Owned() const
+  {
+    return (Private::AtomicLoad(&mWord) & FUTEX_TID_MASK) == Private::CurrentThreadId();
+  }
+
+  bool Lock(const Private::Deadline* deadline)
+  {
+    if (Owned())
+    {
+      ++mCount;
+      return true;
+    }
+    int expected = 0;
+    if (!Private::AtomicCompareExchange(&mWord, expected, Private::CurrentThreadId()))
+    {
+      int err = Private::Futex::LockPI(&mWord, deadline, true);
+      if (err)
+      {
+        errno = err;
+        return false;
+      }
+    }
+    mCount = 1;
+    return true;
+  }
+
+  volatile int mWord;
+  unsigned int mCount;
+};
+
+namespace
+{
+
+// the lock operation for the lock profiler
+struct ProfiledTake
+{
+  ProfiledTake(Id* id, const Private::Deadline* deadline) : mId(id), mDeadline(deadline)
+  {
+  }
+
+  bool Try()
+  {
+    return mId->TryTake();
+  }
+
+  bool Wait()
+  {
+    return mDeadline ? mId->TimedTake(*mDeadline) : mId->Take();
+  }
+
+  const void* Lock() const
+  {
+    return mId;
+  }
+
+  Id* mId;
+  const Private::Deadline* mDeadline;
+};
+
+} // end of local namespace
+
+void RegisterAtExit(at_error_fun func)
+{
+  ExitFunctionsList().Push(func);
+}
+
+Id* Create()
+{
+  std::auto_ptr<Id> id(new IdNoRecuse);
+  return id.release();
+}
+
+Id* Create(Policy policy)
+{
+  std::auto_ptr<Id> id;
+  if (policy == BLOCKING)
+  {
+    id.reset(new IdNoRecuse);
+  }
+  else
+  {
+    id.reset(new IdSpinning(policy));
+  }
+  return id.release();
+}
+
+Id* CreateRecursive(Protection prioritySafe)
+{
+  std::auto_ptr<Id> id;
+  if (prioritySafe == PRIORITY_SAFE)
+  {
+    id.reset(new IdPrioritySafe);
+  }
+  else
+  {
+    id.reset(new IdRecursive);
+  }
+  return id.release();
+}
+
+void Lock(Id* id)
+{
+  OSAL_ASSERT_CONDITION(id, ExitFunctionsList(), "invalid mutex id");
+  if (OSAL_LOCK_PROFILING() ? !Private::LockProfiling::ProfiledTake(ProfiledTake(id, 0), OSAL_LOCK_CALL_SITE(), false) :
+                              !id->Take())
+  {
+    ExitFunctionsList().CriticalError(errno, __FUNCTION__, __LINE__);
+  }
+}
+
+bool TryLock(Id* id)
+{
+  OSAL_ASSERT_CONDITION(id, ExitFunctionsList(), "invalid mutex id");
+  if (OSAL_LOCK_PROFILING() ? !Private::LockProfiling::ProfiledTake(ProfiledTake(id, 0), OSAL_LOCK_CALL_SITE(), true) :
+                              !id->TryTake())
+  {
+    return ExitFunctionsList().TryFail(errno, __FUNCTION__, __LINE__);
+  }
+  else
+  {
+    return true;
+  }
+}
+
+bool TimedLock(Id* id, milliseconds_t milliDuration)
+{
+  OSAL_ASSERT_CONDITION(id, ExitFunctionsList(), "invalid mutex id");
+  Private::Deadline deadline(milliDuration, id->Clock());
+  if (OSAL_LOCK_PROFILING() ?
+        !Private::LockProfiling::ProfiledTake(ProfiledTake(id, &deadline), OSAL_LOCK_CALL_SITE(), false) :
+        !id->TimedTake(deadline))
+  {
+    return ExitFunctionsList().TimedOut(errno, __FUNCTION__, __LINE__);
+  }
+  else
+  {
+    return true;
+  }
+}
+
+bool TimedLock(Id* id, const Duration& duration)
+{
+  OSAL_ASSERT_CONDITION(id, ExitFunctionsList(), "invalid mutex id");
+  Private::Deadline deadline(duration, id->Clock());
+  if (OSAL_LOCK_PROFILING() ?
+        !Private::LockProfiling::ProfiledTake(ProfiledTake(id, &deadline), OSAL_LOCK_CALL_SITE(), false) :
+        !id->TimedTake(deadline))
+  {
+    return ExitFunctionsList().TimedOut(errno, __FUNCTION__, __LINE__);
+  }
+  else
+  {
+    return true;
+  }
+}
+
+void Release(Id* id)
+{
+  OSAL_ASSERT_CONDITION(id, ExitFunctionsList(), "invalid mutex id");
+  if (OSAL_LOCK_HOLDING())
+  {
+    Private::LockProfiling::Released(id);
+  }
+  if (!id->Give())
+  {
+    ExitFunctionsList().CriticalError(errno, __FUNCTION__, __LINE__);
+  }
+}
+
+void Delete(Id*& id)
+{
+  if (id)
+  {
+    delete id;
+    id = 0;
+  }
+}
+
+}	// end of Mutex namespace
+}	// end of osal namespace
+
+#else
+#	error "you cannot include this file inside header file"
+#endif	// MUTEXPOSIX__HPP
@@ -0,0 +1,356 @@
+#ifndef POLLER_POSIX__HPP
+#define POLLER_POSIX__HPP
+// Linux implementation for the poller - this is based on epoll. The OSAL objects
+// are added with their eventfd (see Readiness.h). Since the eventfd is only a hint we
+// clear it and check the object state before reporting it, and since the poller is
+// level triggered, the objects that were reported last time are checked again on the next wait
+
+#include "osal/Poller.h"            // the interface for this implementation
+#include "Readiness.h"              // the readiness of the OSAL objects
+#include "ExitFunctionHolder.h"     // to define the list of error handling functions
+#include <sys/epoll.h>              // epoll
+#include <unistd.h>                 // close
+#include <errno.h>                  // errno values
+#include <map>                      // the sources
+#include <vector>                   // the sources that were reported
+#include <memory>                   // auto_ptr
+
+namespace osal
+{
+
+namespace Poller
+{
+
+namespace
+{
+
+Private::ExitFunctionHolder& ErrorHandler()
+{
+  static Private::ExitFunctionHolder theList;
+  return theList;
+}
+
+enum
+{
+  MAX_EVENTS = 64   // max events to read from epoll in a single call
+};
+
+unsigned int ToEpoll(unsigned int events)
+{
+  return ((events & READABLE) ? (unsigned int)EPOLLIN : 0u) | ((events & WRITABLE) ? (unsigned int)EPOLLOUT : 0u);
+}
+
+unsigned int FromEpoll(unsigned int events)
+{
+  return ((events & (EPOLLIN | EPOLLPRI)) ? (unsigned int)READABLE : 0u) |
+         ((events & EPOLLOUT) ? (unsigned int)WRITABLE : 0u) |
+         ((events & (EPOLLHUP | EPOLLERR)) ? (unsigned int)HANGUP : 0u);
+}
+
+} // end of local namespace
+
+struct Id
+{
+  struct Source
+  {
+    Ready Info;
+    Private::Readiness* Readiness;  // NULL for file descriptors
+    bool Reported;                  // to report each source once in a single wait
+  };
+
+  Id() : mEpoll(epoll_create1(EPOLL_CLOEXEC))
+  {
+  }
+
+  ~Id()
+  {
+    for (sources_t::iterator i = mSources.begin(); i != mSources.end(); ++i)
+    {
+      delete i->second;
+    }
+    if (mEpoll >= 0)
+    {
+      close(mEpoll);
+    }
+  }
+
+  bool Valid() const
+  {
+    return mEpoll >= 0;
+  }
+
+  // @return false with errno set on failure
+  bool Add(const void* key, const Ready& info, Private::Readiness* readiness, int fd, unsigned int events)
+  {
+    if (mSources.find(key) != mSources.end())
+    {
+      errno = EEXIST;
+      return false;
+    }
+    std::auto_ptr<Source> source(new Source);
+    source->Info = info;
+    source->Readiness = readiness;
+    source->Reported = false;
+    epoll_event event;
+    event.events = events;
+    event.data.ptr = source.get();
+    if (epoll_ctl(mEpoll, EPOLL_CTL_ADD, fd, &event) != 0)
+    {
+      return false;
+    }
+    mSources[key] = source.release();
+    return true;
+  }
+
+  bool Remove(const void* key, int fd)
+  {
+    sources_t::iterator i = mSources.find(key);
+    if (i == mSources.end())
+    {
+      errno = ENOENT;
+      return false;
+    }
+    epoll_event event;  // older kernels require this even though it is not used
+    epoll_ctl(mEpoll, EPOLL_CTL_DEL, fd, &event);
+    for (std::vector<Source*>::iterator r = mLastReady.begin(); r != mLastReady.end(); ++r)
+    {
+      if (*r == i->second)
+      {
+        mLastReady.erase(r);
+        break;
+      }
+    }
+    delete i->second;
+    mSources.erase(i);
+    return true;
+  }
+
+  // @return the number of ready sources or -1 with errno set
+  int Wait(Ready* ready, unsigned int maxReady, int timeout)
+  {
+    std::vector<Source*> reported;
+    std::vector<Source*> unchecked;   // no room left to check these, so keep them for the next wait
+    unsigned int count = 0;
+    // level triggered - the OSAL objects we reported last time may still be ready,
+    // but their eventfd was already cleared
+    for (std::vector<Source*>::iterator i = mLastReady.begin(); i != mLastReady.end(); ++i)
+    {
+      if (count == maxReady)
+      {
+        unchecked.push_back(*i);
+      }
+      else if ((*i)->Readiness->IsReady())
+      {
+        Report(*i, 0, ready, count, reported);
+      }
+    }
+    if (count > 0)
+    {
+      timeout = 0;  // just collect what is already ready
+    }
+    if (count < maxReady)
+    {
+      epoll_event events[MAX_EVENTS];
+      const int maxEvents = (maxReady - count) < static_cast<int>(MAX_EVENTS) ? (maxReady - count) : static_cast<int>(MAX_EVENTS);
+      int n = epoll_wait(mEpoll, events, maxEvents, timeout);
+      if (n < 0)
+      {
+        if (errno != EINTR)
+        {
+          return -1;
+        }
+        n = 0;      // treat as timeout
+      }
+      for (int i = 0; i < n; i++)
+      {
+        Source* source = static_cast<Source*>(events[i].data.ptr);
+        if (!source->Readiness)
+        {
+          Report(source, FromEpoll(events[i].events), ready, count, reported);
+        }
+        else if (!source->Reported)
+        {
+          source->Readiness->Clear();
+          if (source->Readiness->IsReady())
+          {
+            Report(source, 0, ready, count, reported);
+          }
+        }
+      }
+    }
+    // the ones we did not check go first, so they would not wait behind the ones we reported
+    mLastReady.swap(unchecked);
+    for (std::vector<Source*>::iterator i = reported.begin(); i != reported.end(); ++i)
+    {
+      (*i)->Reported = false;
+      if ((*i)->Readiness)
+      {
+        mLastReady.push_back(*i);
+      }
+    }
+    return static_cast<int>(count);
+  }
+
+private:
+  typedef std::map<const void*, Source*> sources_t;
+
+  static void Report(Source* source, unsigned int events, Ready* ready, unsigned int& count,
+                     std::vector<Source*>& reported)
+  {
+    source->Reported = true;
+    ready[count] = source->Info;
+    ready[count].Events = events;
+    ++count;
+    reported.push_back(source);
+  }
+
+  int mEpoll;
+  sources_t mSources;             // key is the OSAL object or the file descriptor
+  std::vector<Source*> mLastReady;
+};
+
+namespace
+{
+
+// file descriptors and the OSAL objects share the same map, so the descriptors are
+// mapped to an address that cannot be an object (the objects are allocated on the heap)
+const void* FdKey(int fd)
+{
+  return reinterpret_cast<const void*>(static_cast<unsigned long>(fd) * 2 + 1);
+}
+
+int Waiting(Id* id, Ready* ready, unsigned int maxReady, int timeout, const char* func, int line)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid poller id");
+  OSAL_ASSERT_CONDITION(ready || maxReady == 0, ErrorHandler(), "invalid ready array");
+  int count = id->Wait(ready, maxReady, timeout);
+  if (count < 0)
+  {
+    ErrorHandler().CriticalError(errno, func, line);
+    return 0;
+  }
+  return count;
+}
+
+} // end of local namespace
+
+void RegisterAtExit(at_error_fun func)
+{
+  ErrorHandler().Push(func);
+}
+
+Id* Create()
+{
+  std::auto_ptr<Id> id(new Id);
+  if (!id->Valid())
+  {
+    ErrorHandler().CriticalError(errno, __FUNCTION__, __LINE__);
+  }
+  return id.release();
+}
+
+bool Add(Id* id, int fd, unsigned int events, void* userData)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid poller id");
+  Ready info;
+  info.Type = FILE_DESCRIPTOR;
+  info.Fd = fd;
+  info.Events = 0;
+  info.UserData = userData;
+  return id->Add(FdKey(fd), info, 0, fd, ToEpoll(events));
+}
+
+bool Add(Id* id, EventNotification::Id* event, void* userData)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid poller id");
+  OSAL_ASSERT_CONDITION(event, ErrorHandler(), "invalid event notification id");
+  Ready info;
+  info.Type = EVENT_NOTIFICATION;
+  info.Event = event;
+  info.Events = 0;
+  info.UserData = userData;
+  Private::Readiness& readiness = EventNotification::ReadinessOf(event);
+  const int fd = readiness.Handle();
+  return fd >= 0 && id->Add(event, info, &readiness, fd, EPOLLIN);
+}
+
+bool Add(Id* id, MessageQueue::Id* queue, void* userData)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid poller id");
+  OSAL_ASSERT_CONDITION(queue, ErrorHandler(), "invalid message queue id");
+  Ready info;
+  info.Type = MESSAGE_QUEUE;
+  info.Queue = queue;
+  info.Events = 0;
+  info.UserData = userData;
+  Private::Readiness& readiness = MessageQueue::ReadinessOf(queue);
+  const int fd = readiness.Handle();
+  return fd >= 0 && id->Add(queue, info, &readiness, fd, EPOLLIN);
+}
+
+bool Remove(Id* id, int fd)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid poller id");
+  return id->Remove(FdKey(fd), fd);
+}
+
+bool Remove(Id* id, EventNotification::Id* event)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid poller id");
+  return event && id->Remove(event, EventNotification::ReadinessOf(event).Handle());
+}
+
+bool Remove(Id* id, MessageQueue::Id* queue)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid poller id");
+  return queue && id->Remove(queue, MessageQueue::ReadinessOf(queue).Handle());
+}
+
+int Wait(Id* id, Ready* ready, unsigned int maxReady)
+{
+  int count = 0;
+  while (count == 0 && maxReady > 0)
+  {
+    count = Waiting(id, ready, maxReady, -1, __FUNCTION__, __LINE__);
+  }
+  return count;
+}
+
+int TryWait(Id* id, Ready* ready, unsigned int maxReady)
+{
+  return Waiting(id, ready, maxReady, 0, __FUNCTION__, __LINE__);
+}
+
+int TimedWait(Id* id, Ready* ready, unsigned int maxReady, milliseconds_t milliDuration)
+{
+  // the wait may end without any source (the object was taken by someone else) so we
+  // continue to wait until the deadline
+  Private::Deadline deadline(milliDuration);
+  int count = 0;
+  for (;;)
+  {
+    const milliseconds_t left = deadline.Left();
+    count = Waiting(id, ready, maxReady, static_cast<int>(left), __FUNCTION__, __LINE__);
+    if (count > 0 || left == 0)
+    {
+      return count;
+    }
+  }
+}
+
+void Delete(Id*& id)
+{
+  if (id)
+  {
+    delete id;
+    id = 0;
+  }
+}
+
+} // end of namespace Poller
+
+} // end of namespace osal
+
+#else
+# error "you must not include this file inside header file"
+#endif  // POLLER_POSIX__HPP
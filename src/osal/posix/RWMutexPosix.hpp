@@ -1,2 +1,600 @@
+#ifndef RW_MUTEX_POSIX__HPP
+#define RW_MUTEX_POSIX__HPP
+// Linux implementation for the read/write mutex. This is a "biased reader" lock based on
+// BRAVO (Dice and Kogan, "BRAVO - Biased Locking for Reader-Writer Locks").
+// The lock has two parts -
+// 1. an underlying read/write lock that is based on futex (see ReadWriteLock below)
+// 2. a table that is shared by all the locks in the process, in which readers are publishing
+//    that they are holding a lock. A reader is using a slot that is selected by its thread id and the lock
+//    address, so readers in different threads are writing to different cache lines, and they never
+//    write to the lock itself. This is only allowed as long as the lock is biased for readers - once
+//    a writer is coming, it remove the bias and wait for all the readers in the table to leave.
+//    Since this is expensive, the bias is not restored for some time (that is relative to the time it
+//    took to wait for the readers) so that locks that are written to often would not pay for it.
 
-#error "posix RW mutex is not supported yet"
+#include "osal/RWMutex.h"           // the interface for this implementation
+#include "Futex.h"                  // futex system calls and atomic operations
+#include "CriticalSection.h"        // to guard the error handling functions
+#include "ExitFunctionHolder.h"     // to define the list of error handling functions
+#include "LockProfiling.h"          // hooks for the lock profiler
+#include <sched.h>                  // sched_yield
+#include <time.h>                   // clock_gettime
+#include <errno.h>                  // errno values
+#include <memory>                   // auto_ptr
+
+namespace osal
+{
+
+namespace RWMutex
+{
+
+namespace
+{
+
+Private::ExitFunctionHolder& ErrorHandler()
+{
+  static Private::ExitFunctionHolder theList;
+  return theList;
+}
+
+typedef unsigned long long nanoseconds_t;
+
+nanoseconds_t Now()
+{
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (nanoseconds_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+} // end of local namespace
+
+///////////////////////////////////////////////////////////////////////////////
+// the underlying lock - the futex word hold the number of readers, or the WRITER bit
+// if a writer is holding it. Once a writer is waiting, new readers would wait for it
+// (so that writers would not starve). These readers wait on the count of the waiting
+// writers, since the state is not changed when the last writer stop waiting (it took
+// the lock or gave up). All the function return false with errno set on failure
+class ReadWriteLock
+{
+public:
+  enum
+  {
+    WRITER = 1 << 30
+  };
+
+  ReadWriteLock() : mState(0), mWaiters(0), mWritersWaiting(0), mBlockedReaders(0)
+  {
+  }
+
+  bool TryRead()
+  {
+    int current = Private::AtomicLoad(&mState);
+    while (!(current & WRITER) && Private::AtomicLoad(&mWritersWaiting) == 0)
+    {
+      if (Private::AtomicCompareExchange(&mState, current, current + 1))
+      {
+        return true;
+      }
+    }
+    errno = EBUSY;
+    return false;
+  }
+
+  bool Read(const Private::Deadline* deadline)
+  {
+    while (!TryRead())
+    {
+      const int current = Private::AtomicLoad(&mState);
+      const int writers = Private::AtomicLoad(&mWritersWaiting);
+      bool waited = true;
+      if (current & WRITER)
+      {
+        waited = Wait(&mState, current, &mWaiters, deadline);
+      }
+      else if (writers > 0)
+      {
+        waited = Wait(&mWritersWaiting, writers, &mBlockedReaders, deadline);
+      }
+      if (!waited)  // else it was changed since TryRead - try again
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool TryWrite()
+  {
+    int current = 0;
+    if (Private::AtomicCompareExchange(&mState, current, static_cast<int>(WRITER)))
+    {
+      return true;
+    }
+    errno = EBUSY;
+    return false;
+  }
+
+  bool Write(const Private::Deadline* deadline)
+  {
+    if (TryWrite())
+    {
+      return true;
+    }
+    Private::AtomicFetchAdd(&mWritersWaiting, 1);
+    for (;;)
+    {
+      int current = 0;
+      if (Private::AtomicCompareExchange(&mState, current, static_cast<int>(WRITER)))
+      {
+        StopWaiting();
+        return true;
+      }
+      if (!Wait(&mState, current, &mWaiters, deadline))
+      {
+        StopWaiting();  // the readers that are waiting because of us can go now
+        return false;
+      }
+    }
+  }
+
+  void ReadRelease()
+  {
+    if (Private::AtomicFetchAdd(&mState, -1) == 1)
+    {
+      WakeAll();  // we are the last reader
+    }
+  }
+
+  void WriteRelease()
+  {
+    Private::AtomicStore(&mState, 0);
+    WakeAll();
+  }
+
+private:
+  // @param waiters the count of the threads that are waiting on this word
+  bool Wait(volatile int* word, int current, volatile int* waiters, const Private::Deadline* deadline)
+  {
+    Private::AtomicFetchAdd(waiters, 1);
+    int err = deadline ? Private::Futex::WaitUntil(word, current, *deadline) :
+                         Private::Futex::Wait(word, current);
+    Private::AtomicFetchAdd(waiters, -1);
+    if (err)
+    {
+      errno = err;
+      return false;
+    }
+    return true;
+  }
+
+  // a writer that was waiting took the lock or gave up - if it was the last one, the readers
+  // that were blocked by it can go (or wait for the writer that now hold the lock)
+  void StopWaiting()
+  {
+    if (Private::AtomicFetchAdd(&mWritersWaiting, -1) == 1 && Private::AtomicLoad(&mBlockedReaders) > 0)
+    {
+      Private::Futex::WakeAll(&mWritersWaiting);
+    }
+  }
+
+  void WakeAll()
+  {
+    if (Private::AtomicLoad(&mWaiters) > 0)
+    {
+      Private::Futex::WakeAll(&mState);
+    }
+  }
+
+  volatile int mState;
+  volatile int mWaiters;          // waiting on the state
+  volatile int mWritersWaiting;
+  volatile int mBlockedReaders;   // waiting on the count of the waiting writers
+};
+
+///////////////////////////////////////////////////////////////////////////////
+namespace
+{
+
+// the readers table - each slot is on its own cache line. A slot hold the lock that
+// a reader is holding, or 0 if it is free
+struct VisibleReader
+{
+  Id* volatile Lock;
+  char Pad[Private::CACHE_LINE_SIZE - sizeof(Id*)];
+};
+
+enum
+{
+  VISIBLE_READERS = 1024,     // must be power of 2
+  THREAD_FAST_LOCKS = 8,      // number of locks a single thread can hold with the fast path at the same time
+  INHIBIT_FACTOR = 9          // how long to wait before restoring the bias relative to the time it took to revoke it
+};
+
+VisibleReader visibleReaders[VISIBLE_READERS] __attribute__((aligned(Private::CACHE_LINE_SIZE)));
+
+// each thread keep the slots it is holding, so it would know on release whether it took the fast path
+__thread VisibleReader* threadSlots[THREAD_FAST_LOCKS];
+
+VisibleReader* SlotFor(const Id* lock)
+{
+  unsigned long hash = (unsigned long)lock ^ ((unsigned long)Private::CurrentThreadId() * 0x9E3779B1UL);
+  hash ^= hash >> 15;
+  hash *= 0x2C1B3C6DUL;
+  hash ^= hash >> 12;
+  return &visibleReaders[hash & (VISIBLE_READERS - 1)];
+}
+
+} // end of local namespace
+
+struct Id
+{
+  Id() : mBias(true), mInhibitUntil(0), mWriter(0)
+  {
+  }
+
+  bool ReadLock(const Private::Deadline* deadline)
+  {
+    if (FastReadLock())
+    {
+      return true;
+    }
+    if (!mLock.Read(deadline))
+    {
+      return false;
+    }
+    RestoreBias();
+    return true;
+  }
+
+  bool TryReadLock()
+  {
+    if (FastReadLock())
+    {
+      return true;
+    }
+    if (!mLock.TryRead())
+    {
+      return false;
+    }
+    RestoreBias();
+    return true;
+  }
+
+  bool WriteLock(const Private::Deadline* deadline)
+  {
+    if (!mLock.Write(deadline))
+    {
+      return false;
+    }
+    if (Private::AtomicLoadRelaxed(&mBias) && !RevokeBias(deadline))
+    {
+      mLock.WriteRelease();
+      errno = ETIMEDOUT;
+      return false;
+    }
+    mWriter = Private::CurrentThreadId();
+    return true;
+  }
+
+  bool TryWriteLock()
+  {
+    if (!mLock.TryWrite())
+    {
+      return false;
+    }
+    if (Private::AtomicLoadRelaxed(&mBias) && !RevokeBias(0, false))
+    {
+      mLock.WriteRelease();
+      errno = EBUSY;
+      return false;
+    }
+    mWriter = Private::CurrentThreadId();
+    return true;
+  }
+
+  // we need to know how the lock was taken by this thread - the writer is known, and readers
+  // that took the fast path have the slot in their list, all the rest are slow path readers
+  void Release()
+  {
+    if (mWriter == Private::CurrentThreadId())
+    {
+      mWriter = 0;
+      mLock.WriteRelease();
+      return;
+    }
+    for (unsigned int i = 0; i < THREAD_FAST_LOCKS; i++)
+    {
+      VisibleReader* slot = threadSlots[i];
+      if (slot && slot->Lock == this)
+      {
+        threadSlots[i] = 0;
+        Private::AtomicStoreRelease(&slot->Lock, (Id*)0);
+        return;
+      }
+    }
+    mLock.ReadRelease();
+  }
+
+private:
+  // the fast path for readers - publish in the table that we are holding the lock and
+  // then verify that the lock is still biased for readers (the writer is doing the opposite)
+  bool FastReadLock()
+  {
+    if (!Private::AtomicLoadRelaxed(&mBias))
+    {
+      return false;
+    }
+    int free = FreeThreadSlot();
+    if (free < 0)
+    {
+      return false;
+    }
+    VisibleReader* slot = SlotFor(this);
+    Id* expected = 0;
+    if (!Private::AtomicCompareExchange(&slot->Lock, expected, this))
+    {
+      return false;   // someone else is using this slot
+    }
+    if (Private::AtomicLoad(&mBias))
+    {
+      threadSlots[free] = slot;
+      return true;
+    }
+    Private::AtomicStoreRelease(&slot->Lock, (Id*)0); // a writer is coming, use the slow path
+    return false;
+  }
+
+  static int FreeThreadSlot()
+  {
+    for (unsigned int i = 0; i < THREAD_FAST_LOCKS; i++)
+    {
+      if (!threadSlots[i])
+      {
+        return static_cast<int>(i);
+      }
+    }
+    return -1;
+  }
+
+  // slow path readers are the ones that give the bias back once enough time passed since it was revoked
+  void RestoreBias()
+  {
+    if (!Private::AtomicLoadRelaxed(&mBias) && Now() >= Private::AtomicLoadRelaxed(&mInhibitUntil))
+    {
+      Private::AtomicStore(&mBias, true);
+    }
+  }
+
+  // must be called with the write lock held
+  // @return false if we could not wait for all the fast readers to leave
+  bool RevokeBias(const Private::Deadline* deadline, bool wait = true)
+  {
+    Private::AtomicStore(&mBias, false);
+    const nanoseconds_t start = Now();
+    for (unsigned int i = 0; i < VISIBLE_READERS; i++)
+    {
+      while (Private::AtomicLoadAcquire(&visibleReaders[i].Lock) == this)
+      {
+        if (!wait || (deadline && deadline->Passed()))
+        {
+          return false;
+        }
+        sched_yield();
+      }
+    }
+    const nanoseconds_t now = Now();
+    Private::AtomicStoreRelaxed(&mInhibitUntil, now + (now - start) * INHIBIT_FACTOR);
+    return true;
+  }
+
+  ReadWriteLock mLock;
+  volatile bool mBias;
+  volatile nanoseconds_t mInhibitUntil;
+  pid_t mWriter;    // this is only changed by the thread that hold the lock for writing
+};
+
+namespace
+{
+
+// the lock operations for the lock profiler
+struct ProfiledRead
+{
+  ProfiledRead(Id* id, const Private::Deadline* deadline) : mId(id), mDeadline(deadline)
+  {
+  }
+
+  bool Try()
+  {
+    return mId->TryReadLock();
+  }
+
+  bool Wait()
+  {
+    return mId->ReadLock(mDeadline);
+  }
+
+  const void* Lock() const
+  {
+    return mId;
+  }
+
+  Id* mId;
+  const Private::Deadline* mDeadline;
+};
+
+struct ProfiledWrite
+{
+  ProfiledWrite(Id* id, const Private::Deadline* deadline) : mId(id), mDeadline(deadline)
+  {
+  }
+
+  bool Try()
+  {
+    return mId->TryWriteLock();
+  }
+
+  bool Wait()
+  {
+    return mId->WriteLock(mDeadline);
+  }
+
+  const void* Lock() const
+  {
+    return mId;
+  }
+
+  Id* mId;
+  const Private::Deadline* mDeadline;
+};
+
+} // end of local namespace
+
+void RegisterAtExit(at_error_fun func)
+{
+  ErrorHandler().Push(func);
+}
+
+Id* Create()
+{
+  std::auto_ptr<Id> id(new Id);
+  return id.release();
+}
+
+void ReadLock(Id* id)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid read/write mutex id");
+  if (OSAL_LOCK_PROFILING() ? !Private::LockProfiling::ProfiledTake(ProfiledRead(id, 0), OSAL_LOCK_CALL_SITE(), false) :
+                              !id->ReadLock(0))
+  {
+    ErrorHandler().CriticalError(errno, __FUNCTION__, __LINE__);
+  }
+}
+
+bool TryReadLock(Id* id)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid read/write mutex id");
+  if (OSAL_LOCK_PROFILING() ? !Private::LockProfiling::ProfiledTake(ProfiledRead(id, 0), OSAL_LOCK_CALL_SITE(), true) :
+                              !id->TryReadLock())
+  {
+    return ErrorHandler().TryFail(errno, __FUNCTION__, __LINE__);
+  }
+  else
+  {
+    return true;
+  }
+}
+
+bool TimedReadLock(Id* id, milliseconds_t milliTimeout)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid read/write mutex id");
+  Private::Deadline deadline(milliTimeout);
+  if (OSAL_LOCK_PROFILING() ?
+        !Private::LockProfiling::ProfiledTake(ProfiledRead(id, &deadline), OSAL_LOCK_CALL_SITE(), false) :
+        !id->ReadLock(&deadline))
+  {
+    return ErrorHandler().TimedOut(errno, __FUNCTION__, __LINE__);
+  }
+  else
+  {
+    return true;
+  }
+}
+
+bool TimedReadLock(Id* id, const Duration& timeout)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid read/write mutex id");
+  Private::Deadline deadline(timeout);
+  if (OSAL_LOCK_PROFILING() ?
+        !Private::LockProfiling::ProfiledTake(ProfiledRead(id, &deadline), OSAL_LOCK_CALL_SITE(), false) :
+        !id->ReadLock(&deadline))
+  {
+    return ErrorHandler().TimedOut(errno, __FUNCTION__, __LINE__);
+  }
+  else
+  {
+    return true;
+  }
+}
+
+void WriteLock(Id* id)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid read/write mutex id");
+  if (OSAL_LOCK_PROFILING() ? !Private::LockProfiling::ProfiledTake(ProfiledWrite(id, 0), OSAL_LOCK_CALL_SITE(), false) :
+                              !id->WriteLock(0))
+  {
+    ErrorHandler().CriticalError(errno, __FUNCTION__, __LINE__);
+  }
+}
+
+bool TryWriteLock(Id* id)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid read/write mutex id");
+  if (OSAL_LOCK_PROFILING() ? !Private::LockProfiling::ProfiledTake(ProfiledWrite(id, 0), OSAL_LOCK_CALL_SITE(), true) :
+                              !id->TryWriteLock())
+  {
+    return ErrorHandler().TryFail(errno, __FUNCTION__, __LINE__);
+  }
+  else
+  {
+    return true;
+  }
+}
+
+bool TimedWriteLock(Id* id, milliseconds_t milliTimeout)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid read/write mutex id");
+  Private::Deadline deadline(milliTimeout);
+  if (OSAL_LOCK_PROFILING() ?
+        !Private::LockProfiling::ProfiledTake(ProfiledWrite(id, &deadline), OSAL_LOCK_CALL_SITE(), false) :
+        !id->WriteLock(&deadline))
+  {
+    return ErrorHandler().TimedOut(errno, __FUNCTION__, __LINE__);
+  }
+  else
+  {
+    return true;
+  }
+}
+
+bool TimedWriteLock(Id* id, const Duration& timeout)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid read/write mutex id");
+  Private::Deadline deadline(timeout);
+  if (OSAL_LOCK_PROFILING() ?
+        !Private::LockProfiling::ProfiledTake(ProfiledWrite(id, &deadline), OSAL_LOCK_CALL_SITE(), false) :
+        !id->WriteLock(&deadline))
+  {
+    return ErrorHandler().TimedOut(errno, __FUNCTION__, __LINE__);
+  }
+  else
+  {
+    return true;
+  }
+}
+
+void Release(Id* id)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid read/write mutex id");
+  if (OSAL_LOCK_HOLDING())
+  {
+    Private::LockProfiling::Released(id);
+  }
+  id->Release();
+}
+
+void Delete(Id*& id)
+{
+  if (id)
+  {
+    delete id;
+    id = 0;
+  }
+}
+
+} // end of namespace RWMutex
+
+} // end of namespace osal
+
+#else
+# error "you must not include this file inside header file"
+#endif  // RW_MUTEX_POSIX__HPP
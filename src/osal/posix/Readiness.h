@@ -0,0 +1,143 @@
+#ifndef READINESS__H
+#define READINESS__H
+// This allow other code to know when an OSAL object (event notification, message queue)
+// is ready (signaled, not empty) without blocking on the object itself. The object can
+// expose an eventfd that is written each time the object become ready, so it can be waited on
+// with epoll together with other file descriptors (see Poller). The eventfd is only created
+// when someone ask for it, until then notifying cost a single check.
+// Note that the eventfd is only a hint - once it is readable the object was ready at some point,
+// the user must check whether it is still ready (IsReady) after clearing it (Clear).
+// This also hold the threads that are waiting on the object with MultiWait (see WaitList.h)
+
+#include "Futex.h"          // atomic operations
+#include "WaitList.h"       // threads waiting on more than one object
+#include <sys/eventfd.h>    // eventfd
+#include <unistd.h>         // read, write, close
+#include <stdint.h>         // uint64_t
+#include <errno.h>          // EINTR
+
+namespace osal
+{
+
+namespace Private
+{
+
+class Readiness
+{
+public:
+  typedef bool (*check_func_t)(const void* owner);
+
+  Readiness(check_func_t check, const void* owner) : mCheck(check), mOwner(owner), mFd(-1)
+  {
+  }
+
+  ~Readiness()
+  {
+    if (mFd >= 0)
+    {
+      close(mFd);
+    }
+  }
+
+  // @return the eventfd for this object (create it on the first call) or -1 with errno set
+  int Handle()
+  {
+    int fd = AtomicLoad(&mFd);
+    if (fd < 0)
+    {
+      int created = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+      if (created < 0)
+      {
+        return -1;
+      }
+      int expected = -1;
+      if (AtomicCompareExchange(&mFd, expected, created))
+      {
+        fd = created;
+        if (IsReady())
+        {
+          Signal(fd); // we may have missed this
+        }
+      }
+      else
+      {
+        close(created);   // someone else created it first
+        fd = expected;
+      }
+    }
+    return fd;
+  }
+
+  bool IsReady() const
+  {
+    return mCheck(mOwner);
+  }
+
+  // this must be called after the object state was changed to ready, with a full fence
+  // between the change and this call (see WaitList::Notify) - so we would not miss the
+  // eventfd or the waiters that were added just before it
+  void Notify()
+  {
+    const int fd = AtomicLoad(&mFd);
+    if (fd >= 0)
+    {
+      Signal(fd);
+    }
+    mWaiters.Notify();
+  }
+
+  WaitList& Waiters()
+  {
+    return mWaiters;
+  }
+
+  // make the eventfd not readable, after this the owner must check the object state
+  void Clear()
+  {
+    const int fd = AtomicLoad(&mFd);
+    if (fd >= 0)
+    {
+      uint64_t value = 0;
+      while (read(fd, &value, sizeof(value)) < 0 && errno == EINTR)
+      {
+      }
+    }
+  }
+
+private:
+  Readiness(const Readiness&);
+  Readiness& operator = (const Readiness&);
+
+  static void Signal(int fd)
+  {
+    const uint64_t one = 1;
+    while (write(fd, &one, sizeof(one)) < 0 && errno == EINTR)
+    {
+    }
+  }
+
+  check_func_t mCheck;
+  const void* mOwner;
+  volatile int mFd;
+  WaitList mWaiters;
+};
+
+} // end of namespace Private
+
+namespace EventNotification
+{
+  struct Id;
+
+  Private::Readiness& ReadinessOf(Id* id);
+} // end of namespace EventNotification
+
+namespace MessageQueue
+{
+  struct Id;
+
+  Private::Readiness& ReadinessOf(Id* id);
+} // end of namespace MessageQueue
+
+} // end of namespace osal
+
+#endif  // READINESS__H
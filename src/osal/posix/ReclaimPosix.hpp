@@ -0,0 +1,371 @@
+#ifndef RECLAIM_POSIX__HPP
+#define RECLAIM_POSIX__HPP
+// Linux implementation for the memory reclamation. The epochs are the scheme from Fraser
+// "Practical lock-freedom": there is a global epoch, and each thread announce the epoch it
+// saw when it entered. The epoch can only move forward once all the threads that are inside
+// announced the current one, so a node that was retired at epoch E can't be seen by anyone
+// once the global epoch is E + 2. The hazard pointers are from Michael "Hazard Pointers: Safe
+// Memory Reclamation for Lock-Free Objects" - before a node is freed all the published hazard
+// pointers are scanned, and nodes that are protected are kept for the next time.
+// Each thread has a record in the domain (found with a pthread key), the records are never
+// removed from the domain until it is deleted - when a thread exit its record is released so
+// that the next thread that use the domain would take it (with the nodes that are still in it).
+
+#include "osal/Reclaim.h"           // the interface for this implementation
+#include "Futex.h"                  // atomic operations
+#include "ExitFunctionHolder.h"     // to define the list of error handling functions
+#include <pthread.h>                // pthread_key_t
+#include <algorithm>                // sort, binary_search
+#include <vector>                   // the retired nodes
+#include <memory>                   // auto_ptr
+
+namespace osal
+{
+
+namespace Reclaim
+{
+
+namespace
+{
+
+Private::ExitFunctionHolder& ErrorHandler()
+{
+  static Private::ExitFunctionHolder theList;
+  return theList;
+}
+
+enum
+{
+  EPOCHS = 3,           // the nodes from the current epoch and the two before it can't be freed yet
+  SCAN_THRESHOLD = 64,  // try to free after this number of nodes were retired by a thread
+  ACTIVE = 1            // the low bit of the announced epoch is set while the thread is inside
+};
+
+} // end of local namespace
+
+// the nodes that a thread retired while the global epoch had the same value
+struct Limbo
+{
+  Limbo() : Epoch(0)
+  {
+  }
+
+  unsigned long Epoch;
+  std::vector<void*> Nodes;
+};
+
+// each thread that is using the domain own a record, only the owner change it (other than
+// the hazard pointers and the announced epoch that are read by all the threads)
+struct Record
+{
+  Record() : Announced(0), Owned(1), Next(0), Nesting(0), Retired(0)
+  {
+    for (unsigned int i = 0; i < HAZARDS; i++)
+    {
+      Hazards[i] = 0;
+    }
+  }
+
+  volatile unsigned long Announced;   // (epoch << 1) | ACTIVE while the owner is inside, or 0
+  void* volatile Hazards[HAZARDS];
+  volatile int Owned;                 // 0 once the thread that used it exit
+  Record* Next;                       // the records list is only growing, this is set before it is published
+  unsigned int Nesting;
+  unsigned int Retired;               // since the last time we tried to free
+  Limbo Lists[EPOCHS];
+  std::vector<void*> Protected;       // the hazard pointers snapshot (kept to save the allocation)
+  char mPadding[Private::CACHE_LINE_SIZE];  // the records are changed by different threads
+};
+
+struct Id
+{
+  Id(free_func_t func, void* context) : Epoch(0), Records(0), Pending(0), Func(func), Context(context)
+  {
+  }
+
+  Record* Self();
+  bool TryAdvance();
+  void Collect(Record* self);
+  void Free(Record* self, Limbo& limbo);
+
+  volatile unsigned long Epoch;
+  char mPadding[Private::CACHE_LINE_SIZE - sizeof(unsigned long)];   // this is read on each Enter
+  Record* volatile Records;
+  volatile long Pending;
+  free_func_t Func;
+  void* Context;
+  pthread_key_t Key;
+};
+
+namespace
+{
+
+// called when a thread that is using the domain exit
+void ReleaseRecord(void* value)
+{
+  Record* record = static_cast<Record*>(value);
+  record->Nesting = 0;
+  for (unsigned int i = 0; i < HAZARDS; i++)
+  {
+    Private::AtomicStoreRelaxed(&record->Hazards[i], (void*)0);
+  }
+  Private::AtomicStoreRelease(&record->Announced, 0);
+  Private::AtomicStoreRelease(&record->Owned, 0);
+}
+
+} // end of local namespace
+
+// @return the record for the calling thread, take a free record or add a new one if this is the first call
+Record* Id::Self()
+{
+  Record* self = static_cast<Record*>(pthread_getspecific(Key));
+  if (self)
+  {
+    return self;
+  }
+  for (Record* record = Private::AtomicLoadAcquire(&Records); record && !self; record = record->Next)
+  {
+    int expected = 0;
+    if (Private::AtomicLoadRelaxed(&record->Owned) == 0 && Private::AtomicCompareExchange(&record->Owned, expected, 1))
+    {
+      self = record;  // this one was left by a thread that exit
+    }
+  }
+  if (!self)
+  {
+    self = new Record;
+    Record* head = Private::AtomicLoadRelaxed(&Records);
+    do
+    {
+      self->Next = head;
+    } while (!Private::AtomicCompareExchange(&Records, head, self));
+  }
+  int err = pthread_setspecific(Key, self);
+  if (err)
+  {
+    ErrorHandler().CriticalError(err, __FUNCTION__, __LINE__);
+  }
+  return self;
+}
+
+// move the global epoch forward if all the threads that are inside saw the current one
+bool Id::TryAdvance()
+{
+  unsigned long epoch = Private::AtomicLoad(&Epoch);
+  const unsigned long current = (epoch << 1) | ACTIVE;
+  for (Record* record = Private::AtomicLoadAcquire(&Records); record; record = record->Next)
+  {
+    const unsigned long announced = Private::AtomicLoad(&record->Announced);
+    if ((announced & ACTIVE) && announced != current)
+    {
+      return false;   // this one is still inside the previous epoch
+    }
+  }
+  return Private::AtomicCompareExchange(&Epoch, epoch, epoch + 1);
+}
+
+// free the lists that are old enough
+void Id::Collect(Record* self)
+{
+  TryAdvance();
+  const unsigned long epoch = Private::AtomicLoad(&Epoch);
+  for (unsigned int i = 0; i < EPOCHS; i++)
+  {
+    if (!self->Lists[i].Nodes.empty() && epoch - self->Lists[i].Epoch >= 2)
+    {
+      Free(self, self->Lists[i]);
+    }
+  }
+}
+
+// free the nodes in the list that are not protected by hazard pointers, the rest are left in it
+void Id::Free(Record* self, Limbo& limbo)
+{
+  Private::AtomicFence();   // the nodes were unlinked before we read the hazard pointers
+  std::vector<void*>& hazards = self->Protected;
+  hazards.clear();
+  for (Record* record = Private::AtomicLoadAcquire(&Records); record; record = record->Next)
+  {
+    for (unsigned int i = 0; i < HAZARDS; i++)
+    {
+      void* hazard = Private::AtomicLoad(&record->Hazards[i]);
+      if (hazard)
+      {
+        hazards.push_back(hazard);
+      }
+    }
+  }
+  std::sort(hazards.begin(), hazards.end());
+  std::vector<void*>::iterator kept = limbo.Nodes.begin();
+  for (std::vector<void*>::iterator node = limbo.Nodes.begin(); node != limbo.Nodes.end(); ++node)
+  {
+    if (std::binary_search(hazards.begin(), hazards.end(), *node))
+    {
+      *kept++ = *node;
+    }
+    else
+    {
+      Func(*node, Context);
+    }
+  }
+  Private::AtomicFetchAdd(&Pending, -(long)(limbo.Nodes.end() - kept));
+  limbo.Nodes.erase(kept, limbo.Nodes.end());
+}
+
+void RegisterAtExit(at_error_fun func)
+{
+  ErrorHandler().Push(func);
+}
+
+Id* Create(free_func_t func, void* context)
+{
+  OSAL_ASSERT_CONDITION(func, ErrorHandler(), "invalid free function");
+  std::auto_ptr<Id> id(new Id(func, context));
+  int err = pthread_key_create(&id->Key, ReleaseRecord);
+  if (err)
+  {
+    ErrorHandler().CriticalError(err, __FUNCTION__, __LINE__);
+    return 0;
+  }
+  return id.release();
+}
+
+void Enter(Id* id)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid reclaim id");
+  Record* self = id->Self();
+  if (self->Nesting++ == 0)
+  {
+    // announce the epoch, and check that it did not move before the announcement was seen
+    // (otherwise someone may have freed nodes from the epoch before it without waiting for us)
+    unsigned long epoch = Private::AtomicLoad(&id->Epoch);
+    for (;;)
+    {
+      Private::AtomicStore(&self->Announced, (epoch << 1) | ACTIVE);
+      const unsigned long now = Private::AtomicLoad(&id->Epoch);
+      if (now == epoch)
+      {
+        break;
+      }
+      epoch = now;
+    }
+  }
+}
+
+void Leave(Id* id)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid reclaim id");
+  Record* self = id->Self();
+  OSAL_ASSERT_CONDITION(self->Nesting > 0, ErrorHandler(), "leave without enter");
+  if (--self->Nesting == 0)
+  {
+    Private::AtomicStoreRelease(&self->Announced, 0);  // all our reads are done before this
+  }
+}
+
+void* Protect(Id* id, unsigned int slot, void* const volatile* source)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid reclaim id");
+  OSAL_ASSERT_CONDITION(slot < HAZARDS, ErrorHandler(), "invalid hazard pointer slot");
+  Record* self = id->Self();
+  void* node = Private::AtomicLoadAcquire(source);
+  for (;;)
+  {
+    Private::AtomicStore(&self->Hazards[slot], node);
+    void* const now = Private::AtomicLoad(source);  // if it was not unlinked yet, the hazard would be seen
+    if (now == node)
+    {
+      return node;
+    }
+    node = now;
+  }
+}
+
+void Clear(Id* id, unsigned int slot)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid reclaim id");
+  OSAL_ASSERT_CONDITION(slot < HAZARDS, ErrorHandler(), "invalid hazard pointer slot");
+  Private::AtomicStoreRelease(&id->Self()->Hazards[slot], (void*)0);
+}
+
+void Retire(Id* id, void* node)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid reclaim id");
+  if (!node)
+  {
+    return;
+  }
+  Record* self = id->Self();
+  const unsigned long epoch = Private::AtomicLoad(&id->Epoch);
+  Limbo& limbo = self->Lists[epoch % EPOCHS];
+  if (limbo.Epoch != epoch)
+  {
+    // this list is from at least 3 epochs ago, so only the hazard pointers can hold the nodes in it
+    if (!limbo.Nodes.empty())
+    {
+      id->Free(self, limbo);
+    }
+    limbo.Epoch = epoch;
+  }
+  limbo.Nodes.push_back(node);
+  Private::AtomicFetchAdd(&id->Pending, 1);
+  if (++self->Retired >= SCAN_THRESHOLD)
+  {
+    self->Retired = 0;
+    id->Collect(self);
+  }
+}
+
+unsigned int Flush(Id* id)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid reclaim id");
+  Record* self = id->Self();
+  self->Retired = 0;
+  id->TryAdvance();   // a node that was just retired need two more epochs
+  id->Collect(self);
+  unsigned int left = 0;
+  for (unsigned int i = 0; i < EPOCHS; i++)
+  {
+    left += (unsigned int)self->Lists[i].Nodes.size();
+  }
+  return left;
+}
+
+unsigned int Pending(Id* id)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid reclaim id");
+  return (unsigned int)Private::AtomicLoad(&id->Pending);
+}
+
+void Delete(Id*& id)
+{
+  if (!id)
+  {
+    return;
+  }
+  pthread_key_delete(id->Key);  // the threads that are still using it would not release their records
+  Record* record = id->Records;
+  while (record)
+  {
+    Record* next = record->Next;
+    for (unsigned int i = 0; i < EPOCHS; i++)
+    {
+      for (std::vector<void*>::iterator node = record->Lists[i].Nodes.begin(); node != record->Lists[i].Nodes.end(); ++node)
+      {
+        id->Func(*node, id->Context);
+      }
+    }
+    delete record;
+    record = next;
+  }
+  delete id;
+  id = 0;
+}
+
+} // end of namespace Reclaim
+
+} // end of namespace osal
+
+#else
+# error "you must not include this file inside header file"
+#endif  // RECLAIM_POSIX__HPP
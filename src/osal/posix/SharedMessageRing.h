@@ -0,0 +1,464 @@
+#ifndef SHARED_MESSAGE_RING_POSIX__H
+#define SHARED_MESSAGE_RING_POSIX__H
+// Message queue that is placed in memory that is shared between two processes. This is the
+// same as the single writer ring with the two lanes (see MessageRing.h), only that since the
+// memory is mapped at a different address in each process, this object has no pointers - the
+// slots are right after it in the shared memory (the normal lane and then the urgent lane), and
+// the futex words are shared so a process can wake the other one. One process is sending the
+// messages and the other is reading them, so passing a message is a single memcpy to the slot
+// and a store of the position, and we only go to the kernel when the other side is sleeping.
+// Each side register its process id here, so that a process that is waiting for the other one
+// would find out if it crashed - the waits are done in short periods, and after each one we check
+// that the other process is still alive. Since the positions are only moved after the message
+// was copied, a process that crashed in the middle of an operation would not leave the ring in a
+// broken state, and another process can take its place.
+
+#include "Futex.h"          // atomic operations, EventCount, Deadline
+#include "MessageRing.h"    // RingCapacity
+#include <sys/types.h>      // pid_t
+#include <signal.h>         // kill
+#include <unistd.h>         // getpid
+#include <string.h>         // memcpy
+#include <stddef.h>         // size_t
+#include <errno.h>          // errno values
+
+namespace osal
+{
+
+namespace Private
+{
+
+class SharedMessageRing
+{
+public:
+  // the process that created the queue and the one that opened it
+  enum Side
+  {
+    CREATOR = 0,
+    OPENER
+  };
+
+  enum
+  {
+    MAGIC = 0x4F53514D,     // set once the creator finished to initialize the ring
+    MAX_URGENT_BURST = 32,  // the same as MessageLanes
+    PEER_CHECK_MILLI = 100  // how often the waits check that the other process is alive
+  };
+
+  // @return the size of the shared memory that is needed for the ring and its slots
+  static size_t Footprint(unsigned int capacity, unsigned int maxMessageSize)
+  {
+    return HeaderSize() + 2 * static_cast<size_t>(SlotSize(maxMessageSize)) * RingCapacity(capacity);
+  }
+
+  // @return true if the creator finished to initialize the ring at this address (it is
+  // placed there with placement new, and the magic is stored last)
+  static bool Ready(const void* at)
+  {
+    return AtomicLoadAcquire(&static_cast<const SharedMessageRing*>(at)->mMagic) == static_cast<unsigned int>(MAGIC);
+  }
+
+  // note that the capacity is rounded up to power of 2 (and it is at least 2)
+  SharedMessageRing(unsigned int capacity, unsigned int maxMessageSize) : mMagic(0),
+                                                 mMask(RingCapacity(capacity) - 1),
+                                                 mStride(SlotSize(maxMessageSize)),
+                                                 mMaxMessageSize(maxMessageSize),
+                                                 mNotEmpty(true), mNotFull(true),
+                                                 mBurst(0), mOvertaken(0), mForced(0)
+  {
+    mPeers[CREATOR] = 0;
+    mPeers[OPENER] = 0;
+    memset(mLanes, 0, sizeof(mLanes));
+  }
+
+  // mark the ring as ready for the other process
+  void Publish()
+  {
+    AtomicStoreRelease(&mMagic, static_cast<unsigned int>(MAGIC));
+  }
+
+  unsigned int MaxMessageSize() const
+  {
+    return mMaxMessageSize;
+  }
+
+  unsigned int Capacity() const
+  {
+    return mMask + 1;
+  }
+
+  // register the calling process as the given side
+  // @return false with errno set to EBUSY if another process that is still alive took this side
+  bool Attach(Side side)
+  {
+    pid_t current = AtomicLoad(&mPeers[side]);
+    for (;;)
+    {
+      if (current != 0 && Alive(current))
+      {
+        errno = EBUSY;
+        return false;
+      }
+      if (AtomicCompareExchange(&mPeers[side], current, getpid()))
+      {
+        return true;
+      }
+    }
+  }
+
+  // @return true if a process that is still running is registered as the given side
+  bool Attached(Side side) const
+  {
+    const pid_t pid = AtomicLoad(&mPeers[side]);
+    return pid != 0 && Alive(pid);
+  }
+
+  void Detach(Side side)
+  {
+    pid_t self = getpid();
+    AtomicCompareExchange(&mPeers[side], self, 0);
+  }
+
+  // @return false if the other process was attached and it is no longer running (if it has not
+  // attached yet, or it detached from the ring, it may still come so this would return true)
+  bool PeerAlive(Side side) const
+  {
+    const pid_t peer = AtomicLoad(&mPeers[side == CREATOR ? OPENER : CREATOR]);
+    return peer == 0 || Alive(peer);
+  }
+
+  // must only be called from the writer
+  // @return false if the lane is full
+  bool TryPush(const char* msg, unsigned int size, bool urgent)
+  {
+    if (PushLane(urgent ? URGENT : NORMAL, &msg, &size, 1) == 1)
+    {
+      mNotEmpty.Notify(false);
+      return true;
+    }
+    return false;
+  }
+
+  // must only be called from the reader
+  // @return -1 if the queue is empty, else the number of bytes that were copied to buff
+  int TryPop(char* buff, unsigned int buffSize)
+  {
+    unsigned int size = 0;
+    return TryPopBatch(buff, buffSize, &size, 1) == 1 ? static_cast<int>(size) : -1;
+  }
+
+  // batches are always placed in the normal lane
+  // @return the number of messages that were added - 0 if the queue is full
+  unsigned int TryPushBatch(const char* const msgs[], const unsigned int sizes[], unsigned int count)
+  {
+    unsigned int ret = PushLane(NORMAL, msgs, sizes, count);
+    if (ret > 0)
+    {
+      mNotEmpty.Notify(false);  // there is only one reader
+    }
+    return ret;
+  }
+
+  // read as many as we can from the urgent lane and then from the normal lane
+  // @return the number of messages that were read - 0 if the queue is empty
+  unsigned int TryPopBatch(char* buff, unsigned int stride, unsigned int sizes[], unsigned int maxCount)
+  {
+    unsigned int ret = 0;
+    if (!TakeUrgent())
+    {
+      // either there are no urgent messages, or one normal message must be read first
+      ret = PopLane(NORMAL, buff, stride, sizes, Empty(URGENT) ? maxCount : 1);
+    }
+    ret += PopLane(URGENT, buff + static_cast<size_t>(ret) * stride, stride, sizes ? sizes + ret : 0,
+                   maxCount - ret);
+    ret += PopLane(NORMAL, buff + static_cast<size_t>(ret) * stride, stride, sizes ? sizes + ret : 0,
+                   maxCount - ret);
+    if (ret > 0)
+    {
+      mNotFull.Notify(false);   // there is only one writer
+    }
+    return ret;
+  }
+
+  // block while the lane is full
+  // @return false with errno set if we failed to add before the deadline (if deadline is 0 wait forever)
+  // or if the reader process crashed (EPIPE)
+  bool Push(const char* msg, unsigned int size, bool urgent, const Deadline* deadline, Side self)
+  {
+    while (!TryPush(msg, size, urgent))
+    {
+      int ticket = mNotFull.PrepareWait();
+      if (TryPush(msg, size, urgent))
+      {
+        mNotFull.CancelWait();
+        return true;
+      }
+      int err = Wait(mNotFull, ticket, deadline, self);
+      if (err)
+      {
+        errno = err;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // block while the queue is empty
+  // @return -1 with errno set if we failed to read before the deadline (if deadline is 0 wait forever)
+  // or if the writer process crashed (EPIPE)
+  int Pop(char* buff, unsigned int buffSize, const Deadline* deadline, Side self)
+  {
+    unsigned int size = 0;
+    return PopBatch(buff, buffSize, &size, 1, deadline, self) == 1 ? static_cast<int>(size) : -1;
+  }
+
+  // block while the queue is full, then add as many messages as we can
+  // @return the number of messages that were added, 0 with errno set if we failed
+  unsigned int PushBatch(const char* const msgs[], const unsigned int sizes[], unsigned int count,
+                         const Deadline* deadline, Side self)
+  {
+    unsigned int ret = 0;
+    while (count > 0 && (ret = TryPushBatch(msgs, sizes, count)) == 0)
+    {
+      int ticket = mNotFull.PrepareWait();
+      if ((ret = TryPushBatch(msgs, sizes, count)) > 0)
+      {
+        mNotFull.CancelWait();
+        return ret;
+      }
+      int err = Wait(mNotFull, ticket, deadline, self);
+      if (err)
+      {
+        errno = err;
+        return 0;
+      }
+    }
+    return ret;
+  }
+
+  // block while the queue is empty, then read as many messages as we can
+  // @return the number of messages that were read, 0 with errno set if we failed
+  unsigned int PopBatch(char* buff, unsigned int stride, unsigned int sizes[], unsigned int maxCount,
+                        const Deadline* deadline, Side self)
+  {
+    unsigned int ret = 0;
+    while (maxCount > 0 && (ret = TryPopBatch(buff, stride, sizes, maxCount)) == 0)
+    {
+      int ticket = mNotEmpty.PrepareWait();
+      if ((ret = TryPopBatch(buff, stride, sizes, maxCount)) > 0)
+      {
+        mNotEmpty.CancelWait();
+        return ret;
+      }
+      int err = Wait(mNotEmpty, ticket, deadline, self);
+      if (err)
+      {
+        errno = err;
+        return 0;
+      }
+    }
+    return ret;
+  }
+
+  // note that this is only a snapshot, it may be changed by the time you are using it
+  int Size() const
+  {
+    return NormalSize() + UrgentSize();
+  }
+
+  int NormalSize() const
+  {
+    return LaneSize(NORMAL);
+  }
+
+  int UrgentSize() const
+  {
+    return LaneSize(URGENT);
+  }
+
+  unsigned long Overtaken() const
+  {
+    return AtomicLoadRelaxed(&mOvertaken);
+  }
+
+  unsigned long Forced() const
+  {
+    return AtomicLoadRelaxed(&mForced);
+  }
+
+private:
+  // don't allow copy and assign for this object!
+  SharedMessageRing(const SharedMessageRing&);
+  SharedMessageRing& operator = (const SharedMessageRing&);
+
+  enum LaneIndex
+  {
+    NORMAL = 0,
+    URGENT,
+    LANES_COUNT
+  };
+
+  // the positions of one lane - each side has its own cache line with its position and
+  // its copy of the other side position (see SingleMessageRing)
+  struct Lane
+  {
+    volatile unsigned int Head;
+    unsigned int CachedTail;
+    char Pad1[CACHE_LINE_SIZE - 2 * sizeof(unsigned int)];
+    volatile unsigned int Tail;
+    unsigned int CachedHead;
+    char Pad2[CACHE_LINE_SIZE - 2 * sizeof(unsigned int)];
+  };
+
+  // each slot start with the message size
+  static unsigned int SlotSize(unsigned int maxMessageSize)
+  {
+    unsigned int size = sizeof(unsigned int) + maxMessageSize;
+    return ((size + sizeof(unsigned int) - 1) / sizeof(unsigned int)) * sizeof(unsigned int);
+  }
+
+  // the slots start on a new cache line after this object
+  static size_t HeaderSize()
+  {
+    return ((sizeof(SharedMessageRing) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE) * CACHE_LINE_SIZE;
+  }
+
+  unsigned int* At(unsigned int lane, unsigned int pos)
+  {
+    char* slots = reinterpret_cast<char*>(this) + HeaderSize();
+    return reinterpret_cast<unsigned int*>(slots + (static_cast<size_t>(lane) * (mMask + 1) + (pos & mMask)) * mStride);
+  }
+
+  static bool Alive(pid_t pid)
+  {
+    return kill(pid, 0) == 0 || errno != ESRCH;
+  }
+
+  // wait for the other process - but not more than PEER_CHECK_MILLI at a time, so that we would
+  // notice if the other process crashed while we are waiting
+  // @return 0 if we should check the queue again, ETIMEDOUT if the deadline passed, or EPIPE
+  int Wait(EventCount& event, int ticket, const Deadline* deadline, Side self)
+  {
+    const Deadline check(static_cast<milliseconds_t>(PEER_CHECK_MILLI));
+    const bool last = deadline && deadline->NanoLeft() <= check.NanoLeft();
+    int err = event.Wait(ticket, last ? deadline : &check);
+    if (err == ETIMEDOUT && !last)
+    {
+      return PeerAlive(self) ? 0 : EPIPE;
+    }
+    return err;
+  }
+
+  // must only be called from the writer
+  unsigned int PushLane(unsigned int index, const char* const msgs[], const unsigned int sizes[], unsigned int count)
+  {
+    Lane& lane = mLanes[index];
+    const unsigned int pos = lane.Tail;   // only the writer is changing it
+    unsigned int room = mMask + 1 - (pos - lane.CachedHead);
+    if (room < count)
+    {
+      lane.CachedHead = AtomicLoadAcquire(&lane.Head);
+      room = mMask + 1 - (pos - lane.CachedHead);
+      if (room < count)
+      {
+        count = room;
+      }
+    }
+    for (unsigned int i = 0; i < count; i++)
+    {
+      unsigned int* slot = At(index, pos + i);
+      *slot = sizes[i];
+      memcpy(slot + 1, msgs[i], sizes[i]);
+    }
+    if (count > 0)
+    {
+      AtomicStoreRelease(&lane.Tail, pos + count);
+    }
+    return count;
+  }
+
+  // must only be called from the reader
+  unsigned int PopLane(unsigned int index, char* buff, unsigned int stride, unsigned int sizes[], unsigned int maxCount)
+  {
+    Lane& lane = mLanes[index];
+    const unsigned int pos = lane.Head;   // only the reader is changing it
+    unsigned int ready = lane.CachedTail - pos;
+    if (ready < maxCount)
+    {
+      lane.CachedTail = AtomicLoadAcquire(&lane.Tail);
+      ready = lane.CachedTail - pos;
+      if (ready < maxCount)
+      {
+        maxCount = ready;
+      }
+    }
+    for (unsigned int i = 0; i < maxCount; i++)
+    {
+      unsigned int* slot = At(index, pos + i);
+      unsigned int size = *slot < stride ? *slot : stride;
+      memcpy(buff + static_cast<size_t>(i) * stride, slot + 1, size);
+      if (sizes)
+      {
+        sizes[i] = size;
+      }
+    }
+    if (maxCount > 0)
+    {
+      AtomicStoreRelease(&lane.Head, pos + maxCount);
+    }
+    return maxCount;
+  }
+
+  bool Empty(unsigned int index) const
+  {
+    return AtomicLoadRelaxed(&mLanes[index].Tail) == AtomicLoadRelaxed(&mLanes[index].Head);
+  }
+
+  int LaneSize(unsigned int index) const
+  {
+    int size = static_cast<int>(AtomicLoadRelaxed(&mLanes[index].Tail) - AtomicLoadRelaxed(&mLanes[index].Head));
+    return size < 0 ? 0 : (size > static_cast<int>(mMask + 1) ? static_cast<int>(mMask + 1) : size);
+  }
+
+  // the same as in MessageLanes, only that here there is a single reader
+  bool TakeUrgent()
+  {
+    if (Empty(URGENT))
+    {
+      return false;
+    }
+    if (Empty(NORMAL))
+    {
+      mBurst = 0;
+      return true;
+    }
+    if (mBurst++ < static_cast<unsigned int>(MAX_URGENT_BURST))
+    {
+      AtomicFetchAdd(&mOvertaken, 1);
+      return true;
+    }
+    mBurst = 0;
+    AtomicFetchAdd(&mForced, 1);
+    return false;
+  }
+
+  volatile unsigned int mMagic;
+  const unsigned int mMask;
+  const unsigned int mStride;
+  const unsigned int mMaxMessageSize;
+  volatile pid_t mPeers[2];
+  EventCount mNotEmpty;
+  EventCount mNotFull;
+  unsigned int mBurst;                // only the reader is using it
+  volatile unsigned long mOvertaken;
+  volatile unsigned long mForced;
+  // the positions that follow are changed all the time, don't let them share the cache line
+  char mPad[CACHE_LINE_SIZE];
+  Lane mLanes[LANES_COUNT];
+};
+
+} // end of namespace Private
+
+} // end of namespace osal
+
+#endif  // SHARED_MESSAGE_RING_POSIX__H
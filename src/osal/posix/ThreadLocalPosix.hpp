@@ -0,0 +1,350 @@
+#ifndef THREAD_LOCAL_POSIX__HPP
+#define THREAD_LOCAL_POSIX__HPP
+// Linux implementation for the thread local storage. The value of each thread is kept in a node
+// that is linked into the list of the storage (so ForEach can find it), and the node is set as the
+// value of a pthread key of the storage, so that Get can find it.
+// The nodes of each thread are also linked into a list of the thread, which is the value of a single
+// key that is never deleted - its destructor remove the values when the thread exit. Since this
+// key is never deleted, the destructor is never called for a list that was already freed. The
+// lists of the threads are guarded by one lock, so a storage that is deleted would either take
+// the node of an exiting thread before the thread sees it, or leave it to the thread (which would
+// delete the storage if it is the last one to use it).
+// The fast access is done by the template with a __thread variable, here we only record where
+// this variable is for each thread, so that it can be cleared when the storage is deleted.
+
+#include "osal/ThreadLocal.h"       // the interface for this implementation
+#include "Futex.h"                  // FutexLock
+#include "CriticalSection.h"        // to guard the list of values
+#include "ExitFunctionHolder.h"     // to report errors
+#include <pthread.h>                // pthread_key_t
+#include <memory>                   // auto_ptr
+
+namespace osal
+{
+
+namespace ThreadLocalDetails
+{
+
+struct Values;
+
+struct Node
+{
+  Node(Id* owner, void* value, void** slot, delete_func_t remove) :
+    Owner(owner), Value(value), Slot(slot), Remove(remove), Thread(0), Next(0), Prev(0), ThreadNext(0), ThreadPrev(0)
+  {
+  }
+
+  Id* Owner;
+  void* Value;
+  void** Slot;          // the thread local variable of the thread that own this
+  delete_func_t Remove;
+  Values* Thread;       // the list of the thread, NULL once the thread started to exit
+  Node* Next;           // in the list of the storage
+  Node* Prev;
+  Node* ThreadNext;     // in the list of the thread
+  Node* ThreadPrev;
+};
+
+// the values of a single thread (from all the storages)
+struct Values
+{
+  Values() : Head(0)
+  {
+  }
+
+  void Link(Node* node)
+  {
+    node->Thread = this;
+    node->ThreadPrev = 0;
+    node->ThreadNext = Head;
+    if (Head)
+    {
+      Head->ThreadPrev = node;
+    }
+    Head = node;
+  }
+
+  void Unlink(Node* node)
+  {
+    if (node->ThreadPrev)
+    {
+      node->ThreadPrev->ThreadNext = node->ThreadNext;
+    }
+    else
+    {
+      Head = node->ThreadNext;
+    }
+    if (node->ThreadNext)
+    {
+      node->ThreadNext->ThreadPrev = node->ThreadPrev;
+    }
+    node->Thread = 0;
+    node->ThreadNext = node->ThreadPrev = 0;
+  }
+
+  Node* Head;
+};
+
+struct Id
+{
+  Id(create_func_t create, exit_func_t atExit, delete_func_t remove, void* owner) :
+    Create(create), AtExit(atExit), Remove(remove), Owner(owner), Head(0), Count(0), Exiting(0), Deleted(false)
+  {
+  }
+
+  void Link(Node* node)
+  {
+    node->Next = Head;
+    if (Head)
+    {
+      Head->Prev = node;
+    }
+    Head = node;
+    ++Count;
+  }
+
+  void Unlink(Node* node)
+  {
+    if (node->Prev)
+    {
+      node->Prev->Next = node->Next;
+    }
+    else
+    {
+      Head = node->Next;
+    }
+    if (node->Next)
+    {
+      node->Next->Prev = node->Prev;
+    }
+    --Count;
+  }
+
+  create_func_t Create;
+  exit_func_t AtExit;
+  delete_func_t Remove;
+  void* Owner;
+  pthread_key_t Key;
+  Private::FutexLock Lock;  // guard the list
+  Node* Head;
+  unsigned int Count;
+  unsigned int Exiting;     // threads that took their nodes but did not remove them yet
+  bool Deleted;             // the last exiting thread would delete this
+};
+
+namespace
+{
+
+Private::ExitFunctionHolder& ErrorHandler()
+{
+  static Private::ExitFunctionHolder theList;
+  return theList;
+}
+
+// guard the lists of all the threads - this is taken before the lock of a storage
+Private::FutexLock threadsLock;
+
+pthread_once_t threadsKeyOnce = PTHREAD_ONCE_INIT;
+pthread_key_t threadsKey;
+
+void Detach(void* value);
+
+void CreateThreadsKey()
+{
+  int err = pthread_key_create(&threadsKey, Detach);
+  if (err)
+  {
+    ErrorHandler().CriticalError(err, __FUNCTION__, __LINE__);  // we are out of keys
+  }
+}
+
+// @return the list of the calling thread, create it if it is not there yet
+Values* ThreadValues()
+{
+  pthread_once(&threadsKeyOnce, CreateThreadsKey);
+  Values* values = static_cast<Values*>(pthread_getspecific(threadsKey));
+  if (!values)
+  {
+    values = new Values;
+    int err = pthread_setspecific(threadsKey, values);
+    if (err)
+    {
+      ErrorHandler().CriticalError(err, __FUNCTION__, __LINE__);
+    }
+  }
+  return values;
+}
+
+// the key destructor - called when a thread that has values exit
+void Detach(void* value)
+{
+  Values* values = static_cast<Values*>(value);
+  Node* nodes = 0;
+  {
+    // once a node is not in the list of the thread, Delete would leave it (and the storage) to us
+    Private::CriticalSection<Private::FutexLock> guard(threadsLock);
+    while (Node* node = values->Head)
+    {
+      values->Unlink(node);
+      Private::CriticalSection<Private::FutexLock> storageGuard(node->Owner->Lock);
+      ++node->Owner->Exiting;
+      node->ThreadNext = nodes;
+      nodes = node;
+    }
+  }
+  delete values;
+  while (nodes)
+  {
+    Node* node = nodes;
+    nodes = node->ThreadNext;
+    Id* id = node->Owner;
+    bool last = false;
+    {
+      Private::CriticalSection<Private::FutexLock> guard(id->Lock);
+      if (!id->Deleted)
+      {
+        id->AtExit(node->Value, id->Owner);   // the owner is gone once the storage was deleted
+      }
+      id->Unlink(node);
+      last = --id->Exiting == 0 && id->Deleted;
+    }
+    if (node->Slot)
+    {
+      *node->Slot = 0;
+    }
+    node->Remove(node->Value);
+    delete node;
+    if (last)
+    {
+      delete id;
+    }
+  }
+}
+
+} // end of local namespace
+
+Id* Create(create_func_t create, exit_func_t atExit, delete_func_t remove, void* owner)
+{
+  std::auto_ptr<Id> id(new Id(create, atExit, remove, owner));
+  int err = pthread_key_create(&id->Key, 0);  // the values are removed by the key of the threads
+  if (err)
+  {
+    ErrorHandler().CriticalError(err, __FUNCTION__, __LINE__);  // we are out of keys
+  }
+  return id.release();
+}
+
+void* Attach(Id* id, void** slot)
+{
+  assert(id);
+  Node* node = new Node(id, id->Create(), slot, id->Remove);
+  Values* values = ThreadValues();
+  {
+    Private::CriticalSection<Private::FutexLock> guard(threadsLock);
+    values->Link(node);
+    Private::CriticalSection<Private::FutexLock> storageGuard(id->Lock);
+    id->Link(node);
+  }
+  int err = pthread_setspecific(id->Key, node);
+  if (err)
+  {
+    ErrorHandler().CriticalError(err, __FUNCTION__, __LINE__);
+  }
+  if (slot)
+  {
+    *slot = node->Value;
+  }
+  return node->Value;
+}
+
+void* Get(Id* id)
+{
+  assert(id);
+  Node* node = static_cast<Node*>(pthread_getspecific(id->Key));
+  return node ? node->Value : Attach(id, 0);
+}
+
+void ForEach(Id* id, visit_func_t func, void* context)
+{
+  assert(id);
+  Private::CriticalSection<Private::FutexLock> guard(id->Lock);
+  for (Node* node = id->Head; node; node = node->Next)
+  {
+    func(node->Value, context);
+  }
+}
+
+unsigned int Count(Id* id)
+{
+  assert(id);
+  Private::CriticalSection<Private::FutexLock> guard(id->Lock);
+  return id->Count;
+}
+
+void Delete(Id*& id)
+{
+  if (!id)
+  {
+    return;
+  }
+  pthread_key_delete(id->Key);
+  const delete_func_t remove = id->Remove;  // the storage may be gone once we release the lock
+  Node* nodes = 0;
+  bool last = false;
+  {
+    Private::CriticalSection<Private::FutexLock> guard(threadsLock);
+    Private::CriticalSection<Private::FutexLock> storageGuard(id->Lock);
+    Node* node = id->Head;
+    while (node)
+    {
+      Node* next = node->Next;
+      if (node->Thread)
+      {
+        // the thread is still alive (or did not start to remove its values)
+        node->Thread->Unlink(node);
+        id->Unlink(node);
+        if (node->Slot)
+        {
+          *node->Slot = 0;
+        }
+        node->Next = nodes;
+        nodes = node;
+      }
+      node = next;
+    }
+    id->Deleted = true;
+    last = id->Exiting == 0;
+  }
+  while (nodes)
+  {
+    Node* node = nodes;
+    nodes = node->Next;
+    remove(node->Value);
+    delete node;
+  }
+  if (last)
+  {
+    delete id;
+  }
+  id = 0;
+}
+
+bool TakeSlot(void* volatile* user, void* self)
+{
+  void* expected = 0;
+  return Private::AtomicCompareExchange(user, expected, self);
+}
+
+void GiveSlot(void* volatile* user, void* self)
+{
+  void* expected = self;
+  Private::AtomicCompareExchange(user, expected, (void*)0);
+}
+
+} // end of namespace ThreadLocalDetails
+
+} // end of namespace osal
+
+#else
+# error "you must not include this file inside header file"
+#endif  // THREAD_LOCAL_POSIX__HPP
@@ -0,0 +1,626 @@
+#ifndef THREAD_POOL_POSIX__HPP
+#define THREAD_POOL_POSIX__HPP
+// Linux implementation for the thread pool. Each worker has a Chase-Lev deque ("Dynamic
+// Circular Work-Stealing Deque", with the memory ordering from "Correct and Efficient
+// Work-Stealing for Weak Memory Models") of fixed size - the owner push and take from the
+// bottom without any lock (only taking the last task need a CAS), and the other workers steal from
+// the top with a CAS. Tasks that are submitted from threads that are not workers in this pool are
+// placed in a shared queue under a lock. Idle workers are sleeping on an event count, so
+// submitting a task only enter the kernel if there is a sleeping worker.
+
+#include "osal/ThreadPool.h"        // the interface for this implementation
+#include "osal/Mutex.h"             // to guard the workers startup
+#include "osal/EventNotification.h" // to know when a worker started
+#include "Futex.h"                  // atomic operations and event count
+#include "CriticalSection.h"        // to guard the shared queue
+#include "ExitFunctionHolder.h"     // to define the list of error handling functions
+#include <unistd.h>                 // sysconf
+#include <stdio.h>                  // snprintf
+#include <deque>                    // the shared queue
+#include <vector>                   // the workers
+#include <memory>                   // auto_ptr
+
+namespace osal
+{
+
+namespace ThreadPool
+{
+
+namespace
+{
+
+Private::ExitFunctionHolder& ErrorHandler()
+{
+  static Private::ExitFunctionHolder theList;
+  return theList;
+}
+
+enum
+{
+  DEQUE_SIZE = 4096,    // must be power of 2, when it is full the task is executed directly
+  SPIN_ROUNDS = 128,    // how many times to look for work before going to sleep
+  GROUP_WAITING = 1,    // someone is blocked on the group
+  GROUP_TASK = 2,       // the rest of the group state is the number of tasks times this
+  MAX_NAME = 32
+};
+
+} // end of local namespace
+
+struct Entry
+{
+  task_func_t Func;
+  void* Context;
+  Group* Owner;
+};
+
+// only the owner of the deque is calling Push and Take, any thread can call Steal
+class WorkDeque
+{
+public:
+  WorkDeque() : mTop(0), mBottom(0)
+  {
+  }
+
+  // @return false if the deque is full
+  bool Push(const Entry& entry)
+  {
+    const long bottom = Private::AtomicLoadRelaxed(&mBottom);
+    const long top = Private::AtomicLoadAcquire(&mTop);
+    if (bottom - top >= DEQUE_SIZE)
+    {
+      return false;
+    }
+    Slot& slot = mSlots[bottom & (DEQUE_SIZE - 1)];
+    Private::AtomicStoreRelaxed(&slot.Func, entry.Func);
+    Private::AtomicStoreRelaxed(&slot.Context, entry.Context);
+    Private::AtomicStoreRelaxed(&slot.Owner, entry.Owner);
+    Private::AtomicStoreRelease(&mBottom, bottom + 1);  // publish the entry to the thieves
+    return true;
+  }
+
+  // take the last entry that was pushed
+  bool Take(Entry& entry)
+  {
+    const long bottom = Private::AtomicLoadRelaxed(&mBottom) - 1;
+    Private::AtomicStoreRelaxed(&mBottom, bottom);
+    Private::AtomicFence();   // the thieves must see that we took it before we read the top
+    long top = Private::AtomicLoadRelaxed(&mTop);
+    if (top > bottom)
+    {
+      Private::AtomicStoreRelaxed(&mBottom, bottom + 1);  // it was empty
+      return false;
+    }
+    Read(bottom, entry);
+    if (top == bottom)
+    {
+      // this is the last entry - we are racing with the thieves for it
+      const bool won = Private::AtomicCompareExchange(&mTop, top, top + 1);
+      Private::AtomicStoreRelaxed(&mBottom, bottom + 1);
+      return won;
+    }
+    return true;
+  }
+
+  // take the first entry that was pushed, this may fail if some other thread took it first
+  bool Steal(Entry& entry)
+  {
+    long top = Private::AtomicLoadAcquire(&mTop);
+    Private::AtomicFence();
+    const long bottom = Private::AtomicLoadAcquire(&mBottom);
+    if (top >= bottom)
+    {
+      return false;
+    }
+    Read(top, entry);
+    return Private::AtomicCompareExchange(&mTop, top, top + 1);
+  }
+
+  bool Empty() const
+  {
+    return Private::AtomicLoad(&mBottom) <= Private::AtomicLoad(&mTop);
+  }
+
+private:
+  struct Slot
+  {
+    task_func_t volatile Func;
+    void* volatile Context;
+    Group* volatile Owner;
+  };
+
+  void Read(long index, Entry& entry) const
+  {
+    const Slot& slot = mSlots[index & (DEQUE_SIZE - 1)];
+    entry.Func = Private::AtomicLoadRelaxed(&slot.Func);
+    entry.Context = Private::AtomicLoadRelaxed(&slot.Context);
+    entry.Owner = Private::AtomicLoadRelaxed(&slot.Owner);
+  }
+
+  volatile long mTop;
+  char mPadding[Private::CACHE_LINE_SIZE - sizeof(long)];   // the thieves are only changing the top
+  volatile long mBottom;
+  char mPadding2[Private::CACHE_LINE_SIZE - sizeof(long)];
+  Slot mSlots[DEQUE_SIZE];
+};
+
+struct Worker;
+
+namespace
+{
+
+void Execute(const Entry& entry)
+{
+  entry.Func(entry.Context);
+  if (entry.Owner)
+  {
+    // the group may be gone once the count is 0, but waking on its address is harmless
+    if (Private::AtomicFetchAdd(&entry.Owner->State, -GROUP_TASK) == GROUP_TASK + GROUP_WAITING)
+    {
+      Private::Futex::WakeAll(&entry.Owner->State);
+    }
+  }
+}
+
+// xorshift - this is only used to select the worker to steal from
+unsigned int NextRandom(unsigned int& seed)
+{
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed;
+}
+
+Mutex::Id* StartGuard()
+{
+  static Mutex::Id* guard = Mutex::Create();
+  return guard;
+}
+
+Worker* startingWorker = 0;         // pass the worker to the new thread, protected by StartGuard
+__thread Worker* currentWorker = 0; // the worker that is running in this thread (if any)
+__thread unsigned int helperSeed = 0;
+
+void WorkerThread();
+
+} // end of local namespace
+
+struct Id
+{
+  explicit Id(unsigned int workers) : mWorkers(workers, static_cast<Worker*>(0)), mInjectedCount(0), mStop(false),
+                                      mStarted(EventNotification::Create())
+  {
+  }
+
+  ~Id();
+
+  void Start(const Thread::Attributes& attr);
+
+  void Stop();
+
+  void Push(const Entry& entry);
+
+  void PushBatch(const Task tasks[], unsigned int count, Group* group);
+
+  // @return true if an entry was found, self is NULL if this is not a worker in this pool
+  bool FindWork(Worker* self, unsigned int& seed, Entry& entry);
+
+  bool HasWork() const;
+
+  void Run(Worker* self);
+
+  Worker* Current() const;
+
+  unsigned int Count() const
+  {
+    return static_cast<unsigned int>(mWorkers.size());
+  }
+
+private:
+  std::vector<Worker*> mWorkers;
+  Private::FutexLock mInjectedLock;
+  std::deque<Entry> mInjected;        // tasks from threads that are not workers
+  volatile int mInjectedCount;        // so that we would not lock to check whether it is empty
+  volatile bool mStop;
+  Private::EventCount mSleeping;
+  EventNotification::Id* mStarted;
+};
+
+struct Worker
+{
+  Worker(Id* pool, unsigned int index) : Pool(pool), Seed(index * 2654435761U + 1), Handle(0)
+  {
+  }
+
+  Id* const Pool;
+  unsigned int Seed;
+  Thread::Id* Handle;
+  WorkDeque Deque;
+};
+
+namespace
+{
+
+void WorkerThread()
+{
+  Worker* self = startingWorker;
+  currentWorker = self;
+  self->Pool->Run(self);
+}
+
+} // end of local namespace
+
+Id::~Id()
+{
+  for (std::vector<Worker*>::iterator i = mWorkers.begin(); i != mWorkers.end(); ++i)
+  {
+    delete *i;
+  }
+  EventNotification::Delete(mStarted);
+}
+
+void Id::Start(const Thread::Attributes& attr)
+{
+  Mutex::Lock(StartGuard());
+  for (unsigned int i = 0; i < mWorkers.size(); i++)
+  {
+    mWorkers[i] = new Worker(this, i);
+  }
+  for (unsigned int i = 0; i < mWorkers.size(); i++)
+  {
+    char name[MAX_NAME];
+    snprintf(name, sizeof(name), "%s%u", attr.Name ? attr.Name : Thread::DefaultName(), i);
+    startingWorker = mWorkers[i];
+    mWorkers[i]->Handle = Thread::Create(Thread::CreateAttribute(name, attr.StackSize, attr.Priority, attr.Affinity),
+                                         WorkerThread);
+    EventNotification::Wait(mStarted); // the worker would signal us when it is no longer need startingWorker
+  }
+  startingWorker = 0;
+  Mutex::Release(StartGuard());
+}
+
+void Id::Stop()
+{
+  Private::AtomicStore(&mStop, true);
+  mSleeping.Notify(true);
+  for (std::vector<Worker*>::iterator i = mWorkers.begin(); i != mWorkers.end(); ++i)
+  {
+    Thread::Clean((*i)->Handle);
+  }
+}
+
+Worker* Id::Current() const
+{
+  Worker* self = currentWorker;
+  return self && self->Pool == this ? self : 0;
+}
+
+void Id::Push(const Entry& entry)
+{
+  Worker* self = Current();
+  if (self)
+  {
+    if (!self->Deque.Push(entry))
+    {
+      Execute(entry);   // we have enough work as it is
+      return;
+    }
+  }
+  else
+  {
+    Private::CriticalSection<Private::FutexLock> guard(mInjectedLock);
+    mInjected.push_back(entry);
+    Private::AtomicFetchAdd(&mInjectedCount, 1);
+  }
+  mSleeping.Notify(false);
+}
+
+void Id::PushBatch(const Task tasks[], unsigned int count, Group* group)
+{
+  Worker* self = Current();
+  for (unsigned int i = 0; i < count; i++)
+  {
+    const Entry entry = { tasks[i].Func, tasks[i].Context, group };
+    if (self)
+    {
+      if (!self->Deque.Push(entry))
+      {
+        Execute(entry);
+      }
+    }
+    else
+    {
+      if (i == 0)
+      {
+        mInjectedLock.Take();
+      }
+      mInjected.push_back(entry);
+    }
+  }
+  if (!self && count > 0)
+  {
+    Private::AtomicFetchAdd(&mInjectedCount, static_cast<int>(count));
+    mInjectedLock.Give();
+  }
+  mSleeping.Notify(count > 1);
+}
+
+bool Id::FindWork(Worker* self, unsigned int& seed, Entry& entry)
+{
+  if (self && self->Deque.Take(entry))
+  {
+    return true;
+  }
+  if (Private::AtomicLoad(&mInjectedCount) > 0)
+  {
+    Private::CriticalSection<Private::FutexLock> guard(mInjectedLock);
+    if (!mInjected.empty())
+    {
+      entry = mInjected.front();
+      mInjected.pop_front();
+      Private::AtomicFetchAdd(&mInjectedCount, -1);
+      return true;
+    }
+  }
+  // start from a random worker, so that the thieves would not all go to the same one
+  const unsigned int count = Count();
+  const unsigned int start = NextRandom(seed) % count;
+  for (unsigned int i = 0; i < count; i++)
+  {
+    Worker* victim = mWorkers[(start + i) % count];
+    if (victim != self && victim->Deque.Steal(entry))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool Id::HasWork() const
+{
+  if (Private::AtomicLoad(&mInjectedCount) > 0)
+  {
+    return true;
+  }
+  for (std::vector<Worker*>::const_iterator i = mWorkers.begin(); i != mWorkers.end(); ++i)
+  {
+    if (!(*i)->Deque.Empty())
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+void Id::Run(Worker* self)
+{
+  EventNotification::Signal(mStarted);
+  Entry entry;
+  unsigned int idle = 0;
+  for (;;)
+  {
+    if (FindWork(self, self->Seed, entry))
+    {
+      Execute(entry);
+      idle = 0;
+    }
+    else if (++idle < SPIN_ROUNDS)
+    {
+      Private::CpuRelax();
+    }
+    else
+    {
+      // check again after we are registered as sleeping, so we would not miss a wakeup
+      const int ticket = mSleeping.PrepareWait();
+      if (HasWork())
+      {
+        mSleeping.CancelWait();
+      }
+      else if (Private::AtomicLoad(&mStop))
+      {
+        mSleeping.CancelWait();
+        return;   // all the work is done
+      }
+      else
+      {
+        mSleeping.Wait(ticket, 0);
+      }
+      idle = 0;
+    }
+  }
+}
+
+void RegisterAtExit(at_error_fun func)
+{
+  ErrorHandler().Push(func);
+}
+
+Id* Create(unsigned int workers, const Thread::Attributes& attr)
+{
+  if (workers == 0)
+  {
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    workers = cpus > 0 ? static_cast<unsigned int>(cpus) : 1;
+  }
+  std::auto_ptr<Id> id(new Id(workers));
+  id->Start(attr);
+  return id.release();
+}
+
+unsigned int Workers(Id* id)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid thread pool id");
+  return id->Count();
+}
+
+void Submit(Id* id, task_func_t func, void* context, Group* group)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid thread pool id");
+  OSAL_ASSERT_CONDITION(func, ErrorHandler(), "invalid task function");
+  if (group)
+  {
+    Private::AtomicFetchAdd(&group->State, static_cast<int>(GROUP_TASK));
+  }
+  const Entry entry = { func, context, group };
+  id->Push(entry);
+}
+
+void SubmitBatch(Id* id, const Task tasks[], unsigned int count, Group* group)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid thread pool id");
+  if (group)
+  {
+    Private::AtomicFetchAdd(&group->State, static_cast<int>(count) * GROUP_TASK);
+  }
+  id->PushBatch(tasks, count, group);
+}
+
+void Wait(Id* id, Group& group)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid thread pool id");
+  Worker* self = id->Current();
+  unsigned int& seed = self ? self->Seed : helperSeed;
+  if (seed == 0)
+  {
+    seed = static_cast<unsigned int>(Private::CurrentThreadId()) | 1;
+  }
+  Entry entry;
+  unsigned int idle = 0;
+  for (;;)
+  {
+    int current = Private::AtomicLoad(&group.State);
+    if (current < GROUP_TASK)
+    {
+      break;
+    }
+    if (id->FindWork(self, seed, entry))
+    {
+      Execute(entry);
+      idle = 0;
+    }
+    else if (++idle < SPIN_ROUNDS)
+    {
+      Private::CpuRelax();
+    }
+    else
+    {
+      // nothing to help with - the tasks of the group are running in the workers
+      if ((current & GROUP_WAITING) || Private::AtomicCompareExchange(&group.State, current, current | GROUP_WAITING))
+      {
+        Private::Futex::Wait(&group.State, current | GROUP_WAITING);
+      }
+      idle = 0;
+    }
+  }
+  int waiting = GROUP_WAITING;
+  Private::AtomicCompareExchange(&group.State, waiting, 0);
+}
+
+unsigned int Pending(const Group& group)
+{
+  return static_cast<unsigned int>(Private::AtomicLoad(&group.State)) / GROUP_TASK;
+}
+
+namespace
+{
+
+// ParallelFor split the range of parts recursively - each task run the lower half and submit the upper
+// half. Each index is the start of an upper half at most once, so it is used as the place to store it
+struct ForLoop;
+
+struct Span
+{
+  ForLoop* Loop;
+  unsigned int Low;
+  unsigned int High;
+};
+
+struct ForLoop
+{
+  Id* Pool;
+  Group Tasks;
+  range_func_t Func;
+  void* Context;
+  unsigned int Begin;
+  unsigned int End;
+  unsigned int Grain;
+  std::vector<Span> Spans;
+};
+
+void RunSpan(void* context)
+{
+  Span* span = static_cast<Span*>(context);
+  ForLoop* loop = span->Loop;
+  const unsigned int low = span->Low;
+  unsigned int high = span->High;
+  while (high - low > 1)
+  {
+    const unsigned int middle = low + (high - low) / 2;
+    Span& upper = loop->Spans[middle];
+    upper.Loop = loop;
+    upper.Low = middle;
+    upper.High = high;
+    Submit(loop->Pool, RunSpan, &upper, &loop->Tasks);
+    high = middle;
+  }
+  const unsigned long long begin = loop->Begin + static_cast<unsigned long long>(low) * loop->Grain;
+  const unsigned long long end = begin + loop->Grain;
+  loop->Func(static_cast<unsigned int>(begin), end < loop->End ? static_cast<unsigned int>(end) : loop->End,
+             loop->Context);
+}
+
+} // end of local namespace
+
+void ParallelFor(Id* id, unsigned int begin, unsigned int end, unsigned int grain, range_func_t func, void* context)
+{
+  OSAL_ASSERT_CONDITION(id, ErrorHandler(), "invalid thread pool id");
+  OSAL_ASSERT_CONDITION(func, ErrorHandler(), "invalid range function");
+  if (end <= begin)
+  {
+    return;
+  }
+  const unsigned int size = end - begin;
+  if (grain == 0)
+  {
+    grain = size / (id->Count() * 8);
+    grain = grain ? grain : 1;
+  }
+  const unsigned int parts = size / grain + (size % grain ? 1 : 0);
+  if (parts == 1)
+  {
+    func(begin, end, context);
+    return;
+  }
+  ForLoop loop;
+  loop.Pool = id;
+  loop.Func = func;
+  loop.Context = context;
+  loop.Begin = begin;
+  loop.End = end;
+  loop.Grain = grain;
+  loop.Spans.resize(parts);
+  Span& all = loop.Spans[0];
+  all.Loop = &loop;
+  all.Low = 0;
+  all.High = parts;
+  RunSpan(&all);
+  Wait(id, loop.Tasks);
+}
+
+void Delete(Id*& id)
+{
+  if (id)
+  {
+    OSAL_ASSERT_CONDITION(!id->Current(), ErrorHandler(), "the pool cannot be deleted from its own worker");
+    id->Stop();
+    delete id;
+    id = 0;
+  }
+}
+
+} // end of namespace ThreadPool
+
+} // end of namespace osal
+
+#else
+# error "you must not include this file inside header file"
+#endif  // THREAD_POOL_POSIX__HPP
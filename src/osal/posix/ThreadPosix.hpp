@@ -1 +1,578 @@
-#error "posix thread is not supported yet"
+#ifndef THREADPOSIX__HPP
+#define THREADPOSIX__HPP
+// Linux implementation for threads - this is using pthread directly.
+// The priorities are mapped to real time scheduling (SCHED_FIFO by default, you
+// can change it by defining OSAL_THREAD_RT_POLICY to SCHED_RR) as long as the process
+// have the permission to use it. Once we found that we are not allowed to use it
+// the priorities are mapped to nice levels instead
+
+#include "osal/Thread.h"          // the interface for this implementation
+#include "Futex.h"                // to wait for the new thread to start
+#include "CriticalSection.h"      // to guard the error handling functions
+#include "ExitFunctionHolder.h"   // to define the list of error handling functions
+#include <pthread.h>              // pthread API
+#include <sched.h>                // sched_param, sched_yield, cpu_set_t
+#include <sys/resource.h>         // setpriority
+#include <unistd.h>               // sysconf
+#include <limits.h>               // PTHREAD_STACK_MIN
+#include <errno.h>                // errno values
+#include <time.h>                 // nanosleep
+#include <string.h>               // strcmp, strncpy
+#include <assert.h>               // assert macro
+#include <string>                 // to save the thread name
+
+#ifndef OSAL_THREAD_RT_POLICY
+# define OSAL_THREAD_RT_POLICY SCHED_FIFO
+#endif  // OSAL_THREAD_RT_POLICY
+
+namespace osal
+{
+
+namespace Thread
+{
+
+namespace
+{
+
+const PriorityType DEFAULT_PRIORITY = INVALID_PRIORITY;
+const int LOWEST_NICE = 19;
+const int HIGHEST_NICE = -20;
+const size_t MAX_OS_NAME = 16;  // this is including the terminating null
+
+// we are only trying to use real time priorities until the first time we get EPERM
+volatile int realTimeAllowed = 1;
+
+Private::ExitFunctionHolder& ExitFunctionsThreadList()
+{
+	static Private::ExitFunctionHolder exitFunctions;
+	return exitFunctions;
+}
+
+// PRIORITY_1 is the highest so it is mapped to the highest real time priority
+int ToRealTimePriority(PriorityType prio)
+{
+  static const int minPrio = sched_get_priority_min(OSAL_THREAD_RT_POLICY);
+  static const int maxPrio = sched_get_priority_max(OSAL_THREAD_RT_POLICY);
+  return maxPrio - (static_cast<int>(prio) * (maxPrio - minPrio)) / (LOWSET_PRIORITY - 1);
+}
+
+PriorityType FromRealTimePriority(int prio)
+{
+  static const int minPrio = sched_get_priority_min(OSAL_THREAD_RT_POLICY);
+  static const int maxPrio = sched_get_priority_max(OSAL_THREAD_RT_POLICY);
+  if (maxPrio == minPrio)
+  {
+    return INVALID_PRIORITY;
+  }
+  return static_cast<PriorityType>(((maxPrio - prio) * (LOWSET_PRIORITY - 1)) / (maxPrio - minPrio));
+}
+
+int ToNiceLevel(PriorityType prio)
+{
+  return HIGHEST_NICE + (static_cast<int>(prio) * (LOWEST_NICE - HIGHEST_NICE)) / (LOWSET_PRIORITY - 1);
+}
+
+size_t StackSize(unsigned int requested)
+{
+  // the stack sizes that are good for VxWorks are too small for Linux (glibc need more than that)
+  static const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  size_t size = requested;
+  if (size < DefaultStackSize())
+  {
+    size = DefaultStackSize();
+  }
+  if (size < static_cast<size_t>(PTHREAD_STACK_MIN))
+  {
+    size = PTHREAD_STACK_MIN;
+  }
+  return ((size + pageSize - 1) / pageSize) * pageSize;
+}
+
+void ToOSCpuSet(const CpuSet& from, cpu_set_t& to)
+{
+  CPU_ZERO(&to);
+  for (unsigned int cpu = 0; cpu < CpuSet::MAX_CPUS && cpu < CPU_SETSIZE; cpu++)
+  {
+    if (from.IsSet(cpu))
+    {
+      CPU_SET(cpu, &to);
+    }
+  }
+}
+
+// when we cannot use real time priority, use nice level, note that nice level is per
+// thread under Linux. if we are not allowed to raise the priority, we would just keep the current one
+void SetNiceLevel(pid_t kernelId, PriorityType prio)
+{
+  if (setpriority(PRIO_PROCESS, kernelId, ToNiceLevel(prio)) != 0 && errno != EACCES && errno != EPERM)
+  {
+    ExitFunctionsThreadList().CriticalError(errno, "setpriority", __LINE__);
+  }
+}
+
+// @return true if the priority was set as real time priority
+bool SetRealTimePriority(pthread_t handle, PriorityType prio)
+{
+  if (Private::AtomicLoad(&realTimeAllowed))
+  {
+    sched_param param;
+    param.sched_priority = ToRealTimePriority(prio);
+    int err = pthread_setschedparam(handle, OSAL_THREAD_RT_POLICY, &param);
+    if (err == 0)
+    {
+      return true;
+    }
+    else if (err != EPERM)
+    {
+      ExitFunctionsThreadList().CriticalError(err, "pthread_setschedparam", __LINE__);
+    }
+    Private::AtomicStore(&realTimeAllowed, 0);
+  }
+  return false;
+}
+
+}	// end of local namespace
+
+///////////////////////////////////////////////////////////////////////////////
+// the id is shared between the thread that created it and the thread itself so
+// it is reference counted - the thread release it when it exit (even if canceled)
+struct Id
+{
+  // for thread that we are creating
+  Id(const Attributes& attr, entry_func_t entry) : mName(attr.Name ? attr.Name : DefaultName()),
+                                                   mPriority(attr.Priority), mEntry(entry),
+                                                   mKernelId(0), mRefs(2), mJoinable(1),
+                                                   mRealTime(false)
+  {
+  }
+
+  // for thread that was not created by us (such as the main thread)
+  Id(pthread_t handle, const char* name, PriorityType prio) : mHandle(handle), mName(name),
+                                                              mPriority(prio), mEntry(0),
+                                                              mKernelId(Private::CurrentThreadId()),
+                                                              mRefs(1), mJoinable(0),
+                                                              mRealTime(false)
+  {
+  }
+
+  void AddRef()
+  {
+    Private::AtomicFetchAdd(&mRefs, 1);
+  }
+
+  static void Release(Id* id)
+  {
+    if (Private::AtomicFetchAdd(&id->mRefs, -1) == 1)
+    {
+      delete id;
+    }
+  }
+
+  // @return true only for the first one calling this (so we would only join the thread once)
+  bool ClaimJoin()
+  {
+    return Private::AtomicExchange(&mJoinable, 0) == 1;
+  }
+
+  pthread_t     mHandle;
+  std::string   mName;
+  PriorityType  mPriority;  // the priority as the user gave it (this is not the OS priority)
+  entry_func_t  mEntry;
+  volatile int  mKernelId;  // 0 until the thread is running
+  volatile int  mRefs;
+  volatile int  mJoinable;
+  bool          mRealTime;  // false if we need to use nice level for the priority
+};
+
+namespace
+{
+
+// the id of the current thread if it was created by us
+__thread Id* currentThread = 0;
+
+// make sure that we would release the reference for the id even if the thread was canceled
+struct ReleaseAtExit
+{
+  explicit ReleaseAtExit(Id* id) : mId(id)
+  {
+  }
+
+  ~ReleaseAtExit()
+  {
+    currentThread = 0;
+    Id::Release(mId);
+  }
+
+  Id* mId;
+};
+
+extern "C" void* StartThread(void* arg)
+{
+  Id* self = static_cast<Id*>(arg);
+  ReleaseAtExit guard(self);
+  currentThread = self;
+  char osName[MAX_OS_NAME];
+  strncpy(osName, self->mName.c_str(), MAX_OS_NAME - 1);
+  osName[MAX_OS_NAME - 1] = '\0';
+  pthread_setname_np(pthread_self(), osName);
+  if (self->mPriority != INVALID_PRIORITY && !self->mRealTime)
+  {
+    SetNiceLevel(0, self->mPriority);
+  }
+  // from this point the creator can return the id to the user
+  Private::AtomicStore(&self->mKernelId, Private::CurrentThreadId());
+  Private::Futex::WakeAll(&self->mKernelId);
+  self->mEntry();
+  return 0;
+}
+
+// @return the error code from pthread_create
+int StartWith(Id* id, const Attributes& attr, bool realTime)
+{
+  pthread_attr_t osAttr;
+  pthread_attr_init(&osAttr);
+  pthread_attr_setstacksize(&osAttr, StackSize(attr.StackSize));
+  if (realTime)
+  {
+    sched_param param;
+    param.sched_priority = ToRealTimePriority(attr.Priority);
+    pthread_attr_setinheritsched(&osAttr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&osAttr, OSAL_THREAD_RT_POLICY);
+    pthread_attr_setschedparam(&osAttr, &param);
+  }
+  if (!attr.Affinity.Empty())
+  {
+    cpu_set_t cpus;
+    ToOSCpuSet(attr.Affinity, cpus);
+    pthread_attr_setaffinity_np(&osAttr, sizeof(cpus), &cpus);
+  }
+  id->mRealTime = realTime;
+  int err = pthread_create(&id->mHandle, &osAttr, StartThread, id);
+  pthread_attr_destroy(&osAttr);
+  return err;
+}
+
+// @return the error code from the join (ETIMEDOUT if the deadline passed). the same as
+// Futex::WaitUntil, for precise deadline we are spinning on the last part of the wait
+int JoinUntil(pthread_t handle, const Private::Deadline& deadline)
+{
+  if (!deadline.Precise())
+  {
+    return pthread_timedjoin_np(handle, 0, deadline.Get());
+  }
+  timespec park;
+  if (deadline.ParkUntil(park))
+  {
+    int err = pthread_timedjoin_np(handle, 0, &park);
+    if (err != ETIMEDOUT)
+    {
+      return err;
+    }
+  }
+  for (;;)
+  {
+    int err = pthread_tryjoin_np(handle, 0);
+    if (err != EBUSY)
+    {
+      return err;
+    }
+    if (deadline.Passed())
+    {
+      return ETIMEDOUT;
+    }
+    Private::CpuRelax();
+  }
+}
+
+// @param deadline must be using CLOCK_REALTIME - this is what pthread_timedjoin_np expect
+bool Cleaning(Id*& id, const Private::Deadline& deadline)
+{
+  bool ret = true;
+  if (id)
+  {
+    if (!pthread_equal(id->mHandle, pthread_self()) && id->ClaimJoin())
+    {
+      int err = JoinUntil(id->mHandle, deadline);
+      if (err == ETIMEDOUT)
+      {
+        // the thread would exit at the next cancellation point, we cannot wait for it anymore
+        pthread_cancel(id->mHandle);
+        pthread_detach(id->mHandle);
+        ret = false;
+      }
+      else if (err)
+      {
+        ExitFunctionsThreadList().CriticalError(err, "TimeClean", __LINE__);
+        return false;
+      }
+    }
+    Id::Release(id);
+    id = 0;
+  }
+  return ret;
+}
+
+}	// end of local namespace
+
+///////////////////////////////////////////////////////////////////////////////
+
+Attributes::Attributes() : Name(DefaultName()), StackSize(DefaultStackSize()), Priority(DEFAULT_PRIORITY)
+{
+}
+
+Attributes::Attributes(const char* name, unsigned int stackSize, PriorityType prio) :
+                            Name(name), StackSize(stackSize), Priority(prio)
+{
+}
+
+Attributes::Attributes(const char* name, unsigned int stackSize, PriorityType prio, const CpuSet& affinity) :
+                            Name(name), StackSize(stackSize), Priority(prio), Affinity(affinity)
+{
+}
+
+Attributes CreateAttribute(const char* name, unsigned int sSize, PriorityType pt)
+{
+  return Attributes(name, sSize, pt);
+}
+
+Attributes CreateAttribute(const char* name, unsigned int sSize, PriorityType pt, const CpuSet& affinity)
+{
+  return Attributes(name, sSize, pt, affinity);
+}
+
+void RegisterAtExit(at_error_fun func)
+{
+	ExitFunctionsThreadList().Push(func);
+}
+
+bool EqualsId(Id* left, Id* right)
+{
+	return ((left == 0) && (right == 0)) ||
+	       (left && right && pthread_equal(left->mHandle, right->mHandle));
+}
+
+Id* Create(const Attributes& attr, entry_func_t entryFunc)
+{
+  Id* id = new Id(attr, entryFunc);
+  bool realTime = attr.Priority != INVALID_PRIORITY && Private::AtomicLoad(&realTimeAllowed);
+  int err = StartWith(id, attr, realTime);
+  if (err == EPERM && realTime)
+  {
+    Private::AtomicStore(&realTimeAllowed, 0);  // don't try this again
+    err = StartWith(id, attr, false);
+  }
+  if (err != 0)
+  {
+    delete id;
+    ExitFunctionsThreadList().CriticalError(err, __FUNCTION__, __LINE__);
+    return 0; 	// this is just so we would not have warning, it should not return with this NULL!!
+  }
+  // wait for the thread to start so it would have its name and priority set
+  while (Private::AtomicLoad(&id->mKernelId) == 0)
+  {
+    Private::Futex::Wait(&id->mKernelId, 0);
+  }
+  return id;
+}
+
+PriorityType Priority(Id* to)
+{
+	assert(to);
+	return to->mPriority;
+}
+
+void NewPriority(Id* to, PriorityType newPrio)
+{
+  assert(to);
+	// do set a new priority if the one pass to this function is is invalid!
+	if (newPrio != INVALID_PRIORITY)
+	{
+	  to->mRealTime = SetRealTimePriority(to->mHandle, newPrio);
+	  if (!to->mRealTime)
+	  {
+	    SetNiceLevel(to->mKernelId, newPrio);
+	  }
+	  to->mPriority = newPrio;
+	}
+}
+
+bool NewAffinity(Id* to, const CpuSet& cpus)
+{
+  assert(to);
+  cpu_set_t osCpus;
+  if (cpus.Empty())
+  {
+    CPU_ZERO(&osCpus);
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    {
+      CPU_SET(cpu, &osCpus);
+    }
+  }
+  else
+  {
+    ToOSCpuSet(cpus, osCpus);
+  }
+  return pthread_setaffinity_np(to->mHandle, sizeof(osCpus), &osCpus) == 0;
+}
+
+bool Affinity(Id* of, CpuSet& cpus)
+{
+  assert(of);
+  cpus.Reset();
+  cpu_set_t osCpus;
+  if (pthread_getaffinity_np(of->mHandle, sizeof(osCpus), &osCpus) != 0)
+  {
+    return false;
+  }
+  for (unsigned int cpu = 0; cpu < CpuSet::MAX_CPUS && cpu < CPU_SETSIZE; cpu++)
+  {
+    if (CPU_ISSET(cpu, &osCpus))
+    {
+      cpus.Set(cpu);
+    }
+  }
+  return true;
+}
+
+const char* Name(Id* id)
+{
+	assert(id);
+	return id->mName.c_str();
+}
+
+bool Clean(Id*& id)
+{
+	if (id)
+	{
+	  // we cannot wait for ourself, or for thread that we didn't create, so just release the resources
+	  if (!pthread_equal(id->mHandle, pthread_self()) && id->ClaimJoin())
+	  {
+	    int err = pthread_join(id->mHandle, 0);
+	    if (err)
+	    {
+	      ExitFunctionsThreadList().CriticalError(err, __FUNCTION__, __LINE__);
+	      return false;
+	    }
+	  }
+	  Id::Release(id);
+	  id = 0;
+	}
+	return true;
+}
+
+bool TimeClean(Id*& id, milliseconds_t milliDuration)
+{
+  return Cleaning(id, Private::Deadline(milliDuration, CLOCK_REALTIME));
+}
+
+bool TimeClean(Id*& id, const Duration& duration)
+{
+  return Cleaning(id, Private::Deadline(duration, CLOCK_REALTIME));
+}
+
+
+namespace Self
+{
+
+Thread::Id* Id()
+{
+  if (currentThread)
+  {
+    currentThread->AddRef();
+    return currentThread;
+  }
+  else
+  {
+    return new Thread::Id(pthread_self(), Name(), Priority());
+  }
+}
+
+milliseconds_t Sleep(milliseconds_t milliDuration)
+{
+  timespec remain;
+  remain.tv_sec = milliDuration / 1000;
+  remain.tv_nsec = static_cast<long>(milliDuration % 1000) * 1000000L;
+  while (nanosleep(&remain, &remain) != 0 && errno == EINTR)
+  {
+  }
+  return milliDuration;
+}
+
+void Suspend()
+{
+	sched_yield();
+}
+
+const char* Name()
+{
+  if (currentThread)
+  {
+    return currentThread->mName.c_str();
+  }
+  else
+  {
+    static __thread char name[MAX_OS_NAME];
+    if (pthread_getname_np(pthread_self(), name, sizeof(name)) != 0)
+    {
+      return DefaultName();
+    }
+    return name;
+  }
+}
+
+Thread::PriorityType Priority()
+{
+  if (currentThread)
+  {
+    return currentThread->mPriority;
+  }
+  else
+  {
+    // this thread was not created by us, so we only know the priority if it is using real time scheduling
+    int policy = SCHED_OTHER;
+    sched_param param;
+    if (pthread_getschedparam(pthread_self(), &policy, &param) == 0 && policy == OSAL_THREAD_RT_POLICY)
+    {
+      return FromRealTimePriority(param.sched_priority);
+    }
+    return INVALID_PRIORITY;
+  }
+}
+
+void NewPriority(Thread::PriorityType newPrio)
+{
+  if (currentThread)
+  {
+    Thread::NewPriority(currentThread, newPrio);
+  }
+  else if (newPrio != INVALID_PRIORITY && !SetRealTimePriority(pthread_self(), newPrio))
+  {
+    SetNiceLevel(0, newPrio);
+  }
+}
+
+bool NewAffinity(const CpuSet& cpus)
+{
+  Thread::Id self(pthread_self(), "", INVALID_PRIORITY);
+  return Thread::NewAffinity(&self, cpus);
+}
+
+bool Equel(const Thread::Id* other)
+{
+  return other != 0 && pthread_equal(other->mHandle, pthread_self());
+}
+
+bool EqualName(const char* expectName)
+{
+  return strcmp(expectName, Thread::Self::Name()) == 0;
+}
+
+}	// end of namespace Self
+
+} // end of namespace thread
+
+} // end of namespace osal
+
+#else
+#	error "you cannot include this file inside header file"
+#endif	// THREADPOSIX__HPP
@@ -0,0 +1,481 @@
+#ifndef TOPOLOGY_POSIX__HPP
+#define TOPOLOGY_POSIX__HPP
+// Linux implementation for the machine topology. Everything is read once from sysfs -
+// devices/system/cpu/online for the CPUs, cpuN/topology for the cores and packages,
+// cpuN/cache/indexK for the caches that are shared and devices/system/node for the NUMA nodes.
+// The placement order for Spread and Compact is calculated when the topology is loaded, so
+// the placement functions are only looking at a table. When this machine is loaded the orders
+// only have the CPUs that the process is allowed to run on (sched_getaffinity).
+
+#include "osal/Topology.h"          // the interface for this implementation
+#include <sched.h>                  // sched_getcpu, sched_getaffinity
+#include <unistd.h>                 // getpid
+#include <stdio.h>                  // fopen, snprintf
+#include <stdlib.h>                 // strtoul
+#include <string.h>                 // strcspn
+#include <string>                   // the paths
+#include <vector>                   // the CPUs
+#include <algorithm>                // sort
+
+namespace osal
+{
+
+namespace Topology
+{
+
+namespace
+{
+
+const unsigned int UNKNOWN = ~0u;
+const int ALL = -1;     // for Rank - all the CPUs are in the same parent
+const int SELF = -2;    // for Rank - the CPU number itself
+
+// @return false if the file can't be read, else line is its first line (without the new line)
+bool ReadLine(const std::string& path, std::string& line)
+{
+  FILE* file = fopen(path.c_str(), "r");
+  if (!file)
+  {
+    return false;
+  }
+  char buffer[1024];
+  const bool ok = fgets(buffer, sizeof(buffer), file) != 0;
+  fclose(file);
+  if (ok)
+  {
+    buffer[strcspn(buffer, "\n")] = '\0';
+    line = buffer;
+  }
+  return ok;
+}
+
+bool ReadNumber(const std::string& path, unsigned int& value)
+{
+  std::string line;
+  if (!ReadLine(path, line) || line.empty() || line[0] == '-')  // the package is -1 when it is not known
+  {
+    return false;
+  }
+  value = (unsigned int)strtoul(line.c_str(), 0, 10);
+  return true;
+}
+
+// parse a list such as "0-3,8,10-11"
+// @return the lowest number in the list, UNKNOWN if the list is empty
+unsigned int ParseList(const std::string& list, Thread::CpuSet& numbers)
+{
+  numbers.Reset();
+  unsigned int lowest = UNKNOWN;
+  const char* at = list.c_str();
+  while (*at >= '0' && *at <= '9')
+  {
+    char* end = 0;
+    const unsigned int first = (unsigned int)strtoul(at, &end, 10);
+    unsigned int last = first;
+    if (*end == '-')
+    {
+      last = (unsigned int)strtoul(end + 1, &end, 10);
+    }
+    for (unsigned int i = first; i <= last && i < Thread::CpuSet::MAX_CPUS; i++)
+    {
+      numbers.Set(i);
+    }
+    lowest = std::min(lowest, first);
+    at = *end == ',' ? end + 1 : end;
+  }
+  return lowest;
+}
+
+unsigned int ReadList(const std::string& path, Thread::CpuSet& numbers)
+{
+  std::string line;
+  if (!ReadLine(path, line))
+  {
+    numbers.Reset();
+    return UNKNOWN;
+  }
+  return ParseList(line, numbers);
+}
+
+std::string Number(unsigned int value)
+{
+  char buffer[16];
+  snprintf(buffer, sizeof(buffer), "%u", value);
+  return buffer;
+}
+
+unsigned int Field(const Cpu& cpu, int level)
+{
+  switch (level)
+  {
+    case SELF:
+      return cpu.Id;
+    case CORE:
+      return cpu.Core;
+    case L2_CACHE:
+      return cpu.L2;
+    case L3_CACHE:
+      return cpu.L3;
+    case NUMA_NODE:
+      return cpu.Node;
+    default:
+      return cpu.Package;
+  }
+}
+
+// order the CPUs so that the closest ones are next to each other
+struct CompactLess
+{
+  explicit CompactLess(const std::vector<Cpu>& cpus) : mCpus(cpus)
+  {
+  }
+
+  bool operator () (unsigned int left, unsigned int right) const
+  {
+    const Cpu& l = mCpus[left];
+    const Cpu& r = mCpus[right];
+    const unsigned int lKey[] = { l.Node, l.Package, l.L3, l.L2, l.Core, l.Id };
+    const unsigned int rKey[] = { r.Node, r.Package, r.L3, r.L2, r.Core, r.Id };
+    return std::lexicographical_compare(lKey, lKey + 6, rKey, rKey + 6);
+  }
+
+  const std::vector<Cpu>& mCpus;
+};
+
+// the place of the CPU in each level, the levels that change the slowest are first
+struct SpreadKey
+{
+  unsigned int Key[6];  // sibling in the core, core in the L2, L2 in the L3, L3 in the node, node, CPU
+
+  bool operator < (const SpreadKey& other) const
+  {
+    return std::lexicographical_compare(Key, Key + 6, other.Key, other.Key + 6);
+  }
+};
+
+// @return the CPUs that the thread (or the process for 0) is allowed to run on, empty if not known
+Thread::CpuSet Allowed(pid_t of)
+{
+  Thread::CpuSet allowed;
+  cpu_set_t osCpus;
+  if (sched_getaffinity(of, sizeof(osCpus), &osCpus) == 0)
+  {
+    for (unsigned int cpu = 0; cpu < Thread::CpuSet::MAX_CPUS && cpu < CPU_SETSIZE; cpu++)
+    {
+      if (CPU_ISSET(cpu, &osCpus))
+      {
+        allowed.Set(cpu);
+      }
+    }
+  }
+  return allowed;
+}
+
+struct Machine
+{
+  explicit Machine(const char* root)
+  {
+    Load(root, Allowed(getpid()));
+  }
+
+  // @param allowed the placement orders would only have these CPUs (all of them if it is empty)
+  bool Load(const std::string& root, const Thread::CpuSet& allowed);
+
+  const Cpu* Find(unsigned int id) const
+  {
+    for (std::vector<Cpu>::const_iterator cpu = Cpus.begin(); cpu != Cpus.end(); ++cpu)
+    {
+      if (cpu->Id == id)
+      {
+        return &*cpu;
+      }
+    }
+    return 0;
+  }
+
+  // @return the number of different values that the child has, that are lower than the one the
+  // given CPU has, among the CPUs that are in the same parent
+  unsigned int Rank(const Cpu& cpu, int parent, int child) const
+  {
+    std::vector<unsigned int> values;
+    for (std::vector<Cpu>::const_iterator other = Cpus.begin(); other != Cpus.end(); ++other)
+    {
+      if ((parent == ALL || Field(*other, parent) == Field(cpu, parent)) &&
+          Field(*other, child) < Field(cpu, child))
+      {
+        values.push_back(Field(*other, child));
+      }
+    }
+    std::sort(values.begin(), values.end());
+    return (unsigned int)(std::unique(values.begin(), values.end()) - values.begin());
+  }
+
+  std::vector<Cpu> Cpus;
+  std::vector<unsigned int> CompactOrder;   // the CPUs numbers
+  std::vector<unsigned int> SpreadOrder;
+};
+
+bool Machine::Load(const std::string& root, const Thread::CpuSet& allowed)
+{
+  Cpus.clear();
+  CompactOrder.clear();
+  SpreadOrder.clear();
+  const std::string cpusDir = root + "/devices/system/cpu/";
+  Thread::CpuSet online;
+  if (ReadList(cpusDir + "online", online) == UNKNOWN)
+  {
+    return false;
+  }
+  Thread::CpuSet members;
+  for (unsigned int id = 0; id < Thread::CpuSet::MAX_CPUS; id++)
+  {
+    if (!online.IsSet(id))
+    {
+      continue;
+    }
+    const std::string dir = cpusDir + "cpu" + Number(id) + "/";
+    Cpu cpu = { id, id, UNKNOWN, UNKNOWN, 0, 0 };
+    const unsigned int core = ReadList(dir + "topology/thread_siblings_list", members);
+    if (core != UNKNOWN)
+    {
+      cpu.Core = core;
+    }
+    ReadNumber(dir + "topology/physical_package_id", cpu.Package);
+    for (unsigned int index = 0;; index++)
+    {
+      const std::string cache = dir + "cache/index" + Number(index) + "/";
+      unsigned int level = 0;
+      std::string type;
+      if (!ReadNumber(cache + "level", level))
+      {
+        break;
+      }
+      if (ReadLine(cache + "type", type) && type == "Instruction")
+      {
+        continue;
+      }
+      const unsigned int shared = ReadList(cache + "shared_cpu_list", members);
+      if (level == 2)
+      {
+        cpu.L2 = shared;
+      }
+      else if (level == 3)
+      {
+        cpu.L3 = shared;
+      }
+    }
+    Cpus.push_back(cpu);
+  }
+  // the NUMA nodes list the CPUs that belong to them
+  const std::string nodesDir = root + "/devices/system/node/";
+  Thread::CpuSet nodes;
+  ReadList(nodesDir + "online", nodes);
+  for (unsigned int node = 0; node < Thread::CpuSet::MAX_CPUS; node++)
+  {
+    if (nodes.IsSet(node) && ReadList(nodesDir + "node" + Number(node) + "/cpulist", members) != UNKNOWN)
+    {
+      for (std::vector<Cpu>::iterator cpu = Cpus.begin(); cpu != Cpus.end(); ++cpu)
+      {
+        if (members.IsSet(cpu->Id))
+        {
+          cpu->Node = node;
+        }
+      }
+    }
+  }
+  // the package is identified by its first CPU (like the other levels), and the caches that are
+  // not reported are taken from the level above them
+  std::vector<unsigned int> packages(Cpus.size());
+  for (unsigned int i = 0; i < Cpus.size(); i++)
+  {
+    packages[i] = Cpus[i].Id;
+    for (unsigned int j = 0; j < i; j++)
+    {
+      if (Cpus[j].Package == Cpus[i].Package)
+      {
+        packages[i] = packages[j];
+        break;
+      }
+    }
+  }
+  for (unsigned int i = 0; i < Cpus.size(); i++)
+  {
+    Cpus[i].Package = packages[i];
+    if (Cpus[i].L2 == UNKNOWN)
+    {
+      Cpus[i].L2 = Cpus[i].Core;
+    }
+    if (Cpus[i].L3 == UNKNOWN)
+    {
+      Cpus[i].L3 = Cpus[i].Package;
+    }
+  }
+  // and the placement orders
+  std::vector<unsigned int> indexes;
+  std::vector<std::pair<SpreadKey, unsigned int> > spread;
+  for (unsigned int i = 0; i < Cpus.size(); i++)
+  {
+    indexes.push_back(i);
+    const SpreadKey key = { { Rank(Cpus[i], CORE, SELF), Rank(Cpus[i], L2_CACHE, CORE), Rank(Cpus[i], L3_CACHE, L2_CACHE),
+                              Rank(Cpus[i], NUMA_NODE, L3_CACHE), Rank(Cpus[i], ALL, NUMA_NODE), Cpus[i].Id } };
+    spread.push_back(std::make_pair(key, Cpus[i].Id));
+  }
+  std::sort(indexes.begin(), indexes.end(), CompactLess(Cpus));
+  std::sort(spread.begin(), spread.end());
+  // the ranks are calculated for the whole machine, so the order of the allowed CPUs would
+  // still be the same - we only skip the ones we can't run on. If none of the CPUs is allowed
+  // (the mask is for another machine) we keep all of them
+  bool any = false;
+  for (unsigned int i = 0; i < Cpus.size(); i++)
+  {
+    any = any || allowed.IsSet(Cpus[i].Id);
+  }
+  for (unsigned int i = 0; i < indexes.size(); i++)
+  {
+    if (!any || allowed.IsSet(Cpus[indexes[i]].Id))
+    {
+      CompactOrder.push_back(Cpus[indexes[i]].Id);
+    }
+  }
+  for (unsigned int i = 0; i < spread.size(); i++)
+  {
+    if (!any || allowed.IsSet(spread[i].second))
+    {
+      SpreadOrder.push_back(spread[i].second);
+    }
+  }
+  return !Cpus.empty();
+}
+
+Machine& TheMachine()
+{
+  static Machine machine("/sys");
+  return machine;
+}
+
+Thread::CpuSet Single(const std::vector<unsigned int>& order, unsigned int index)
+{
+  Thread::CpuSet cpus;
+  if (!order.empty())
+  {
+    cpus.Set(order[index % order.size()]);
+  }
+  return cpus;
+}
+
+} // end of local namespace
+
+unsigned int Count()
+{
+  return (unsigned int)TheMachine().Cpus.size();
+}
+
+bool At(unsigned int index, Cpu& info)
+{
+  const Machine& machine = TheMachine();
+  if (index >= machine.Cpus.size())
+  {
+    return false;
+  }
+  info = machine.Cpus[index];
+  return true;
+}
+
+bool Find(unsigned int cpu, Cpu& info)
+{
+  const Cpu* found = TheMachine().Find(cpu);
+  if (found)
+  {
+    info = *found;
+  }
+  return found != 0;
+}
+
+unsigned int Current()
+{
+  const int cpu = sched_getcpu();
+  return cpu < 0 ? Count() : (unsigned int)cpu;
+}
+
+Thread::CpuSet Domain(unsigned int cpu, Level level)
+{
+  const Machine& machine = TheMachine();
+  Thread::CpuSet cpus;
+  const Cpu* of = machine.Find(cpu);
+  if (of)
+  {
+    for (std::vector<Cpu>::const_iterator other = machine.Cpus.begin(); other != machine.Cpus.end(); ++other)
+    {
+      if (Field(*other, level) == Field(*of, level))
+      {
+        cpus.Set(other->Id);
+      }
+    }
+  }
+  return cpus;
+}
+
+Thread::CpuSet Spread(unsigned int index)
+{
+  return Single(TheMachine().SpreadOrder, index);
+}
+
+Thread::CpuSet Compact(unsigned int index)
+{
+  return Single(TheMachine().CompactOrder, index);
+}
+
+Thread::CpuSet Near(Thread::Id* thread, Level level)
+{
+  const Machine& machine = TheMachine();
+  Thread::CpuSet bound;
+  if (thread)
+  {
+    Thread::Affinity(thread, bound);
+  }
+  else
+  {
+    bound = Allowed(0);
+  }
+  bool all = true;
+  for (std::vector<Cpu>::const_iterator cpu = machine.Cpus.begin(); cpu != machine.Cpus.end(); ++cpu)
+  {
+    all = all && bound.IsSet(cpu->Id);
+  }
+  if (all)
+  {
+    // the thread can run anywhere - we only know where the calling thread is running now
+    return thread ? Thread::CpuSet() : Domain(Current(), level);
+  }
+  Thread::CpuSet cpus;
+  for (std::vector<Cpu>::const_iterator cpu = machine.Cpus.begin(); cpu != machine.Cpus.end(); ++cpu)
+  {
+    if (bound.IsSet(cpu->Id))
+    {
+      const Thread::CpuSet domain = Domain(cpu->Id, level);
+      for (std::vector<Cpu>::const_iterator other = machine.Cpus.begin(); other != machine.Cpus.end(); ++other)
+      {
+        if (domain.IsSet(other->Id))
+        {
+          cpus.Set(other->Id);
+        }
+      }
+    }
+  }
+  return cpus;
+}
+
+bool Load(const char* root)
+{
+  // the affinity of the process only means something for the machine it is running on
+  const std::string path = root ? root : "/sys";
+  return TheMachine().Load(path, path == "/sys" ? Allowed(getpid()) : Thread::CpuSet());
+}
+
+} // end of namespace Topology
+
+} // end of namespace osal
+
+#else
+# error "you must not include this file inside header file"
+#endif  // TOPOLOGY_POSIX__HPP
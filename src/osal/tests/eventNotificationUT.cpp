@@ -6,6 +6,7 @@
 #include "osal/EventNotification.h" // unit under test
 # include "../OsalTimeUtils.h"          // MinResolution
 #include "osal/Thread.h"            // thread module
+#include "osal/StopWatch.h"         // to measure the timeout
 #include <gtest/gtest.h>            // unit test framework
 #include <iostream>
 
@@ -275,4 +276,25 @@ TEST_F(EventNotificationTest, TestWithTime)
   EXPECT_EQ(threadIsRunning, false);  // after we signal the thread should have allowed to continue
 }
 
+#ifdef __linux__  // on other platforms the timeout is rounded up to the system tick
+TEST_F(EventNotificationTest, MicrosecondsTimeout)
+{
+  // the wait must not end before the timeout, and since it is spinning at the end
+  // it should not end much later (we allow a lot here since the machine may be loaded)
+  eventNotifyId = osal::EventNotification::Create();
+  const osal::nanoseconds_t timeouts[] = { 20000, 300000, 1500000 };
+  for (unsigned int i = 0; i < sizeof(timeouts) / sizeof(timeouts[0]); i++)
+  {
+    UT::StopWatch watch;
+    EXPECT_FALSE(osal::EventNotification::TimedWait(eventNotifyId, osal::Nanoseconds(timeouts[i])));
+    const osal::nanoseconds_t passed = watch.StopNano();
+    EXPECT_GE(passed, timeouts[i]);
+    EXPECT_LT(passed, timeouts[i] + 5000000);
+  }
+  osal::EventNotification::Signal(eventNotifyId);
+  EXPECT_TRUE(osal::EventNotification::TimedWait(eventNotifyId, osal::Microseconds(100)));
+  EXPECT_FALSE(osal::EventNotification::TryWait(eventNotifyId));
+}
+#endif  // __linux__
+
 }   // end of local namespace
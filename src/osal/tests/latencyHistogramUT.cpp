@@ -0,0 +1,114 @@
+/*
+ * This would test the latency histogram and the nanoseconds
+ * stop watch. You can read more about it in the header file for this module
+ */
+#include "osal/LatencyHistogram.h" // module under test
+#include "osal/StopWatch.h"        // module under test
+#include "osal/Thread.h"           // to sleep
+#include "../OsalTimeUtils.h"      // for timeout value
+#include <gtest/gtest.h>           // unit test framework
+
+namespace   // all unit tests are private to this file
+{
+
+TEST(LatencyHistogramUT, EmptyHistogram)
+{
+  osal::LatencyHistogram h;
+  EXPECT_EQ(0u, h.Count());
+  EXPECT_EQ(0u, h.Min());
+  EXPECT_EQ(0u, h.Max());
+  EXPECT_EQ(0u, h.Mean());
+  EXPECT_EQ(0u, h.Percentile(50.0));
+}
+
+TEST(LatencyHistogramUT, BucketsAreContinuous)
+{
+  // every value must fall in a bucket that its range contains it, and the
+  // buckets must not have any holes between them
+  for (unsigned int i = 1; i < osal::LatencyHistogram::BUCKETS; i++)
+  {
+    EXPECT_EQ(osal::LatencyHistogram::BucketHighValue(i - 1) + 1, osal::LatencyHistogram::BucketLowValue(i));
+    EXPECT_EQ(i, osal::LatencyHistogram::BucketOf(osal::LatencyHistogram::BucketLowValue(i)));
+    EXPECT_EQ(i, osal::LatencyHistogram::BucketOf(osal::LatencyHistogram::BucketHighValue(i)));
+  }
+  EXPECT_EQ((unsigned int)osal::LatencyHistogram::BUCKETS - 1, osal::LatencyHistogram::BucketOf(~0ULL));
+}
+
+TEST(LatencyHistogramUT, Percentiles)
+{
+  // record 1 to 100000 and make sure that the percentiles are within the precision we promise
+  osal::LatencyHistogram h;
+  const osal::nanoseconds_t samples = 100000;
+  for (osal::nanoseconds_t i = 1; i <= samples; i++)
+  {
+    h.Record(i);
+  }
+  EXPECT_EQ(samples, h.Count());
+  EXPECT_EQ(1u, h.Min());
+  EXPECT_EQ(samples, h.Max());
+  EXPECT_EQ(samples / 2, h.Mean());
+  const double percents[] = {10.0, 50.0, 90.0, 99.0, 99.9};
+  for (unsigned int i = 0; i < sizeof(percents) / sizeof(percents[0]); i++)
+  {
+    const double expected = samples * percents[i] / 100.0;
+    const double actual = static_cast<double>(h.Percentile(percents[i]));
+    EXPECT_GE(actual, expected);
+    EXPECT_LE(actual, expected * (1.0 + 1.0 / osal::LatencyHistogram::SUB_BUCKETS));
+  }
+  EXPECT_EQ(samples, h.Percentile(100.0));
+  EXPECT_EQ(1u, h.Percentile(0.0));
+}
+
+TEST(LatencyHistogramUT, Merge)
+{
+  osal::LatencyHistogram low, high, all;
+  for (osal::nanoseconds_t i = 0; i < 1000; i++)
+  {
+    low.Record(i);
+    high.Record(i * 1000 + 5, 2);
+    all.Record(i);
+    all.Record(i * 1000 + 5, 2);
+  }
+  osal::LatencyHistogram merged;
+  merged.Merge(low);
+  merged.Merge(high);
+  EXPECT_EQ(all.Count(), merged.Count());
+  EXPECT_EQ(all.Min(), merged.Min());
+  EXPECT_EQ(all.Max(), merged.Max());
+  EXPECT_EQ(all.Mean(), merged.Mean());
+  for (unsigned int i = 0; i < osal::LatencyHistogram::BUCKETS; i++)
+  {
+    EXPECT_EQ(all.CountAt(i), merged.CountAt(i));
+  }
+  merged.Reset();
+  EXPECT_EQ(0u, merged.Count());
+}
+
+TEST(LatencyHistogramUT, StopWatchNano)
+{
+  // the nanoseconds and the milliseconds must agree with each other and with the time we slept
+  const osal::milliseconds_t sleepTime = osal::TimeUtils::MinResolution() * 2;
+  osal::LatencyHistogram h;
+  UT::StopWatch sw;
+  {
+    osal::ScopedLatency measure(h);
+    osal::Thread::Self::Sleep(sleepTime);
+  }
+  osal::nanoseconds_t nano = sw.PauseNano();
+  osal::milliseconds_t milli = sw.Pause();
+  EXPECT_GE(nano, sleepTime * 1000000ULL);
+  EXPECT_GE(milli, nano / 1000000ULL);
+  EXPECT_EQ(1u, h.Count());
+  EXPECT_GE(h.Max(), sleepTime * 1000000ULL);
+  EXPECT_LE(h.Max(), nano);
+  // the clock must be monotonic
+  osal::nanoseconds_t last = osal::StopWatchOper::Now();
+  for (int i = 0; i < 1000; i++)
+  {
+    osal::nanoseconds_t now = osal::StopWatchOper::Now();
+    EXPECT_GE(now, last);
+    last = now;
+  }
+}
+
+} // end of local namespace
@@ -0,0 +1,120 @@
+/*
+ * This would test the lock profiler. You can read more
+ * about this module in the header file for this module
+ */
+#include "osal/LockProfiler.h"     // module under test
+#include "osal/Mutex.h"            // the locks that are profiled
+#include "osal/RWMutex.h"          // the locks that are profiled
+#include "osal/Thread.h"           // to create contention
+#include "../OsalTimeUtils.h"      // for timeout value
+#include <gtest/gtest.h>           // unit test framework
+#include <algorithm>               // max
+
+#if defined(__linux__) && !defined(OSAL_NO_LOCK_PROFILER)
+namespace   // all unit tests are private to this file
+{
+
+osal::Mutex::Id* contendedMutex = 0;
+volatile bool threadIsRunning = false;
+const osal::milliseconds_t holdTime = 20;
+
+void HoldMutexFunction()
+{
+  osal::Mutex::Lock(contendedMutex);
+  threadIsRunning = true;
+  osal::Thread::Self::Sleep(holdTime);
+  osal::Mutex::Release(contendedMutex);
+}
+
+TEST(LockProfilerUT, DisabledByDefault)
+{
+  osal::LockProfiler::Reset();
+  EXPECT_FALSE(osal::LockProfiler::Enabled());
+  osal::Mutex::Id* m = osal::Mutex::Create();
+  osal::Mutex::Lock(m);
+  osal::Mutex::Release(m);
+  osal::LockProfiler::Entry entries[4];
+  EXPECT_EQ(0u, osal::LockProfiler::Top(entries, 4));
+  osal::Mutex::Delete(m);
+}
+
+TEST(LockProfilerUT, ContendedMutex)
+{
+  // one thread hold the lock for a while and we are waiting for it,
+  // so we should see contended acquisition with the wait and the hold time
+  osal::LockProfiler::Reset();
+  osal::LockProfiler::Enable(true);
+  contendedMutex = osal::Mutex::Create();
+  threadIsRunning = false;
+  osal::Thread::Id* tid = osal::Thread::Create(osal::Thread::CreateAttribute("ProfilerT", 4048,
+                                                                             osal::Thread::Self::Priority()),
+                                               HoldMutexFunction);
+  while (!threadIsRunning)
+  {
+    osal::Thread::Self::Suspend();
+  }
+  osal::Mutex::Lock(contendedMutex);
+  osal::Mutex::Release(contendedMutex);
+  EXPECT_TRUE(osal::Mutex::TryLock(contendedMutex));
+  osal::Mutex::Release(contendedMutex);
+  osal::Thread::Clean(tid);
+  osal::LockProfiler::Enable(false);
+
+  osal::LockProfiler::Entry entries[16];
+  unsigned int count = osal::LockProfiler::Top(entries, 16);
+  ASSERT_GE(count, 3u);  // the other thread, and 2 call sites from this thread
+  // the most contended is the one we blocked on
+  EXPECT_EQ(contendedMutex, entries[0].Lock);
+  EXPECT_EQ(1u, entries[0].Contended);
+  EXPECT_GE(entries[0].WaitTime + osal::TimeUtils::MinResolution() * 1000000ULL, holdTime * 1000000ULL / 2);
+  unsigned long long acquisitions = 0;
+  osal::nanoseconds_t longestHold = 0;
+  for (unsigned int i = 0; i < count; i++)
+  {
+    if (entries[i].Lock == contendedMutex)
+    {
+      acquisitions += entries[i].Acquisitions;
+      longestHold = std::max(longestHold, entries[i].MaxHold);
+    }
+  }
+  EXPECT_EQ(3u, acquisitions);
+  EXPECT_GE(longestHold, holdTime * 1000000ULL);
+  osal::Mutex::Delete(contendedMutex);
+
+  osal::LockProfiler::Reset();
+  EXPECT_EQ(0u, osal::LockProfiler::Top(entries, 16));
+}
+
+TEST(LockProfilerUT, ReadWriteMutex)
+{
+  osal::LockProfiler::Reset();
+  osal::LockProfiler::Enable(true);
+  osal::RWMutex::Id* rw = osal::RWMutex::Create();
+  osal::RWMutex::ReadLock(rw);
+  EXPECT_FALSE(osal::RWMutex::TryWriteLock(rw));
+  osal::RWMutex::Release(rw);
+  osal::RWMutex::WriteLock(rw);
+  osal::RWMutex::Release(rw);
+  osal::LockProfiler::Enable(false);
+
+  osal::LockProfiler::Entry entries[16];
+  unsigned int count = osal::LockProfiler::Top(entries, 16);
+  unsigned long long acquisitions = 0;
+  unsigned long long failed = 0;
+  for (unsigned int i = 0; i < count; i++)
+  {
+    if (entries[i].Lock == rw)
+    {
+      acquisitions += entries[i].Acquisitions;
+      failed += entries[i].Failed;
+    }
+  }
+  EXPECT_EQ(2u, acquisitions);
+  EXPECT_EQ(1u, failed);
+  osal::RWMutex::Delete(rw);
+  osal::LockProfiler::Report(5);
+}
+
+} // end of local namespace
+
+#endif  // __linux__ && !OSAL_NO_LOCK_PROFILER
@@ -4,10 +4,19 @@
  */
 #include "osal/MessageQueue.h"  // the module under test
 #include "osal/Thread.h"  // so we can test with more than one thread - assume that thread was tested
+#include "osal/Mutex.h"   // to give each writer thread its own id
 #include <osal/StopWatch.h>    // this for class StopWatch
+#include <boost/message_queue/message_queue.hpp>  // the queue that the locking engine is using
+#include <boost/message_queue/broadcast_ring.hpp> // the ring that is next to it
 #include <gtest/gtest.h>  // unit test framework
 #include <string.h>       // strlen
 #include <string>         // class string
+#ifdef __linux__
+# include <sys/types.h>   // pid_t
+# include <sys/wait.h>    // waitpid
+# include <unistd.h>      // fork
+# include <stdio.h>       // snprintf
+#endif  // __linux__
 
 namespace // all unit test would hide their internal data
 {
@@ -56,12 +65,66 @@ void ReadQueueThread()
   }
 }
   
-TEST(MessageQueueUT, BasicTest)
+// for the test with many writers
+const unsigned int WRITERS_COUNT = 4;
+const unsigned int MESSAGES_PER_WRITER = 20000;
+osal::Mutex::Id* writersLock = 0;
+unsigned int nextWriter = 0;
+
+struct WriterMessage
+{
+  unsigned int Writer;
+  unsigned int Sequence;
+};
+
+void ManyWritersThread()
+{
+  osal::Mutex::Lock(writersLock);
+  unsigned int writer = nextWriter++;
+  osal::Mutex::Release(writersLock);
+  for (unsigned int i = 0; i < MESSAGES_PER_WRITER; i++)
+  {
+    WriterMessage msg = { writer, i };
+    osal::MessageQueue::Send(testMessageQueue, (CONST_MESSAGE char*)&msg, sizeof(msg), false);
+  }
+}
+
+// for the batch test - each batch is all the messages
+const unsigned int BATCH_ROUNDS = 1000;
+
+void BatchWriteThread()
+{
+  unsigned int sizes[MESSAGE_COUNT];
+  for (unsigned int i = 0; i < MESSAGE_COUNT; i++)
+  {
+    sizes[i] = strlen(MESSAGES[i]);
+  }
+  for (unsigned int round = 0; round < BATCH_ROUNDS; round++)
+  {
+    for (unsigned int sent = 0; sent < MESSAGE_COUNT;)
+    {
+      sent += osal::MessageQueue::SendBatch(testMessageQueue, (CONST_MESSAGE char* const*)MESSAGES + sent, 
+                                            sizes + sent, MESSAGE_COUNT - sent);
+    }
+  }
+}
+
+// all the tests are running on all the queue engines
+class MessageQueueUT : public ::testing::TestWithParam<osal::MessageQueue::Engine>
+{
+protected:
+  osal::MessageQueue::Id* CreateQueue(unsigned int queueSize, unsigned int maxMessageSize)
+  {
+    return osal::MessageQueue::Create(queueSize, maxMessageSize, GetParam());
+  }
+};
+
+TEST_P(MessageQueueUT, BasicTest)
 {
   // this test would just try to make a message queue and to verify that create funcion actually work
   
-  osal::MessageQueue::Id* mq = osal::MessageQueue::Create(10, 20);  // if this function would fail a report outside this would be called
-  osal::MessageQueue::Id* mq2 = osal::MessageQueue::Create(10, 20); // ensure that the second one do not affect by the first
+  osal::MessageQueue::Id* mq = CreateQueue(10, 20);  // if this function would fail a report outside this would be called
+  osal::MessageQueue::Id* mq2 = CreateQueue(10, 20); // ensure that the second one do not affect by the first
   EXPECT_NE(mq, mq2);
   EXPECT_EQ(osal::MessageQueue::CurrentCount(mq), osal::MessageQueue::CurrentCount(mq2));
   EXPECT_EQ(osal::MessageQueue::CurrentCount(mq), 0);
@@ -73,11 +136,11 @@ TEST(MessageQueueUT, BasicTest)
   osal::MessageQueue::Delete(mq2);
 }
 
-TEST(MessageQueueUT, BasicSendRecive)
+TEST_P(MessageQueueUT, BasicSendRecive)
 {
   // in this function we would have a thread that would write messages to the queue
   // the other thread would read them and verify that the messages we recieve are correct
-  testMessageQueue = osal::MessageQueue::Create(1, MAX_MESSAGE_SIZE);
+  testMessageQueue = CreateQueue(1, MAX_MESSAGE_SIZE);
   osal::Thread::Id* tid = osal::Thread::Create(osal::Thread::Attributes("MQTestT", 1024*1024,
                                                                         osal::Thread::Self::Priority()),
                                                                         WriteQueueThread);
@@ -97,14 +160,14 @@ TEST(MessageQueueUT, BasicSendRecive)
                                                                         
 }
 
-TEST(MessageQueueUT, TrySendRecieve)
+TEST_P(MessageQueueUT, TrySendRecieve)
 {
   // in this test we would like to make sure that we can use the queue without being blocked
   // both for send messages and to receive them
   // in order to test that, we would like to set a timeout value for the thread that would do
   // the reading when we would like to test the try send and timeout to the thread that would
   // do the would the send when testing try receive
-  testMessageQueue = osal::MessageQueue::Create(1, MAX_MESSAGE_SIZE);
+  testMessageQueue = CreateQueue(1, MAX_MESSAGE_SIZE);
   timeoutValue4Test = 10;
   osal::Thread::Id* tid = osal::Thread::Create(osal::Thread::Attributes("MQTestTryT", 1024*1024,
                                                                         osal::Thread::Self::Priority()),
@@ -132,7 +195,7 @@ TEST(MessageQueueUT, TrySendRecieve)
   osal::MessageQueue::Delete(testMessageQueue);
   testMessageQueue = 0;
   // now do the same with trySend
-  testMessageQueue = osal::MessageQueue::Create(1, MAX_MESSAGE_SIZE);
+  testMessageQueue = CreateQueue(1, MAX_MESSAGE_SIZE);
   timeoutValue4Test = 10;
   tid = osal::Thread::Create(osal::Thread::Attributes("MQTestTryT2", 1024*1024,
                                                        osal::Thread::Self::Priority()),
@@ -156,14 +219,14 @@ TEST(MessageQueueUT, TrySendRecieve)
   
 }
 
-TEST(MessageQueueUT, TimeSendRecieve)
+TEST_P(MessageQueueUT, TimeSendRecieve)
 {
   // in this test we would like to make sure that we can use the queue without being blocked
   // both for send messages and to receive them
   // in order to test that, we would like to set a timeout value for the thread that would do
   // the reading when we would like to test the try send and timeout to the thread that would
   // do the would the send when testing try receive
-  testMessageQueue = osal::MessageQueue::Create(1, MAX_MESSAGE_SIZE);
+  testMessageQueue = CreateQueue(1, MAX_MESSAGE_SIZE);
   timeoutValue4Test = 30;
   osal::Thread::Id* tid = osal::Thread::Create(osal::Thread::Attributes("MQTestTryT", 1024*1024,
                                                                         osal::Thread::Self::Priority()),
@@ -191,7 +254,7 @@ TEST(MessageQueueUT, TimeSendRecieve)
   osal::MessageQueue::Delete(testMessageQueue);
   testMessageQueue = 0;
   // now do the same with trySend
-  testMessageQueue = osal::MessageQueue::Create(1, MAX_MESSAGE_SIZE);
+  testMessageQueue = CreateQueue(1, MAX_MESSAGE_SIZE);
   timeoutValue4Test = 10;
   tid = osal::Thread::Create(osal::Thread::Attributes("MQTestTryT2", 1024*1024,
                                                        osal::Thread::Self::Priority()),
@@ -215,4 +278,637 @@ TEST(MessageQueueUT, TimeSendRecieve)
   testMessageQueue = 0;
 }
 
+TEST_P(MessageQueueUT, MicrosecondsTimeout)
+{
+  testMessageQueue = CreateQueue(1, MAX_MESSAGE_SIZE);
+  char buffer[MAX_MESSAGE_SIZE];
+  UT::StopWatch watch;
+  EXPECT_EQ(-1, osal::MessageQueue::TimedReceive(testMessageQueue, buffer, MAX_MESSAGE_SIZE, osal::Microseconds(500)));
+  EXPECT_GE(watch.StopNano(), 500000u);
+  EXPECT_TRUE(osal::MessageQueue::TimedSend(testMessageQueue, (CONST_MESSAGE char*)MESSAGES[0], strlen(MESSAGES[0]),
+                                            osal::Microseconds(500), false));
+  // the lock free engines may have room for more than the queue size
+  while (osal::MessageQueue::TrySend(testMessageQueue, (CONST_MESSAGE char*)MESSAGES[0], strlen(MESSAGES[0]), false))
+  {
+  }
+  watch.StopNano();
+  EXPECT_FALSE(osal::MessageQueue::TimedSend(testMessageQueue, (CONST_MESSAGE char*)MESSAGES[1], strlen(MESSAGES[1]),
+                                             osal::Microseconds(500), false));
+  EXPECT_GE(watch.StopNano(), 500000u);
+  int count = osal::MessageQueue::TimedReceive(testMessageQueue, buffer, MAX_MESSAGE_SIZE, osal::Microseconds(500));
+  EXPECT_EQ(std::string(MESSAGES[0]), std::string(buffer, count > 0 ? count : 0));
+  osal::MessageQueue::Delete(testMessageQueue);
+  testMessageQueue = 0;
+}
+
+TEST_P(MessageQueueUT, ManyWriters)
+{
+  // few threads are writing at the same time, we expect to get all the messages
+  // and that messages from the same writer would arrive in the order they were sent
+  // (for queue that allow only one writer, we would just use a single writer)
+  const unsigned int writers = GetParam() == osal::MessageQueue::SINGLE_READER_WRITER ? 1 : WRITERS_COUNT;
+  testMessageQueue = CreateQueue(16, sizeof(WriterMessage));
+  writersLock = osal::Mutex::Create();
+  nextWriter = 0;
+  osal::Thread::Id* tids[WRITERS_COUNT];
+  for (unsigned int i = 0; i < writers; i++)
+  {
+    tids[i] = osal::Thread::Create(osal::Thread::Attributes("MQTestWriters", 1024*1024,
+                                                            osal::Thread::Self::Priority()),
+                                   ManyWritersThread);
+  }
+  unsigned int expected[WRITERS_COUNT] = { 0 };
+  unsigned int outOfOrder = 0;
+  for (unsigned int i = 0; i < writers * MESSAGES_PER_WRITER; i++)
+  {
+    WriterMessage msg = { WRITERS_COUNT, 0 };
+    int count = osal::MessageQueue::Receive(testMessageQueue, (char*)&msg, sizeof(msg));
+    EXPECT_EQ(count, (int)sizeof(msg));
+    ASSERT_LT(msg.Writer, writers);
+    if (msg.Sequence != expected[msg.Writer])
+    {
+      ++outOfOrder;
+    }
+    expected[msg.Writer] = msg.Sequence + 1;
+  }
+  EXPECT_EQ(outOfOrder, 0u);
+  for (unsigned int i = 0; i < writers; i++)
+  {
+    EXPECT_EQ(expected[i], MESSAGES_PER_WRITER);
+    osal::Thread::Clean(tids[i]);
+  }
+  EXPECT_EQ(osal::MessageQueue::CurrentCount(testMessageQueue), 0);
+  osal::Mutex::Delete(writersLock);
+  osal::MessageQueue::Delete(testMessageQueue);
+  testMessageQueue = 0;
+}
+
+TEST_P(MessageQueueUT, BatchSendReceive)
+{
+  // one thread is sending all the messages in batches, we would read them in batches that are
+  // not aligned with the writer batches, and expect to get them all in the right order
+  const unsigned int READ_BATCH = 3;
+  const unsigned int STRIDE = 8;
+  testMessageQueue = CreateQueue(4, MAX_MESSAGE_SIZE);
+  char buffer[READ_BATCH * STRIDE];
+  unsigned int sizes[READ_BATCH];
+  // nothing to read yet
+  EXPECT_EQ(0u, osal::MessageQueue::ReceiveBatch(testMessageQueue, buffer, STRIDE, sizes, READ_BATCH, 0));
+  EXPECT_EQ(0u, osal::MessageQueue::ReceiveBatch(testMessageQueue, buffer, STRIDE, sizes, READ_BATCH, 10));
+  osal::Thread::Id* tid = osal::Thread::Create(osal::Thread::Attributes("MQTestBatch", 1024*1024,
+                                                                        osal::Thread::Self::Priority()),
+                                               BatchWriteThread);
+  unsigned int received = 0;
+  unsigned int errors = 0;
+  while (received < BATCH_ROUNDS * MESSAGE_COUNT)
+  {
+    unsigned int count = osal::MessageQueue::ReceiveBatch(testMessageQueue, buffer, STRIDE, sizes, READ_BATCH, 1000);
+    ASSERT_GT(count, 0u);
+    ASSERT_LE(count, READ_BATCH);
+    for (unsigned int i = 0; i < count; i++, received++)
+    {
+      if (std::string(buffer + i * STRIDE, sizes[i]) != MESSAGES[received % MESSAGE_COUNT])
+      {
+        ++errors;
+      }
+    }
+  }
+  EXPECT_EQ(errors, 0u);
+  EXPECT_EQ(osal::MessageQueue::CurrentCount(testMessageQueue), 0);
+  osal::Thread::Clean(tid);
+  osal::MessageQueue::Delete(testMessageQueue);
+  testMessageQueue = 0;
+}
+
+TEST_P(MessageQueueUT, UrgentMessages)
+{
+  // urgent message should be read before all the normal messages that are already in the queue
+  testMessageQueue = CreateQueue(8, MAX_MESSAGE_SIZE);
+  for (unsigned int i = 0; i < MESSAGE_COUNT - 1; i++)
+  {
+    osal::MessageQueue::Send(testMessageQueue, (CONST_MESSAGE char*)MESSAGES[i], strlen(MESSAGES[i]), false);
+  }
+  const char* urgent = MESSAGES[MESSAGE_COUNT - 1];
+  EXPECT_TRUE(osal::MessageQueue::TrySend(testMessageQueue, (CONST_MESSAGE char*)urgent, strlen(urgent), true));
+  osal::MessageQueue::LanesCount lanes = osal::MessageQueue::CurrentLanesCount(testMessageQueue);
+#ifndef __VXWORKS__
+  EXPECT_EQ(lanes.Normal, (int)MESSAGE_COUNT - 1);
+  EXPECT_EQ(lanes.Urgent, 1);
+#endif  // __VXWORKS__
+  EXPECT_EQ(osal::MessageQueue::CurrentCount(testMessageQueue), (int)MESSAGE_COUNT);
+  char buffer[MAX_MESSAGE_SIZE];
+  int count = osal::MessageQueue::Receive(testMessageQueue, buffer, MAX_MESSAGE_SIZE);
+  EXPECT_EQ(std::string(buffer, count), std::string(urgent));
+  for (unsigned int i = 0; i < MESSAGE_COUNT - 1; i++)
+  {
+    count = osal::MessageQueue::Receive(testMessageQueue, buffer, MAX_MESSAGE_SIZE);
+    EXPECT_EQ(std::string(buffer, count), std::string(MESSAGES[i]));
+  }
+  lanes = osal::MessageQueue::CurrentLanesCount(testMessageQueue);
+  EXPECT_EQ(lanes.Normal, 0);
+  EXPECT_EQ(lanes.Urgent, 0);
+  osal::MessageQueue::Delete(testMessageQueue);
+  testMessageQueue = 0;
+}
+
+#ifndef __VXWORKS__ // the native queue has no protection from starvation
+TEST_P(MessageQueueUT, NormalMessagesNotStarving)
+{
+  // when there are many urgent messages, the normal message should still be read before all of them
+  const unsigned int URGENT_COUNT = 48;
+  testMessageQueue = CreateQueue(64, sizeof(unsigned int));
+  unsigned int normal = URGENT_COUNT;
+  osal::MessageQueue::Send(testMessageQueue, (CONST_MESSAGE char*)&normal, sizeof(normal), false);
+  for (unsigned int i = 0; i < URGENT_COUNT; i++)
+  {
+    osal::MessageQueue::Send(testMessageQueue, (CONST_MESSAGE char*)&i, sizeof(i), true);
+  }
+  unsigned int normalAt = URGENT_COUNT + 1;
+  unsigned int expected = 0;
+  for (unsigned int i = 0; i <= URGENT_COUNT; i++)
+  {
+    unsigned int value = 0;
+    EXPECT_EQ(osal::MessageQueue::Receive(testMessageQueue, (char*)&value, sizeof(value)), (int)sizeof(value));
+    if (value == normal)
+    {
+      normalAt = i;
+    }
+    else
+    {
+      EXPECT_EQ(value, expected++);  // the urgent messages are still in order
+    }
+  }
+  EXPECT_GT(normalAt, 0u);
+  EXPECT_LT(normalAt, URGENT_COUNT);
+  osal::MessageQueue::LanesCount lanes = osal::MessageQueue::CurrentLanesCount(testMessageQueue);
+  EXPECT_EQ(lanes.Forced, 1u);
+  EXPECT_EQ(lanes.Overtaken, (unsigned long)normalAt);
+  osal::MessageQueue::Delete(testMessageQueue);
+  testMessageQueue = 0;
+}
+#endif  // __VXWORKS__
+
+INSTANTIATE_TEST_CASE_P(AllEngines, MessageQueueUT, 
+                        ::testing::Values(osal::MessageQueue::LOCKING, osal::MessageQueue::LOCK_FREE,
+                                          osal::MessageQueue::SINGLE_READER_WRITER));
+
+// the locking engine is based on boost::opaque_message_queue - these test the slots API that
+// allow to build the message inside the queue (this is not exposed by the osal interface)
+boost::opaque_message_queue* opaqueQueue = 0;
+const unsigned int OPAQUE_MESSAGES = 10000;
+
+void ReserveCommitThread()
+{
+  for (unsigned int i = 0; i < OPAQUE_MESSAGES; i++)
+  {
+    char* slot = opaqueQueue->reserve(sizeof(i));
+    memcpy(slot, &i, sizeof(i));
+    opaqueQueue->commit(slot, sizeof(i));
+  }
+}
+
+TEST(OpaqueMessageQueueUT, ReserveCommitPeekRelease)
+{
+  boost::opaque_message_queue queue(4, MAX_MESSAGE_SIZE);
+  EXPECT_TRUE(queue.reserve(MAX_MESSAGE_SIZE + 1) == 0);  // this cannot fit into the slot
+  char* first = queue.reserve(strlen(MESSAGES[0]));
+  char* second = queue.reserve(strlen(MESSAGES[1]));
+  ASSERT_TRUE(first != 0);
+  ASSERT_TRUE(second != 0);
+  EXPECT_NE(first, second);
+  strcpy(second, MESSAGES[1]);
+  queue.commit(second, strlen(MESSAGES[1]));
+  // the first one was reserved before it, so it must be read first
+  EXPECT_EQ(queue.size(), 0u);
+  EXPECT_TRUE(queue.try_peek(boost::posix_time::milliseconds(10)).second == 0);
+  strcpy(first, MESSAGES[0]);
+  queue.commit(first, strlen(MESSAGES[0]));
+  EXPECT_EQ(queue.size(), 2u);
+  boost::details::mq_data::data_type item = queue.peek();
+  EXPECT_EQ(std::string(item.second, item.first), std::string(MESSAGES[0]));
+  EXPECT_EQ(item.second, first);   // we got it from the same place it was written to
+  boost::details::mq_data::data_type next = queue.peek();
+  EXPECT_EQ(std::string(next.second, next.first), std::string(MESSAGES[1]));
+  // the second slot is released, but the first is still used so the queue has room only for 2
+  queue.release(next.second);
+  EXPECT_TRUE(queue.try_reserve(1, boost::posix_time::milliseconds(1)) != 0);
+  EXPECT_TRUE(queue.try_reserve(1, boost::posix_time::milliseconds(1)) != 0);
+  EXPECT_TRUE(queue.try_reserve(1, boost::posix_time::milliseconds(10)) == 0);
+  queue.release(item.second);
+  char* urgent = queue.try_reserve(1, boost::posix_time::milliseconds(1), true);
+  ASSERT_TRUE(urgent != 0);
+  *urgent = 'u';
+  queue.commit(urgent, 1);
+  item = queue.peek();  // the urgent item is ready before the normal ones that were not committed
+  EXPECT_EQ(std::string(item.second, item.first), std::string("u"));
+  queue.release(item.second);
+}
+
+TEST(OpaqueMessageQueueUT, ReserveAndPeekFromThreads)
+{
+  boost::opaque_message_queue queue(8, sizeof(unsigned int));
+  opaqueQueue = &queue;
+  osal::Thread::Id* tid = osal::Thread::Create(osal::Thread::Attributes("MQTestReserve", 1024*1024,
+                                                                        osal::Thread::Self::Priority()),
+                                               ReserveCommitThread);
+  unsigned int outOfOrder = 0;
+  for (unsigned int i = 0; i < OPAQUE_MESSAGES; i++)
+  {
+    boost::details::mq_data::data_type item = queue.peek();
+    unsigned int value = OPAQUE_MESSAGES;
+    EXPECT_EQ(item.first, sizeof(value));
+    memcpy(&value, item.second, sizeof(value));
+    if (value != i)
+    {
+      ++outOfOrder;
+    }
+    queue.release(item.second);
+  }
+  EXPECT_EQ(outOfOrder, 0u);
+  osal::Thread::Clean(tid);
+  EXPECT_EQ(queue.size(), 0u);
+  opaqueQueue = 0;
+}
+
+// the producers and the consumers are using different locks - make sure that nothing is lost
+// or read twice when both are blocking on a small queue at the same time
+const unsigned int OPAQUE_PRODUCERS = 3;
+volatile unsigned long long consumedSum = 0;
+volatile unsigned int consumedCount = 0;
+osal::Mutex::Id* consumedLock = 0;
+
+void PushThread()
+{
+  for (unsigned int i = 1; i <= OPAQUE_MESSAGES; i++)
+  {
+    opaqueQueue->push_front((const char*)&i, sizeof(i), i % 7 == 0);
+  }
+}
+
+void PopThread()
+{
+  unsigned int value = 0;
+  std::size_t size = sizeof(value);
+  while (opaqueQueue->try_pop((char*)&value, size, boost::posix_time::milliseconds(100)))
+  {
+    EXPECT_EQ(size, sizeof(value));
+    osal::Mutex::Lock(consumedLock);
+    consumedSum += value;
+    ++consumedCount;
+    osal::Mutex::Release(consumedLock);
+    size = sizeof(value);
+  }
+}
+
+TEST(OpaqueMessageQueueUT, ProducersAndConsumers)
+{
+  boost::opaque_message_queue queue(4, sizeof(unsigned int));
+  opaqueQueue = &queue;
+  consumedLock = osal::Mutex::Create();
+  consumedSum = 0;
+  consumedCount = 0;
+  osal::Thread::Id* producers[OPAQUE_PRODUCERS];
+  for (unsigned int i = 0; i < OPAQUE_PRODUCERS; i++)
+  {
+    producers[i] = osal::Thread::Create(osal::Thread::Attributes("MQTestPush", 1024*1024,
+                                                                 osal::Thread::Self::Priority()),
+                                        PushThread);
+  }
+  osal::Thread::Id* consumer = osal::Thread::Create(osal::Thread::Attributes("MQTestPop", 1024*1024,
+                                                                             osal::Thread::Self::Priority()),
+                                                    PopThread);
+  PopThread();  // we are the second consumer
+  for (unsigned int i = 0; i < OPAQUE_PRODUCERS; i++)
+  {
+    osal::Thread::Clean(producers[i]);
+  }
+  osal::Thread::Clean(consumer);
+  const unsigned long long expected = (unsigned long long)OPAQUE_MESSAGES * (OPAQUE_MESSAGES + 1) / 2;
+  EXPECT_EQ(consumedCount, OPAQUE_PRODUCERS * OPAQUE_MESSAGES);
+  EXPECT_EQ(consumedSum, OPAQUE_PRODUCERS * expected);
+  osal::Mutex::Delete(consumedLock);
+  EXPECT_EQ(queue.size(), 0u);
+  boost::opaque_message_queue::lanes_info lanes = queue.lanes();
+  EXPECT_EQ(lanes.normal, 0u);
+  EXPECT_EQ(lanes.urgent, 0u);
+  opaqueQueue = 0;
+}
+
+TEST(OpaqueMessageQueueUT, GenericQueue)
+{
+  boost::message_queue<int> queue(2);
+  int value = 0;
+  EXPECT_FALSE(queue.try_pop(&value));
+  EXPECT_FALSE(queue.try_pop(&value, boost::posix_time::milliseconds(10)));
+  EXPECT_TRUE(queue.try_push(1));
+  queue.push_front(2);
+  EXPECT_FALSE(queue.try_push(3));
+  EXPECT_FALSE(queue.try_push(3, boost::posix_time::milliseconds(10)));
+  EXPECT_EQ(queue.size(), 2u);
+  queue.pop_back(&value);
+  EXPECT_EQ(value, 1);
+  EXPECT_TRUE(queue.try_push(3, boost::get_system_time() + boost::posix_time::milliseconds(10)));
+  EXPECT_TRUE(queue.try_pop(&value, boost::posix_time::milliseconds(10)));
+  EXPECT_EQ(value, 2);
+  EXPECT_TRUE(queue.try_pop(&value, boost::get_system_time() + boost::posix_time::milliseconds(10)));
+  EXPECT_EQ(value, 3);   // the ring was wrapped around
+  EXPECT_EQ(queue.size(), 0u);
+}
+
+// the broadcast ring is next to the message queue - each item is read by all the consumers
+TEST(BroadcastRingUT, ClaimPublishRelease)
+{
+  typedef boost::broadcast_ring<unsigned int, boost::busy_spin_wait> ring_type;
+  ring_type ring(5);
+  EXPECT_EQ(ring.capacity(), 8u);
+  ring_type::consumer& first = ring.add_consumer();
+  ring_type::consumer& second = ring.add_consumer(first);
+  ring_type::sequence_type at = 0;
+  ASSERT_TRUE(ring.try_claim(at, 8, boost::posix_time::milliseconds(1)));
+  EXPECT_EQ(at, 0u);
+  for (unsigned int i = 0; i < 8; i++)
+  {
+    ring[at + i] = i;
+  }
+  EXPECT_EQ(first.available(), 0u);   // nothing is seen before it is published
+  ring.publish(at, 8);
+  ring_type::sequence_type next = 0;
+  EXPECT_FALSE(ring.try_claim(next, 1, boost::posix_time::milliseconds(1)));
+  EXPECT_EQ(second.available(), 0u);  // the first one did not release them yet
+  EXPECT_EQ(first.try_wait_for(next, boost::posix_time::milliseconds(1)), 8u);
+  EXPECT_EQ(next, 0u);
+  first.release(8);
+  EXPECT_EQ(first.try_wait_for(next, boost::posix_time::milliseconds(1)), 0u);
+  EXPECT_FALSE(ring.try_claim(next, 1, boost::posix_time::milliseconds(1)));  // second still has them
+  unsigned int value = 8;
+  EXPECT_TRUE(second.try_pop(value));
+  EXPECT_EQ(value, 0u);
+  second.release(2);
+  EXPECT_TRUE(ring.try_claim(next, 3, boost::posix_time::milliseconds(1)));
+  EXPECT_EQ(next, 8u);
+  ring.publish(next, 3);
+  EXPECT_EQ(first.available(), 3u);
+  EXPECT_EQ(second.available(), 5u);
+  EXPECT_EQ(ring[next], 0u);   // the slots are reused (we did not write to them)
+}
+
+// few consumers read all the items while the producer is publishing them in batches, the last
+// consumer runs after the first one
+template<typename Ring>
+struct FanOut
+{
+  static const unsigned int CONSUMERS = 3;
+  static const unsigned int ITEMS = 20000;
+  static const unsigned int BATCH = 5;
+
+  static void Consume(unsigned int index)
+  {
+    typename Ring::consumer& consumer = *consumers[index];
+    unsigned int expected = 0;
+    while (expected < ITEMS)
+    {
+      typename Ring::sequence_type first = 0;
+      const std::size_t count = consumer.wait_for(first);
+      for (std::size_t i = 0; i < count; i++, expected++)
+      {
+        if ((*ring)[first + i] != expected)
+        {
+          ++errors[index];
+        }
+      }
+      if (index == CONSUMERS - 1 && consumers[0]->next() - first < count)
+      {
+        ++errors[index];  // we got an item before the first consumer released it
+      }
+      consumer.release(count);
+    }
+  }
+
+  static void First()
+  {
+    Consume(0);
+  }
+
+  static void Second()
+  {
+    Consume(1);
+  }
+
+  static void Last()
+  {
+    Consume(2);
+  }
+
+  static void Run()
+  {
+    Ring theRing(16);
+    ring = &theRing;
+    consumers[0] = &theRing.add_consumer();
+    consumers[1] = &theRing.add_consumer();
+    consumers[2] = &theRing.add_consumer(*consumers[0]);
+    osal::Thread::entry_func_t entries[CONSUMERS] = { First, Second, Last };
+    osal::Thread::Id* threads[CONSUMERS];
+    for (unsigned int i = 0; i < CONSUMERS; i++)
+    {
+      errors[i] = 0;
+      threads[i] = osal::Thread::Create(osal::Thread::Attributes("MQTestFanOut", 1024*1024,
+                                                                 osal::Thread::Self::Priority()),
+                                        entries[i]);
+    }
+    for (unsigned int value = 0; value < ITEMS; value += BATCH)
+    {
+      const typename Ring::sequence_type first = theRing.claim(BATCH);
+      for (unsigned int i = 0; i < BATCH; i++)
+      {
+        theRing[first + i] = value + i;
+      }
+      theRing.publish(first, BATCH);
+    }
+    for (unsigned int i = 0; i < CONSUMERS; i++)
+    {
+      osal::Thread::Clean(threads[i]);
+      EXPECT_EQ(errors[i], 0u);
+      EXPECT_EQ(consumers[i]->next(), (typename Ring::sequence_type)ITEMS);
+    }
+    ring = 0;
+  }
+
+  static Ring* ring;
+  static typename Ring::consumer* consumers[CONSUMERS];
+  static volatile unsigned int errors[CONSUMERS];
+};
+
+template<typename Ring> Ring* FanOut<Ring>::ring = 0;
+template<typename Ring> typename Ring::consumer* FanOut<Ring>::consumers[FanOut<Ring>::CONSUMERS];
+template<typename Ring> volatile unsigned int FanOut<Ring>::errors[FanOut<Ring>::CONSUMERS];
+
+TEST(BroadcastRingUT, FanOutBlocking)
+{
+  FanOut<boost::broadcast_ring<unsigned int, boost::blocking_wait> >::Run();
+}
+
+TEST(BroadcastRingUT, FanOutYielding)
+{
+  FanOut<boost::broadcast_ring<unsigned int, boost::yielding_wait> >::Run();
+}
+
+#ifdef __linux__
+// the queues between processes - the other process is a child that we fork
+class SharedMessageQueueUT : public ::testing::Test
+{
+protected:
+  static const unsigned int CHILD_MESSAGES = 20000;
+
+  SharedMessageQueueUT()
+  {
+    snprintf(mName, sizeof(mName), "/osal_mq_ut_%d", (int)getpid());
+  }
+
+  // in the child - open the queue and send count messages with their sequence
+  // @return the exit code of the child
+  int SendFromChild(unsigned int count, bool detach)
+  {
+    osal::MessageQueue::Id* qid = 0;
+    while (!(qid = osal::MessageQueue::OpenShared(mName)))
+    {
+      osal::Thread::Self::Sleep(1);
+    }
+    for (unsigned int i = 0; i < count; i++)
+    {
+      osal::MessageQueue::Send(qid, (CONST_MESSAGE char*)&i, sizeof(i), false);
+    }
+    if (detach)
+    {
+      osal::MessageQueue::Delete(qid);
+    }
+    return 0;   // if we are not detaching this look to the parent as if we crashed
+  }
+
+  pid_t StartChild(unsigned int count, bool detach)
+  {
+    pid_t child = fork();
+    if (child == 0)
+    {
+      _exit(SendFromChild(count, detach));
+    }
+    return child;
+  }
+
+  static int WaitChild(pid_t child)
+  {
+    int status = -1;
+    waitpid(child, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+  }
+
+  char mName[64];
+};
+
+TEST_F(SharedMessageQueueUT, SameProcess)
+{
+  // both sides can be in the same process - this is the same as the single reader and writer queue
+  osal::MessageQueue::Id* writer = osal::MessageQueue::CreateShared(mName, 8, MAX_MESSAGE_SIZE);
+  osal::MessageQueue::Id* reader = osal::MessageQueue::OpenShared(mName);
+  ASSERT_TRUE(reader != 0);
+  EXPECT_TRUE(osal::MessageQueue::OpenShared(mName) == 0);  // the other side is already taken
+  EXPECT_TRUE(osal::MessageQueue::PeerAlive(writer));
+  EXPECT_TRUE(osal::MessageQueue::PeerAlive(reader));
+  char buffer[MAX_MESSAGE_SIZE];
+  EXPECT_EQ(-1, osal::MessageQueue::TryReceive(reader, buffer, MAX_MESSAGE_SIZE));
+  for (unsigned int i = 0; i < MESSAGE_COUNT - 1; i++)
+  {
+    osal::MessageQueue::Send(writer, (CONST_MESSAGE char*)MESSAGES[i], strlen(MESSAGES[i]), false);
+  }
+  const char* urgent = MESSAGES[MESSAGE_COUNT - 1];
+  osal::MessageQueue::Send(writer, (CONST_MESSAGE char*)urgent, strlen(urgent), true);
+  osal::MessageQueue::LanesCount lanes = osal::MessageQueue::CurrentLanesCount(reader);
+  EXPECT_EQ(lanes.Normal, (int)MESSAGE_COUNT - 1);
+  EXPECT_EQ(lanes.Urgent, 1);
+  int count = osal::MessageQueue::Receive(reader, buffer, MAX_MESSAGE_SIZE);
+  EXPECT_EQ(std::string(buffer, count), std::string(urgent));
+  for (unsigned int i = 0; i < MESSAGE_COUNT - 1; i++)
+  {
+    count = osal::MessageQueue::TimedReceive(reader, buffer, MAX_MESSAGE_SIZE, 100);
+    EXPECT_EQ(std::string(buffer, count), std::string(MESSAGES[i]));
+  }
+  EXPECT_EQ(-1, osal::MessageQueue::TimedReceive(reader, buffer, MAX_MESSAGE_SIZE, 10));
+  osal::MessageQueue::Delete(reader);
+  osal::MessageQueue::Delete(writer);
+  EXPECT_TRUE(osal::MessageQueue::OpenShared(mName) == 0);  // the name was removed with the queue
+}
+
+TEST_F(SharedMessageQueueUT, NameInUse)
+{
+  osal::MessageQueue::Id* first = osal::MessageQueue::CreateShared(mName, 8, MAX_MESSAGE_SIZE);
+  ASSERT_TRUE(first != 0);
+  // we are still running, so it must not be replaced
+  EXPECT_TRUE(osal::MessageQueue::CreateShared(mName, 8, MAX_MESSAGE_SIZE) == 0);
+  osal::MessageQueue::Id* reader = osal::MessageQueue::OpenShared(mName);
+  ASSERT_TRUE(reader != 0);
+  osal::MessageQueue::Send(first, (CONST_MESSAGE char*)MESSAGES[0], strlen(MESSAGES[0]), false);
+  char buffer[MAX_MESSAGE_SIZE];
+  EXPECT_EQ((int)strlen(MESSAGES[0]), osal::MessageQueue::TryReceive(reader, buffer, MAX_MESSAGE_SIZE));
+  osal::MessageQueue::Delete(reader);
+  osal::MessageQueue::Delete(first);
+
+  // a queue that was left by a process that crashed is replaced
+  pid_t child = fork();
+  if (child == 0)
+  {
+    osal::MessageQueue::CreateShared(mName, 8, MAX_MESSAGE_SIZE);
+    _exit(0);
+  }
+  ASSERT_GT(child, 0);
+  EXPECT_EQ(WaitChild(child), 0);
+  osal::MessageQueue::Id* replaced = osal::MessageQueue::CreateShared(mName, 8, MAX_MESSAGE_SIZE);
+  EXPECT_TRUE(replaced != 0);
+  osal::MessageQueue::Delete(replaced);
+}
+
+TEST_F(SharedMessageQueueUT, BetweenProcesses)
+{
+  // the queue is small, so both sides would have to wait for each other
+  osal::MessageQueue::Id* reader = osal::MessageQueue::CreateShared(mName, 16, sizeof(unsigned int));
+  pid_t child = StartChild(CHILD_MESSAGES, true);
+  ASSERT_GT(child, 0);
+  unsigned int outOfOrder = 0;
+  for (unsigned int i = 0; i < CHILD_MESSAGES; i++)
+  {
+    unsigned int value = CHILD_MESSAGES;
+    EXPECT_EQ(osal::MessageQueue::Receive(reader, (char*)&value, sizeof(value)), (int)sizeof(value));
+    if (value != i)
+    {
+      ++outOfOrder;
+    }
+  }
+  EXPECT_EQ(outOfOrder, 0u);
+  EXPECT_EQ(WaitChild(child), 0);
+  EXPECT_TRUE(osal::MessageQueue::PeerAlive(reader));   // it deleted the queue before it exit
+  osal::MessageQueue::Delete(reader);
+}
+
+TEST_F(SharedMessageQueueUT, PeerCrash)
+{
+  osal::MessageQueue::Id* reader = osal::MessageQueue::CreateShared(mName, 16, sizeof(unsigned int));
+  pid_t child = StartChild(1, false);
+  ASSERT_GT(child, 0);
+  unsigned int value = 1;
+  EXPECT_EQ(osal::MessageQueue::Receive(reader, (char*)&value, sizeof(value)), (int)sizeof(value));
+  EXPECT_EQ(value, 0u);
+  EXPECT_EQ(WaitChild(child), 0);
+  EXPECT_FALSE(osal::MessageQueue::PeerAlive(reader));
+  // we should not wait for the whole timeout, since no one would send anything
+  UT::StopWatch watch;
+  EXPECT_EQ(-1, osal::MessageQueue::TimedReceive(reader, (char*)&value, sizeof(value), 10000));
+  EXPECT_LT(watch.Stop(), 5000u);
+  // another process can take the place of the one that crashed
+  child = StartChild(1, true);
+  ASSERT_GT(child, 0);
+  EXPECT_EQ(osal::MessageQueue::Receive(reader, (char*)&value, sizeof(value)), (int)sizeof(value));
+  EXPECT_EQ(WaitChild(child), 0);
+  EXPECT_TRUE(osal::MessageQueue::PeerAlive(reader));
+  osal::MessageQueue::Delete(reader);
+}
+#endif  // __linux__
+
 } // end of local namespace
@@ -0,0 +1,145 @@
+/*
+ * This would test waiting on more than one object (event notifications,
+ * counting semaphores and message queues). You can read more
+ * about this module in the header file for this module
+ */
+#include "osal/MultiWait.h"         // module under test
+#include "osal/EventNotification.h" // the objects to wait on
+#include "osal/CountingSemaphore.h" // the objects to wait on
+#include "osal/MessageQueue.h"      // the objects to wait on
+#include "osal/Thread.h"            // to make the objects ready from another thread
+#include "osal/StopWatch.h"         // to measure the timeout
+#include "../OsalTimeUtils.h"       // for timeout value
+#include <gtest/gtest.h>            // unit test framework
+
+#if defined(__linux__) || defined(__VXWORKS__)
+namespace   // all unit tests are private to this file
+{
+
+const unsigned int MESSAGE_SIZE = 16;
+const osal::milliseconds_t delay = 20;
+osal::EventNotification::Id* remoteEvent = 0;
+osal::CountingSemaphore::Id* remoteSemaphore = 0;
+osal::MessageQueue::Id* remoteQueue = 0;
+
+void SignalFunction()
+{
+  osal::Thread::Self::Sleep(delay);
+  osal::EventNotification::Signal(remoteEvent);
+}
+
+void SendFunction()
+{
+  osal::Thread::Self::Sleep(delay);
+  char message[MESSAGE_SIZE] = "message";
+  osal::MessageQueue::Send(remoteQueue, message, MESSAGE_SIZE, false);
+}
+
+void PostFunction()
+{
+  osal::Thread::Self::Sleep(delay);
+  osal::CountingSemaphore::Post(remoteSemaphore);
+}
+
+osal::Thread::Id* StartThread(const char* name, void (*function)())
+{
+  return osal::Thread::Create(osal::Thread::CreateAttribute(name, 4048, osal::Thread::Self::Priority()), function);
+}
+
+TEST(MultiWaitUT, AnyAlreadyReady)
+{
+  osal::EventNotification::Id* event = osal::EventNotification::Create();
+  osal::CountingSemaphore::Id* semaphore = osal::CountingSemaphore::Create(1);
+  osal::WaitObject objects[] = { osal::WaitObject(event), osal::WaitObject(semaphore) };
+
+  EXPECT_EQ(1, osal::WaitAny(objects, 2, 0));
+  // the semaphore was taken
+  EXPECT_FALSE(osal::CountingSemaphore::TryWait(semaphore));
+  EXPECT_EQ(-1, osal::WaitAny(objects, 2, 0));
+
+  // the first in the array is returned
+  osal::EventNotification::Signal(event);
+  osal::CountingSemaphore::Post(semaphore);
+  EXPECT_EQ(0, osal::WaitAny(objects, 2));
+  EXPECT_EQ(1, osal::WaitAny(objects, 2));
+
+  osal::CountingSemaphore::Delete(semaphore);
+  osal::EventNotification::Delete(event);
+}
+
+TEST(MultiWaitUT, AnyTimeout)
+{
+  osal::EventNotification::Id* event = osal::EventNotification::Create();
+  osal::MessageQueue::Id* queue = osal::MessageQueue::Create(4, MESSAGE_SIZE);
+  osal::WaitObject objects[] = { osal::WaitObject(event), osal::WaitObject(queue) };
+
+  UT::StopWatch watch;
+  EXPECT_EQ(-1, osal::WaitAny(objects, 2, delay));
+  EXPECT_GE(watch.Stop() + osal::TimeUtils::MinResolution(), delay);
+
+  osal::MessageQueue::Delete(queue);
+  osal::EventNotification::Delete(event);
+}
+
+TEST(MultiWaitUT, AnyWakeup)
+{
+  remoteEvent = osal::EventNotification::Create();
+  remoteQueue = osal::MessageQueue::Create(4, MESSAGE_SIZE);
+  remoteSemaphore = osal::CountingSemaphore::Create(0);
+  osal::WaitObject objects[] = { osal::WaitObject(remoteSemaphore), osal::WaitObject(remoteEvent),
+                                 osal::WaitObject(remoteQueue) };
+
+  osal::Thread::Id* tid = StartThread("SignalT", SignalFunction);
+  EXPECT_EQ(1, osal::WaitAny(objects, 3));
+  EXPECT_FALSE(osal::EventNotification::TryWait(remoteEvent));
+  osal::Thread::Clean(tid);
+
+  tid = StartThread("SendT", SendFunction);
+  EXPECT_EQ(2, osal::WaitAny(objects, 3, delay * 50));
+  // the message is not read by the wait
+  char message[MESSAGE_SIZE];
+  EXPECT_EQ((int)MESSAGE_SIZE, osal::MessageQueue::TryReceive(remoteQueue, message, MESSAGE_SIZE));
+  osal::Thread::Clean(tid);
+
+  tid = StartThread("PostT", PostFunction);
+  EXPECT_EQ(0, osal::WaitAny(objects, 3, delay * 50));
+  osal::Thread::Clean(tid);
+
+  osal::CountingSemaphore::Delete(remoteSemaphore);
+  osal::MessageQueue::Delete(remoteQueue);
+  osal::EventNotification::Delete(remoteEvent);
+}
+
+TEST(MultiWaitUT, All)
+{
+  remoteEvent = osal::EventNotification::Create();
+  remoteSemaphore = osal::CountingSemaphore::Create(0);
+  osal::WaitObject objects[] = { osal::WaitObject(remoteEvent), osal::WaitObject(remoteSemaphore) };
+
+  // only the event is ready - it must not be taken
+  osal::EventNotification::Signal(remoteEvent);
+  EXPECT_FALSE(osal::WaitAll(objects, 2, delay));
+  EXPECT_TRUE(osal::EventNotification::TryWait(remoteEvent));
+  osal::EventNotification::Signal(remoteEvent);
+
+  osal::Thread::Id* tid = StartThread("PostT", PostFunction);
+  osal::WaitAll(objects, 2);
+  EXPECT_FALSE(osal::EventNotification::TryWait(remoteEvent));
+  EXPECT_FALSE(osal::CountingSemaphore::TryWait(remoteSemaphore));
+  osal::Thread::Clean(tid);
+
+  // the same semaphore twice, so we need 2 posts
+  osal::WaitObject twice[] = { osal::WaitObject(remoteSemaphore), osal::WaitObject(remoteSemaphore) };
+  osal::CountingSemaphore::Post(remoteSemaphore);
+  tid = StartThread("PostT", PostFunction);
+  EXPECT_TRUE(osal::WaitAll(twice, 2, delay * 50));
+  EXPECT_FALSE(osal::CountingSemaphore::TryWait(remoteSemaphore));
+  osal::Thread::Clean(tid);
+
+  osal::CountingSemaphore::Delete(remoteSemaphore);
+  osal::EventNotification::Delete(remoteEvent);
+}
+
+} // end of local namespace
+
+#endif  // __linux__ || __VXWORKS__
@@ -26,6 +26,9 @@ const unsigned int timeoutToBlock =
 #endif // __VXWORKS__
 bool lockWasTaken = false;
 const unsigned int maxLock4RecursiveTest = 12;
+const unsigned int CONTENDING_THREADS = 4;
+const unsigned int INCREMENTS = 20000;
+unsigned int sharedCounter = 0;
 
 void RecursiveTestFunction()
 {
@@ -69,6 +72,16 @@ void SyncTestFunction()
   osal::Mutex::Release(mutex4Test);
 }
 
+void IncrementThread()
+{
+  for (unsigned int i = 0; i < INCREMENTS; i++)
+  {
+    osal::Mutex::Lock(mutex4Test);
+    ++sharedCounter;
+    osal::Mutex::Release(mutex4Test);
+  }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 void EnsureNotEqual(osal::Mutex::Id* left, osal::Mutex::Id* right)
@@ -274,6 +287,13 @@ TEST(MutexUT, BasicLock)
   threadIsRunning  = false;
   mutex4Test = osal::Mutex::CreateRecursive(osal::Mutex::PRIORITY_UNSAFE);
   TestBlockingMutex("BasicBlocking3");
+  // the spinning mutexes must block (or spin) for as long as the lock is held
+  threadIsRunning  = false;
+  mutex4Test = osal::Mutex::Create(osal::Mutex::ADAPTIVE_SPIN);
+  TestBlockingMutex("BasicBlocking4");
+  threadIsRunning  = false;
+  mutex4Test = osal::Mutex::Create(osal::Mutex::SPIN);
+  TestBlockingMutex("BasicBlocking5");
 }
 
 TEST(MutexUT, TryTest)
@@ -294,6 +314,12 @@ TEST(MutexUT, TryTest)
   threadIsRunning  = false;
   mutex4Test = osal::Mutex::CreateRecursive(osal::Mutex::PRIORITY_UNSAFE);
   TestWithTry("TryTest3");
+  threadIsRunning  = false;
+  mutex4Test = osal::Mutex::Create(osal::Mutex::ADAPTIVE_SPIN);
+  TestWithTry("TryTest4");
+  threadIsRunning  = false;
+  mutex4Test = osal::Mutex::Create(osal::Mutex::SPIN);
+  TestWithTry("TryTest5");
 }
 
 TEST(MutexUT, TimeoutTest)
@@ -312,6 +338,39 @@ TEST(MutexUT, TimeoutTest)
   threadIsRunning = false;
   mutex4Test = osal::Mutex::CreateRecursive(osal::Mutex::PRIORITY_UNSAFE);
   TestWithTimeout("TimeoutTest3");
+
+  threadIsRunning = false;
+  mutex4Test = osal::Mutex::Create(osal::Mutex::ADAPTIVE_SPIN);
+  TestWithTimeout("TimeoutTest4");
+
+  threadIsRunning = false;
+  mutex4Test = osal::Mutex::Create(osal::Mutex::SPIN);
+  TestWithTimeout("TimeoutTest5");
+}
+
+TEST(MutexUT, PoliciesUnderContention)
+{
+  // few threads are doing very short critical sections at the same time, if the
+  // mutex is not protecting them we would miss some of the increments
+  const osal::Mutex::Policy policies[] = { osal::Mutex::BLOCKING, osal::Mutex::ADAPTIVE_SPIN, osal::Mutex::SPIN };
+  for (unsigned int p = 0; p < sizeof(policies) / sizeof(policies[0]); p++)
+  {
+    mutex4Test = osal::Mutex::Create(policies[p]);
+    sharedCounter = 0;
+    osal::Thread::Id* tids[CONTENDING_THREADS];
+    for (unsigned int i = 0; i < CONTENDING_THREADS; i++)
+    {
+      tids[i] = osal::Thread::Create(osal::Thread::CreateAttribute("MutexContend", 4048,
+                                                                   osal::Thread::Self::Priority()),
+                                     IncrementThread);
+    }
+    for (unsigned int i = 0; i < CONTENDING_THREADS; i++)
+    {
+      EXPECT_TRUE(osal::Thread::Clean(tids[i]));
+    }
+    EXPECT_EQ(CONTENDING_THREADS * INCREMENTS, sharedCounter);
+    osal::Mutex::Delete(mutex4Test);
+  }
 }
 
 } // end of local namespace
@@ -0,0 +1,157 @@
+/*
+ * This would test the poller - waiting on event notifications,
+ * message queues and file descriptors together. You can read more
+ * about this module in the header file for this module
+ */
+#include "osal/Poller.h"            // module under test
+#include "osal/EventNotification.h" // the objects to poll on
+#include "osal/MessageQueue.h"      // the objects to poll on
+#include "osal/Thread.h"            // to signal from another thread
+#include <gtest/gtest.h>            // unit test framework
+#include <unistd.h>                 // pipe
+
+#ifdef __linux__
+namespace   // all unit tests are private to this file
+{
+
+const unsigned int MESSAGE_SIZE = 16;
+osal::EventNotification::Id* remoteEvent = 0;
+
+void SignalFunction()
+{
+  osal::Thread::Self::Sleep(20);
+  osal::EventNotification::Signal(remoteEvent);
+}
+
+TEST(PollerUT, EventAndQueue)
+{
+  osal::Poller::Id* poller = osal::Poller::Create();
+  osal::EventNotification::Id* event = osal::EventNotification::Create();
+  osal::MessageQueue::Id* queue = osal::MessageQueue::Create(8, MESSAGE_SIZE);
+  int eventData = 1;
+  int queueData = 2;
+  EXPECT_TRUE(osal::Poller::Add(poller, event, &eventData));
+  EXPECT_TRUE(osal::Poller::Add(poller, queue, &queueData));
+  EXPECT_FALSE(osal::Poller::Add(poller, queue, &queueData));  // already there
+
+  osal::Poller::Ready ready[4];
+  EXPECT_EQ(0, osal::Poller::TryWait(poller, ready, 4));
+
+  osal::EventNotification::Signal(event);
+  ASSERT_EQ(1, osal::Poller::TryWait(poller, ready, 4));
+  EXPECT_EQ(osal::Poller::EVENT_NOTIFICATION, ready[0].Type);
+  EXPECT_EQ(event, ready[0].Event);
+  EXPECT_EQ(&eventData, ready[0].UserData);
+  // level triggered - we did not take the event so it is reported again
+  EXPECT_EQ(1, osal::Poller::TryWait(poller, ready, 4));
+  EXPECT_TRUE(osal::EventNotification::TryWait(event));
+  EXPECT_EQ(0, osal::Poller::TryWait(poller, ready, 4));
+
+  char message[MESSAGE_SIZE] = "message";
+  osal::MessageQueue::Send(queue, message, MESSAGE_SIZE, false);
+  osal::MessageQueue::Send(queue, message, MESSAGE_SIZE, false);
+  ASSERT_EQ(1, osal::Poller::TryWait(poller, ready, 4));
+  EXPECT_EQ(osal::Poller::MESSAGE_QUEUE, ready[0].Type);
+  EXPECT_EQ(queue, ready[0].Queue);
+  EXPECT_EQ(&queueData, ready[0].UserData);
+  // reading only one message, so the queue is still ready
+  EXPECT_EQ((int)MESSAGE_SIZE, osal::MessageQueue::TryReceive(queue, message, MESSAGE_SIZE));
+  EXPECT_EQ(1, osal::Poller::TryWait(poller, ready, 4));
+  EXPECT_EQ((int)MESSAGE_SIZE, osal::MessageQueue::TryReceive(queue, message, MESSAGE_SIZE));
+  EXPECT_EQ(0, osal::Poller::TryWait(poller, ready, 4));
+
+  // both are ready, but we only have room for one
+  osal::EventNotification::Signal(event);
+  osal::MessageQueue::Send(queue, message, MESSAGE_SIZE, false);
+  EXPECT_EQ(1, osal::Poller::TryWait(poller, ready, 1));
+  EXPECT_EQ(2, osal::Poller::TryWait(poller, ready, 4));
+
+  EXPECT_TRUE(osal::Poller::Remove(poller, event));
+  EXPECT_FALSE(osal::Poller::Remove(poller, event));
+  ASSERT_EQ(1, osal::Poller::TryWait(poller, ready, 4));
+  EXPECT_EQ(queue, ready[0].Queue);
+
+  osal::Poller::Delete(poller);
+  EXPECT_TRUE(poller == 0);
+  osal::MessageQueue::Delete(queue);
+  osal::EventNotification::Delete(event);
+}
+
+TEST(PollerUT, ReadyLeftOverIsKept)
+{
+  osal::Poller::Id* poller = osal::Poller::Create();
+  osal::MessageQueue::Id* queueA = osal::MessageQueue::Create(8, MESSAGE_SIZE);
+  osal::MessageQueue::Id* queueB = osal::MessageQueue::Create(8, MESSAGE_SIZE);
+  EXPECT_TRUE(osal::Poller::Add(poller, queueA, 0));
+  EXPECT_TRUE(osal::Poller::Add(poller, queueB, 0));
+
+  char message[MESSAGE_SIZE] = "message";
+  osal::MessageQueue::Send(queueA, message, MESSAGE_SIZE, false);
+  osal::MessageQueue::Send(queueA, message, MESSAGE_SIZE, false);
+  osal::MessageQueue::Send(queueB, message, MESSAGE_SIZE, false);
+  osal::Poller::Ready ready[2];
+  ASSERT_EQ(2, osal::Poller::TryWait(poller, ready, 2));
+  // only room for one of them - the other one was not checked and must not be lost
+  ASSERT_EQ(1, osal::Poller::TryWait(poller, ready, 1));
+  osal::MessageQueue::Id* first = ready[0].Queue;
+  osal::MessageQueue::Id* other = first == queueA ? queueB : queueA;
+  while (osal::MessageQueue::TryReceive(first, message, MESSAGE_SIZE) > 0)
+  {
+  }
+  ASSERT_EQ(1, osal::Poller::TimedWait(poller, ready, 2, 100));
+  EXPECT_EQ(other, ready[0].Queue);
+
+  osal::Poller::Delete(poller);
+  osal::MessageQueue::Delete(queueA);
+  osal::MessageQueue::Delete(queueB);
+}
+
+TEST(PollerUT, FileDescriptor)
+{
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  osal::Poller::Id* poller = osal::Poller::Create();
+  EXPECT_TRUE(osal::Poller::Add(poller, fds[0], osal::Poller::READABLE, 0));
+  EXPECT_FALSE(osal::Poller::Add(poller, -1, osal::Poller::READABLE, 0));
+
+  osal::Poller::Ready ready[4];
+  EXPECT_EQ(0, osal::Poller::TryWait(poller, ready, 4));
+  char c = 'x';
+  ASSERT_EQ(1, write(fds[1], &c, 1));
+  ASSERT_EQ(1, osal::Poller::TryWait(poller, ready, 4));
+  EXPECT_EQ(osal::Poller::FILE_DESCRIPTOR, ready[0].Type);
+  EXPECT_EQ(fds[0], ready[0].Fd);
+  EXPECT_EQ((unsigned int)osal::Poller::READABLE, ready[0].Events);
+  ASSERT_EQ(1, read(fds[0], &c, 1));
+  EXPECT_EQ(0, osal::Poller::TryWait(poller, ready, 4));
+
+  EXPECT_TRUE(osal::Poller::Remove(poller, fds[0]));
+  osal::Poller::Delete(poller);
+  close(fds[0]);
+  close(fds[1]);
+}
+
+TEST(PollerUT, WaitAndTimeout)
+{
+  osal::Poller::Id* poller = osal::Poller::Create();
+  remoteEvent = osal::EventNotification::Create();
+  EXPECT_TRUE(osal::Poller::Add(poller, remoteEvent, 0));
+
+  osal::Poller::Ready ready[2];
+  EXPECT_EQ(0, osal::Poller::TimedWait(poller, ready, 2, 10));
+
+  osal::Thread::Id* tid = osal::Thread::Create(osal::Thread::CreateAttribute("PollerT", 4048,
+                                                                             osal::Thread::Self::Priority()),
+                                               SignalFunction);
+  ASSERT_EQ(1, osal::Poller::Wait(poller, ready, 2));
+  EXPECT_EQ(remoteEvent, ready[0].Event);
+  EXPECT_TRUE(osal::EventNotification::TryWait(remoteEvent));
+  osal::Thread::Clean(tid);
+
+  osal::Poller::Delete(poller);
+  osal::EventNotification::Delete(remoteEvent);
+}
+
+} // end of local namespace
+
+#endif  // __linux__
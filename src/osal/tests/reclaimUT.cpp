@@ -0,0 +1,278 @@
+/*
+ * This would test the memory reclamation. To read more about
+ * this module read the comments in the header file
+ */
+#include "osal/Reclaim.h"   // module under test
+#include "osal/Thread.h"    // to access the nodes from few threads
+#include "osal/Mutex.h"     // to guard the nodes pool
+#include <gtest/gtest.h>    // unit test framework
+#include <vector>           // the nodes pool
+
+namespace   // all unit tests are private to this file
+{
+
+enum
+{
+  LIVE = 0x1234abcd,
+  FREED = 0xdeadbeef
+};
+
+struct Node
+{
+  Node* volatile Next;
+  volatile unsigned int Magic;
+  unsigned int Value;
+};
+
+// the freed nodes are kept and reused (like a MemoryPool would), so a node that was freed too
+// early would be changed while the readers are still using it
+struct NodesPool
+{
+  NodesPool() : Lock(osal::Mutex::Create()), Freed(0)
+  {
+  }
+
+  ~NodesPool()
+  {
+    for (std::vector<Node*>::iterator i = All.begin(); i != All.end(); ++i)
+    {
+      delete *i;
+    }
+    osal::Mutex::Delete(Lock);
+  }
+
+  Node* Alloc(unsigned int value)
+  {
+    osal::Mutex::Lock(Lock);
+    Node* node = 0;
+    if (Free.empty())
+    {
+      node = new Node;
+      All.push_back(node);
+    }
+    else
+    {
+      node = Free.back();
+      Free.pop_back();
+    }
+    osal::Mutex::Release(Lock);
+    node->Next = 0;
+    node->Magic = LIVE;
+    node->Value = value;
+    return node;
+  }
+
+  osal::Mutex::Id* Lock;
+  std::vector<Node*> All;
+  std::vector<Node*> Free;
+  unsigned int Freed;
+};
+
+void FreeNode(void* node, void* context)
+{
+  NodesPool* pool = static_cast<NodesPool*>(context);
+  Node* freed = static_cast<Node*>(node);
+  EXPECT_EQ((unsigned int)LIVE, freed->Magic);  // freed only once
+  freed->Magic = FREED;
+  osal::Mutex::Lock(pool->Lock);
+  pool->Free.push_back(freed);
+  ++pool->Freed;
+  osal::Mutex::Release(pool->Lock);
+}
+
+// lock free stack (Treiber) that is shared between the threads
+osal::Reclaim::Id* domain = 0;
+NodesPool* pool = 0;
+Node* volatile top = 0;
+volatile int errors = 0;
+volatile int nextValue = 0;
+volatile bool useHazards = false;
+
+const unsigned int THREADS = 4;
+const unsigned int OPERATIONS = 20000;
+
+void Push(Node* node)
+{
+  Node* head = __atomic_load_n(&top, __ATOMIC_RELAXED);
+  do
+  {
+    node->Next = head;
+  } while (!__atomic_compare_exchange_n(&top, &head, node, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+// the node that is returned is removed from the stack but not retired yet,
+// if pause is set, let the other threads run while we are holding the top node
+Node* PopWithEpochs(bool pause)
+{
+  osal::Reclaim::Guard guard(domain);
+  Node* head = __atomic_load_n(&top, __ATOMIC_ACQUIRE);
+  while (head)
+  {
+    if (pause)
+    {
+      osal::Thread::Self::Suspend();
+    }
+    if (head->Magic != LIVE)
+    {
+      __sync_fetch_and_add(&errors, 1);  // we are reading a node that was freed
+    }
+    Node* const next = head->Next;
+    if (__atomic_compare_exchange_n(&top, &head, next, false, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE))
+    {
+      break;
+    }
+  }
+  return head;
+}
+
+Node* PopWithHazards(bool pause)
+{
+  Node* head = 0;
+  for (;;)
+  {
+    head = osal::Reclaim::Protect(domain, 0, top);
+    if (!head)
+    {
+      break;
+    }
+    if (pause)
+    {
+      osal::Thread::Self::Suspend();
+    }
+    if (head->Magic != LIVE)
+    {
+      __sync_fetch_and_add(&errors, 1);
+    }
+    Node* expected = head;
+    if (__atomic_compare_exchange_n(&top, &expected, head->Next, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+    {
+      break;
+    }
+  }
+  osal::Reclaim::Clear(domain, 0);
+  return head;
+}
+
+void StackThread()
+{
+  for (unsigned int i = 0; i < OPERATIONS; i++)
+  {
+    if (i % 3 == 0)
+    {
+      Push(pool->Alloc(__sync_fetch_and_add(&nextValue, 1)));
+    }
+    else
+    {
+      const bool pause = i % 64 == 1;
+      Node* node = useHazards ? PopWithHazards(pause) : PopWithEpochs(pause);
+      if (node)
+      {
+        osal::Reclaim::Retire(domain, node);
+      }
+      else
+      {
+        Push(pool->Alloc(__sync_fetch_and_add(&nextValue, 1)));
+      }
+    }
+  }
+}
+
+void RunStack(bool hazards)
+{
+  NodesPool nodes;
+  pool = &nodes;
+  domain = osal::Reclaim::Create(FreeNode, &nodes);
+  top = 0;
+  errors = 0;
+  nextValue = 0;
+  useHazards = hazards;
+  osal::Thread::Id* threads[THREADS];
+  for (unsigned int i = 0; i < THREADS; i++)
+  {
+    threads[i] = osal::Thread::Create(osal::Thread::CreateAttribute("Reclaim", 64 * 1024,
+                                                                    osal::Thread::Self::Priority()),
+                                      StackThread);
+  }
+  for (unsigned int i = 0; i < THREADS; i++)
+  {
+    EXPECT_TRUE(osal::Thread::Clean(threads[i]));
+  }
+  EXPECT_EQ(0, errors);
+  // all the nodes are either in the stack, retired or freed
+  unsigned int inStack = 0;
+  for (Node* node = top; node; node = node->Next)
+  {
+    EXPECT_EQ((unsigned int)LIVE, node->Magic);
+    ++inStack;
+  }
+  const unsigned int pending = osal::Reclaim::Pending(domain);
+  EXPECT_EQ((unsigned int)nextValue, inStack + pending + nodes.Freed);
+  EXPECT_GT(nodes.Freed, 0u);   // the nodes are reused while the threads are running
+  EXPECT_LT(nodes.All.size(), (size_t)nextValue);
+  osal::Reclaim::Delete(domain);
+  EXPECT_EQ(0, domain);
+  EXPECT_EQ((unsigned int)nextValue, inStack + nodes.Freed);
+  pool = 0;
+}
+
+TEST(ReclaimUT, RetireOutsideAndInside)
+{
+  NodesPool nodes;
+  osal::Reclaim::Id* reclaim = osal::Reclaim::Create(FreeNode, &nodes);
+  for (unsigned int i = 0; i < 10; i++)
+  {
+    osal::Reclaim::Retire(reclaim, nodes.Alloc(i));
+  }
+  EXPECT_EQ(10u, osal::Reclaim::Pending(reclaim));
+  EXPECT_EQ(0u, osal::Reclaim::Flush(reclaim));
+  EXPECT_EQ(0u, osal::Reclaim::Pending(reclaim));
+  EXPECT_EQ(10u, nodes.Freed);
+  {
+    // while we are inside, the nodes that we may see must not be freed
+    osal::Reclaim::Guard guard(reclaim);
+    osal::Reclaim::Enter(reclaim);    // nested
+    osal::Reclaim::Retire(reclaim, nodes.Alloc(10));
+    osal::Reclaim::Leave(reclaim);
+    EXPECT_EQ(1u, osal::Reclaim::Flush(reclaim));
+    EXPECT_EQ(1u, osal::Reclaim::Flush(reclaim));
+    EXPECT_EQ(10u, nodes.Freed);
+  }
+  EXPECT_EQ(0u, osal::Reclaim::Flush(reclaim));
+  EXPECT_EQ(11u, nodes.Freed);
+  osal::Reclaim::Retire(reclaim, 0);  // ignored
+  osal::Reclaim::Retire(reclaim, nodes.Alloc(11));
+  osal::Reclaim::Delete(reclaim);
+  EXPECT_EQ(0, reclaim);
+  EXPECT_EQ(12u, nodes.Freed);
+}
+
+TEST(ReclaimUT, HazardKeepsNode)
+{
+  NodesPool nodes;
+  osal::Reclaim::Id* reclaim = osal::Reclaim::Create(FreeNode, &nodes);
+  Node* volatile shared = nodes.Alloc(1);
+  Node* node = osal::Reclaim::Protect(reclaim, 1, shared);
+  EXPECT_EQ(1u, node->Value);
+  shared = 0;   // unlink it
+  osal::Reclaim::Retire(reclaim, node);
+  EXPECT_EQ(1u, osal::Reclaim::Flush(reclaim));
+  EXPECT_EQ(1u, osal::Reclaim::Flush(reclaim));
+  EXPECT_EQ((unsigned int)LIVE, node->Magic);
+  osal::Reclaim::Clear(reclaim, 1);
+  EXPECT_EQ(0u, osal::Reclaim::Flush(reclaim));
+  EXPECT_EQ(1u, nodes.Freed);
+  EXPECT_EQ(0, osal::Reclaim::Protect(reclaim, 0, shared));
+  osal::Reclaim::Delete(reclaim);
+}
+
+TEST(ReclaimUT, StackWithEpochs)
+{
+  RunStack(false);
+}
+
+TEST(ReclaimUT, StackWithHazards)
+{
+  RunStack(true);
+}
+
+} // end of local namespace
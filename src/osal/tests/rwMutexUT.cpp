@@ -4,6 +4,7 @@
  */
 #include "osal/RWMutex.h" // module under test
 #include "osal/Thread.h"  // so we can test with more than one thread - assume that thread was tested
+#include "osal/Mutex.h"   // to update the counters of the readers
 #include <osal/StopWatch.h>    // this for class StopWatch
 #include "../OsalTimeUtils.h" // for timeout value
 #include <gtest/gtest.h>  // unit test framework
@@ -93,6 +94,35 @@ void SyncReadOnlyFunction()
   
 }
 
+// shared data for the readers/writer test - the writer always update both
+// values together, so a reader that see them different did not get the lock
+volatile unsigned int protectedFirst = 0;
+volatile unsigned int protectedSecond = 0;
+volatile unsigned int readersErrors = 0;
+volatile unsigned int readersRunning = 0;
+osal::Mutex::Id* readersLock = 0;   // to update the counters from the readers
+
+void ConsistentReadFunction()
+{
+  osal::Mutex::Lock(readersLock);
+  ++readersRunning;
+  osal::Mutex::Release(readersLock);
+  while (!finishRunning)
+  {
+    osal::RWMutex::ReadLock(mutex4Test);
+    if (protectedFirst != protectedSecond)
+    {
+      osal::Mutex::Lock(readersLock);
+      ++readersErrors;
+      osal::Mutex::Release(readersLock);
+    }
+    osal::RWMutex::Release(mutex4Test);
+  }
+  osal::Mutex::Lock(readersLock);
+  --readersRunning;
+  osal::Mutex::Release(readersLock);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 void EnsureNotEqual(osal::RWMutex::Id* left, osal::RWMutex::Id* right)
@@ -349,6 +379,96 @@ TEST(RWMutexUT, ReadLockNoWriteAccess)
   mutex4Test = 0;
 }
 
+#if !defined(__VXWORKS__)
+bool writerGotLock = false;
+bool readerGotLock = false;
+osal::milliseconds_t readerWaited = 0;
+
+void TimedWriterFunction()
+{
+  writerGotLock = osal::RWMutex::TimedWriteLock(mutex4Test, timeoutToBlock);
+  if (writerGotLock)
+  {
+    osal::RWMutex::Release(mutex4Test);
+  }
+}
+
+void BlockedReaderFunction()
+{
+  UT::StopWatch sw;
+  readerGotLock = osal::RWMutex::TimedReadLock(mutex4Test, timeoutToBlock * 10);
+  readerWaited = sw.Stop();
+  if (readerGotLock)
+  {
+    osal::RWMutex::Release(mutex4Test);
+  }
+}
+
+TEST(RWMutexUT, WriterTimeoutReleaseReaders)
+{
+  // a reader that is waiting behind a writer must get the lock once the writer gave up
+  mutex4Test = osal::RWMutex::Create();
+  osal::RWMutex::ReadLock(mutex4Test);
+  osal::Thread::Id* writer = osal::Thread::Create(osal::Thread::CreateAttribute("WriterT", 4048,
+                                                                                osal::Thread::Self::Priority()),
+                                                  TimedWriterFunction);
+  osal::Thread::Self::Sleep(timeoutToBlock / 4);  // so the writer would be waiting
+  osal::Thread::Id* reader = osal::Thread::Create(osal::Thread::CreateAttribute("ReaderT", 4048,
+                                                                                osal::Thread::Self::Priority()),
+                                                  BlockedReaderFunction);
+  osal::Thread::Clean(writer);
+  osal::Thread::Clean(reader);
+  osal::RWMutex::Release(mutex4Test);
+  EXPECT_FALSE(writerGotLock);
+  EXPECT_TRUE(readerGotLock);
+  EXPECT_LT(readerWaited, timeoutToBlock * 5);
+  osal::RWMutex::Delete(mutex4Test);
+  mutex4Test = 0;
+}
+
+TEST(RWMutexUT, ManyReadersWithWriter)
+{
+  // readers are taking the lock all the time while this thread is writing,
+  // make sure that none of the readers see partial update and that the writer
+  // is not starved by the readers
+  mutex4Test = osal::RWMutex::Create();
+  readersLock = osal::Mutex::Create();
+  finishRunning = false;
+  protectedFirst = protectedSecond = readersErrors = 0;
+  const unsigned int READERS = 4;
+  osal::Thread::Id* tids[READERS];
+  for (unsigned int i = 0; i < READERS; i++)
+  {
+    tids[i] = osal::Thread::Create(osal::Thread::CreateAttribute("ReadersT", 4048, 
+                                                                 osal::Thread::Self::Priority()),
+                                   ConsistentReadFunction);
+  }
+  while (readersRunning < READERS)
+  {
+    osal::Thread::Self::Suspend();
+  }
+  const unsigned int WRITES = 2000;
+  for (unsigned int i = 0; i < WRITES; i++)
+  {
+    osal::RWMutex::WriteLock(mutex4Test);
+    ++protectedFirst;
+    ++protectedSecond;
+    osal::RWMutex::Release(mutex4Test);
+  }
+  finishRunning = true;
+  for (unsigned int i = 0; i < READERS; i++)
+  {
+    osal::Thread::Clean(tids[i]);
+  }
+  EXPECT_EQ(0u, readersErrors);
+  EXPECT_EQ(WRITES, protectedFirst);
+  finishRunning = false;
+  osal::Mutex::Delete(readersLock);
+  osal::RWMutex::Delete(mutex4Test);
+  mutex4Test = 0;
+}
+#endif  // __VXWORKS__
+
 } // end of local namespace
 
 #endif  // !defined(__VXWORKS__) || defined(INCLUDE_SEM_READ_WRITE)
@@ -0,0 +1,197 @@
+/*
+ * This would test the sequence lock. To read more about
+ * this module read the comments in the header file
+ */
+#include "osal/SeqLock.h"   // module under test
+#include "osal/Thread.h"    // to read and write from few threads
+#include "osal/Mutex.h"     // to update the counters of the threads
+#include <gtest/gtest.h>    // unit test framework
+
+namespace   // all unit tests are private to this file
+{
+
+// the fields are depending on each other, so a reader that see a mix
+// of two writes would find that they are not consistent
+struct Payload
+{
+  unsigned long long Value;
+  unsigned long long Twice;
+  unsigned long long Inverse;
+  unsigned int Writer;
+  unsigned int Check;
+};
+
+Payload MakePayload(unsigned long long value, unsigned int writer)
+{
+  Payload payload = { value, value * 2, ~value, writer, (unsigned int)value ^ writer };
+  return payload;
+}
+
+bool Consistent(const Payload& payload)
+{
+  return payload.Twice == payload.Value * 2 && payload.Inverse == ~payload.Value &&
+         payload.Check == ((unsigned int)payload.Value ^ payload.Writer);
+}
+
+const unsigned int READERS = 4;
+const unsigned int WRITERS = 2;
+const unsigned int WRITES = 20000;
+
+osal::SeqLock<Payload>* sharedLock = 0;
+osal::Mutex::Id* countersLock = 0;
+volatile int writersRunning = 0;
+volatile int readersErrors = 0;
+volatile int readsDone = 0;
+volatile unsigned int nextWriter = 0;
+
+void WriterThread()
+{
+  osal::Mutex::Lock(countersLock);
+  const unsigned int writer = nextWriter++;
+  osal::Mutex::Release(countersLock);
+  for (unsigned int i = 1; i <= WRITES; i++)
+  {
+    if (i % 2)
+    {
+      sharedLock->Write(MakePayload(i, writer));
+    }
+    else
+    {
+      // change it in place, one field at a time
+      Payload& payload = sharedLock->BeginWrite();
+      payload.Value = i;
+      if (i % 64 == 0)
+      {
+        osal::Thread::Self::Suspend();  // let the readers run in the middle of the write
+      }
+      payload.Twice = i * 2ULL;
+      payload.Inverse = ~(unsigned long long)i;
+      payload.Writer = writer;
+      payload.Check = i ^ writer;
+      sharedLock->EndWrite();
+    }
+    if (i % 1000 == 0)
+    {
+      osal::Thread::Self::Suspend();  // let the readers see the values
+    }
+  }
+  osal::Mutex::Lock(countersLock);
+  --writersRunning;
+  osal::Mutex::Release(countersLock);
+}
+
+void ReaderThread()
+{
+  unsigned long long last[WRITERS] = { 0 };
+  int reads = 0;
+  while (writersRunning > 0)
+  {
+    Payload payload = sharedLock->Read();
+    if (!Consistent(payload) || payload.Writer >= WRITERS || payload.Value < last[payload.Writer])
+    {
+      osal::Mutex::Lock(countersLock);
+      ++readersErrors;
+      osal::Mutex::Release(countersLock);
+    }
+    else
+    {
+      last[payload.Writer] = payload.Value;   // each writer is only moving forward
+    }
+    // and read a single field in place
+    unsigned int ticket = 0;
+    unsigned long long value = 0;
+    unsigned long long twice = 0;
+    do
+    {
+      ticket = sharedLock->BeginRead();
+      value = sharedLock->Data().Value;
+      if (reads % 64 == 0)
+      {
+        osal::Thread::Self::Suspend();  // let the writers run in the middle of the read
+      }
+      twice = sharedLock->Data().Twice;
+    } while (!sharedLock->EndRead(ticket));
+    if (twice != value * 2)
+    {
+      osal::Mutex::Lock(countersLock);
+      ++readersErrors;
+      osal::Mutex::Release(countersLock);
+    }
+    ++reads;
+  }
+  osal::Mutex::Lock(countersLock);
+  readsDone += reads;
+  osal::Mutex::Release(countersLock);
+}
+
+TEST(SeqLockUT, SingleThread)
+{
+  osal::SeqLock<Payload> lock(MakePayload(5, 0));
+  EXPECT_EQ(5u, lock.Read().Value);
+  lock.Write(MakePayload(7, 1));
+  Payload payload = MakePayload(0, 0);
+  EXPECT_TRUE(lock.TryRead(payload));
+  EXPECT_EQ(7u, payload.Value);
+  EXPECT_EQ(1u, payload.Writer);
+  EXPECT_TRUE(Consistent(payload));
+  // while a write is in progress the readers must not see the data
+  lock.BeginWrite().Value = 9;
+  EXPECT_FALSE(lock.TryRead(payload));
+  EXPECT_EQ(7u, payload.Value);   // not changed
+  lock.EndWrite();
+  EXPECT_TRUE(lock.TryRead(payload));
+  EXPECT_EQ(9u, payload.Value);
+}
+
+TEST(SeqLockUT, StaleTicket)
+{
+  osal::SeqLock<unsigned int> lock(1);
+  const unsigned int ticket = lock.BeginRead();
+  EXPECT_EQ(1u, lock.Data());
+  EXPECT_TRUE(lock.EndRead(ticket));
+  lock.Write(2);
+  EXPECT_FALSE(lock.EndRead(ticket));   // the data was changed since we started to read
+  EXPECT_EQ(2u, lock.Read());
+}
+
+TEST(SeqLockUT, ManyReadersAndWriters)
+{
+  // hammer the lock from few readers while the writers are publishing new values,
+  // none of the readers may ever see a mix of two values
+  osal::SeqLock<Payload> lock(MakePayload(0, 0));
+  sharedLock = &lock;
+  countersLock = osal::Mutex::Create();
+  writersRunning = WRITERS;
+  readersErrors = 0;
+  readsDone = 0;
+  nextWriter = 0;
+  osal::Thread::Id* readers[READERS];
+  osal::Thread::Id* writers[WRITERS];
+  for (unsigned int i = 0; i < READERS; i++)
+  {
+    readers[i] = osal::Thread::Create(osal::Thread::CreateAttribute("SeqReader", 4048, osal::Thread::Self::Priority()),
+                                      ReaderThread);
+  }
+  for (unsigned int i = 0; i < WRITERS; i++)
+  {
+    writers[i] = osal::Thread::Create(osal::Thread::CreateAttribute("SeqWriter", 4048, osal::Thread::Self::Priority()),
+                                      WriterThread);
+  }
+  for (unsigned int i = 0; i < WRITERS; i++)
+  {
+    EXPECT_TRUE(osal::Thread::Clean(writers[i]));
+  }
+  for (unsigned int i = 0; i < READERS; i++)
+  {
+    EXPECT_TRUE(osal::Thread::Clean(readers[i]));
+  }
+  EXPECT_EQ(0, readersErrors);
+  EXPECT_GT(readsDone, 0);
+  const Payload last = lock.Read();
+  EXPECT_TRUE(Consistent(last));
+  EXPECT_EQ((unsigned long long)WRITES, last.Value);
+  osal::Mutex::Delete(countersLock);
+  sharedLock = 0;
+}
+
+} // end of local namespace
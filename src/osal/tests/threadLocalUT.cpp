@@ -0,0 +1,206 @@
+/*
+ * This would test the thread local storage. To read more about
+ * this module read the comments in the header file
+ */
+#include "osal/ThreadLocal.h"   // module under test
+#include "osal/Thread.h"        // to have values in few threads
+#include "osal/Mutex.h"         // to count the values from few threads
+#include <gtest/gtest.h>        // unit test framework
+
+namespace   // all unit tests are private to this file
+{
+
+// the values are created and deleted by the threads of the test
+osal::Mutex::Id* countersLock = osal::Mutex::Create();
+
+struct Counter
+{
+  Counter() : Value(0)
+  {
+    osal::Mutex::Lock(countersLock);
+    ++created;
+    osal::Mutex::Release(countersLock);
+  }
+
+  ~Counter()
+  {
+    osal::Mutex::Lock(countersLock);
+    ++deleted;
+    osal::Mutex::Release(countersLock);
+  }
+
+  volatile unsigned long Value;
+  static volatile int created;
+  static volatile int deleted;
+};
+
+volatile int Counter::created = 0;
+volatile int Counter::deleted = 0;
+
+struct OtherTag;
+
+void Sum(Counter& counter, void* context)
+{
+  *static_cast<unsigned long*>(context) += counter.Value;
+}
+
+const unsigned int THREADS = 4;
+const unsigned long INCREMENTS = 1000;
+
+osal::ThreadLocal<Counter>* counters = 0;
+volatile int ready = 0;
+volatile bool stopThreads = false;
+
+void CountingThread()
+{
+  for (unsigned long i = 0; i < INCREMENTS; i++)
+  {
+    ++counters->Get().Value;
+  }
+  EXPECT_EQ(INCREMENTS, (*counters)->Value);  // each thread see only its own value
+  osal::Mutex::Lock(countersLock);
+  ++ready;
+  osal::Mutex::Release(countersLock);
+  while (!stopThreads)
+  {
+    osal::Thread::Self::Sleep(1);
+  }
+}
+
+// touch the value and exit at once, so the storage may be deleted while the thread is exiting
+void ExitingThread()
+{
+  ++counters->Get().Value;
+  osal::Mutex::Lock(countersLock);
+  ++ready;
+  osal::Mutex::Release(countersLock);
+}
+
+TEST(ThreadLocalUT, LazyCreation)
+{
+  Counter::created = 0;
+  Counter::deleted = 0;
+  {
+    osal::ThreadLocal<Counter> local;
+    EXPECT_EQ(0, Counter::created);   // nothing is created until it is used
+    EXPECT_EQ(0u, local.Count());
+    Counter& first = local.Get();
+    EXPECT_EQ(1, Counter::created);
+    EXPECT_EQ(&first, &local.Get());
+    first.Value = 5;
+    EXPECT_EQ(5u, (*local).Value);
+    EXPECT_EQ(1u, local.Count());
+  }
+  EXPECT_EQ(1, Counter::deleted);   // the value is deleted with the storage
+  {
+    // a new storage must not see the value from the old one
+    osal::ThreadLocal<Counter> local;
+    EXPECT_EQ(0u, local->Value);
+    EXPECT_EQ(2, Counter::created);
+  }
+  EXPECT_EQ(2, Counter::deleted);
+}
+
+TEST(ThreadLocalUT, Tags)
+{
+  osal::ThreadLocal<Counter> first;
+  osal::ThreadLocal<Counter, OtherTag> second;
+  first->Value = 1;
+  second->Value = 2;
+  EXPECT_EQ(1u, first->Value);
+  EXPECT_EQ(2u, second->Value);
+  EXPECT_NE(&first.Get(), &second.Get());
+}
+
+TEST(ThreadLocalUT, SameType)
+{
+  // the second object can't use the thread local variable, but it must have its own values
+  osal::ThreadLocal<Counter> first;
+  first->Value = 1;
+  {
+    osal::ThreadLocal<Counter> second;
+    EXPECT_EQ(0u, second->Value);
+    second->Value = 2;
+    EXPECT_EQ(1u, first->Value);
+    EXPECT_EQ(2u, second->Value);
+    EXPECT_NE(&first.Get(), &second.Get());
+    EXPECT_EQ(1u, second.Count());
+  }
+  EXPECT_EQ(1u, first->Value);
+  EXPECT_EQ(1u, first.Count());
+}
+
+TEST(ThreadLocalUT, ManyThreads)
+{
+  Counter::created = 0;
+  Counter::deleted = 0;
+  unsigned long exited = 0;
+  osal::ThreadLocal<Counter> local(Sum, &exited);
+  counters = &local;
+  ready = 0;
+  stopThreads = false;
+  osal::Thread::Id* threads[THREADS];
+  for (unsigned int i = 0; i < THREADS; i++)
+  {
+    threads[i] = osal::Thread::Create(osal::Thread::CreateAttribute("Local", 16 * 1024, osal::Thread::Self::Priority()),
+                                      CountingThread);
+  }
+  while (ready < (int)THREADS)
+  {
+    osal::Thread::Self::Sleep(1);
+  }
+  // all the threads are alive - we can sum their values
+  EXPECT_EQ(THREADS, local.Count());
+  unsigned long total = 0;
+  local.ForEach(Sum, &total);
+  EXPECT_EQ(THREADS * INCREMENTS, total);
+  EXPECT_EQ(0u, exited);
+
+  stopThreads = true;
+  for (unsigned int i = 0; i < THREADS; i++)
+  {
+    EXPECT_TRUE(osal::Thread::Clean(threads[i]));
+  }
+  // the values were removed when the threads exit, and added to the total
+  EXPECT_EQ(0u, local.Count());
+  EXPECT_EQ(THREADS * INCREMENTS, exited);
+  EXPECT_EQ((int)THREADS, Counter::created);
+  EXPECT_EQ((int)THREADS, Counter::deleted);
+  total = 0;
+  local.ForEach(Sum, &total);
+  EXPECT_EQ(0u, total);
+  counters = 0;
+}
+
+TEST(ThreadLocalUT, DeleteWhileThreadsExit)
+{
+  // every value must be deleted exactly once - either by the thread or by the storage
+  Counter::created = 0;
+  Counter::deleted = 0;
+  for (unsigned int round = 0; round < 50; round++)
+  {
+    unsigned long exited = 0;
+    counters = new osal::ThreadLocal<Counter>(Sum, &exited);
+    ready = 0;
+    osal::Thread::Id* threads[THREADS];
+    for (unsigned int i = 0; i < THREADS; i++)
+    {
+      threads[i] = osal::Thread::Create(osal::Thread::CreateAttribute("Exiting", 16 * 1024, osal::Thread::Self::Priority()),
+                                        ExitingThread);
+    }
+    while (ready < (int)THREADS)
+    {
+      osal::Thread::Self::Suspend();
+    }
+    delete counters;
+    for (unsigned int i = 0; i < THREADS; i++)
+    {
+      EXPECT_TRUE(osal::Thread::Clean(threads[i]));
+    }
+  }
+  counters = 0;
+  EXPECT_EQ((int)(THREADS * 50), Counter::created);
+  EXPECT_EQ(Counter::created, Counter::deleted);
+}
+
+} // end of local namespace
@@ -0,0 +1,129 @@
+/*
+ * This would test the thread pool. You can read more
+ * about this module in the header file for this module
+ */
+#include "osal/ThreadPool.h"       // module under test
+#include "osal/Mutex.h"            // to count the tasks
+#include "osal/Thread.h"           // the workers attributes
+#include <gtest/gtest.h>           // unit test framework
+#include <vector>                  // to check ParallelFor
+
+namespace   // all unit tests are private to this file
+{
+
+osal::ThreadPool::Id* pool = 0;
+osal::Mutex::Id* counterLock = 0;
+unsigned int counter = 0;
+
+osal::ThreadPool::Id* CreatePool(unsigned int workers)
+{
+  counterLock = osal::Mutex::Create();
+  counter = 0;
+  return osal::ThreadPool::Create(workers, osal::Thread::CreateAttribute("PoolT", 64 * 1024,
+                                                                          osal::Thread::Self::Priority()));
+}
+
+void DeletePool()
+{
+  osal::ThreadPool::Delete(pool);
+  osal::Mutex::Delete(counterLock);
+}
+
+void Count(void*)
+{
+  osal::Mutex::Lock(counterLock);
+  ++counter;
+  osal::Mutex::Release(counterLock);
+}
+
+// each task split itself in two, until the depth is 0, and wait for both parts
+void Split(void* context)
+{
+  const long depth = reinterpret_cast<long>(context);
+  Count(0);
+  if (depth > 0)
+  {
+    osal::ThreadPool::Group parts;
+    osal::ThreadPool::Submit(pool, Split, reinterpret_cast<void*>(depth - 1), &parts);
+    osal::ThreadPool::Submit(pool, Split, reinterpret_cast<void*>(depth - 1), &parts);
+    osal::ThreadPool::Wait(pool, parts);
+    EXPECT_EQ(0u, osal::ThreadPool::Pending(parts));
+  }
+}
+
+void Visit(unsigned int begin, unsigned int end, void* context)
+{
+  std::vector<unsigned int>& visited = *static_cast<std::vector<unsigned int>*>(context);
+  EXPECT_LT(begin, end);
+  for (unsigned int i = begin; i < end; i++)
+  {
+    ++visited[i];   // each index is only visited from a single task
+  }
+}
+
+TEST(ThreadPoolUT, SubmitAndWait)
+{
+  pool = CreatePool(4);
+  EXPECT_EQ(4u, osal::ThreadPool::Workers(pool));
+  osal::ThreadPool::Group group;
+  EXPECT_EQ(0u, osal::ThreadPool::Pending(group));
+  for (unsigned int i = 0; i < 1000; i++)
+  {
+    osal::ThreadPool::Submit(pool, Count, 0, &group);
+  }
+  osal::ThreadPool::Wait(pool, group);
+  EXPECT_EQ(0u, osal::ThreadPool::Pending(group));
+  EXPECT_EQ(1000u, counter);
+
+  osal::ThreadPool::Task tasks[10];
+  for (unsigned int i = 0; i < 10; i++)
+  {
+    tasks[i].Func = Count;
+    tasks[i].Context = 0;
+  }
+  osal::ThreadPool::SubmitBatch(pool, tasks, 10, &group);
+  osal::ThreadPool::Wait(pool, group);
+  EXPECT_EQ(1010u, counter);
+  DeletePool();
+}
+
+TEST(ThreadPoolUT, NestedWait)
+{
+  // the tasks are waiting from inside the pool, this would dead lock if the wait was not helping
+  pool = CreatePool(2);
+  osal::ThreadPool::Group group;
+  osal::ThreadPool::Submit(pool, Split, reinterpret_cast<void*>(10L), &group);
+  osal::ThreadPool::Wait(pool, group);
+  EXPECT_EQ(2047u, counter);
+  DeletePool();
+}
+
+TEST(ThreadPoolUT, ParallelFor)
+{
+  pool = CreatePool(0);
+  EXPECT_LT(0u, osal::ThreadPool::Workers(pool));
+  const unsigned int grains[] = { 0, 1, 7, 1000, 100000 };
+  for (unsigned int g = 0; g < sizeof(grains) / sizeof(grains[0]); g++)
+  {
+    std::vector<unsigned int> visited(10003, 0);
+    osal::ThreadPool::ParallelFor(pool, 3, 10003, grains[g], Visit, &visited);
+    for (unsigned int i = 0; i < visited.size(); i++)
+    {
+      ASSERT_EQ(i < 3 ? 0u : 1u, visited[i]) << "index " << i << " grain " << grains[g];
+    }
+  }
+  DeletePool();
+}
+
+TEST(ThreadPoolUT, DeleteRunAll)
+{
+  pool = CreatePool(3);
+  for (unsigned int i = 0; i < 500; i++)
+  {
+    osal::ThreadPool::Submit(pool, Count, 0);
+  }
+  DeletePool();
+  EXPECT_EQ(500u, counter);
+}
+
+} // end of local namespace
@@ -13,6 +13,13 @@
 #include <osal/StopWatch.h>    // this for class StopWatch
 #include <gtest/gtest.h>  // unit test framework
 #include <string>         // class string
+#ifdef __linux__
+# include "osal/Mutex.h"        // the lock that a cancelled thread is waiting for
+# include "../posix/Futex.h"    // EventCount
+# include <pthread.h>           // pthread_cancel
+# include <sys/wait.h>          // waitpid
+# include <unistd.h>            // fork
+#endif  // __linux__
 
 namespace   // al tests would be hide from the outside of this compilation unit
 {
@@ -95,6 +102,37 @@ TEST(ThreadUnitTest, BasicUsage)
   osal::Thread::Clean(tid1);
 }
 
+TEST(ThreadUnitTest, AffinityTest)
+{
+  osal::Thread::CpuSet cpus;
+  EXPECT_EQ(cpus.Empty(), true);
+  cpus.Set(0);
+  cpus.Set(65);
+  EXPECT_EQ(cpus.Empty(), false);
+  EXPECT_EQ(cpus.IsSet(0), true);
+  EXPECT_EQ(cpus.IsSet(1), false);
+  EXPECT_EQ(cpus.IsSet(65), true);
+  cpus.Clear(65);
+  EXPECT_EQ(cpus.IsSet(65), false);
+  cpus.Set(osal::Thread::CpuSet::MAX_CPUS); // out of range should be ignored
+  EXPECT_EQ(cpus.IsSet(osal::Thread::CpuSet::MAX_CPUS), false);
+  
+  osal::Thread::Attributes attr = osal::Thread::CreateAttribute("AffinityT", 4048, 
+                                                                osal::Thread::Self::Priority(), cpus);
+  EXPECT_EQ(attr.Affinity.IsSet(0), true);
+  // the thread must run even if we bind it to a single CPU
+  stopRunning = false;
+  threadIsRunning = false;
+  osal::Thread::Id* tid = osal::Thread::Create(attr, ThreadFunction);
+  EXPECT_NE(INVALID_TID, tid);
+  osal::Thread::Self::Sleep(osal::TimeUtils::MinResolution());
+#if !defined(WIN32)
+  EXPECT_EQ(threadIsRunning, true);
+#endif  // WIN32
+  stopRunning = true;
+  EXPECT_EQ(osal::Thread::Clean(tid), true);
+}
+
 TEST(ThreadUnitTest, SelfThreadTest)
 {
   // this test would not work under windows
@@ -121,4 +159,94 @@ TEST(ThreadUnitTest, SelfThreadTest)
 #endif  // __VXWORKS__
 }
   
+#ifdef __linux__
+// a thread that is cancelled while it is blocked must not be unwound in the middle of the wait -
+// it must not own the lock it was waiting for, or stay counted as a waiter
+osal::Mutex::Id* cancelledLock = 0;
+osal::Private::EventCount* cancelledEvent = 0;
+volatile int cancelledStarted = 0;
+volatile int cancelledPassed = 0;
+
+void* LockAndExit(void*)
+{
+  osal::Private::AtomicStore(&cancelledStarted, 1);
+  osal::Mutex::Lock(cancelledLock);   // we would be cancelled while we are waiting here
+  osal::Private::AtomicStore(&cancelledPassed, 1);
+  osal::Mutex::Release(cancelledLock);
+  return 0;
+}
+
+void* WaitForEvent(void*)
+{
+  const int ticket = cancelledEvent->PrepareWait();
+  osal::Private::AtomicStore(&cancelledStarted, 1);
+  cancelledEvent->Wait(ticket, 0);    // we would be cancelled once this is done
+  osal::Private::AtomicStore(&cancelledPassed, 1);
+  return 0;
+}
+
+TEST(ThreadUnitTest, CancelWhileLockingPI)
+{
+  cancelledLock = osal::Mutex::CreateRecursive(osal::Mutex::PRIORITY_SAFE);
+  cancelledStarted = cancelledPassed = 0;
+  osal::Mutex::Lock(cancelledLock);
+  pthread_t thread;
+  ASSERT_EQ(0, pthread_create(&thread, 0, LockAndExit, 0));
+  while (!osal::Private::AtomicLoad(&cancelledStarted))
+  {
+    osal::Thread::Self::Sleep(1);
+  }
+  osal::Thread::Self::Sleep(20);  // let it block in the kernel
+  EXPECT_EQ(0, pthread_cancel(thread));
+  void* result = 0;
+  EXPECT_EQ(0, pthread_join(thread, &result));   // while we are still holding the lock
+  EXPECT_EQ(PTHREAD_CANCELED, result);
+  EXPECT_EQ(0, cancelledPassed);
+  osal::Mutex::Release(cancelledLock);
+  EXPECT_TRUE(osal::Mutex::TryLock(cancelledLock));   // it is not owned by the thread that is gone
+  osal::Mutex::Release(cancelledLock);
+  osal::Mutex::Delete(cancelledLock);
+}
+
+TEST(ThreadUnitTest, CancelWhileWaitingOnEventCount)
+{
+  osal::Private::EventCount event;
+  cancelledEvent = &event;
+  cancelledStarted = cancelledPassed = 0;
+  pthread_t thread;
+  ASSERT_EQ(0, pthread_create(&thread, 0, WaitForEvent, 0));
+  while (!osal::Private::AtomicLoad(&cancelledStarted))
+  {
+    osal::Thread::Self::Sleep(1);
+  }
+  osal::Thread::Self::Sleep(20);
+  EXPECT_EQ(0, pthread_cancel(thread));
+  EXPECT_TRUE(event.HasWaiters());
+  event.Notify(true);
+  void* result = 0;
+  EXPECT_EQ(0, pthread_join(thread, &result));
+  EXPECT_EQ(PTHREAD_CANCELED, result);
+  EXPECT_EQ(0, cancelledPassed);
+  EXPECT_FALSE(event.HasWaiters());  // so the next Notify would not go to the kernel
+}
+
+TEST(ThreadUnitTest, ThreadIdAfterFork)
+{
+  // the id that we cached is of the parent, the child must not use it as the owner of its locks
+  const pid_t parentId = osal::Private::CurrentThreadId();
+  pid_t child = fork();
+  ASSERT_NE(-1, child);
+  if (child == 0)
+  {
+    // the main thread of a process has the id of the process
+    _exit(osal::Private::CurrentThreadId() == getpid() ? 0 : 1);
+  }
+  int status = -1;
+  ASSERT_EQ(child, waitpid(child, &status, 0));
+  EXPECT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(0, WEXITSTATUS(status));
+  EXPECT_EQ(parentId, osal::Private::CurrentThreadId());
+}
+#endif  // __linux__
+
 } // end of local namespace
@@ -0,0 +1,178 @@
+/*
+ * This would test the timer service. You can read more
+ * about this module in the header file for this module
+ */
+#include "osal/TimerService.h"       // module under test
+#include "osal/MessageQueue.h"       // to test timers that are sent to a queue
+#include "osal/EventNotification.h"  // to know when the timer thread fired
+#include "osal/Thread.h"             // to sleep
+#include "osal/StopWatch.h"          // to make sure that the timers are not fired too early
+#include <gtest/gtest.h>             // unit test framework
+#include <vector>                    // to record the timers that fired
+
+namespace   // all unit tests are private to this file
+{
+
+std::vector<int> firedTimers;
+osal::EventNotification::Id* timerFired = 0;
+
+void RecordTimer(void* context)
+{
+  firedTimers.push_back(*static_cast<int*>(context));
+}
+
+void SignalTimer(void* context)
+{
+  RecordTimer(context);
+  osal::EventNotification::Signal(timerFired);
+}
+
+struct DueTime
+{
+  osal::nanoseconds_t Due;
+  osal::nanoseconds_t FiredAt;
+};
+
+void CheckDueTime(void* context)
+{
+  static_cast<DueTime*>(context)->FiredAt = osal::StopWatchOper::Now();
+}
+
+// poll until all the timers are fired or the time is out
+void PollAll(osal::TimerService::Id* timers, osal::milliseconds_t timeout)
+{
+  UT::StopWatch sw;
+  while (osal::TimerService::Pending(timers) > 0 && sw.Pause() < timeout)
+  {
+    osal::milliseconds_t wait = osal::TimerService::NextTimeout(timers);
+    osal::Thread::Self::Sleep(wait > 0 ? wait : 1);
+    osal::TimerService::Poll(timers);
+  }
+}
+
+TEST(TimerServiceUT, PollInOrder)
+{
+  firedTimers.clear();
+  osal::TimerService::Id* timers = osal::TimerService::Create(10, 1);
+  int ids[] = {0, 1, 2};
+  osal::TimerService::Schedule(timers, 30, RecordTimer, &ids[2]);
+  osal::TimerService::Schedule(timers, 10, RecordTimer, &ids[0]);
+  osal::TimerService::Schedule(timers, 20, RecordTimer, &ids[1]);
+  EXPECT_EQ(3u, osal::TimerService::Pending(timers));
+  EXPECT_EQ(0u, osal::TimerService::Poll(timers));  // nothing should fire yet
+  EXPECT_GT(osal::TimerService::NextTimeout(timers), 0u);
+  PollAll(timers, 1000);
+  ASSERT_EQ(3u, firedTimers.size());
+  for (int i = 0; i < 3; i++)
+  {
+    EXPECT_EQ(i, firedTimers[i]);
+  }
+  EXPECT_EQ(0u, osal::TimerService::Pending(timers));
+  osal::TimerService::Delete(timers);
+  EXPECT_EQ((osal::TimerService::Id*)0, timers);
+}
+
+TEST(TimerServiceUT, Cancel)
+{
+  firedTimers.clear();
+  osal::TimerService::Id* timers = osal::TimerService::Create(10, 1);
+  int ids[] = {0, 1, 2};
+  osal::TimerService::Handle h1 = osal::TimerService::Schedule(timers, 10, RecordTimer, &ids[0]);
+  osal::TimerService::Handle h2 = osal::TimerService::Schedule(timers, 10, RecordTimer, &ids[1]);
+  osal::TimerService::Handle h3 = osal::TimerService::Schedule(timers, 100000, RecordTimer, &ids[2]);
+  EXPECT_NE(osal::TimerService::INVALID_HANDLE, h1);
+  EXPECT_NE(h1, h2);
+  EXPECT_TRUE(osal::TimerService::Cancel(timers, h1));
+  EXPECT_FALSE(osal::TimerService::Cancel(timers, h1)); // already cancelled
+  EXPECT_TRUE(osal::TimerService::Cancel(timers, h3));  // from the higher levels of the wheel
+  EXPECT_FALSE(osal::TimerService::Cancel(timers, osal::TimerService::INVALID_HANDLE));
+  PollAll(timers, 1000);
+  ASSERT_EQ(1u, firedTimers.size());
+  EXPECT_EQ(1, firedTimers[0]);
+  EXPECT_FALSE(osal::TimerService::Cancel(timers, h2)); // already fired
+  // the handle must not be valid even when the timer is reused
+  osal::TimerService::Handle h4 = osal::TimerService::Schedule(timers, 10, RecordTimer, &ids[0]);
+  EXPECT_FALSE(osal::TimerService::Cancel(timers, h2));
+  EXPECT_TRUE(osal::TimerService::Cancel(timers, h4));
+  osal::TimerService::Delete(timers);
+}
+
+TEST(TimerServiceUT, MaxTimers)
+{
+  int id = 0;
+  osal::TimerService::Id* timers = osal::TimerService::Create(2, 1);
+  osal::TimerService::Handle h = osal::TimerService::Schedule(timers, 10, RecordTimer, &id);
+  EXPECT_NE(osal::TimerService::INVALID_HANDLE, osal::TimerService::Schedule(timers, 10, RecordTimer, &id));
+  EXPECT_EQ(osal::TimerService::INVALID_HANDLE, osal::TimerService::Schedule(timers, 10, RecordTimer, &id));
+  EXPECT_TRUE(osal::TimerService::Cancel(timers, h));
+  EXPECT_NE(osal::TimerService::INVALID_HANDLE, osal::TimerService::Schedule(timers, 10, RecordTimer, &id));
+  osal::TimerService::Delete(timers);
+}
+
+TEST(TimerServiceUT, ManyTimers)
+{
+  // make sure that timers that are cascaded from the higher levels of the wheel
+  // are fired, and that none of them is fired before its time
+  const unsigned int TIMERS = 20000;
+  const osal::milliseconds_t MAX_DELAY = 700;
+  std::vector<DueTime> due(TIMERS);
+  osal::TimerService::Id* timers = osal::TimerService::Create(TIMERS, 1);
+  for (unsigned int i = 0; i < TIMERS; i++)
+  {
+    const osal::milliseconds_t delay = (i * 7) % MAX_DELAY;
+    due[i].Due = osal::StopWatchOper::Now() + delay * 1000000ULL;
+    due[i].FiredAt = 0;
+    EXPECT_NE(osal::TimerService::INVALID_HANDLE, osal::TimerService::Schedule(timers, delay, CheckDueTime, &due[i]));
+  }
+  PollAll(timers, MAX_DELAY * 4);
+  EXPECT_EQ(0u, osal::TimerService::Pending(timers));
+  for (unsigned int i = 0; i < TIMERS; i++)
+  {
+    EXPECT_GE(due[i].FiredAt, due[i].Due);
+  }
+  osal::TimerService::Delete(timers);
+}
+
+TEST(TimerServiceUT, ServiceThread)
+{
+  firedTimers.clear();
+  timerFired = osal::EventNotification::Create();
+  int id = 7;
+  osal::TimerService::Id* timers = osal::TimerService::Create(10, 1);
+  osal::TimerService::Start(timers, "TimersT", osal::Thread::Self::Priority());
+  // the thread is sleeping, this should wake it up
+  UT::StopWatch sw;
+  osal::TimerService::Schedule(timers, 20, SignalTimer, &id);
+  EXPECT_TRUE(osal::EventNotification::TimedWait(timerFired, 1000));
+  EXPECT_GE(sw.Pause(), 20u);
+  ASSERT_EQ(1u, firedTimers.size());
+  EXPECT_EQ(id, firedTimers[0]);
+  osal::TimerService::Stop(timers);
+  osal::TimerService::Delete(timers);
+  osal::EventNotification::Delete(timerFired);
+}
+
+TEST(TimerServiceUT, TargetQueue)
+{
+  firedTimers.clear();
+  int id = 3;
+  osal::MessageQueue::Id* queue = osal::MessageQueue::Create(10, osal::TimerService::MESSAGE_SIZE);
+  osal::TimerService::Id* timers = osal::TimerService::Create(10, 1);
+  osal::TimerService::Start(timers, "TimersQueueT", osal::Thread::Self::Priority());
+  osal::TimerService::Schedule(timers, 5, RecordTimer, &id, queue);
+  char buffer[osal::TimerService::MESSAGE_SIZE];
+  int size = osal::MessageQueue::TimedReceive(queue, buffer, sizeof(buffer), 1000);
+  EXPECT_TRUE(firedTimers.empty()); // not called by the timer thread
+  EXPECT_TRUE(osal::TimerService::Dispatch(buffer, size));
+  ASSERT_EQ(1u, firedTimers.size());
+  EXPECT_EQ(id, firedTimers[0]);
+  EXPECT_FALSE(osal::TimerService::Dispatch(buffer, size - 1));
+  // a message of the same size that was not sent by the service
+  osal::TimerService::Expired other = { buffer, RecordTimer, &id };
+  EXPECT_FALSE(osal::TimerService::Dispatch((const char*)&other, sizeof(other)));
+  EXPECT_EQ(1u, firedTimers.size());
+  osal::TimerService::Delete(timers);
+  osal::MessageQueue::Delete(queue);
+}
+
+} // end of local namespace
@@ -0,0 +1,227 @@
+/*
+ * This would test the machine topology. To read more about
+ * this module read the comments in the header file
+ */
+#include "osal/Topology.h"  // module under test
+#include "osal/Thread.h"    // to place threads
+#include <gtest/gtest.h>    // unit test framework
+#include <sys/stat.h>       // mkdir
+#include <unistd.h>         // sysconf
+#include <stdio.h>          // fopen
+#include <stdlib.h>         // mkdtemp
+#include <string>           // the paths
+
+namespace   // all unit tests are private to this file
+{
+
+// create the file with all the directories above it
+void MakeFile(const std::string& path, const char* content)
+{
+  for (std::string::size_type slash = path.find('/', 1); slash != std::string::npos; slash = path.find('/', slash + 1))
+  {
+    mkdir(path.substr(0, slash).c_str(), 0755);
+  }
+  FILE* file = fopen(path.c_str(), "w");
+  ASSERT_TRUE(file != 0);
+  fprintf(file, "%s\n", content);
+  fclose(file);
+}
+
+// the sysfs of a machine with 2 packages, each with 2 cores with 2 hyper threads. each core has its
+// own L2 and each package has its own L3 and its own NUMA node. the siblings are numbered as in Intel
+// machines - CPU 0 and 4 are on the same core
+class FakeMachine
+{
+public:
+  FakeMachine()
+  {
+    char root[] = "/tmp/topologyUT.XXXXXX";
+    if (mkdtemp(root))
+    {
+      mRoot = root;
+    }
+    const char* siblings[] = { "0,4", "1,5", "2,6", "3,7" };
+    const char* packages[] = { "0-1,4-5", "2-3,6-7" };
+    MakeFile(mRoot + "/devices/system/cpu/online", "0-7");
+    for (unsigned int cpu = 0; cpu < 8; cpu++)
+    {
+      char dir[128];
+      snprintf(dir, sizeof(dir), "%s/devices/system/cpu/cpu%u/", mRoot.c_str(), cpu);
+      const unsigned int core = cpu % 4;
+      const unsigned int package = core / 2;
+      MakeFile(std::string(dir) + "topology/thread_siblings_list", siblings[core]);
+      MakeFile(std::string(dir) + "topology/physical_package_id", package ? "1" : "0");
+      MakeFile(std::string(dir) + "cache/index0/level", "1");
+      MakeFile(std::string(dir) + "cache/index0/type", "Data");
+      MakeFile(std::string(dir) + "cache/index0/shared_cpu_list", siblings[core]);
+      MakeFile(std::string(dir) + "cache/index1/level", "1");
+      MakeFile(std::string(dir) + "cache/index1/type", "Instruction");
+      MakeFile(std::string(dir) + "cache/index1/shared_cpu_list", siblings[core]);
+      MakeFile(std::string(dir) + "cache/index2/level", "2");
+      MakeFile(std::string(dir) + "cache/index2/type", "Unified");
+      MakeFile(std::string(dir) + "cache/index2/shared_cpu_list", siblings[core]);
+      MakeFile(std::string(dir) + "cache/index3/level", "3");
+      MakeFile(std::string(dir) + "cache/index3/type", "Unified");
+      MakeFile(std::string(dir) + "cache/index3/shared_cpu_list", packages[package]);
+    }
+    MakeFile(mRoot + "/devices/system/node/online", "0-1");
+    MakeFile(mRoot + "/devices/system/node/node0/cpulist", packages[0]);
+    MakeFile(mRoot + "/devices/system/node/node1/cpulist", packages[1]);
+  }
+
+  ~FakeMachine()
+  {
+    osal::Topology::Load("/sys");   // the other tests should see the real machine
+    if (!mRoot.empty())
+    {
+      system(("rm -rf " + mRoot).c_str());
+    }
+  }
+
+  const char* Root() const
+  {
+    return mRoot.c_str();
+  }
+
+private:
+  std::string mRoot;
+};
+
+unsigned int Only(const osal::Thread::CpuSet& cpus)
+{
+  unsigned int found = osal::Thread::CpuSet::MAX_CPUS;
+  for (unsigned int cpu = 0; cpu < osal::Thread::CpuSet::MAX_CPUS; cpu++)
+  {
+    if (cpus.IsSet(cpu))
+    {
+      EXPECT_EQ((unsigned int)osal::Thread::CpuSet::MAX_CPUS, found);   // a single CPU
+      found = cpu;
+    }
+  }
+  return found;
+}
+
+unsigned int Size(const osal::Thread::CpuSet& cpus)
+{
+  unsigned int size = 0;
+  for (unsigned int cpu = 0; cpu < osal::Thread::CpuSet::MAX_CPUS; cpu++)
+  {
+    size += cpus.IsSet(cpu) ? 1 : 0;
+  }
+  return size;
+}
+
+volatile bool stopWaiting = false;
+
+void Waiting()
+{
+  while (!stopWaiting)
+  {
+    osal::Thread::Self::Sleep(1);
+  }
+}
+
+TEST(TopologyUT, ThisMachine)
+{
+  ASSERT_TRUE(osal::Topology::Load("/sys"));
+  EXPECT_EQ((unsigned int)sysconf(_SC_NPROCESSORS_ONLN), osal::Topology::Count());
+  for (unsigned int i = 0; i < osal::Topology::Count(); i++)
+  {
+    osal::Topology::Cpu cpu;
+    ASSERT_TRUE(osal::Topology::At(i, cpu));
+    // each level contain the one bellow it
+    const osal::Thread::CpuSet core = osal::Topology::Domain(cpu.Id, osal::Topology::CORE);
+    const osal::Thread::CpuSet l2 = osal::Topology::Domain(cpu.Id, osal::Topology::L2_CACHE);
+    const osal::Thread::CpuSet l3 = osal::Topology::Domain(cpu.Id, osal::Topology::L3_CACHE);
+    EXPECT_TRUE(core.IsSet(cpu.Id));
+    EXPECT_TRUE(core.IsSet(cpu.Core));
+    for (unsigned int other = 0; other < osal::Thread::CpuSet::MAX_CPUS; other++)
+    {
+      EXPECT_TRUE(!core.IsSet(other) || l2.IsSet(other));
+      EXPECT_TRUE(!l2.IsSet(other) || l3.IsSet(other));
+    }
+  }
+  osal::Topology::Cpu current;
+  EXPECT_TRUE(osal::Topology::Find(osal::Topology::Current(), current));
+  EXPECT_FALSE(osal::Topology::At(osal::Topology::Count(), current));
+  EXPECT_TRUE(osal::Topology::Find(Only(osal::Topology::Spread(0)), current));
+  EXPECT_TRUE(osal::Topology::Find(Only(osal::Topology::Compact(0)), current));
+  EXPECT_TRUE(osal::Topology::Near(0, osal::Topology::CORE).IsSet(osal::Topology::Current()));
+  EXPECT_FALSE(osal::Topology::Load("/no/such/root"));
+  EXPECT_EQ(0u, osal::Topology::Count());
+  EXPECT_TRUE(osal::Topology::Spread(3).Empty());   // no restrictions
+  EXPECT_TRUE(osal::Topology::Load("/sys"));
+}
+
+TEST(TopologyUT, OnlyAllowedCpus)
+{
+  // the main thread is the process for sched_getaffinity
+  const unsigned int current = osal::Topology::Current();
+  osal::Thread::CpuSet only;
+  only.Set(current);
+  ASSERT_TRUE(osal::Thread::Self::NewAffinity(only));
+  ASSERT_TRUE(osal::Topology::Load("/sys"));
+  for (unsigned int i = 0; i < osal::Topology::Count(); i++)
+  {
+    EXPECT_EQ(current, Only(osal::Topology::Spread(i)));
+    EXPECT_EQ(current, Only(osal::Topology::Compact(i)));
+  }
+  EXPECT_TRUE(osal::Thread::Self::NewAffinity(osal::Thread::CpuSet()));
+  EXPECT_TRUE(osal::Topology::Load("/sys"));
+}
+
+TEST(TopologyUT, FakeMachine)
+{
+  FakeMachine machine;
+  ASSERT_TRUE(osal::Topology::Load(machine.Root()));
+  ASSERT_EQ(8u, osal::Topology::Count());
+  osal::Topology::Cpu cpu;
+  ASSERT_TRUE(osal::Topology::Find(6, cpu));
+  EXPECT_EQ(6u, cpu.Id);
+  EXPECT_EQ(2u, cpu.Core);
+  EXPECT_EQ(2u, cpu.L2);
+  EXPECT_EQ(2u, cpu.L3);
+  EXPECT_EQ(1u, cpu.Node);
+  EXPECT_EQ(2u, cpu.Package);
+  EXPECT_FALSE(osal::Topology::Find(8, cpu));
+
+  EXPECT_EQ(2u, Size(osal::Topology::Domain(5, osal::Topology::CORE)));
+  EXPECT_TRUE(osal::Topology::Domain(5, osal::Topology::CORE).IsSet(1));
+  const osal::Thread::CpuSet node = osal::Topology::Domain(5, osal::Topology::NUMA_NODE);
+  EXPECT_EQ(4u, Size(node));
+  EXPECT_TRUE(node.IsSet(0) && node.IsSet(1) && node.IsSet(4) && node.IsSet(5));
+  EXPECT_TRUE(osal::Topology::Domain(9, osal::Topology::CORE).Empty());
+
+  // spread - first a core in each package, then the other cores and only then the siblings
+  const unsigned int spread[] = { 0, 2, 1, 3, 4, 6, 5, 7 };
+  // compact - both siblings of a core, then the other core in the package
+  const unsigned int compact[] = { 0, 4, 1, 5, 2, 6, 3, 7 };
+  for (unsigned int i = 0; i < 8; i++)
+  {
+    EXPECT_EQ(spread[i], Only(osal::Topology::Spread(i)));
+    EXPECT_EQ(compact[i], Only(osal::Topology::Compact(i)));
+  }
+  EXPECT_EQ(spread[1], Only(osal::Topology::Spread(9)));    // start again
+
+  // a thread that is bound to CPU 0, and the CPUs that share its L3
+  osal::Thread::CpuSet first;
+  first.Set(0);
+  stopWaiting = false;
+  osal::Thread::Id* thread = osal::Thread::Create(osal::Thread::CreateAttribute("Bound", 16 * 1024,
+                                                                                osal::Thread::Self::Priority(),
+                                                                                first),
+                                                  Waiting);
+  osal::Thread::CpuSet bound;
+  EXPECT_TRUE(osal::Thread::Affinity(thread, bound));
+  EXPECT_EQ(0u, Only(bound));
+  const osal::Thread::CpuSet near = osal::Topology::Near(thread, osal::Topology::L3_CACHE);
+  EXPECT_EQ(4u, Size(near));
+  EXPECT_TRUE(near.IsSet(0) && near.IsSet(1) && near.IsSet(4) && near.IsSet(5));
+  const osal::Thread::CpuSet core = osal::Topology::Near(thread, osal::Topology::CORE);
+  EXPECT_EQ(2u, Size(core));
+  EXPECT_TRUE(core.IsSet(4));
+  stopWaiting = true;
+  EXPECT_TRUE(osal::Thread::Clean(thread));
+}
+
+} // end of local namespace
@@ -5,6 +5,7 @@
 #include "SemHandle.h"	// the vxworks semaphore handle is implemted here
 #include "CriticalSection.h"		// to guard the error handling functions
 #include "ExitFunctionHolder.h"		// to define the list of error handling functions
+#include "WaitList.h"             // to allow waiting on more than one object
 #include <errnoLib.h>             // errnoGet and the errno values
 #include <semLib.h>               // vxworks semaphore API
 #include <assert.h>               // assert macro
@@ -38,6 +39,8 @@ struct  Id : public semvx::SemHandle
 	Id()
 	{
 	}
+
+	Private::WaitList Waiters;
 };
 
 void RegisterAtExit(at_error_fun func)
@@ -94,6 +97,12 @@ bool TimedWait(Id* on, milliseconds_t milliDuration)
 	}
 }
 
+// the wait is in system ticks, so finer timeouts are rounded up
+bool TimedWait(Id* on, const Duration& duration)
+{
+  return TimedWait(on, duration.Milli());
+}
+
 void Post(Id* on)
 {
 	assert(on);
@@ -101,6 +110,12 @@ void Post(Id* on)
 	{
 	  ErrorFunctionsHandler().CriticalError(errnoGet(), __FUNCTION__, __LINE__);
 	}
+	on->Waiters.Notify();
+}
+
+Private::WaitList& WaitListOf(Id* id)
+{
+	return id->Waiters;
 }
 
 void Delete(Id*& what)
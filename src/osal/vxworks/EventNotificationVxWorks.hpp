@@ -4,6 +4,7 @@
 #include "CriticalSection.h"      // to gaurd error function registrations
 #include "SemHandle.h" // to data type that are use to implement this
 #include "ExitFunctionHolder.h"   // hold the exit functions
+#include "WaitList.h"             // to allow waiting on more than one object
 #include "OsalTimeUtils.h"        // support for milli2ticks
 #include <vxWorks.h>              // vxworks data types
 #include <errnoLib.h>             // library to support errno
@@ -32,6 +33,7 @@ struct Id : semvx::SemHandle
   {
   }
   
+  Private::WaitList Waiters;
 };
 
 void RegisterAtExit(at_error_fun func)
@@ -85,6 +87,12 @@ bool TimedWait(Id* on, milliseconds_t milliDuration)
   
 }
 
+// the wait is in system ticks, so finer timeouts are rounded up
+bool TimedWait(Id* on, const Duration& duration)
+{
+  return TimedWait(on, duration.Milli());
+}
+
 void Signal(Id* on)
 {
   assert(on);
@@ -92,6 +100,7 @@ void Signal(Id* on)
   {
     ErrorFunctionsHandler().CriticalError(errnoGet(), __FUNCTION__, __LINE__);
   }
+  on->Waiters.Notify();
 }
 
 void SignalAll(Id* on)
@@ -103,6 +112,17 @@ void SignalAll(Id* on)
   }
 }
 
+// there are no file descriptors for the OS objects here
+int ReadyHandle(Id*)
+{
+  return -1;
+}
+
+Private::WaitList& WaitListOf(Id* id)
+{
+  return id->Waiters;
+}
+
 void Delete(Id*& id)
 {
   if (id)
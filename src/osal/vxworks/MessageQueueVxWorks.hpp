@@ -5,9 +5,11 @@
 #include "SemHandle.h" // vxworks semaphore handle
 #include "CriticalSection.h"        // critical section pattern
 #include "OsalTimeUtils.h"          // shared resources and functions in osal
+#include "WaitList.h"               // to allow waiting on more than one object
 #include <msgQLib.h>                // vxworks message queue interface
 #include <assert.h>                 // assert
 #include <errnoLib.h>               // errno
+#include <errno.h>                  // ENOSYS
 #include <stdio.h>                  // perror
 
 namespace osal
@@ -47,6 +49,7 @@ struct Id
   }
   
   MSG_Q_ID  mValue; 
+  Private::WaitList Waiters;
 };
 
 void RegisterAtExit(at_error_fun func)
@@ -64,6 +67,16 @@ Id* Create(unsigned int queueSize, unsigned int maxMessageSize)
   
 }
 
+Id* Create(unsigned int queueSize, unsigned int maxMessageSize, Engine)
+{
+  return Create(queueSize, maxMessageSize);  // the native message queue is the only engine here
+}
+
+Id* CreateLockFree(unsigned int queueSize, unsigned int maxMessageSize)
+{
+  return Create(queueSize, maxMessageSize);
+}
+
 void Send(Id* mqId, CONST_MESSAGE char* msgBuff, unsigned int msgSize, bool highPriority)
 {
   assert(mqId);   // this function cannot be called with invalid id
@@ -71,6 +84,7 @@ void Send(Id* mqId, CONST_MESSAGE char* msgBuff, unsigned int msgSize, bool high
   {
 	  ExitFunctionsList().CriticalError(errnoGet(), __FUNCTION__, __LINE__);
   }
+  mqId->Waiters.Notify();
 }
 
 bool TrySend(Id* mqId, CONST_MESSAGE char* msgBuff, unsigned int msgSize, bool highPriority)
@@ -82,6 +96,7 @@ bool TrySend(Id* mqId, CONST_MESSAGE char* msgBuff, unsigned int msgSize, bool h
   }
   else
   {
+    mqId->Waiters.Notify();
     return true;
   }
   
@@ -97,10 +112,18 @@ bool TimedSend(Id* mqId, CONST_MESSAGE char* msgBuff, unsigned int msgSize,
   }
   else
   {
+    mqId->Waiters.Notify();
     return true;
   }  
 }
 
+// the wait is in system ticks, so finer timeouts are rounded up
+bool TimedSend(Id* mqId, CONST_MESSAGE char* msgBuff, unsigned int msgSize,
+               const Duration& duration, bool highPriority)
+{
+  return TimedSend(mqId, msgBuff, msgSize, duration.Milli(), highPriority);
+}
+
 int Receive(Id* mqId, char* msgBuff, unsigned int buffSize)
 {
   assert(mqId);   // this function cannot be called with invalid id
@@ -138,12 +161,109 @@ int TimedReceive(Id* mqId, char* msgBuff, unsigned int buffSize, milliseconds_t
   
 }
 
+int TimedReceive(Id* mqId, char* msgBuff, unsigned int buffSize, const Duration& duration)
+{
+  return TimedReceive(mqId, msgBuff, buffSize, duration.Milli());
+}
+
+// the native queue has no batch operations, so we only save the calls to the
+// error handling - the first message is waited for, the rest are taken as long as they are ready
+unsigned int SendBatch(Id* mqId, CONST_MESSAGE char* const msgs[], const unsigned int sizes[], unsigned int count)
+{
+  assert(mqId);   // this function cannot be called with invalid id
+  unsigned int sent = 0;
+  for (; sent < count; sent++)
+  {
+    if (msgQSend(mqId->mValue, msgs[sent], sizes[sent], sent ? NO_WAIT : WAIT_FOREVER, MSG_PRI_NORMAL) != OK)
+    {
+      if (sent == 0)
+      {
+        ExitFunctionsList().CriticalError(errnoGet(), __FUNCTION__, __LINE__);
+      }
+      break;  // the queue is full, return what we have so far
+    }
+  }
+  if (sent)
+  {
+    mqId->Waiters.Notify();
+  }
+  return sent;
+}
+
+unsigned int ReceiveBatch(Id* mqId, char* msgBuff, unsigned int stride, unsigned int sizes[],
+                          unsigned int maxCount, milliseconds_t milliDuration)
+{
+  assert(mqId);   // this function cannot be called with invalid id
+  unsigned int count = 0;
+  for (; count < maxCount; count++)
+  {
+    int ret = msgQReceive(mqId->mValue, msgBuff + count * stride, stride, 
+                          count ? NO_WAIT : TimeUtils::Milli2Ticks(milliDuration));
+    if (ret == ERROR)
+    {
+      if (count == 0)
+      {
+        if (milliDuration)
+        {
+          ExitFunctionsList().TimedOut(errnoGet(), __FUNCTION__, __LINE__);
+        }
+        else
+        {
+          ExitFunctionsList().TryFail(errnoGet(), __FUNCTION__, __LINE__);
+        }
+      }
+      break;
+    }
+    if (sizes)
+    {
+      sizes[count] = ret;
+    }
+  }
+  return count;
+}
+
 int CurrentCount(Id* mqId)
 {
   assert(mqId);   // this function cannot be called with invalid id
   return msgQNumMsgs(mqId->mValue);
 }
 
+// the native queue do not keep the urgent messages apart, so all are counted as normal
+LanesCount CurrentLanesCount(Id* mqId)
+{
+  assert(mqId);   // this function cannot be called with invalid id
+  LanesCount lanes = { msgQNumMsgs(mqId->mValue), 0, 0, 0 };
+  return lanes;
+}
+
+// there are no file descriptors for the OS objects here
+int ReadyHandle(Id*)
+{
+  return -1;
+}
+
+// all the tasks are sharing the same memory here, so there is no need for queues between processes
+Id* CreateShared(const char*, unsigned int, unsigned int)
+{
+  ExitFunctionsList().CriticalError(ENOSYS, __FUNCTION__, __LINE__);
+  return 0;
+}
+
+Id* OpenShared(const char*)
+{
+  return 0;
+}
+
+bool PeerAlive(Id*)
+{
+  return true;
+}
+
+Private::WaitList& WaitListOf(Id* mqId)
+{
+  return mqId->Waiters;
+}
+
 void Delete(Id*& mqId)
 {
   if (mqId)
@@ -95,6 +95,13 @@ Id* Create()
   return id.release();
 }
 
+// vxworks mutex semaphores are already blocking the task right away, and the critical
+// sections are not shorter than the cost of blocking on a single CPU, so the policy is ignored
+Id* Create(Policy)
+{
+  return Create();
+}
+
 Id* CreateRecursive(Protection prioritySafe)
 {
 	std::auto_ptr<Id> id(new Id);
@@ -146,6 +153,12 @@ bool TimedLock(Id* id, milliseconds_t milliDuration)
 	}
 }
 
+// the wait is in system ticks, so finer timeouts are rounded up
+bool TimedLock(Id* id, const Duration& duration)
+{
+  return TimedLock(id, duration.Milli());
+}
+
 void Release(Id* id)
 {
   OSAL_ASSERT_CONDITION(id, ExitFunctionsList(), "invalid mutex id");
@@ -109,6 +109,12 @@ bool TimedReadLock(Id* id, milliseconds_t milliTimeout)
   }
 }
 
+// the wait is in system ticks, so finer timeouts are rounded up
+bool TimedReadLock(Id* id, const Duration& timeout)
+{
+  return TimedReadLock(id, timeout.Milli());
+}
+
 void WriteLock(Id* id)
 {
   assert(id);
@@ -144,6 +150,11 @@ bool TimedWriteLock(Id* id, milliseconds_t milliTimeout)
   }
 }
 
+bool TimedWriteLock(Id* id, const Duration& timeout)
+{
+  return TimedWriteLock(id, timeout.Milli());
+}
+
 void Release(Id* id)
 {
   assert(id);
@@ -55,6 +55,12 @@ bool TimedReadLock(Id* id, milliseconds_t milliTimeout)
   return Mutex::TimedLock(id->mData, milliTimeout);
 }
 
+// the wait is in system ticks, so finer timeouts are rounded up
+bool TimedReadLock(Id* id, const Duration& timeout)
+{
+  return TimedReadLock(id, timeout.Milli());
+}
+
 void WriteLock(Id* id)
 {
   assert(id);
@@ -73,6 +79,11 @@ bool TimedWriteLock(Id* id, milliseconds_t milliTimeout)
   return Mutex::TimedLock(id->mData, milliTimeout);
 }
 
+bool TimedWriteLock(Id* id, const Duration& timeout)
+{
+  return TimedWriteLock(id, timeout.Milli());
+}
+
 void Release(Id* id)
 {
   assert(id);
@@ -0,0 +1,243 @@
+#ifndef THREAD_LOCAL_VXWORKS__HPP
+#define THREAD_LOCAL_VXWORKS__HPP
+// VxWorks implementation for the thread local storage. The pointer that the template is using
+// is a global variable, and when a task access the value for the first time, we make it a task
+// variable (taskVarAdd) for this task, so the kernel would switch it with the task. The values are
+// removed from a task delete hook, that look for the values of the task in all the storages.
+
+#include "osal/ThreadLocal.h"       // the interface for this implementation
+#include "CriticalSection.h"        // to guard the list of values
+#include "ExitFunctionHolder.h"     // to report errors
+#include "SemHandle.h"              // the lock
+#include <vxWorks.h>                // vxworks types
+#include <taskLib.h>                // taskIdSelf
+#include <taskVarLib.h>             // taskVarAdd
+#include <taskHookLib.h>            // taskDeleteHookAdd
+#include <errnoLib.h>               // errno for vxworks
+#include <vector>                   // all the storages
+#include <algorithm>                // find
+
+namespace osal
+{
+
+namespace ThreadLocalDetails
+{
+
+struct Node
+{
+  Node(Id* owner, void* value, void** slot, int task) : Owner(owner), Value(value), Slot(slot), Task(task), Next(0)
+  {
+  }
+
+  Id* Owner;
+  void* Value;
+  void** Slot;    // the task variable
+  int Task;
+  Node* Next;
+};
+
+struct Id
+{
+  Id(create_func_t create, exit_func_t atExit, delete_func_t remove, void* owner) :
+    Create(create), AtExit(atExit), Remove(remove), Owner(owner), Head(0), Count(0)
+  {
+  }
+
+  // @return the node of the task (it is removed from the list if remove is set)
+  Node* Find(int task, bool remove)
+  {
+    for (Node** at = &Head; *at; at = &(*at)->Next)
+    {
+      Node* node = *at;
+      if (node->Task == task)
+      {
+        if (remove)
+        {
+          *at = node->Next;
+          --Count;
+        }
+        return node;
+      }
+    }
+    return 0;
+  }
+
+  create_func_t Create;
+  exit_func_t AtExit;
+  delete_func_t Remove;
+  void* Owner;
+  Node* Head;
+  unsigned int Count;
+};
+
+namespace
+{
+
+typedef Private::CriticalSection<semvx::SemHandle> Guard;
+
+Private::ExitFunctionHolder& ErrorHandler()
+{
+  static Private::ExitFunctionHolder theList;
+  return theList;
+}
+
+// one lock for all the storages, since the delete hook need to look at all of them
+const semvx::SemHandle& TheLock()
+{
+  static semvx::SemHandle lock(true);
+  return lock;
+}
+
+std::vector<Id*>& AllStorages()
+{
+  static std::vector<Id*> storages;
+  return storages;
+}
+
+// called when any task is deleted
+void TaskDeleted(WIND_TCB* tcb)
+{
+  const int task = (int)tcb;
+  std::vector<Node*> removed;
+  {
+    Guard guard(TheLock());
+    for (std::vector<Id*>::iterator id = AllStorages().begin(); id != AllStorages().end(); ++id)
+    {
+      Node* node = (*id)->Find(task, true);
+      if (node)
+      {
+        (*id)->AtExit(node->Value, (*id)->Owner);
+        removed.push_back(node);
+      }
+    }
+  }
+  for (std::vector<Node*>::iterator node = removed.begin(); node != removed.end(); ++node)
+  {
+    (*node)->Owner->Remove((*node)->Value);   // the task variable is removed with the task
+    delete *node;
+  }
+}
+
+} // end of local namespace
+
+Id* Create(create_func_t create, exit_func_t atExit, delete_func_t remove, void* owner)
+{
+  static bool hooked = false;
+  Id* id = new Id(create, atExit, remove, owner);
+  Guard guard(TheLock());
+  if (!hooked)
+  {
+    if (taskDeleteHookAdd((FUNCPTR)TaskDeleted) != OK)
+    {
+      ErrorHandler().CriticalError(errnoGet(), __FUNCTION__, __LINE__);
+    }
+    hooked = true;
+  }
+  AllStorages().push_back(id);
+  return id;
+}
+
+void* Attach(Id* id, void** slot)
+{
+  assert(id);
+  const int task = taskIdSelf();
+  if (slot && taskVarAdd(task, (int*)slot) != OK)
+  {
+    ErrorHandler().CriticalError(errnoGet(), __FUNCTION__, __LINE__);
+  }
+  Node* node = new Node(id, id->Create(), slot, task);
+  {
+    Guard guard(TheLock());
+    node->Next = id->Head;
+    id->Head = node;
+    ++id->Count;
+  }
+  if (slot)
+  {
+    *slot = node->Value;  // this is now our own copy of the variable
+  }
+  return node->Value;
+}
+
+void* Get(Id* id)
+{
+  assert(id);
+  Node* node = 0;
+  {
+    Guard guard(TheLock());
+    node = id->Find(taskIdSelf(), false);
+  }
+  return node ? node->Value : Attach(id, 0);
+}
+
+void ForEach(Id* id, visit_func_t func, void* context)
+{
+  assert(id);
+  Guard guard(TheLock());
+  for (Node* node = id->Head; node; node = node->Next)
+  {
+    func(node->Value, context);
+  }
+}
+
+unsigned int Count(Id* id)
+{
+  assert(id);
+  Guard guard(TheLock());
+  return id->Count;
+}
+
+void Delete(Id*& id)
+{
+  if (!id)
+  {
+    return;
+  }
+  {
+    Guard guard(TheLock());
+    std::vector<Id*>& storages = AllStorages();
+    storages.erase(std::find(storages.begin(), storages.end(), id));
+  }
+  Node* node = id->Head;
+  while (node)
+  {
+    Node* next = node->Next;
+    if (node->Slot)
+    {
+      taskVarDelete(node->Task, (int*)node->Slot);  // the task would see the global variable (NULL) again
+    }
+    id->Remove(node->Value);
+    delete node;
+    node = next;
+  }
+  delete id;
+  id = 0;
+}
+
+bool TakeSlot(void* volatile* user, void* self)
+{
+  Guard guard(TheLock());
+  if (*user)
+  {
+    return false;
+  }
+  *user = self;
+  return true;
+}
+
+void GiveSlot(void* volatile* user, void* self)
+{
+  Guard guard(TheLock());
+  if (*user == self)
+  {
+    *user = 0;
+  }
+}
+
+} // end of namespace ThreadLocalDetails
+
+} // end of namespace osal
+
+#else
+# error "you must not include this file inside header file"
+#endif  // THREAD_LOCAL_VXWORKS__HPP
@@ -9,6 +9,9 @@
 #include <assert.h>   // assert macro
 #include <errnoLib.h> // errno for vxworks
 #include <string.h>   // strcmp
+#ifdef _WRS_CONFIG_SMP
+# include <cpuset.h>  // cpuset_t for task affinity
+#endif  // _WRS_CONFIG_SMP
 //#include <stdio.h>    // remove this!!
 
 namespace osal
@@ -310,11 +313,21 @@ Attributes::Attributes(const char* name, unsigned int stackSize, PriorityType pr
 {
 }
 
+Attributes::Attributes(const char* name, unsigned int stackSize, PriorityType prio, const CpuSet& affinity) : 
+                            Name(name), StackSize(stackSize), Priority(prio), Affinity(affinity)
+{
+}
+
 Attributes CreateAttribute(const char* name, unsigned int sSize, PriorityType pt)
 {
   return Attributes(name, sSize, pt); 
 }
 
+Attributes CreateAttribute(const char* name, unsigned int sSize, PriorityType pt, const CpuSet& affinity)
+{
+  return Attributes(name, sSize, pt, affinity); 
+}
+
 void RegisterAtExit(at_error_fun func)
 {
 	ExitFunctionsThreadList().Push(func);
@@ -335,7 +348,12 @@ Id* Create(const Attributes& attr, entry_func_t entryFunc)
 	if (tid != ERROR)
 	{
 	  //printf("created task id %d\r\n", tid);
-		return new Id(tid);	// return the new task object
+	  Id* id = new Id(tid);	// return the new task object
+	  if (!attr.Affinity.Empty())
+	  {
+	    NewAffinity(id, attr.Affinity);
+	  }
+		return id;
 	}
 	else
 	{
@@ -368,6 +386,49 @@ void NewPriority(Id* to, PriorityType newPrio)
 	}
 }
 
+bool NewAffinity(Id* to, const CpuSet& cpus)
+{
+  assert(to);
+#ifdef _WRS_CONFIG_SMP
+  cpuset_t osCpus;
+  CPUSET_ZERO(osCpus);  // empty set mean that the task can run on any CPU
+  for (unsigned int cpu = 0; cpu < CpuSet::MAX_CPUS; cpu++)
+  {
+    if (cpus.IsSet(cpu))
+    {
+      CPUSET_SET(osCpus, cpu);
+    }
+  }
+  return taskCpuAffinitySet(to->TaskId, osCpus) == OK;
+#else
+  return cpus.Empty(); // this is not SMP so there is only one CPU anyway
+#endif  // _WRS_CONFIG_SMP
+}
+
+bool Affinity(Id* of, CpuSet& cpus)
+{
+  assert(of);
+  cpus.Reset();
+#ifdef _WRS_CONFIG_SMP
+  cpuset_t osCpus;
+  CPUSET_ZERO(osCpus);
+  if (taskCpuAffinityGet(of->TaskId, &osCpus) != OK)
+  {
+    return false;
+  }
+  for (unsigned int cpu = 0; cpu < CpuSet::MAX_CPUS; cpu++)
+  {
+    if (CPUSET_ISSET(osCpus, cpu))
+    {
+      cpus.Set(cpu);
+    }
+  }
+  return true;
+#else
+  return true;  // the task can run on the only CPU
+#endif  // _WRS_CONFIG_SMP
+}
+
 const char* Name(Id* id)
 {
 	assert(id);
@@ -418,6 +479,12 @@ bool TimeClean(Id*& id, milliseconds_t milliDuration)
 	return ret;
 }
 
+// the wait is in system ticks, so finer timeouts are rounded up
+bool TimeClean(Id*& id, const Duration& duration)
+{
+  return TimeClean(id, duration.Milli());
+}
+
 
 namespace Self
 {
@@ -456,6 +523,12 @@ void NewPriority(Thread::PriorityType newPrio)
   Thread::NewPriority(&id, newPrio);
 }
 
+bool NewAffinity(const CpuSet& cpus)
+{
+  Thread::Id id(taskIdSelf());
+  return Thread::NewAffinity(&id, cpus);
+}
+
 bool Equel(const Thread::Id* other)
 {
   return other != 0 && other->TaskId == taskIdSelf();
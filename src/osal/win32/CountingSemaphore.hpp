@@ -5,3 +5,19 @@
 # include "mocks/src/CountingSemaphore.hpp" // this one would have mock as the internals
 //# include "noop/CountingSemaphore.hpp"  // this would have a file without any action in it
 #endif  // SUPPORT_FOR_WIN32_OSAL
+
+namespace osal
+{
+
+namespace CountingSemaphore
+{
+
+// the waits here are in milliseconds, so finer timeouts are rounded up
+bool TimedWait(Id* on, const Duration& duration)
+{
+  return TimedWait(on, duration.Milli());
+}
+
+} // end of namespace CountingSemaphore
+
+} // end of namespace osal
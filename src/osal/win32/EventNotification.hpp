@@ -5,3 +5,19 @@
 //#elif defined(SUPPORT_FOR_OSAL_MOCKS)
 //# include "noop/EventNotification.hpp"  // this would have a file without any action in it
 #endif  // SUPPORT_FOR_WIN32_OSAL
+
+namespace osal
+{
+
+namespace EventNotification
+{
+
+// the waits here are in milliseconds, so finer timeouts are rounded up
+bool TimedWait(Id* on, const Duration& duration)
+{
+  return TimedWait(on, duration.Milli());
+}
+
+} // end of namespace EventNotification
+
+} // end of namespace osal
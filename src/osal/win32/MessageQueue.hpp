@@ -5,3 +5,25 @@
 # include "mocks/src/MessageQueue.hpp" // this one would have mock as the internals
 //# include "noop/MessageQueue.hpp"  // this would have a file without any action in it
 #endif  // SUPPORT_FOR_WIN32_OSAL
+
+namespace osal
+{
+
+namespace MessageQueue
+{
+
+// the waits here are in milliseconds, so finer timeouts are rounded up
+bool TimedSend(Id* mqId, CONST_MESSAGE char* msgBuff, unsigned int msgSize,
+               const Duration& duration, bool highPriority)
+{
+  return TimedSend(mqId, msgBuff, msgSize, duration.Milli(), highPriority);
+}
+
+int TimedReceive(Id* mqId, char* msgBuff, unsigned int buffSize, const Duration& duration)
+{
+  return TimedReceive(mqId, msgBuff, buffSize, duration.Milli());
+}
+
+} // end of namespace MessageQueue
+
+} // end of namespace osal
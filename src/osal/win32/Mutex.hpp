@@ -5,3 +5,25 @@
 # include "mocks/src/Mutex.hpp" // this one would have mock as the internals
 //# include "noop/Mutex.hpp"  // this would have a file without any action in it
 #endif  // SUPPORT_FOR_WIN32_OSAL
+
+namespace osal
+{
+
+namespace Mutex
+{
+
+// there is no control over the spinning here, so the policy is ignored
+Id* Create(Policy)
+{
+  return Create();
+}
+
+// the waits here are in milliseconds, so finer timeouts are rounded up
+bool TimedLock(Id* id, const Duration& duration)
+{
+  return TimedLock(id, duration.Milli());
+}
+
+} // end of namespace Mutex
+
+} // end of namespace osal
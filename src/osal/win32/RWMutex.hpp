@@ -5,3 +5,24 @@
 # include "mocks/src/RWMutex.hpp" // this one would have mock as the internals
 //# include "noop/RWMutex.hpp"  // this would have a file without any action in it
 #endif  // SUPPORT_FOR_WIN32_OSAL
+
+namespace osal
+{
+
+namespace RWMutex
+{
+
+// the waits here are in milliseconds, so finer timeouts are rounded up
+bool TimedReadLock(Id* id, const Duration& timeout)
+{
+  return TimedReadLock(id, timeout.Milli());
+}
+
+bool TimedWriteLock(Id* id, const Duration& timeout)
+{
+  return TimedWriteLock(id, timeout.Milli());
+}
+
+} // end of namespace RWMutex
+
+} // end of namespace osal
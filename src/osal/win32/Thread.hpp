@@ -6,3 +6,19 @@
 //# include "noop/Thread.hpp"  // this would have a file without any action in it
 #endif  // SUPPORT_FOR_WIN32_OSAL
 
+
+namespace osal
+{
+
+namespace Thread
+{
+
+// the waits here are in milliseconds, so finer timeouts are rounded up
+bool TimeClean(Id*& id, const Duration& duration)
+{
+  return TimeClean(id, duration.Milli());
+}
+
+} // end of namespace Thread
+
+} // end of namespace osal
@@ -0,0 +1,205 @@
+#ifndef THREAD_LOCAL_WIN32__HPP
+#define THREAD_LOCAL_WIN32__HPP
+// win32 implementation for the thread local storage (the same for the native and the mocks build).
+// there is no fast slot here, the value is found with fiber local storage - it is the same as thread
+// local storage (TlsAlloc) but it allow to have a callback when the thread exit, which we need to
+// remove the value
+
+#include "osal/ThreadLocal.h"       // the interface for this implementation
+#include "ExitFunctionHolder.h"     // to report errors
+#include <windows.h>                // FlsAlloc, CRITICAL_SECTION
+
+namespace osal
+{
+
+namespace ThreadLocalDetails
+{
+
+struct Node
+{
+  Node(Id* owner, void* value) : Owner(owner), Value(value), Next(0), Prev(0)
+  {
+  }
+
+  Id* Owner;
+  void* Value;
+  Node* Next;
+  Node* Prev;
+};
+
+struct Id
+{
+  Id(create_func_t create, exit_func_t atExit, delete_func_t remove, void* owner) :
+    Create(create), AtExit(atExit), Remove(remove), Owner(owner), Index(FLS_OUT_OF_INDEXES),
+    Head(0), Count(0), Deleting(false)
+  {
+    InitializeCriticalSection(&Lock);
+  }
+
+  ~Id()
+  {
+    DeleteCriticalSection(&Lock);
+  }
+
+  void Link(Node* node)
+  {
+    node->Next = Head;
+    if (Head)
+    {
+      Head->Prev = node;
+    }
+    Head = node;
+    ++Count;
+  }
+
+  void Unlink(Node* node)
+  {
+    if (node->Prev)
+    {
+      node->Prev->Next = node->Next;
+    }
+    else
+    {
+      Head = node->Next;
+    }
+    if (node->Next)
+    {
+      node->Next->Prev = node->Prev;
+    }
+    --Count;
+  }
+
+  create_func_t Create;
+  exit_func_t AtExit;
+  delete_func_t Remove;
+  void* Owner;
+  DWORD Index;
+  CRITICAL_SECTION Lock;
+  Node* Head;
+  unsigned int Count;
+  bool Deleting;  // the values are removed because the storage is deleted, not because the threads exit
+};
+
+namespace
+{
+
+Private::ExitFunctionHolder& ErrorHandler()
+{
+  static Private::ExitFunctionHolder theList;
+  return theList;
+}
+
+struct Guard
+{
+  explicit Guard(Id* id) : mLock(id->Lock)
+  {
+    EnterCriticalSection(&mLock);
+  }
+
+  ~Guard()
+  {
+    LeaveCriticalSection(&mLock);
+  }
+
+private:
+  Guard(const Guard&);
+  Guard& operator = (const Guard&);
+
+  CRITICAL_SECTION& mLock;
+};
+
+// called when a thread that has a value exit (or for all the values when the index is freed)
+void WINAPI Detach(void* value)
+{
+  Node* node = static_cast<Node*>(value);
+  Id* id = node->Owner;
+  {
+    Guard guard(id);
+    if (!id->Deleting)
+    {
+      id->AtExit(node->Value, id->Owner);
+    }
+    id->Unlink(node);
+  }
+  id->Remove(node->Value);
+  delete node;
+}
+
+} // end of local namespace
+
+Id* Create(create_func_t create, exit_func_t atExit, delete_func_t remove, void* owner)
+{
+  Id* id = new Id(create, atExit, remove, owner);
+  id->Index = FlsAlloc(Detach);
+  if (id->Index == FLS_OUT_OF_INDEXES)
+  {
+    ErrorHandler().CriticalError(GetLastError(), __FUNCTION__, __LINE__);
+  }
+  return id;
+}
+
+void* Attach(Id* id, void**)
+{
+  assert(id);
+  Node* node = new Node(id, id->Create());
+  {
+    Guard guard(id);
+    id->Link(node);
+  }
+  if (!FlsSetValue(id->Index, node))
+  {
+    ErrorHandler().CriticalError(GetLastError(), __FUNCTION__, __LINE__);
+  }
+  return node->Value;
+}
+
+void* Get(Id* id)
+{
+  assert(id);
+  Node* node = static_cast<Node*>(FlsGetValue(id->Index));
+  return node ? node->Value : Attach(id, 0);
+}
+
+void ForEach(Id* id, visit_func_t func, void* context)
+{
+  assert(id);
+  Guard guard(id);
+  for (Node* node = id->Head; node; node = node->Next)
+  {
+    func(node->Value, context);
+  }
+}
+
+unsigned int Count(Id* id)
+{
+  assert(id);
+  Guard guard(id);
+  return id->Count;
+}
+
+void Delete(Id*& id)
+{
+  if (!id)
+  {
+    return;
+  }
+  {
+    Guard guard(id);
+    id->Deleting = true;
+  }
+  FlsFree(id->Index);   // this would call Detach for the values that are still set
+  while (id->Head)
+  {
+    Detach(id->Head);
+  }
+  delete id;
+  id = 0;
+}
+
+} // end of namespace ThreadLocalDetails
+
+} // end of namespace osal
+
+#else
+# error "you must not include this file inside header file"
+#endif  // THREAD_LOCAL_WIN32__HPP
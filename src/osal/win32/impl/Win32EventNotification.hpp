@@ -41,6 +41,12 @@ bool TimedWait(Id* on, milliseconds_t milliDuration)
   return on->TimeWait(milliDuration);
 }
 
+// there are no file descriptors for the OS objects here
+int ReadyHandle(Id*)
+{
+  return -1;
+}
+
 void Delete(Id*& what)
 {
   delete what;
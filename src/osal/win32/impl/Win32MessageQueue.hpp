@@ -21,23 +21,33 @@ Id* Create(unsigned int queueSize, unsigned int maxMessageSize)
   return new Id(queueSize, maxMessageSize);
 }
 
+Id* Create(unsigned int queueSize, unsigned int maxMessageSize, Engine)
+{
+  return Create(queueSize, maxMessageSize); // we have only one engine on this platform
+}
+
+Id* CreateLockFree(unsigned int queueSize, unsigned int maxMessageSize)
+{
+  return Create(queueSize, maxMessageSize);
+}
+
 void Send(Id* mqId, CONST_MESSAGE char* msgBuff, unsigned int msgSize, bool highPriority)
 {
   assert(mqId);
-  mqId->Push(msgBuff, msgSize);
+  mqId->Push(msgBuff, msgSize, highPriority);
 }
 
 bool TrySend(Id* mqId, CONST_MESSAGE char* msgBuff, unsigned int msgSize, bool highPriority)
 {
   assert(mqId);
-  return mqId->TryPush(msgBuff, msgSize);
+  return mqId->TryPush(msgBuff, msgSize, highPriority);
 }
 
 bool TimedSend(Id* mqId, CONST_MESSAGE char* msgBuff, unsigned int msgSize, 
                milliseconds_t milliDuration, bool highPriority)
 {
   assert(mqId);
-  return mqId->TimePush(msgBuff, msgSize, milliDuration);
+  return mqId->TimePush(msgBuff, msgSize, milliDuration, highPriority);
 }
 
 int Receive(Id* mqId, char* msgBuff, unsigned int buffSize)
@@ -58,12 +68,53 @@ int TimedReceive(Id* mqId, char* msgBuff, unsigned int buffSize, milliseconds_t
   return mqId->TimePop(msgBuff, buffSize, milliDuration); 
 }
 
+unsigned int SendBatch(Id* mqId, CONST_MESSAGE char* const msgs[], const unsigned int sizes[], unsigned int count)
+{
+  assert(mqId);
+  return mqId->PushBatch(msgs, sizes, count);
+}
+
+unsigned int ReceiveBatch(Id* mqId, char* msgBuff, unsigned int stride, unsigned int sizes[],
+                          unsigned int maxCount, milliseconds_t milliDuration)
+{
+  assert(mqId);
+  return mqId->PopBatch(msgBuff, stride, sizes, maxCount, milliDuration);
+}
+
 int CurrentCount(Id* mqId)
 {
   assert(mqId);
   return mqId->Size();
 }
 
+LanesCount CurrentLanesCount(Id* mqId)
+{
+  assert(mqId);
+  return mqId->Lanes();
+}
+
+// there are no file descriptors for the OS objects here
+int ReadyHandle(Id*)
+{
+  return -1;
+}
+
+// the queues between processes are only supported on Linux
+Id* CreateShared(const char*, unsigned int, unsigned int)
+{
+  return 0;
+}
+
+Id* OpenShared(const char*)
+{
+  return 0;
+}
+
+bool PeerAlive(Id*)
+{
+  return true;
+}
+
 void Delete(Id*& mqId)
 {
   delete mqId;
@@ -70,6 +70,19 @@ void NewPriority(Id* to, PriorityType newPrio)
   // not supported under this paltform
 }
 
+bool NewAffinity(Id* to, const CpuSet& cpus)
+{
+  assert(to);
+  return cpus.Empty(); // not supported under this paltform
+}
+
+bool Affinity(Id* of, CpuSet& cpus)
+{
+  assert(of);
+  cpus.Reset();
+  return false; // not supported under this paltform
+}
+
 const char* Name(Id* id)
 {
   assert(id);
@@ -156,6 +169,11 @@ void NewPriority(Thread::PriorityType newPrio)
   // not supported
 }
 
+bool NewAffinity(const CpuSet& cpus)
+{
+  return cpus.Empty(); // not supported
+}
+
 const char* Name()
 {
   return "unknown"; // not supported
@@ -63,6 +63,12 @@ void SignalAll(Id* id)
   id->mData.SignalAll(); 
 }
 
+// there are no file descriptors for the OS objects here
+int ReadyHandle(Id*)
+{
+  return -1;
+}
+
 void Delete(Id*& id)
 {
   delete id;
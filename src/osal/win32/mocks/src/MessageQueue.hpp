@@ -40,6 +40,16 @@ Id* Create(unsigned int, unsigned int)
   return GetMessageQueueId();
 }
 
+Id* Create(unsigned int, unsigned int, Engine)
+{
+  return GetMessageQueueId();
+}
+
+Id* CreateLockFree(unsigned int, unsigned int)
+{
+  return GetMessageQueueId();
+}
+
 void Send(Id* id, const char* data, unsigned int len, bool)
 {
   assert(id);
@@ -125,12 +135,70 @@ int TimedReceive(Id* id, char* data, unsigned int buffSize, milliseconds_t )
   return buffSize;
 }
 
+unsigned int SendBatch(Id* id, const char* const msgs[], const unsigned int sizes[], unsigned int count)
+{
+  assert(id);
+  for (unsigned int i = 0; i < count; i++)
+  {
+    id->Data.push(std::string(msgs[i], sizes[i]));
+  }
+  return count;
+}
+
+unsigned int ReceiveBatch(Id* id, char* data, unsigned int stride, unsigned int sizes[],
+                          unsigned int maxCount, milliseconds_t )
+{
+  assert(id);
+  unsigned int count = 0;
+  for (; count < maxCount && !id->Data.empty(); count++)
+  {
+    const std::string& s(id->Data.front());
+    unsigned int size = s.size() > stride ? stride : s.size();
+    std::copy(s.begin(), s.begin() + size, data + count * stride);
+    if (sizes)
+    {
+      sizes[count] = size;
+    }
+    id->Data.pop();
+  }
+  return count;
+}
+
 int CurrentCount(Id* id)
 {
   assert(id);
   return id->Data.size();
 }
 
+LanesCount CurrentLanesCount(Id* id)
+{
+  assert(id);
+  LanesCount lanes = { (int)id->Data.size(), 0, 0, 0 };
+  return lanes;
+}
+
+// there are no file descriptors for the OS objects here
+int ReadyHandle(Id*)
+{
+  return -1;
+}
+
+// there is no other process here, this is just like any other queue
+Id* CreateShared(const char*, unsigned int, unsigned int)
+{
+  return GetMessageQueueId();
+}
+
+Id* OpenShared(const char*)
+{
+  return 0;
+}
+
+bool PeerAlive(Id*)
+{
+  return true;
+}
+
 void Delete(Id*& id)
 {
  delete id;
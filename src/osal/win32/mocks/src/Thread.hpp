@@ -32,11 +32,20 @@ Attributes::Attributes(const char* n, unsigned int ss, PriorityType p):  Name(n)
 {
 }
 
+Attributes::Attributes(const char* n, unsigned int ss, PriorityType p, const CpuSet& a):  Name(n), StackSize(ss), Priority(p), Affinity(a)
+{
+}
+
 Attributes CreateAttribute(const char* name, unsigned int sSize, PriorityType p)
 {
   return Attributes(name, sSize, p);
 }
 
+Attributes CreateAttribute(const char* name, unsigned int sSize, PriorityType p, const CpuSet& a)
+{
+  return Attributes(name, sSize, p, a);
+}
+
 
 void RegisterAtExit(at_error_fun)
 { 
@@ -66,6 +75,19 @@ void NewPriority(Id* id, PriorityType p)
   return id->mData.NewPriority(p);
 }
 
+bool NewAffinity(Id* id, const CpuSet&)
+{
+  assert(id);
+  return true;
+}
+
+bool Affinity(Id* id, CpuSet& cpus)
+{
+  assert(id);
+  cpus.Reset();
+  return true;
+}
+
 const char* Name(Id* id)
 {
   assert(id);
@@ -112,6 +134,11 @@ void NewPriority(Thread::PriorityType )
 {
 }
 
+bool NewAffinity(const CpuSet&)
+{
+  return true;
+}
+
 const char* Name()
 {
   return "osalWin32noOp";